@@ -0,0 +1,235 @@
+/****************************************************************
+*
+* Copyright (c) 2026
+*
+* Fraunhofer Institute for Manufacturing Engineering
+* and Automation (IPA)
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Project name: care-o-bot
+* ROS stack name: cob_bringup_sandbox
+* ROS package name: cob_camera_sensors_ipa
+* Description: Per-stage latency instrumentation of image acquisition.
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Date of creation: October 2026
+* ToDo:
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer.
+* * Redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution.
+* * Neither the name of the Fraunhofer Institute for Manufacturing
+* Engineering and Automation (IPA) nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License LGPL as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License LGPL for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License LGPL along with this program.
+* If not, see <http://www.gnu.org/licenses/>.
+*
+****************************************************************/
+
+/// @file AcquisitionProfiler.h
+/// Lightweight, always-on latency instrumentation of the image acquisition.
+/// Drivers register named stages (e.g. SDK wait, copy, conversion, registration) once
+/// and wrap them with a <code>ScopedStageTimer</code>. Durations are recorded into
+/// log-linear histograms owned by the measuring thread, so recording never takes a lock.
+/// Aggregated statistics are available through <code>AcquisitionProfiler::GetStatistics</code>
+/// and are dumped to <code>std::cerr</code> on <code>SIGUSR1</code>. The instrumented
+/// drivers install that handler in <code>Init</code> unless the application handles
+/// <code>SIGUSR1</code> itself. Applications that time their own stages without such a
+/// driver call <code>InstallDumpSignalHandler</code>.
+/// @date October 2026.
+
+#ifndef __IPA_ACQUISITIONPROFILER_H__
+#define __IPA_ACQUISITIONPROFILER_H__
+
+#ifdef __LINUX__
+	#include <cob_camera_sensors/AbstractRangeImagingSensor.h>
+	#include <time.h>
+#else
+	#include <cob_driver/cob_camera_sensors/common/include/cob_camera_sensors/AbstractRangeImagingSensor.h>
+	#include <boost/date_time/posix_time/posix_time.hpp>
+#endif
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace ipa_CameraSensors {
+
+static const int PROFILER_MAX_STAGES = 64;		///< Maximum number of registered stages
+static const int PROFILER_SUB_BUCKETS = 4;		///< Histogram buckets per power of two
+static const int PROFILER_NUM_BUCKETS = 104;	///< Buckets cover 0 us to about 2 minutes
+
+/// Latency histogram of one stage, written by a single thread only.
+struct t_StageHistogram
+{
+	volatile unsigned long m_Buckets[PROFILER_NUM_BUCKETS];	///< Number of samples per bucket
+	volatile unsigned long m_Count;							///< Number of samples
+	volatile unsigned long long m_SumUs;					///< Sum of all samples in microseconds
+	volatile unsigned long long m_MaxUs;					///< Largest sample in microseconds
+};
+
+/// Aggregated statistics of one stage over all threads.
+struct t_StageStatistics
+{
+	std::string m_Name;		///< Stage name
+	unsigned long m_Count;	///< Number of samples
+	double m_MeanMs;		///< Mean latency in milliseconds
+	double m_P50Ms;			///< Median latency in milliseconds
+	double m_P90Ms;			///< 90th percentile in milliseconds
+	double m_P99Ms;			///< 99th percentile in milliseconds
+	double m_MaxMs;			///< Largest latency in milliseconds
+};
+
+/// Registry of the instrumented stages and their per-thread histograms.
+/// Percentiles are estimated from the histograms and are accurate to about 20 percent.
+class __DLL_LIBCAMERASENSORS__ AcquisitionProfiler
+{
+public:
+	/// Registers a stage or returns the id of an already registered stage.
+	/// Meant to initialize a static constant once per stage, as the lookup takes a lock.
+	/// @param name Stage name, by convention <I>[Driver]/[stage]</I>.
+	/// @return Stage id, or -1 if <code>PROFILER_MAX_STAGES</code> is exceeded.
+	static int RegisterStage(const std::string& name);
+
+	/// Adds a sample to the histogram of the calling thread.
+	/// @param stageId Id returned by <code>RegisterStage</code>.
+	/// @param durationUs Duration in microseconds.
+	static void Record(int stageId, unsigned long long durationUs);
+
+	/// Aggregates the histograms of all threads.
+	/// Stages without samples are omitted.
+	/// @param statistics Statistics per stage.
+	static void GetStatistics(std::vector<t_StageStatistics>& statistics);
+
+	/// Aggregates the histograms of all threads for one stage.
+	/// @param name Stage name.
+	/// @param statistics Statistics of the stage.
+	/// @return Return code, <code>RET_FAILED</code> if the stage is unknown.
+	static unsigned long GetStatistics(const std::string& name, t_StageStatistics& statistics);
+
+	/// Prints the statistics of all stages as a table.
+	static void Dump(std::ostream& stream);
+
+	/// Clears all histograms.
+	/// Samples recorded concurrently to the reset may get lost.
+	static void Reset();
+
+	/// Enables or disables recording. Recording is enabled by default.
+	static void SetEnabled(bool enabled);
+	static bool IsEnabled() { return m_Enabled; }
+
+	/// Dumps the statistics to <code>std::cerr</code> when the signal arrives.
+	/// The signal handler only raises a flag, the dump is written by the next
+	/// finished stage timer outside of the signal context.
+	/// @param signalNumber Signal to react on, <code>SIGUSR1</code> by default.
+	/// @return Return code.
+	static unsigned long InstallDumpSignalHandler(int signalNumber = -1);
+
+	/// Installs the dump handler for <code>SIGUSR1</code>, unless a handler for it is
+	/// already in place. Called by the instrumented drivers in <code>Init</code>,
+	/// only the first call has an effect.
+	static void InstallDefaultDumpSignalHandler();
+
+	/// Requests a dump by the next finished stage timer.
+	/// Safe to call from a signal handler.
+	static void RequestDump() { m_DumpRequested = 1; }
+
+	/// Writes the pending dump requested by signal, if any.
+	static void DumpIfRequested()
+	{
+		if (m_DumpRequested)
+		{
+			m_DumpRequested = 0;
+			Dump(std::cerr);
+		}
+	}
+
+	/// Monotonic time in microseconds.
+	static unsigned long long Now()
+	{
+#ifdef __LINUX__
+		timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (unsigned long long)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+#else
+		static const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+		return (boost::posix_time::microsec_clock::universal_time() - epoch).total_microseconds();
+#endif
+	}
+
+	/// Histogram bucket of a duration.
+	static int GetBucket(unsigned long long durationUs);
+
+	/// Smallest duration in microseconds falling into the bucket.
+	static unsigned long long GetBucketLowerBound(int bucket);
+
+private:
+	static volatile bool m_Enabled;				///< Recording enabled
+	static volatile int m_DumpRequested;		///< Set by the signal handler
+};
+
+/// Measures the time from construction to <code>Stop</code> or destruction.
+/// Example:
+/// <code>
+/// static const int s_StageWait = AcquisitionProfiler::RegisterStage("Kinect/sdk_wait");
+/// {
+///		ScopedStageTimer timer(s_StageWait);
+///		...
+/// }
+/// </code>
+class ScopedStageTimer
+{
+public:
+	explicit ScopedStageTimer(int stageId)
+		: m_StageId(stageId),
+		  m_Start(AcquisitionProfiler::IsEnabled() ? AcquisitionProfiler::Now() : 0)
+	{
+	}
+
+	~ScopedStageTimer()
+	{
+		Stop();
+	}
+
+	/// Records the elapsed time unless the timer has already been stopped.
+	void Stop()
+	{
+		if (m_Start == 0)
+			return;
+		AcquisitionProfiler::Record(m_StageId, AcquisitionProfiler::Now() - m_Start);
+		m_Start = 0;
+		AcquisitionProfiler::DumpIfRequested();
+	}
+
+private:
+	int m_StageId;					///< Measured stage
+	unsigned long long m_Start;		///< Start time in microseconds, 0 if stopped
+
+	ScopedStageTimer(const ScopedStageTimer&);
+	ScopedStageTimer& operator=(const ScopedStageTimer&);
+};
+
+} // end namespace ipa_CameraSensors
+#endif // __IPA_ACQUISITIONPROFILER_H__
@@ -0,0 +1,402 @@
+/****************************************************************
+*
+* Copyright (c) 2026
+*
+* Fraunhofer Institute for Manufacturing Engineering
+* and Automation (IPA)
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Project name: care-o-bot
+* ROS stack name: cob_bringup_sandbox
+* ROS package name: cob_camera_sensors_ipa
+* Description: Binary log of camera frames for recording and replay.
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Date of creation: October 2026
+* ToDo:
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer.
+* * Redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution.
+* * Neither the name of the Fraunhofer Institute for Manufacturing
+* Engineering and Automation (IPA) nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License LGPL as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License LGPL for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License LGPL along with this program.
+* If not, see <http://www.gnu.org/licenses/>.
+*
+****************************************************************/
+
+/// @file FrameLog.h
+/// Binary log of range, color and cartesian frames.
+/// A frame log is a single file consisting of a <code>t_FrameLogHeader</code> followed
+/// by an append-only sequence of frame records. Each record starts with a
+/// <code>t_FrameLogRecord</code> and holds the pixel data of all recorded streams.
+/// Range images may be stored as 16 bit millimeters and streams may be LZ4 compressed
+/// when the library is built with <code>__USE_LZ4__</code>.
+/// A sidecar file <I>[log].idx</I> holds one <code>t_FrameLogIndexEntry</code> per frame,
+/// so long logs are opened without scanning. Logs are read through a memory mapping,
+/// so replay does not pay for file I/O.
+/// @date October 2026.
+
+#ifndef __IPA_FRAMELOG_H__
+#define __IPA_FRAMELOG_H__
+
+#ifdef __LINUX__
+	#include <cob_camera_sensors/AbstractRangeImagingSensor.h>
+#else
+	#include <cob_driver/cob_camera_sensors/common/include/cob_camera_sensors/AbstractRangeImagingSensor.h>
+#endif
+
+#include <opencv2/core/core.hpp>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <deque>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ipa_CameraSensors {
+
+/// Image streams that may be stored in a frame log.
+enum t_FrameLogStream
+{
+	FRAMELOG_RANGE = 0,		///< Range image
+	FRAMELOG_COLOR,			///< Color, intensity or amplitude image
+	FRAMELOG_CARTESIAN,		///< Cartesian image
+	FRAMELOG_NUM_STREAMS
+};
+
+/// Storage encoding of a stream.
+enum t_FrameLogEncoding
+{
+	FRAMELOG_ENCODING_RAW = 0,		///< Pixel data as delivered by the driver
+	FRAMELOG_ENCODING_DEPTH_16U_MM	///< CV_32FC1 range in meters stored as unsigned 16 bit millimeters, 0 marks invalid pixels
+};
+
+/// Magic number at the beginning of each frame log file.
+static const char FRAMELOG_MAGIC[8] = {'I', 'P', 'A', 'F', 'L', 'O', 'G', '\0'};
+/// Current version of the frame log format.
+static const unsigned int FRAMELOG_VERSION = 2;
+/// Sync word at the beginning of each frame record.
+static const unsigned int FRAMELOG_RECORD_MAGIC = 0x4D415246; // "FRAM"
+
+/// Flags of <code>t_FrameLogHeader::m_Flags</code>.
+enum t_FrameLogHeaderFlags
+{
+	FRAMELOG_HAS_INTRINSICS = 0x1,	///< <code>m_IntrinsicMatrix</code> is valid
+	FRAMELOG_HAS_EXTRINSICS = 0x2	///< <code>m_ExtrinsicMatrix</code> is valid
+};
+
+/// File header of a frame log.
+struct t_FrameLogHeader
+{
+	char m_Magic[8];							///< Equals <code>FRAMELOG_MAGIC</code>
+	unsigned int m_Version;						///< Format version
+	unsigned int m_HeaderSize;					///< Size of the file header in bytes, the first record starts at this offset
+	int m_CameraType;							///< <code>t_cameraType</code> of the recorded sensor
+	unsigned int m_Flags;						///< Combination of <code>t_FrameLogHeaderFlags</code>
+	int m_Width[FRAMELOG_NUM_STREAMS];			///< Image width per stream, 0 if the stream is not recorded
+	int m_Height[FRAMELOG_NUM_STREAMS];			///< Image height per stream, 0 if the stream is not recorded
+	int m_Type[FRAMELOG_NUM_STREAMS];			///< OpenCV matrix type per stream as returned by the reader
+	int m_Encoding[FRAMELOG_NUM_STREAMS];		///< <code>t_FrameLogEncoding</code> per stream
+	double m_IntrinsicMatrix[9];				///< Intrinsic parameters [fx 0 cx; 0 fy cy; 0 0 1], row major
+	double m_ExtrinsicMatrix[12];				///< Extrinsic parameters [R|t], row major
+};
+
+/// Header of a single frame record.
+/// The payload of all streams flagged in <code>m_StreamMask</code> follows in stream order,
+/// each stored row by row without padding and padded to a multiple of 8 bytes.
+struct t_FrameLogRecord
+{
+	unsigned int m_Magic;						///< Equals <code>FRAMELOG_RECORD_MAGIC</code>
+	unsigned int m_StreamMask;					///< Bit i is set if stream i is present in this record
+	double m_Timestamp;							///< Acquisition time in seconds
+	unsigned int m_Size[FRAMELOG_NUM_STREAMS];	///< Stored payload size per stream in bytes
+	unsigned int m_CompressedMask;				///< Bit i is set if the payload of stream i is LZ4 compressed
+};
+
+/// Entry of the index file <I>[log].idx</I>.
+struct t_FrameLogIndexEntry
+{
+	unsigned long long m_Offset;				///< Offset of the frame record within the log
+	double m_Timestamp;							///< Acquisition time in seconds
+};
+
+/// Options for writing a frame log.
+struct t_FrameLogOptions
+{
+	bool m_Depth16U;			///< Store CV_32FC1 range images as 16 bit millimeters
+	bool m_Compress;			///< Compress streams with LZ4, ignored without <code>__USE_LZ4__</code>
+	unsigned int m_QueueSize;	///< Number of frames buffered for the background writer, 0 writes synchronously
+
+	t_FrameLogOptions()
+		: m_Depth16U(true), m_Compress(false), m_QueueSize(16)
+	{}
+};
+
+/// Appends frames to a frame log file.
+/// With a non-zero queue size, <code>Write()</code> only copies the images into preallocated
+/// buffers and a background thread encodes and writes them. When the writer falls behind,
+/// frames are dropped instead of stalling acquisition.
+class __DLL_LIBCAMERASENSORS__ FrameLogWriter
+{
+public:
+
+	FrameLogWriter();
+	~FrameLogWriter();
+
+	/// Creates the log file and its index. Existing files are overwritten.
+	/// @param filename Path to the log file.
+	/// @param cameraType Type of the camera that is recorded.
+	/// @param options Encoding and buffering options.
+	/// @return Return code.
+	unsigned long Open(const std::string& filename, t_cameraType cameraType,
+		const t_FrameLogOptions& options = t_FrameLogOptions());
+
+	/// Writes all queued frames, then closes the log file.
+	/// @return Return code.
+	unsigned long Close();
+
+	/// Returns true, when a log file is open for writing.
+	bool isOpen() {return m_File.is_open();}
+
+	/// Stores the camera calibration in the file header.
+	/// Has to be called before the first frame is written.
+	/// @param intrinsicMatrix 3x3 intrinsic matrix of type CV_64FC1 or an empty matrix.
+	/// @param extrinsicMatrix 3x4 or 4x4 extrinsic matrix of type CV_64FC1 or an empty matrix.
+	/// @return Return code.
+	unsigned long SetCalibration(const cv::Mat& intrinsicMatrix, const cv::Mat& extrinsicMatrix);
+
+	/// Appends one frame to the log.
+	/// The image geometry of each stream is fixed by the first written frame.
+	/// Streams that are passed as NULL or as empty matrix are omitted from the record.
+	/// A frame that does not match that geometry, e.g. with a stream absent from the
+	/// first frame, is rejected with <code>RET_FAILED</code> and later frames are still written.
+	/// Use <code>HasFailed()</code> to tell a rejected frame from an I/O error.
+	/// @param timestamp Acquisition time in seconds.
+	/// @param rangeImage Range image or NULL.
+	/// @param colorImage Color or intensity image or NULL.
+	/// @param cartesianImage Cartesian image or NULL.
+	/// @return Return code. Returns <code>RET_OK</code> if the frame has been dropped because the queue was full.
+	unsigned long Write(double timestamp, const cv::Mat* rangeImage, const cv::Mat* colorImage, const cv::Mat* cartesianImage);
+
+	/// Returns the number of frames written since <code>Open()</code>.
+	size_t GetNumberOfFrames();
+
+	/// Returns the number of frames dropped since <code>Open()</code> because the background writer fell behind.
+	size_t GetNumberOfDroppedFrames();
+
+	/// Returns the number of frames rejected by <code>Write()</code> since <code>Open()</code>.
+	size_t GetNumberOfRejectedFrames();
+
+	/// Returns true after an I/O error, all further writes fail then.
+	bool HasFailed();
+
+private:
+
+	/// Frame waiting for the background writer.
+	struct t_QueuedFrame
+	{
+		double m_Timestamp;
+		cv::Mat m_Images[FRAMELOG_NUM_STREAMS];
+		bool m_Valid[FRAMELOG_NUM_STREAMS];
+	};
+
+	/// Takes the image geometry and encoding of each stream from the first frame.
+	/// @return Return code, <code>RET_FAILED</code> if the frame contains no image.
+	unsigned long FixGeometry(const cv::Mat* const images[FRAMELOG_NUM_STREAMS]);
+
+	/// Counts a frame rejected by <code>Write()</code>, reporting the first one.
+	/// @param reason Description of the mismatch.
+	/// @return <code>RET_FAILED</code>
+	unsigned long RejectFrame(const std::string& reason);
+
+	/// Writes the file header.
+	void WriteHeader();
+
+	/// Encodes and writes one frame record and its index entry.
+	unsigned long WriteRecord(double timestamp, const cv::Mat* const images[FRAMELOG_NUM_STREAMS]);
+
+	/// Encodes one stream for storage.
+	/// @param stream Stream index.
+	/// @param image Image of the stream.
+	/// @param size Returns the size of the encoded data.
+	/// @param compressed Returns true if the encoded data is LZ4 compressed.
+	/// @return Pointer to the encoded data, valid until the stream is encoded again.
+	const char* EncodeStream(int stream, const cv::Mat& image, size_t& size, bool& compressed);
+
+	/// Main loop of the background writer.
+	void WriterThread();
+
+	std::ofstream m_File;				///< Output file
+	std::ofstream m_IndexFile;			///< Index of the output file
+	std::string m_Filename;				///< Path of the output file
+	t_FrameLogOptions m_Options;		///< Encoding and buffering options
+	t_FrameLogHeader m_Header;			///< Header of the output file
+	bool m_GeometryFixed;				///< True, when <code>Write()</code> has taken the geometry from the first frame
+	bool m_HeaderWritten;				///< True, when the header has been written
+	unsigned long long m_Offset;		///< Offset of the next record
+	size_t m_NumberOfFrames;			///< Number of frames written, guarded by <code>m_QueueMutex</code>
+	size_t m_NumberOfDroppedFrames;		///< Number of frames dropped because the queue was full, guarded by <code>m_QueueMutex</code>
+	size_t m_NumberOfRejectedFrames;	///< Number of frames not matching the first frame, guarded by <code>m_QueueMutex</code>
+	bool m_WriteFailed;					///< Set on I/O errors, guarded by <code>m_QueueMutex</code>
+
+	std::vector<char> m_ScratchBuffer[FRAMELOG_NUM_STREAMS];	///< Converted stream data of the current record
+	std::vector<char> m_EncodeBuffer[FRAMELOG_NUM_STREAMS];	///< Compressed stream data of the current record
+
+	boost::shared_ptr<boost::thread> m_WriterThread;	///< Background writer, only when buffering
+	boost::mutex m_QueueMutex;							///< Protects the queues
+	boost::condition_variable m_QueueCondition;			///< Signals new frames and free buffers
+	std::vector<t_QueuedFrame> m_Frames;				///< Preallocated frame buffers
+	std::deque<size_t> m_FreeFrames;					///< Indices of unused frame buffers
+	std::deque<size_t> m_PendingFrames;					///< Indices of frames waiting to be written
+	bool m_StopWriter;									///< Requests the background writer to terminate
+};
+
+/// Provides random access to the frames of a memory-mapped frame log.
+class __DLL_LIBCAMERASENSORS__ FrameLogReader
+{
+public:
+
+	FrameLogReader();
+	~FrameLogReader();
+
+	/// Maps the log file into memory and indexes its frames.
+	/// Records are taken from the index file, records missing in the index, e.g. from an
+	/// interrupted recording, are recovered by scanning. A truncated last record is ignored.
+	/// @param filename Path to the log file.
+	/// @return Return code.
+	unsigned long Open(const std::string& filename);
+
+	/// Unmaps the log file.
+	/// @return Return code.
+	unsigned long Close();
+
+	/// Returns true, when a log file is mapped.
+	bool isOpen() {return m_open;}
+
+	/// Returns the file header of the log.
+	const t_FrameLogHeader& GetHeader() const {return m_Header;}
+
+	/// Returns the intrinsic matrix stored in the header or an empty matrix.
+	cv::Mat GetIntrinsicMatrix() const;
+
+	/// Returns the 3x4 extrinsic matrix stored in the header or an empty matrix.
+	cv::Mat GetExtrinsicMatrix() const;
+
+	/// Returns the number of complete frames in the log.
+	size_t GetNumberOfFrames() const {return m_Records.size();}
+
+	/// Returns the acquisition time of frame <code>index</code> in seconds.
+	double GetTimestamp(size_t index) const;
+
+	/// Returns true, if stream <code>stream</code> is recorded in the log.
+	bool HasStream(t_FrameLogStream stream) const {return m_Header.m_Width[stream] > 0 && m_Header.m_Height[stream] > 0;}
+
+	/// Decodes the images of frame <code>index</code> into the given matrices.
+	/// The matrices are (re)allocated only if their size or type does not match.
+	/// Matrices of streams that are missing in the frame are released.
+	/// @param index Frame index.
+	/// @param rangeImage Range image or NULL.
+	/// @param colorImage Color or intensity image or NULL.
+	/// @param cartesianImage Cartesian image or NULL.
+	/// @return Return code.
+	unsigned long GetFrame(size_t index, cv::Mat* rangeImage, cv::Mat* colorImage, cv::Mat* cartesianImage);
+
+private:
+
+	/// Reads the index file and returns the offset at which scanning has to continue.
+	size_t ReadIndex(const std::string& filename, size_t fileSize);
+
+	/// Returns the size of the record at <code>offset</code> or 0 if there is no complete record.
+	size_t GetRecordSize(size_t offset, size_t fileSize) const;
+
+	/// Decodes one stream of a frame into <code>image</code>.
+	unsigned long DecodeStream(size_t index, t_FrameLogStream stream, cv::Mat& image);
+
+	boost::interprocess::file_mapping m_Mapping;	///< File mapping of the log
+	boost::interprocess::mapped_region m_Region;	///< Mapped view of the complete log
+	const char* m_Data;								///< Start of the mapped log
+	t_FrameLogHeader m_Header;						///< Copy of the file header
+	std::vector<size_t> m_Records;					///< Offsets of the frame records within the file
+	std::vector<char> m_DecodeBuffer;				///< Temporary storage for decompression
+	bool m_open;									///< True, when a log is mapped
+};
+
+/// Paces the replay of a frame log.
+/// Frames are released at their recorded timing scaled by the playback speed.
+/// A playback speed of 0 returns all frames in order without waiting, which makes
+/// replay deterministic for profiling.
+class __DLL_LIBCAMERASENSORS__ FrameLogPlayer
+{
+public:
+
+	FrameLogPlayer();
+
+	/// Starts replay of <code>reader</code> from the first frame.
+	/// @param reader The log to replay. Must outlive the player.
+	/// @param playbackSpeed Factor applied to the recorded timing, 0 for unthrottled replay.
+	/// @param loop Restart at the first frame after the last frame has been returned.
+	void Reset(const FrameLogReader* reader, double playbackSpeed, bool loop);
+
+	/// Waits until the next frame is due and returns its index.
+	/// @param getLatestFrame If true, frames whose time has already passed are skipped,
+	///						  as a camera would drop them. Ignored for unthrottled replay.
+	/// @return Frame index or -1, when the end of a non-looping log has been reached.
+	long NextFrame(bool getLatestFrame);
+
+private:
+
+	/// Returns the wall clock time at which frame <code>index</code> is due.
+	boost::posix_time::ptime DueTime(size_t index) const;
+
+	const FrameLogReader* m_Reader;				///< The log that is replayed
+	double m_PlaybackSpeed;						///< Factor applied to the recorded timing
+	bool m_Loop;								///< Restart after the last frame
+	size_t m_NextFrame;							///< Index of the next frame to return
+	boost::posix_time::ptime m_StartTime;		///< Wall clock time at which the first frame was returned
+};
+
+/// Reads the replay parameters of a virtual camera from the xml configuration file.
+/// Reads the tags <code>Path</code>, <code>PlaybackSpeed</code> and <code>Loop</code>
+/// below the tag <code>LibCameraSensors->cameraTag</code>.
+/// A relative path is interpreted relative to the directory of the configuration file.
+/// @param filename The path to the configuration file.
+/// @param cameraTag Tag of the camera, e.g. <code>ReplayRangeCam_0</code>.
+/// @param path Path to the frame log.
+/// @param playbackSpeed Factor applied to the recorded timing.
+/// @param loop Restart replay after the last frame.
+/// @return Return code.
+__DLL_LIBCAMERASENSORS__ unsigned long LoadFrameLogReplayParameters(const char* filename, const std::string& cameraTag,
+	std::string& path, double& playbackSpeed, bool& loop);
+
+} // end namespace ipa_CameraSensors
+#endif // __IPA_FRAMELOG_H__
@@ -13,6 +13,12 @@
 	#include <cob_driver/cob_camera_sensors/common/include/cob_camera_sensors/AbstractRangeImagingSensor.h>
 #endif
 
+#ifdef __LINUX__
+	#include "cob_camera_sensors_ipa/UndistortMapCache.h"
+#else
+	#include "cob_bringup_sandbox/cob_camera_sensors_ipa/common/include/cob_camera_sensors_ipa/UndistortMapCache.h"
+#endif
+
 #include <pmdsdk2.h>
 
 #ifdef __LINUX__
@@ -62,6 +68,10 @@ public:
 
 	unsigned long SaveParameters(const char* filename);
 
+	/// Stores the undistortion maps additionally in fixed point for integer remapping.
+	unsigned long SetIntrinsics(cv::Mat& intrinsicMatrix,
+		cv::Mat& undistortMapX, cv::Mat& undistortMapY);
+
 	bool isInitialized() {return m_initialized;}
 	bool isOpen() {return m_open;}
 
@@ -101,6 +111,12 @@ private:
 	cv::Mat m_CoeffsA4; ///< a4 z-calibration parameters. One matrix entry corresponds to one pixel
 	cv::Mat m_CoeffsA5; ///< a5 z-calibration parameters. One matrix entry corresponds to one pixel
 	cv::Mat m_CoeffsA6; ///< a6 z-calibration parameters. One matrix entry corresponds to one pixel
+
+	UndistortMapCache m_UndistortMaps;	///< Fixed-point version of m_undistortMapX/Y
+	cv::Mat m_LensIntrinsics;			///< Optional intrinsics from the configuration file
+	cv::Mat m_LensDistortion;			///< Optional distortion coefficients (k1, k2, p1, p2) from the configuration file
+	std::string m_UndistortMapDirectory;	///< Cache directory of the undistortion maps
+	cv::Mat m_DistortedData;			///< Buffer for the distorted image during undistortion
 };
 
 /// Creates, intializes and returns a smart pointer object for the camera.
@@ -0,0 +1,143 @@
+/****************************************************************
+*
+* Copyright (c) 2026
+*
+* Fraunhofer Institute for Manufacturing Engineering
+* and Automation (IPA)
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Project name: care-o-bot
+* ROS stack name: cob_bringup_sandbox
+* ROS package name: cob_camera_sensors_ipa
+* Description: Image processing kernels shared by the camera drivers.
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Date of creation: October 2026
+* ToDo:
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer.
+* * Redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution.
+* * Neither the name of the Fraunhofer Institute for Manufacturing
+* Engineering and Automation (IPA) nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License LGPL as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License LGPL for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License LGPL along with this program.
+* If not, see <http://www.gnu.org/licenses/>.
+*
+****************************************************************/
+
+/// @file ProcessingKernels.h
+/// Image processing kernels shared by the camera drivers.
+/// The kernels operate on plain memory, so they can be run and benchmarked without hardware.
+/// @date October 2026.
+
+#ifndef __IPA_PROCESSINGKERNELS_H__
+#define __IPA_PROCESSINGKERNELS_H__
+
+#ifdef __LINUX__
+	#include <cob_camera_sensors/AbstractRangeImagingSensor.h>
+#else
+	#include <cob_driver/cob_camera_sensors/common/include/cob_camera_sensors/AbstractRangeImagingSensor.h>
+#endif
+
+#include <opencv2/core/core.hpp>
+
+#include <vector>
+
+namespace ipa_CameraSensors {
+
+/// Interpolation used for Bayer demosaicing.
+enum t_DebayeringMethod
+{
+	DEBAYERING_BILINEAR = 0,			///< Bilinear interpolation
+	DEBAYERING_EDGE_AWARE,				///< Interpolation along the smaller gradient
+	DEBAYERING_EDGE_AWARE_WEIGHTED		///< Interpolation weighted by the gradients
+};
+
+/// Converts a YUV422 (UYVY) image to 24 bit RGB.
+/// The source image may be larger than the destination image by an even integer factor
+/// in both dimensions, in which case it is subsampled.
+/// @param yuvData Source image data.
+/// @param yuvWidth Width of the source image.
+/// @param yuvHeight Height of the source image.
+/// @param rgbData Destination image data, <code>3*width*height</code> bytes.
+/// @param width Width of the destination image.
+/// @param height Height of the destination image.
+/// @return Return code.
+__DLL_LIBCAMERASENSORS__ unsigned long ConvertYUV422ToRGB(const unsigned char* yuvData, unsigned yuvWidth, unsigned yuvHeight,
+	unsigned char* rgbData, unsigned width, unsigned height);
+
+/// Demosaics an 8 bit Bayer image with GRBG pattern to 24 bit RGB.
+/// @param bayerData Source image data.
+/// @param width Image width.
+/// @param height Image height.
+/// @param rgbData Destination image data, <code>3*width*height</code> bytes.
+/// @param debayeringMethod Interpolation method.
+/// @return Return code.
+__DLL_LIBCAMERASENSORS__ unsigned long ConvertBayerGRBGToRGB(const unsigned char* bayerData, unsigned width, unsigned height,
+	unsigned char* rgbData, t_DebayeringMethod debayeringMethod = DEBAYERING_EDGE_AWARE_WEIGHTED);
+
+/// Swaps the first and the third channel of a 3 channel 8 bit image in place.
+/// @param data Image data.
+/// @param width Image width.
+/// @param height Image height.
+/// @param widthStep Line width of the image in bytes.
+__DLL_LIBCAMERASENSORS__ void SwapRedBlueChannels(unsigned char* data, unsigned width, unsigned height, int widthStep);
+
+/// Converts a depth image in millimeters to a range image in meters.
+/// @param depthImage Depth image of type CV_16UC1 in millimeters, 0 marks invalid pixels.
+/// @param rangeData Destination image data of type float.
+/// @param widthStep Line width of the destination image in bytes.
+/// @param badDepth Value written for invalid pixels.
+/// @return Return code.
+__DLL_LIBCAMERASENSORS__ unsigned long ConvertDepthToRange(const cv::Mat& depthImage, char* rangeData, int widthStep,
+	unsigned short badDepth = 0);
+
+/// Back-projects a depth image in millimeters to a cartesian image in meters using the pinhole model.
+/// Invalid pixels are set to (0, 0, 0).
+/// @param depthImage Depth image of type CV_16UC1 in millimeters.
+/// @param fx Focal length in x direction in pixels.
+/// @param fy Focal length in y direction in pixels.
+/// @param cx Principal point x coordinate.
+/// @param cy Principal point y coordinate.
+/// @param cartesianData Destination image data with 3 floats per pixel.
+/// @param widthStep Line width of the destination image in bytes.
+/// @param badDepth Depth value of invalid pixels.
+/// @return Return code.
+__DLL_LIBCAMERASENSORS__ unsigned long ConvertDepthToCartesian(const cv::Mat& depthImage, double fx, double fy, double cx, double cy,
+	char* cartesianData, int widthStep, unsigned short badDepth = 0);
+
+/// Applies a per-pixel polynomial calibration to a range image.
+/// Pixel (v,u) is mapped to sum_i coefficients[i](v,u) * raw(v,u)^i, as done with the
+/// 6 degree z calibration of time-of-flight cameras.
+/// @param rawRange Raw range image of type CV_32FC1.
+/// @param coefficients Polynomial coefficients, one CV_64FC1 image per degree starting with degree 0.
+/// @param calibratedRange Calibrated range image of type CV_32FC1, allocated on demand.
+/// @return Return code.
+__DLL_LIBCAMERASENSORS__ unsigned long EvaluateRangePolynomial(const cv::Mat& rawRange, const std::vector<cv::Mat>& coefficients,
+	cv::Mat& calibratedRange);
+
+} // end namespace ipa_CameraSensors
+#endif // __IPA_PROCESSINGKERNELS_H__
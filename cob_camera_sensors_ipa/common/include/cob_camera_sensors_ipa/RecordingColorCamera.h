@@ -0,0 +1,158 @@
+/****************************************************************
+*
+* Copyright (c) 2026
+*
+* Fraunhofer Institute for Manufacturing Engineering
+* and Automation (IPA)
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Project name: care-o-bot
+* ROS stack name: cob_bringup_sandbox
+* ROS package name: cob_camera_sensors_ipa
+* Description: Records the frames of any color camera to a frame log.
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Date of creation: October 2026
+* ToDo:
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer.
+* * Redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution.
+* * Neither the name of the Fraunhofer Institute for Manufacturing
+* Engineering and Automation (IPA) nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License LGPL as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License LGPL for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License LGPL along with this program.
+* If not, see <http://www.gnu.org/licenses/>.
+*
+****************************************************************/
+/// @file RecordingColorCamera.h
+/// Recording tap for color cameras.
+/// @date October 2026.
+
+#ifndef __IPA_RECORDINGCOLORCAMERA_H__
+#define __IPA_RECORDINGCOLORCAMERA_H__
+
+#ifdef __LINUX__
+	#include <cob_camera_sensors/AbstractColorCamera.h>
+	#include "cob_camera_sensors_ipa/FrameLog.h"
+#else
+	#include <cob_driver/cob_camera_sensors/common/include/cob_camera_sensors/AbstractColorCamera.h>
+	#include "cob_bringup_sandbox/cob_camera_sensors_ipa/common/include/cob_camera_sensors_ipa/FrameLog.h"
+#endif
+
+namespace ipa_CameraSensors {
+
+/// @ingroup ColorCameraDriver
+/// Recording tap for color cameras.
+/// Wraps an arbitrary driver, forwards all calls to it and appends every image
+/// acquired through <code>GetColorImage</code> to the color stream of a frame log while recording is active.
+/// The resulting log is replayed with <code>ReplayColorCam</code>.
+/// @code
+/// AbstractColorCameraPtr camera = CreateColorCamera_AxisCam();
+/// boost::shared_ptr<RecordingColorCamera> recorder(new RecordingColorCamera(camera));
+/// recorder->Init(directory);
+/// recorder->Open();
+/// recorder->StartRecording("axis.flog");
+/// @endcode
+class __DLL_LIBCAMERASENSORS__ RecordingColorCamera : public AbstractColorCamera
+{
+public:
+
+	/// Constructor
+	/// @param camera The driver that is recorded.
+	RecordingColorCamera(AbstractColorCameraPtr camera);
+	~RecordingColorCamera();
+
+	//*******************************************************************************
+	// AbstractColorCamera interface implementation
+	//*******************************************************************************
+
+	unsigned long Init(std::string directory, int cameraIndex = 0);
+
+	bool isInitialized();
+	bool isOpen();
+
+	unsigned long Open();
+	unsigned long Close();
+
+	/// Forwarded to the wrapped camera.
+	/// While recording, the image is acquired through the cv::Mat interface
+	/// and copied to <code>colorImageData</code>, so it is recorded as well.
+	unsigned long GetColorImage(char* colorImageData, bool getLatestFrame=true);
+	unsigned long GetColorImage(cv::Mat* colorImage, bool getLatestFrame=true);
+
+	t_cameraType GetCameraType();
+
+	unsigned long SetProperty(t_cameraProperty* cameraProperty);
+	unsigned long SetPropertyDefaults();
+	unsigned long GetProperty(t_cameraProperty* cameraProperty);
+
+	unsigned long PrintCameraInformation();
+	unsigned long SaveParameters(const char* filename);
+	unsigned long TestCamera(const char* filename);
+
+	int GetNumberOfImages();
+	unsigned long SetPathToImages(std::string path);
+
+	//*******************************************************************************
+	// Recording
+	//*******************************************************************************
+
+	/// Starts recording all subsequently acquired images.
+	/// Frames are written by a background thread unless <code>options.m_QueueSize</code> is 0,
+	/// so recording never stalls acquisition. Frames that cannot be queued are dropped,
+	/// frames not matching the geometry of the first one are skipped. Only an I/O error stops recording.
+	/// @param filename Path to the frame log. An existing file is overwritten.
+	/// @param options Encoding and buffering options.
+	/// @param intrinsicMatrix Optional 3x3 intrinsic matrix that is stored in the log header.
+	/// @param extrinsicMatrix Optional 3x4 extrinsic matrix that is stored in the log header.
+	/// @return Return code.
+	unsigned long StartRecording(const std::string& filename, const t_FrameLogOptions& options = t_FrameLogOptions(),
+		const cv::Mat& intrinsicMatrix = cv::Mat(), const cv::Mat& extrinsicMatrix = cv::Mat());
+
+	/// Stops recording and closes the frame log.
+	/// @return Return code.
+	unsigned long StopRecording();
+
+	/// Returns true, while frames are recorded.
+	bool isRecording() {return m_Writer.isOpen();}
+
+	/// Returns the wrapped camera.
+	AbstractColorCameraPtr GetCamera() {return m_Camera;}
+
+private:
+
+	AbstractColorCameraPtr m_Camera;	///< The recorded driver
+	FrameLogWriter m_Writer;			///< Output log while recording
+	cv::Mat m_ColorMat;					///< Temporary storage for the char* interface
+};
+
+/// Creates and returns a smart pointer to a recording tap attached to <code>camera</code>.
+/// @param camera The driver that is recorded.
+/// @return Smart pointer, refering to the generated object
+__DLL_LIBCAMERASENSORS__ AbstractColorCameraPtr CreateColorCamera_Recording(AbstractColorCameraPtr camera);
+
+} // End namespace ipa_CameraSensors
+#endif // __IPA_RECORDINGCOLORCAMERA_H__
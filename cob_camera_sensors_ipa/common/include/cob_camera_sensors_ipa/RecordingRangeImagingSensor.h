@@ -0,0 +1,165 @@
+/****************************************************************
+*
+* Copyright (c) 2026
+*
+* Fraunhofer Institute for Manufacturing Engineering
+* and Automation (IPA)
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Project name: care-o-bot
+* ROS stack name: cob_bringup_sandbox
+* ROS package name: cob_camera_sensors_ipa
+* Description: Records the frames of any range imaging sensor to a frame log.
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Date of creation: October 2026
+* ToDo:
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer.
+* * Redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution.
+* * Neither the name of the Fraunhofer Institute for Manufacturing
+* Engineering and Automation (IPA) nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License LGPL as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License LGPL for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License LGPL along with this program.
+* If not, see <http://www.gnu.org/licenses/>.
+*
+****************************************************************/
+
+/// @file RecordingRangeImagingSensor.h
+/// Recording tap for range imaging sensors.
+/// @date October 2026.
+
+#ifndef __IPA_RECORDINGRANGEIMAGINGSENSOR_H__
+#define __IPA_RECORDINGRANGEIMAGINGSENSOR_H__
+
+#ifdef __LINUX__
+	#include <cob_camera_sensors/AbstractRangeImagingSensor.h>
+	#include "cob_camera_sensors_ipa/FrameLog.h"
+#else
+	#include <cob_driver/cob_camera_sensors/common/include/cob_camera_sensors/AbstractRangeImagingSensor.h>
+	#include "cob_bringup_sandbox/cob_camera_sensors_ipa/common/include/cob_camera_sensors_ipa/FrameLog.h"
+#endif
+
+namespace ipa_CameraSensors {
+
+/// @ingroup RangeCameraDriver
+/// Recording tap for range imaging sensors.
+/// Wraps an arbitrary driver, forwards all calls to it and appends every frame
+/// acquired through <code>AcquireImages</code> to a frame log while recording is active.
+/// The resulting log is replayed with <code>ReplayRangeCam</code>.
+/// @code
+/// AbstractRangeImagingSensorPtr sensor = CreateRangeImagingSensor_Kinect();
+/// boost::shared_ptr<RecordingRangeImagingSensor> recorder(new RecordingRangeImagingSensor(sensor));
+/// recorder->Init(directory);
+/// recorder->Open();
+/// recorder->StartRecording("kinect.flog");
+/// @endcode
+class __DLL_LIBCAMERASENSORS__ RecordingRangeImagingSensor : public AbstractRangeImagingSensor
+{
+public:
+
+	/// Constructor
+	/// @param sensor The driver that is recorded.
+	RecordingRangeImagingSensor(AbstractRangeImagingSensorPtr sensor);
+	~RecordingRangeImagingSensor();
+
+	//*******************************************************************************
+	// AbstractRangeImagingSensor interface implementation
+	//*******************************************************************************
+
+	unsigned long Init(std::string directory, int cameraIndex = 0);
+
+	unsigned long Open();
+	unsigned long Close();
+
+	unsigned long SetProperty(t_cameraProperty* cameraProperty);
+	unsigned long SetPropertyDefaults();
+	unsigned long GetProperty(t_cameraProperty* cameraProperty);
+
+	/// Forwarded to the wrapped sensor.
+	/// While recording, the images are acquired through the cv::Mat interface
+	/// and copied to the buffers, so they are recorded as well.
+	unsigned long AcquireImages(int widthStepRange, int widthStepGray, int widthStepCartesian, char* rangeImage=NULL, char* grayImage=NULL,
+		char* cartesianImage=NULL, bool getLatestFrame=true, bool undistort=true,
+		ipa_CameraSensors::t_ToFGrayImageType grayImageType = ipa_CameraSensors::INTENSITY_32F1);
+	unsigned long AcquireImages(cv::Mat* rangeImage = 0, cv::Mat* grayImage = 0,
+		cv::Mat* cartesianImage = 0, bool getLatestFrame = true, bool undistort = true,
+		ipa_CameraSensors::t_ToFGrayImageType grayImageType = ipa_CameraSensors::INTENSITY_32F1);
+
+	unsigned long SaveParameters(const char* filename);
+
+	bool isInitialized();
+	bool isOpen();
+
+	t_cameraType GetCameraType();
+
+	unsigned long SetIntrinsics(cv::Mat& intrinsicMatrix,
+		cv::Mat& undistortMapX, cv::Mat& undistortMapY);
+
+	//*******************************************************************************
+	// Recording
+	//*******************************************************************************
+
+	/// Starts recording all subsequently acquired frames.
+	/// The intrinsics passed to <code>SetIntrinsics()</code> are stored in the log header.
+	/// Frames are written by a background thread unless <code>options.m_QueueSize</code> is 0,
+	/// so recording never stalls acquisition. Frames that cannot be queued are dropped,
+	/// frames not matching the geometry of the first one are skipped. Only an I/O error stops recording.
+	/// @param filename Path to the frame log. An existing file is overwritten.
+	/// @param options Encoding and buffering options.
+	/// @param extrinsicMatrix Optional 3x4 extrinsic matrix that is stored in the log header.
+	/// @return Return code.
+	unsigned long StartRecording(const std::string& filename, const t_FrameLogOptions& options = t_FrameLogOptions(),
+		const cv::Mat& extrinsicMatrix = cv::Mat());
+
+	/// Stops recording and closes the frame log.
+	/// @return Return code.
+	unsigned long StopRecording();
+
+	/// Returns true, while frames are recorded.
+	bool isRecording() {return m_Writer.isOpen();}
+
+	/// Returns the wrapped sensor.
+	AbstractRangeImagingSensorPtr GetSensor() {return m_Sensor;}
+
+private:
+
+	AbstractRangeImagingSensorPtr m_Sensor;	///< The recorded driver
+	FrameLogWriter m_Writer;				///< Output log while recording
+	cv::Mat m_RecordedIntrinsicMatrix;		///< Intrinsics of the recorded driver for the log header
+
+	cv::Mat m_RangeMat;						///< Temporary storage for the char* interface
+	cv::Mat m_GrayMat;						///< Temporary storage for the char* interface
+	cv::Mat m_CartesianMat;					///< Temporary storage for the char* interface
+};
+
+/// Creates and returns a smart pointer to a recording tap attached to <code>sensor</code>.
+/// @param sensor The driver that is recorded.
+/// @return Smart pointer, refering to the generated object
+__DLL_LIBCAMERASENSORS__ AbstractRangeImagingSensorPtr CreateRangeImagingSensor_Recording(AbstractRangeImagingSensorPtr sensor);
+
+} // End namespace ipa_CameraSensors
+#endif // __IPA_RECORDINGRANGEIMAGINGSENSOR_H__
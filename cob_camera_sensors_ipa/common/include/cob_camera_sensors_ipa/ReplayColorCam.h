@@ -0,0 +1,193 @@
+/****************************************************************
+*
+* Copyright (c) 2026
+*
+* Fraunhofer Institute for Manufacturing Engineering
+* and Automation (IPA)
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Project name: care-o-bot
+* ROS stack name: cob_bringup_sandbox
+* ROS package name: cob_camera_sensors_ipa
+* Description: Virtual color camera replaying a frame log.
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Date of creation: October 2026
+* ToDo:
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer.
+* * Redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution.
+* * Neither the name of the Fraunhofer Institute for Manufacturing
+* Engineering and Automation (IPA) nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License LGPL as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License LGPL for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License LGPL along with this program.
+* If not, see <http://www.gnu.org/licenses/>.
+*
+****************************************************************/
+
+/// @file ReplayColorCam.h
+/// Virtual color camera that replays the color stream of a frame log.
+/// @date October 2026.
+
+#ifndef __IPA_REPLAYCOLORCAM_H__
+#define __IPA_REPLAYCOLORCAM_H__
+
+#ifdef __LINUX__
+	#include "cob_camera_sensors/AbstractColorCamera.h"
+	#include "cob_camera_sensors_ipa/FrameLog.h"
+#else
+	#include "cob_driver/cob_camera_sensors/common/include/cob_camera_sensors/AbstractColorCamera.h"
+	#include "cob_bringup_sandbox/cob_camera_sensors_ipa/common/include/cob_camera_sensors_ipa/FrameLog.h"
+#endif
+
+namespace ipa_CameraSensors {
+
+/// Virtual color camera that replays the color stream of a frame log.
+/// Configured within <I>cameraSensorsIni.xml</I> below the tag <code>ReplayColorCam_[index]</code>
+/// with the same parameters as <code>ReplayRangeCam</code>.
+class __DLL_LIBCAMERASENSORS__ ReplayColorCam : public AbstractColorCamera
+{
+	public:
+
+		/// Constructor
+		ReplayColorCam();
+
+		/// Destructor
+		~ReplayColorCam();
+
+		/// Initializes the color camera.
+		/// Reads the replay parameters from the configuration file <I>cameraSensorsIni.xml</I>.
+		/// @param directory Path to the configuration file directory.
+		/// @param cameraIndex Index of the virtual camera within the configuration file.
+		/// @return Return code.
+		unsigned long Init(std::string directory, int cameraIndex = 0);
+
+		/// Returns true, when <code>Init()</code> has been called on the camera.
+		/// @return Camera initialized or not.
+		bool isInitialized() {return m_initialized;}
+
+		/// Returns true, when <code>Open()</code> has been called on the camera.
+		/// @return Camera opened or not.
+		bool isOpen() {return m_open;}
+
+		/// Maps the frame log and restarts replay with its first frame.
+		/// @return Return code.
+		unsigned long Open();
+
+		/// Unmaps the frame log.
+		/// @return Return code.
+		unsigned long Close();
+
+		/// Retrieves image data from the color camera.
+		/// @param colorImageData An array to be filled with image data
+		/// @param getLatestFrame True, when the latest picture has to be returned. Otherwise, the next picture
+		///						  following the last call to <code>getLatestFrame</code> is returned.
+		/// @return Return code
+		unsigned long GetColorImage(char* colorImageData, bool getLatestFrame=true);
+
+		/// Retrieves an image from the camera.
+		/// <code>cv::Mat</code> object is initialized on demand.
+		/// @param colorImage The image that has been acquired by the camera.
+		/// @param getLatestFrame If true, frames whose replay time has already passed are skipped.
+		/// @return Return code
+		unsigned long GetColorImage(cv::Mat* colorImage, bool getLatestFrame=true);
+
+		/// Returns the camera type.
+		/// @return The camera type
+		t_cameraType GetCameraType() { return m_CameraType; }
+
+		/// Function to set properties of the camera sensor.
+		/// @param cameraProperty The value of the property.
+		/// @return Return code.
+		unsigned long SetProperty(t_cameraProperty* cameraProperty) {return RET_OK;};
+
+		/// Function to set property defaults of the camera sensor.
+		/// @return Return code.
+		unsigned long SetPropertyDefaults() {return RET_OK;};
+
+		/// Function to get properties of the camera sensor.
+		/// @param cameraProperty The value of the property.
+		/// @return Return code.
+		unsigned long GetProperty(t_cameraProperty* cameraProperty);
+
+		/// Displays camera information on standard output.
+		/// @return Return code.
+		unsigned long PrintCameraInformation();
+
+		/// Saves all parameters on hard disk.
+		/// @param filename The filename of the storage.
+		/// @return Return code.
+		unsigned long SaveParameters(const char* filename) {return RET_FAILED;};
+
+		/// Unit Test for the camera interface.
+		/// Replays all frames of the log and reports the achieved frame rate.
+		/// @param filename Path to the camera initialization xml file.
+		/// @return Return code.
+		unsigned long TestCamera(const char* filename);
+
+		/// Returns the number of images in the frame log
+		/// @return The number of images in the frame log
+		int GetNumberOfImages();
+
+		/// Function specific to virtual camera.
+		/// Replaces the frame log read from the configuration file.
+		/// @param path Path to the frame log
+		/// @return Return code
+		unsigned long SetPathToImages(std::string path);
+
+	protected:
+
+		bool m_initialized; ///< True, when the camera has sucessfully been initialized.
+		bool m_open;		///< True, when the camera has sucessfully been opend.
+
+		t_cameraType m_CameraType; ///< Camera Type
+
+		unsigned int m_BufferSize; ///< Number of images, the camera buffers internally
+
+	private:
+
+		/// Loads the replay parameters from the xml configuration file.
+		/// @param filename The path to the configuration file.
+		/// @param cameraIndex Index of the virtual camera.
+		/// @return Return code.
+		unsigned long LoadParameters(const char* filename, int cameraIndex);
+
+		FrameLogReader m_Reader;		///< Memory-mapped frame log
+		FrameLogPlayer m_Player;		///< Paces the replay
+
+		std::string m_Path;				///< Path to the frame log
+		double m_PlaybackSpeed;			///< Factor applied to the recorded timing, 0 for unthrottled replay
+		bool m_Loop;					///< Restart replay after the last frame
+
+		cv::Mat m_ColorMat;				///< Temporary storage for the char* interface
+};
+
+/// Creates, intializes and returns a smart pointer object for the camera.
+/// @return Smart pointer, refering to the generated object
+__DLL_LIBCAMERASENSORS__ AbstractColorCameraPtr CreateColorCamera_ReplayColorCam();
+
+} // end namespace
+#endif // __IPA_REPLAYCOLORCAM_H__
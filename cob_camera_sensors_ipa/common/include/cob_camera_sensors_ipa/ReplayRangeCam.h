@@ -0,0 +1,146 @@
+/****************************************************************
+*
+* Copyright (c) 2026
+*
+* Fraunhofer Institute for Manufacturing Engineering
+* and Automation (IPA)
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Project name: care-o-bot
+* ROS stack name: cob_bringup_sandbox
+* ROS package name: cob_camera_sensors_ipa
+* Description: Virtual range imaging sensor replaying a frame log.
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Date of creation: October 2026
+* ToDo:
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer.
+* * Redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution.
+* * Neither the name of the Fraunhofer Institute for Manufacturing
+* Engineering and Automation (IPA) nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License LGPL as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License LGPL for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License LGPL along with this program.
+* If not, see <http://www.gnu.org/licenses/>.
+*
+****************************************************************/
+
+/// @file ReplayRangeCam.h
+/// Virtual range imaging sensor that replays a frame log.
+/// @date October 2026.
+
+#ifndef __IPA_REPLAYRANGECAM_H__
+#define __IPA_REPLAYRANGECAM_H__
+
+#ifdef __LINUX__
+	#include <cob_camera_sensors/AbstractRangeImagingSensor.h>
+	#include "cob_camera_sensors_ipa/FrameLog.h"
+#else
+	#include <cob_driver/cob_camera_sensors/common/include/cob_camera_sensors/AbstractRangeImagingSensor.h>
+	#include "cob_bringup_sandbox/cob_camera_sensors_ipa/common/include/cob_camera_sensors_ipa/FrameLog.h"
+#endif
+
+namespace ipa_CameraSensors {
+
+/// @ingroup RangeCameraDriver
+/// Virtual range imaging sensor that replays range, color and cartesian frames from a frame log.
+/// Frames are delivered at the recorded timing scaled by a playback speed, or as fast as possible
+/// for deterministic profiling of the processing that follows <code>AcquireImages</code>.
+/// Logs are created by attaching a <code>RecordingRangeImagingSensor</code> to any other driver.
+///
+/// Configuration within <I>cameraSensorsIni.xml</I>:
+/// @code
+/// <ReplayRangeCam_0>
+///		<Path value="recording.flog"/>		<!-- absolute or relative to the configuration file -->
+///		<PlaybackSpeed value="1.0"/>		<!-- optional, 0 replays without waiting -->
+///		<Loop value="true"/>				<!-- optional -->
+/// </ReplayRangeCam_0>
+/// @endcode
+class __DLL_LIBCAMERASENSORS__ ReplayRangeCam : public AbstractRangeImagingSensor
+{
+public:
+
+	ReplayRangeCam();
+	~ReplayRangeCam();
+
+	//*******************************************************************************
+	// AbstractRangeImagingSensor interface implementation
+	//*******************************************************************************
+
+	unsigned long Init(std::string directory, int cameraIndex = 0);
+
+	unsigned long Open();
+	unsigned long Close();
+
+	unsigned long SetProperty(t_cameraProperty* cameraProperty);
+	unsigned long SetPropertyDefaults();
+	unsigned long GetProperty(t_cameraProperty* cameraProperty);
+
+	unsigned long AcquireImages(int widthStepRange, int widthStepGray, int widthStepCartesian, char* rangeImage=NULL, char* grayImage=NULL,
+		char* cartesianImage=NULL, bool getLatestFrame=true, bool undistort=true,
+		ipa_CameraSensors::t_ToFGrayImageType grayImageType = ipa_CameraSensors::INTENSITY_32F1);
+	unsigned long AcquireImages(cv::Mat* rangeImage = 0, cv::Mat* grayImage = 0,
+		cv::Mat* cartesianImage = 0, bool getLatestFrame = true, bool undistort = true,
+		ipa_CameraSensors::t_ToFGrayImageType grayImageType = ipa_CameraSensors::INTENSITY_32F1);
+
+	unsigned long SaveParameters(const char* filename);
+
+	bool isInitialized() {return m_initialized;}
+	bool isOpen() {return m_open;}
+
+	/// Returns the number of frames in the replayed log.
+	/// @return The number of frames
+	int GetNumberOfImages();
+
+	/// Function specific to virtual camera.
+	/// Replaces the frame log read from the configuration file.
+	/// When the camera is open, replay restarts with the first frame of the new log.
+	/// @param path Path to the frame log
+	/// @return Return code
+	unsigned long SetPathToImages(std::string path);
+
+private:
+
+	unsigned long LoadParameters(const char* filename, int cameraIndex);
+
+	FrameLogReader m_Reader;		///< Memory-mapped frame log
+	FrameLogPlayer m_Player;		///< Paces the replay
+
+	std::string m_Path;				///< Path to the frame log
+	double m_PlaybackSpeed;			///< Factor applied to the recorded timing, 0 for unthrottled replay
+	bool m_Loop;					///< Restart replay after the last frame
+
+	cv::Mat m_RangeMat;				///< Temporary storage for the char* interface
+	cv::Mat m_GrayMat;				///< Temporary storage for the char* interface
+	cv::Mat m_CartesianMat;			///< Temporary storage for the char* interface
+};
+
+/// Creates, intializes and returns a smart pointer object for the camera.
+/// @return Smart pointer, refering to the generated object
+__DLL_LIBCAMERASENSORS__ AbstractRangeImagingSensorPtr CreateRangeImagingSensor_ReplayRangeCam();
+
+} // End namespace ipa_CameraSensors
+#endif // __IPA_REPLAYRANGECAM_H__
@@ -0,0 +1,160 @@
+/****************************************************************
+*
+* Copyright (c) 2026
+*
+* Fraunhofer Institute for Manufacturing Engineering
+* and Automation (IPA)
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Project name: care-o-bot
+* ROS stack name: cob_bringup_sandbox
+* ROS package name: cob_camera_sensors_ipa
+* Description: Disk cache of fixed-point undistortion maps.
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Date of creation: October 2026
+* ToDo:
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer.
+* * Redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution.
+* * Neither the name of the Fraunhofer Institute for Manufacturing
+* Engineering and Automation (IPA) nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License LGPL as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License LGPL for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License LGPL along with this program.
+* If not, see <http://www.gnu.org/licenses/>.
+*
+****************************************************************/
+
+/// @file UndistortMapCache.h
+/// Fixed-point undistortion and rectification maps cached on disk.
+/// The maps of a calibration are computed once as <code>CV_16SC2</code>/<code>CV_16UC1</code>
+/// remap tables and stored in a file named after a hash of the calibration. Later runs map
+/// the file into memory instead of recomputing the tables, and undistortion uses the
+/// integer code path of <code>cv::remap</code>.
+/// @date October 2026.
+
+#ifndef __IPA_UNDISTORTMAPCACHE_H__
+#define __IPA_UNDISTORTMAPCACHE_H__
+
+#ifdef __LINUX__
+	#include <cob_camera_sensors/AbstractRangeImagingSensor.h>
+#else
+	#include <cob_driver/cob_camera_sensors/common/include/cob_camera_sensors/AbstractRangeImagingSensor.h>
+#endif
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <string>
+
+namespace ipa_CameraSensors {
+
+static const char UNDISTORTMAP_MAGIC[8] = "IPAUMAP";	///< Identifies a map file
+static const unsigned int UNDISTORTMAP_VERSION = 1;		///< Version of the map file format
+
+/// Header of a map file.
+/// It is followed by the <code>CV_16SC2</code> map and the <code>CV_16UC1</code> map, both continuous.
+struct t_UndistortMapFileHeader
+{
+	char m_Magic[8];				///< Equals <code>UNDISTORTMAP_MAGIC</code>
+	unsigned int m_Version;			///< Equals <code>UNDISTORTMAP_VERSION</code>
+	unsigned int m_HeaderSize;		///< Size of this header in bytes
+	unsigned long long m_Hash;		///< Hash of the calibration the maps belong to
+	int m_Width;					///< Image width
+	int m_Height;					///< Image height
+};
+
+/// Fixed-point undistortion maps of one calibration.
+/// The maps returned by <code>GetMap1</code> and <code>GetMap2</code> may point into the
+/// mapped file and must not be used after the cache has been released.
+class __DLL_LIBCAMERASENSORS__ UndistortMapCache
+{
+public:
+	UndistortMapCache();
+	~UndistortMapCache();
+
+	/// Loads the maps of the calibration from the cache directory.
+	/// If no valid map file exists, the maps are computed and stored in the cache directory.
+	/// @param cacheDirectory Directory holding the map files, created on demand.
+	/// @param intrinsicMatrix 3x3 camera matrix.
+	/// @param distortionCoeffs Distortion coefficients (k1, k2, p1, p2[, k3]).
+	/// @param imageSize Image size.
+	/// @param rectificationMatrix Optional 3x3 rectification transformation.
+	/// @param newIntrinsicMatrix Optional camera matrix of the undistorted image, defaults to <code>intrinsicMatrix</code>.
+	/// @return Return code. The maps are valid, even if storing them in the cache failed.
+	unsigned long Load(const std::string& cacheDirectory, const cv::Mat& intrinsicMatrix, const cv::Mat& distortionCoeffs,
+		const cv::Size& imageSize, const cv::Mat& rectificationMatrix = cv::Mat(), const cv::Mat& newIntrinsicMatrix = cv::Mat());
+
+	/// Converts floating point maps, e.g. as passed to <code>SetIntrinsics</code>, to fixed point.
+	/// Maps that already are in fixed point are taken over as they are.
+	/// @param mapX Map of x coordinates (<code>CV_32FC1</code>) or <code>CV_16SC2</code> map.
+	/// @param mapY Map of y coordinates (<code>CV_32FC1</code>) or <code>CV_16UC1</code> map.
+	/// @return Return code.
+	unsigned long SetMaps(const cv::Mat& mapX, const cv::Mat& mapY);
+
+	/// Releases the maps and unmaps the file.
+	void Release();
+
+	/// Returns true if maps are available.
+	bool isValid() const {return !m_Map1.empty();}
+
+	/// Undistorts an image with the integer code path of <code>cv::remap</code>.
+	/// Source and destination must not share their data.
+	/// @param src Distorted image.
+	/// @param dst Undistorted image, allocated on demand.
+	/// @param interpolation Interpolation method, <code>cv::INTER_NEAREST</code> or <code>cv::INTER_LINEAR</code>.
+	/// @return Return code.
+	unsigned long Remap(const cv::Mat& src, cv::Mat& dst, int interpolation = cv::INTER_LINEAR) const;
+
+	const cv::Mat& GetMap1() const {return m_Map1;}		///< <code>CV_16SC2</code> integer coordinates
+	const cv::Mat& GetMap2() const {return m_Map2;}		///< <code>CV_16UC1</code> interpolation table indices
+
+	/// FNV-1a hash over the calibration parameters and the image size.
+	static unsigned long long GetCalibrationHash(const cv::Mat& intrinsicMatrix, const cv::Mat& distortionCoeffs,
+		const cv::Size& imageSize, const cv::Mat& rectificationMatrix, const cv::Mat& newIntrinsicMatrix);
+
+	/// Name of the map file of a calibration hash within the cache directory.
+	static std::string GetCacheFilename(const std::string& cacheDirectory, unsigned long long hash);
+
+private:
+	/// Maps the file and takes its maps if the file belongs to the hash and size.
+	unsigned long MapFile(const std::string& filename, unsigned long long hash, const cv::Size& imageSize);
+
+	/// Writes the current maps to a temporary file and renames it, so readers never see partial files.
+	unsigned long WriteFile(const std::string& filename, unsigned long long hash) const;
+
+	cv::Mat m_Map1;		///< <code>CV_16SC2</code> map
+	cv::Mat m_Map2;		///< <code>CV_16UC1</code> map
+
+	boost::interprocess::file_mapping m_Mapping;	///< File mapping of the map file
+	boost::interprocess::mapped_region m_Region;	///< Mapped view of the map file
+};
+
+} // end namespace ipa_CameraSensors
+#endif // __IPA_UNDISTORTMAPCACHE_H__
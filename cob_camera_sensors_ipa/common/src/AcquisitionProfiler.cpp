@@ -0,0 +1,352 @@
+/****************************************************************
+*
+* Copyright (c) 2026
+*
+* Fraunhofer Institute for Manufacturing Engineering
+* and Automation (IPA)
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Project name: care-o-bot
+* ROS stack name: cob_bringup_sandbox
+* ROS package name: cob_camera_sensors_ipa
+* Description: Per-stage latency instrumentation of image acquisition.
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Date of creation: October 2026
+* ToDo:
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer.
+* * Redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution.
+* * Neither the name of the Fraunhofer Institute for Manufacturing
+* Engineering and Automation (IPA) nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License LGPL as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License LGPL for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License LGPL along with this program.
+* If not, see <http://www.gnu.org/licenses/>.
+*
+****************************************************************/
+
+#include <cob_vision_utils/StdAfx.h>
+#ifdef __LINUX__
+	#include "cob_camera_sensors_ipa/AcquisitionProfiler.h"
+	#include "cob_vision_utils/GlobalDefines.h"
+
+	#include <signal.h>
+#else
+	#include "cob_bringup_sandbox/cob_camera_sensors_ipa/common/include/cob_camera_sensors_ipa/AcquisitionProfiler.h"
+	#include "cob_perception_common/cob_vision_utils/common/include/cob_vision_utils/GlobalDefines.h"
+#endif
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+
+using namespace ipa_CameraSensors;
+
+volatile bool AcquisitionProfiler::m_Enabled = true;
+volatile int AcquisitionProfiler::m_DumpRequested = 0;
+
+namespace
+{
+	/// Histograms of all stages measured by one thread.
+	/// Blocks are never freed, so readers may access them after the thread has finished.
+	struct t_ThreadProfile
+	{
+		t_StageHistogram m_Stages[PROFILER_MAX_STAGES];
+	};
+
+	/// Stage names and the histogram blocks of all threads.
+	struct t_ProfilerRegistry
+	{
+		boost::mutex m_Mutex;
+		std::vector<std::string> m_StageNames;
+		std::vector<t_ThreadProfile*> m_Threads;
+	};
+
+	t_ProfilerRegistry& GetRegistry()
+	{
+		static t_ProfilerRegistry registry;
+		return registry;
+	}
+
+	// The cleanup function keeps the block alive after thread exit
+	void KeepThreadProfile(t_ThreadProfile*)
+	{
+	}
+
+	boost::thread_specific_ptr<t_ThreadProfile>& GetThreadProfilePtr()
+	{
+		static boost::thread_specific_ptr<t_ThreadProfile> threadProfile(&KeepThreadProfile);
+		return threadProfile;
+	}
+
+	t_ThreadProfile* GetThreadProfile()
+	{
+		boost::thread_specific_ptr<t_ThreadProfile>& threadProfile = GetThreadProfilePtr();
+		t_ThreadProfile* profile = threadProfile.get();
+		if (profile == 0)
+		{
+			profile = new t_ThreadProfile();
+			memset((void*)profile, 0, sizeof(t_ThreadProfile));
+			threadProfile.reset(profile);
+
+			t_ProfilerRegistry& registry = GetRegistry();
+			boost::mutex::scoped_lock lock(registry.m_Mutex);
+			registry.m_Threads.push_back(profile);
+		}
+		return profile;
+	}
+
+	double GetPercentileMs(const std::vector<unsigned long long>& buckets, unsigned long count, double p)
+	{
+		if (count == 0)
+			return 0;
+		unsigned long long rank = (unsigned long long)(p * (count - 1)) + 1;
+		unsigned long long cumulated = 0;
+		for (int i=0; i<PROFILER_NUM_BUCKETS; i++)
+		{
+			cumulated += buckets[i];
+			if (cumulated >= rank)
+			{
+				// Center of the bucket
+				double lower = (double)AcquisitionProfiler::GetBucketLowerBound(i);
+				double upper = (i+1 < PROFILER_NUM_BUCKETS) ? (double)AcquisitionProfiler::GetBucketLowerBound(i+1) : lower;
+				return 0.0005 * (lower + upper);
+			}
+		}
+		return 0.001 * (double)AcquisitionProfiler::GetBucketLowerBound(PROFILER_NUM_BUCKETS-1);
+	}
+
+	extern "C" void AcquisitionProfilerSignalHandler(int)
+	{
+		AcquisitionProfiler::RequestDump();
+	}
+}
+
+int AcquisitionProfiler::RegisterStage(const std::string& name)
+{
+	t_ProfilerRegistry& registry = GetRegistry();
+	boost::mutex::scoped_lock lock(registry.m_Mutex);
+
+	for (size_t i=0; i<registry.m_StageNames.size(); i++)
+		if (registry.m_StageNames[i] == name)
+			return (int)i;
+
+	if ((int)registry.m_StageNames.size() >= PROFILER_MAX_STAGES)
+	{
+		std::cerr << "ERROR - AcquisitionProfiler::RegisterStage:" << std::endl;
+		std::cerr << "\t ... Maximum number of " << PROFILER_MAX_STAGES << " stages exceeded by '" << name << "'" << std::endl;
+		return -1;
+	}
+
+	registry.m_StageNames.push_back(name);
+	return (int)registry.m_StageNames.size() - 1;
+}
+
+int AcquisitionProfiler::GetBucket(unsigned long long durationUs)
+{
+	if (durationUs < (unsigned long long)PROFILER_SUB_BUCKETS)
+		return (int)durationUs;
+
+	// Position of the most significant bit, at least 2
+	int msb = 2;
+	while ((durationUs >> (msb + 1)) != 0)
+		msb++;
+
+	int subBucket = (int)((durationUs >> (msb - 2)) & (PROFILER_SUB_BUCKETS - 1));
+	int bucket = PROFILER_SUB_BUCKETS + (msb - 2) * PROFILER_SUB_BUCKETS + subBucket;
+	return (bucket < PROFILER_NUM_BUCKETS) ? bucket : PROFILER_NUM_BUCKETS - 1;
+}
+
+unsigned long long AcquisitionProfiler::GetBucketLowerBound(int bucket)
+{
+	if (bucket < PROFILER_SUB_BUCKETS)
+		return (unsigned long long)bucket;
+
+	int msb = (bucket - PROFILER_SUB_BUCKETS) / PROFILER_SUB_BUCKETS + 2;
+	int subBucket = (bucket - PROFILER_SUB_BUCKETS) % PROFILER_SUB_BUCKETS;
+	return (unsigned long long)(PROFILER_SUB_BUCKETS + subBucket) << (msb - 2);
+}
+
+void AcquisitionProfiler::Record(int stageId, unsigned long long durationUs)
+{
+	if (!m_Enabled || stageId < 0 || stageId >= PROFILER_MAX_STAGES)
+		return;
+
+	// Only the calling thread writes to its histograms
+	t_StageHistogram& histogram = GetThreadProfile()->m_Stages[stageId];
+	histogram.m_Buckets[GetBucket(durationUs)]++;
+	histogram.m_SumUs += durationUs;
+	if (durationUs > histogram.m_MaxUs)
+		histogram.m_MaxUs = durationUs;
+	histogram.m_Count++;
+}
+
+void AcquisitionProfiler::GetStatistics(std::vector<t_StageStatistics>& statistics)
+{
+	statistics.clear();
+
+	t_ProfilerRegistry& registry = GetRegistry();
+	boost::mutex::scoped_lock lock(registry.m_Mutex);
+
+	std::vector<unsigned long long> buckets(PROFILER_NUM_BUCKETS);
+	for (size_t stage=0; stage<registry.m_StageNames.size(); stage++)
+	{
+		std::fill(buckets.begin(), buckets.end(), 0);
+		unsigned long count = 0;
+		unsigned long long sumUs = 0;
+		unsigned long long maxUs = 0;
+
+		for (size_t thread=0; thread<registry.m_Threads.size(); thread++)
+		{
+			const t_StageHistogram& histogram = registry.m_Threads[thread]->m_Stages[stage];
+			unsigned long bucketCount = 0;
+			for (int i=0; i<PROFILER_NUM_BUCKETS; i++)
+			{
+				unsigned long n = histogram.m_Buckets[i];
+				buckets[i] += n;
+				bucketCount += n;
+			}
+			// The bucket counts define the sample count, as the counter may lag behind
+			count += bucketCount;
+			sumUs += histogram.m_SumUs;
+			if (histogram.m_MaxUs > maxUs)
+				maxUs = histogram.m_MaxUs;
+		}
+
+		if (count == 0)
+			continue;
+
+		t_StageStatistics stageStatistics;
+		stageStatistics.m_Name = registry.m_StageNames[stage];
+		stageStatistics.m_Count = count;
+		stageStatistics.m_MeanMs = 0.001 * (double)sumUs / count;
+		stageStatistics.m_P50Ms = GetPercentileMs(buckets, count, 0.5);
+		stageStatistics.m_P90Ms = GetPercentileMs(buckets, count, 0.9);
+		stageStatistics.m_P99Ms = GetPercentileMs(buckets, count, 0.99);
+		stageStatistics.m_MaxMs = 0.001 * (double)maxUs;
+		statistics.push_back(stageStatistics);
+	}
+}
+
+unsigned long AcquisitionProfiler::GetStatistics(const std::string& name, t_StageStatistics& statistics)
+{
+	std::vector<t_StageStatistics> allStatistics;
+	GetStatistics(allStatistics);
+	for (size_t i=0; i<allStatistics.size(); i++)
+	{
+		if (allStatistics[i].m_Name == name)
+		{
+			statistics = allStatistics[i];
+			return RET_OK;
+		}
+	}
+	return RET_FAILED;
+}
+
+void AcquisitionProfiler::Dump(std::ostream& stream)
+{
+	std::vector<t_StageStatistics> statistics;
+	GetStatistics(statistics);
+
+	std::ios::fmtflags flags = stream.flags();
+	std::streamsize precision = stream.precision();
+
+	stream << "INFO - AcquisitionProfiler::Dump:" << std::endl;
+	stream << std::left << "\t " << std::setw(36) << "stage" << std::right << std::setw(10) << "count"
+		<< std::setw(10) << "mean ms" << std::setw(10) << "p50 ms" << std::setw(10) << "p90 ms"
+		<< std::setw(10) << "p99 ms" << std::setw(10) << "max ms" << std::endl;
+	stream << std::fixed << std::setprecision(3);
+	for (size_t i=0; i<statistics.size(); i++)
+	{
+		stream << std::left << "\t " << std::setw(36) << statistics[i].m_Name << std::right
+			<< std::setw(10) << statistics[i].m_Count
+			<< std::setw(10) << statistics[i].m_MeanMs
+			<< std::setw(10) << statistics[i].m_P50Ms
+			<< std::setw(10) << statistics[i].m_P90Ms
+			<< std::setw(10) << statistics[i].m_P99Ms
+			<< std::setw(10) << statistics[i].m_MaxMs << std::endl;
+	}
+
+	stream.flags(flags);
+	stream.precision(precision);
+}
+
+void AcquisitionProfiler::Reset()
+{
+	t_ProfilerRegistry& registry = GetRegistry();
+	boost::mutex::scoped_lock lock(registry.m_Mutex);
+	for (size_t thread=0; thread<registry.m_Threads.size(); thread++)
+		memset((void*)registry.m_Threads[thread], 0, sizeof(t_ThreadProfile));
+}
+
+void AcquisitionProfiler::SetEnabled(bool enabled)
+{
+	m_Enabled = enabled;
+}
+
+unsigned long AcquisitionProfiler::InstallDumpSignalHandler(int signalNumber)
+{
+#ifdef __LINUX__
+	if (signalNumber < 0)
+		signalNumber = SIGUSR1;
+
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = &AcquisitionProfilerSignalHandler;
+	sigemptyset(&action.sa_mask);
+	action.sa_flags = SA_RESTART;
+	if (sigaction(signalNumber, &action, 0) != 0)
+	{
+		std::cerr << "ERROR - AcquisitionProfiler::InstallDumpSignalHandler:" << std::endl;
+		std::cerr << "\t ... Could not install handler for signal " << signalNumber << std::endl;
+		return RET_FAILED;
+	}
+	return RET_OK;
+#else
+	return (RET_FAILED | RET_FUNCTION_NOT_IMPLEMENTED);
+#endif
+}
+
+void AcquisitionProfiler::InstallDefaultDumpSignalHandler()
+{
+#ifdef __LINUX__
+	t_ProfilerRegistry& registry = GetRegistry();
+	boost::mutex::scoped_lock lock(registry.m_Mutex);
+	static bool installed = false;
+	if (installed)
+		return;
+	installed = true;
+
+	// Leave the signal alone if the application uses it
+	struct sigaction current;
+	if (sigaction(SIGUSR1, 0, &current) != 0 || current.sa_handler != SIG_DFL)
+		return;
+	InstallDumpSignalHandler(SIGUSR1);
+#endif
+}
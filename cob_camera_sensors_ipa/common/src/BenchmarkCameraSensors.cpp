@@ -0,0 +1,621 @@
+/****************************************************************
+*
+* Copyright (c) 2026
+*
+* Fraunhofer Institute for Manufacturing Engineering
+* and Automation (IPA)
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Project name: care-o-bot
+* ROS stack name: cob_bringup_sandbox
+* ROS package name: cob_camera_sensors_ipa
+* Description: Benchmark of the camera post-processing kernels on synthetic frames.
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Date of creation: October 2026
+* ToDo:
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer.
+* * Redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution.
+* * Neither the name of the Fraunhofer Institute for Manufacturing
+* Engineering and Automation (IPA) nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License LGPL as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License LGPL for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License LGPL along with this program.
+* If not, see <http://www.gnu.org/licenses/>.
+*
+****************************************************************/
+
+/// @file BenchmarkCameraSensors.cpp
+/// Benchmark of the post-processing kernels of the camera drivers.
+/// Each kernel runs on synthetic frames at VGA, SXGA and 4MP resolution. Per stage the
+/// latency percentiles, the throughput and the number of heap allocations per frame are reported.
+/// Results may be saved as baseline and later runs compared against it, so performance
+/// regressions are caught without attached hardware.
+/// @date October 2026.
+
+#include <cob_vision_utils/StdAfx.h>
+#ifdef __LINUX__
+	#include "cob_camera_sensors_ipa/ProcessingKernels.h"
+	#include "cob_camera_sensors_ipa/UndistortMapCache.h"
+	#include "cob_vision_utils/GlobalDefines.h"
+#else
+	#include "cob_bringup_sandbox/cob_camera_sensors_ipa/common/include/cob_camera_sensors_ipa/ProcessingKernels.h"
+	#include "cob_bringup_sandbox/cob_camera_sensors_ipa/common/include/cob_camera_sensors_ipa/UndistortMapCache.h"
+	#include "cob_perception_common/cob_vision_utils/common/include/cob_vision_utils/GlobalDefines.h"
+#endif
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ipa_CameraSensors;
+
+// Heap allocations are counted by interposing the allocator of the C library.
+// operator new ends up in malloc, so C++ allocations are counted as well. The aligned
+// entry points are interposed too, as OpenCV and Eigen allocate their buffers through them.
+static volatile long g_AllocationCount = 0;
+
+// Set by CheckAllocationCounting(), allocation counts are reported as n/a otherwise
+static bool g_AllocationCountingWorks = false;
+
+#ifdef __GLIBC__
+extern "C"
+{
+	void* __libc_malloc(size_t size);
+	void* __libc_calloc(size_t num, size_t size);
+	void* __libc_realloc(void* ptr, size_t size);
+	void* __libc_memalign(size_t alignment, size_t size);
+	void* __libc_valloc(size_t size);
+	void* __libc_pvalloc(size_t size);
+	void __libc_free(void* ptr);
+
+	void* malloc(size_t size)
+	{
+		__sync_fetch_and_add(&g_AllocationCount, 1);
+		return __libc_malloc(size);
+	}
+
+	void* calloc(size_t num, size_t size)
+	{
+		__sync_fetch_and_add(&g_AllocationCount, 1);
+		return __libc_calloc(num, size);
+	}
+
+	void* realloc(void* ptr, size_t size)
+	{
+		__sync_fetch_and_add(&g_AllocationCount, 1);
+		return __libc_realloc(ptr, size);
+	}
+
+	void* memalign(size_t alignment, size_t size)
+	{
+		__sync_fetch_and_add(&g_AllocationCount, 1);
+		return __libc_memalign(alignment, size);
+	}
+
+	void* aligned_alloc(size_t alignment, size_t size)
+	{
+		__sync_fetch_and_add(&g_AllocationCount, 1);
+		return __libc_memalign(alignment, size);
+	}
+
+	int posix_memalign(void** ptr, size_t alignment, size_t size)
+	{
+		// A power of two multiple of sizeof(void*), as glibc demands
+		if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0 || alignment == 0)
+			return EINVAL;
+		__sync_fetch_and_add(&g_AllocationCount, 1);
+		void* p = __libc_memalign(alignment, size);
+		if (p == 0 && size > 0)
+			return ENOMEM;
+		*ptr = p;
+		return 0;
+	}
+
+	void* valloc(size_t size)
+	{
+		__sync_fetch_and_add(&g_AllocationCount, 1);
+		return __libc_valloc(size);
+	}
+
+	void* pvalloc(size_t size)
+	{
+		__sync_fetch_and_add(&g_AllocationCount, 1);
+		return __libc_pvalloc(size);
+	}
+
+	void free(void* ptr)
+	{
+		__libc_free(ptr);
+	}
+}
+#define ALLOCATION_COUNTING_AVAILABLE true
+#else
+#define ALLOCATION_COUNTING_AVAILABLE false
+#endif
+
+/// Synthetic input frames of one resolution.
+struct t_BenchmarkFrames
+{
+	std::string m_Name;				///< Name of the resolution
+	int m_Width;					///< Image width
+	int m_Height;					///< Image height
+
+	cv::Mat m_Depth;				///< Depth image in millimeters, CV_16UC1
+	cv::Mat m_Bayer;				///< GRBG bayer image, CV_8UC1
+	cv::Mat m_YUV422;				///< UYVY image, CV_8UC2
+	cv::Mat m_RawRange;				///< Range image in meters, CV_32FC1
+	std::vector<cv::Mat> m_Coeffs;	///< Polynomial calibration coefficients, degree 6
+
+	cv::Mat m_IntrinsicMatrix;		///< Camera matrix
+	cv::Mat m_DistortionCoeffs;		///< Lens distortion (k1, k2, p1, p2)
+	cv::Mat m_UndistortMapX;		///< Undistortion map x
+	cv::Mat m_UndistortMapY;		///< Undistortion map y
+
+	double m_fx, m_fy, m_cx, m_cy;	///< Pinhole parameters
+};
+
+/// Measurements of one stage at one resolution.
+struct t_BenchmarkResult
+{
+	std::string m_Stage;			///< Stage name
+	std::string m_Resolution;		///< Resolution name
+	double m_MegaPixels;			///< Number of pixels per frame in millions
+	std::vector<double> m_Latency;	///< Latency of each iteration in milliseconds, sorted
+	double m_AllocationsPerFrame;	///< Heap allocations per iteration
+
+	double Percentile(double p) const
+	{
+		if (m_Latency.empty())
+			return 0;
+		size_t idx = (size_t)(p * (m_Latency.size() - 1) + 0.5);
+		return m_Latency[std::min(idx, m_Latency.size() - 1)];
+	}
+};
+
+/// Interface of a benchmarked stage.
+/// The destination buffers are allocated in <code>Prepare</code>, so
+/// <code>Run</code> measures the kernel only.
+class BenchmarkStage
+{
+public:
+	virtual ~BenchmarkStage() {}
+	virtual std::string Name() const = 0;
+	virtual void Prepare(const t_BenchmarkFrames& frames) = 0;
+	virtual void Run(const t_BenchmarkFrames& frames) = 0;
+};
+
+/// Kinect back-projection of depth to cartesian coordinates.
+class BackProjectionStage : public BenchmarkStage
+{
+public:
+	std::string Name() const { return "back_projection"; }
+	void Prepare(const t_BenchmarkFrames& frames) { m_XYZ.create(frames.m_Height, frames.m_Width, CV_32FC3); }
+	void Run(const t_BenchmarkFrames& frames)
+	{
+		ConvertDepthToCartesian(frames.m_Depth, frames.m_fx, frames.m_fy, frames.m_cx, frames.m_cy,
+			m_XYZ.ptr<char>(0), (int)m_XYZ.step);
+	}
+private:
+	cv::Mat m_XYZ;
+};
+
+/// Kinect conversion of depth in millimeters to range in meters.
+class DepthToRangeStage : public BenchmarkStage
+{
+public:
+	std::string Name() const { return "depth_to_range"; }
+	void Prepare(const t_BenchmarkFrames& frames) { m_Range.create(frames.m_Height, frames.m_Width, CV_32FC1); }
+	void Run(const t_BenchmarkFrames& frames) { ConvertDepthToRange(frames.m_Depth, m_Range.ptr<char>(0), (int)m_Range.step); }
+private:
+	cv::Mat m_Range;
+};
+
+/// Kinect demosaicing of GRBG bayer images.
+class DemosaicingStage : public BenchmarkStage
+{
+public:
+	DemosaicingStage(t_DebayeringMethod method, const std::string& name) : m_Method(method), m_Name(name) {}
+	std::string Name() const { return m_Name; }
+	void Prepare(const t_BenchmarkFrames& frames) { m_RGB.create(frames.m_Height, frames.m_Width, CV_8UC3); }
+	void Run(const t_BenchmarkFrames& frames)
+	{
+		ConvertBayerGRBGToRGB(frames.m_Bayer.ptr<unsigned char>(0), frames.m_Width, frames.m_Height,
+			m_RGB.ptr<unsigned char>(0), m_Method);
+	}
+private:
+	t_DebayeringMethod m_Method;
+	std::string m_Name;
+	cv::Mat m_RGB;
+};
+
+/// Kinect YUV422 to RGB conversion followed by the red/blue swap.
+class YUVConversionStage : public BenchmarkStage
+{
+public:
+	std::string Name() const { return "yuv422_to_bgr"; }
+	void Prepare(const t_BenchmarkFrames& frames) { m_RGB.create(frames.m_Height, frames.m_Width, CV_8UC3); }
+	void Run(const t_BenchmarkFrames& frames)
+	{
+		ConvertYUV422ToRGB(frames.m_YUV422.ptr<unsigned char>(0), frames.m_Width, frames.m_Height,
+			m_RGB.ptr<unsigned char>(0), frames.m_Width, frames.m_Height);
+		SwapRedBlueChannels(m_RGB.ptr<unsigned char>(0), frames.m_Width, frames.m_Height, (int)m_RGB.step);
+	}
+private:
+	cv::Mat m_RGB;
+};
+
+/// Undistortion of range images as done by the time-of-flight drivers.
+class UndistortionStage : public BenchmarkStage
+{
+public:
+	std::string Name() const { return "undistortion"; }
+	void Prepare(const t_BenchmarkFrames& frames) { m_Undistorted.create(frames.m_Height, frames.m_Width, CV_32FC1); }
+	void Run(const t_BenchmarkFrames& frames)
+	{
+		cv::remap(frames.m_RawRange, m_Undistorted, frames.m_UndistortMapX, frames.m_UndistortMapY, cv::INTER_LINEAR);
+	}
+private:
+	cv::Mat m_Undistorted;
+};
+
+/// Undistortion with the fixed-point maps of <code>UndistortMapCache</code>, loaded
+/// from the map cache as the drivers do.
+class FixedPointUndistortionStage : public BenchmarkStage
+{
+public:
+	FixedPointUndistortionStage(const std::string& cacheDirectory) : m_CacheDirectory(cacheDirectory) {}
+	std::string Name() const { return "undistortion_fixed_point"; }
+	void Prepare(const t_BenchmarkFrames& frames)
+	{
+		m_Maps.Load(m_CacheDirectory, frames.m_IntrinsicMatrix, frames.m_DistortionCoeffs, cv::Size(frames.m_Width, frames.m_Height));
+		m_Undistorted.create(frames.m_Height, frames.m_Width, CV_32FC1);
+	}
+	void Run(const t_BenchmarkFrames& frames) { m_Maps.Remap(frames.m_RawRange, m_Undistorted, cv::INTER_LINEAR); }
+private:
+	std::string m_CacheDirectory;
+	UndistortMapCache m_Maps;
+	cv::Mat m_Undistorted;
+};
+
+/// Startup cost of the undistortion maps: memory-mapping the cached file.
+/// The first call of Prepare() fills the cache if it is cold.
+class UndistortMapLoadStage : public BenchmarkStage
+{
+public:
+	UndistortMapLoadStage(const std::string& cacheDirectory) : m_CacheDirectory(cacheDirectory) {}
+	std::string Name() const { return "undistortion_map_load"; }
+	void Prepare(const t_BenchmarkFrames& frames) { Run(frames); }
+	void Run(const t_BenchmarkFrames& frames)
+	{
+		m_Maps.Load(m_CacheDirectory, frames.m_IntrinsicMatrix, frames.m_DistortionCoeffs, cv::Size(frames.m_Width, frames.m_Height));
+	}
+private:
+	std::string m_CacheDirectory;
+	UndistortMapCache m_Maps;
+};
+
+/// Per-pixel polynomial z calibration of time-of-flight cameras.
+class PolynomialCalibrationStage : public BenchmarkStage
+{
+public:
+	std::string Name() const { return "polynomial_calibration"; }
+	void Prepare(const t_BenchmarkFrames& frames) { m_Calibrated.create(frames.m_Height, frames.m_Width, CV_32FC1); }
+	void Run(const t_BenchmarkFrames& frames) { EvaluateRangePolynomial(frames.m_RawRange, frames.m_Coeffs, m_Calibrated); }
+private:
+	cv::Mat m_Calibrated;
+};
+
+/// Creates reproducible synthetic frames.
+/// The depth image is a tilted plane with invalid pixels, the bayer and YUV images hold
+/// gradients with noise, so that branches of the kernels behave as on real data.
+void CreateBenchmarkFrames(const std::string& name, int width, int height, t_BenchmarkFrames& frames)
+{
+	frames.m_Name = name;
+	frames.m_Width = width;
+	frames.m_Height = height;
+	frames.m_fx = frames.m_fy = 0.8 * width;
+	frames.m_cx = 0.5 * width - 0.5;
+	frames.m_cy = 0.5 * height - 0.5;
+
+	cv::RNG rng(0x1234);
+
+	frames.m_Depth.create(height, width, CV_16UC1);
+	frames.m_RawRange.create(height, width, CV_32FC1);
+	frames.m_Bayer.create(height, width, CV_8UC1);
+	frames.m_YUV422.create(height, width, CV_8UC2);
+	for (int row=0; row<height; row++)
+	{
+		unsigned short* p_depth = frames.m_Depth.ptr<unsigned short>(row);
+		float* p_range = frames.m_RawRange.ptr<float>(row);
+		unsigned char* p_bayer = frames.m_Bayer.ptr<unsigned char>(row);
+		unsigned char* p_yuv = frames.m_YUV422.ptr<unsigned char>(row);
+		for (int col=0; col<width; col++)
+		{
+			unsigned short depth = (unsigned short)(800 + 2*row + col + rng.uniform(0, 8));
+			// About 3 percent invalid measurements
+			if (rng.uniform(0, 100) < 3)
+				depth = 0;
+			p_depth[col] = depth;
+			p_range[col] = 0.001f * depth;
+			p_bayer[col] = (unsigned char)((row + col + rng.uniform(0, 16)) & 0xff);
+			p_yuv[2*col] = (unsigned char)((col & 1) ? (row & 0xff) : (col & 0xff));
+			p_yuv[2*col + 1] = (unsigned char)((row + col + rng.uniform(0, 16)) & 0xff);
+		}
+	}
+
+	frames.m_Coeffs.resize(7);
+	for (int i=0; i<7; i++)
+	{
+		frames.m_Coeffs[i].create(height, width, CV_64FC1);
+		rng.fill(frames.m_Coeffs[i], cv::RNG::UNIFORM, cv::Scalar(-1.0 / (i+1)), cv::Scalar(1.0 / (i+1)));
+	}
+
+	frames.m_IntrinsicMatrix = (cv::Mat_<double>(3, 3) << frames.m_fx, 0, frames.m_cx, 0, frames.m_fy, frames.m_cy, 0, 0, 1);
+	frames.m_DistortionCoeffs = (cv::Mat_<double>(1, 4) << -0.25, 0.1, 0.001, -0.001);
+	cv::initUndistortRectifyMap(frames.m_IntrinsicMatrix, frames.m_DistortionCoeffs, cv::Mat(), frames.m_IntrinsicMatrix,
+		cv::Size(width, height), CV_32FC1, frames.m_UndistortMapX, frames.m_UndistortMapY);
+}
+
+/// Runs a stage on the given frames and collects the measurements.
+void RunStage(BenchmarkStage& stage, const t_BenchmarkFrames& frames, int iterations, t_BenchmarkResult& result)
+{
+	result.m_Stage = stage.Name();
+	result.m_Resolution = frames.m_Name;
+	result.m_MegaPixels = frames.m_Width * frames.m_Height / 1e6;
+	result.m_Latency.assign(iterations, 0);
+
+	stage.Prepare(frames);
+
+	// Warm up caches and lazily allocated buffers
+	for (int i=0; i<3; i++)
+		stage.Run(frames);
+
+	double tickFrequency = cv::getTickFrequency();
+	long allocationsBefore = g_AllocationCount;
+	for (int i=0; i<iterations; i++)
+	{
+		int64 start = cv::getTickCount();
+		stage.Run(frames);
+		result.m_Latency[i] = 1000.0 * (cv::getTickCount() - start) / tickFrequency;
+	}
+	result.m_AllocationsPerFrame = (double)(g_AllocationCount - allocationsBefore) / iterations;
+
+	std::sort(result.m_Latency.begin(), result.m_Latency.end());
+}
+
+void PrintResult(const t_BenchmarkResult& result)
+{
+	double p50 = result.Percentile(0.5);
+	std::cout << std::left << std::setw(26) << result.m_Stage << std::setw(7) << result.m_Resolution << std::right
+		<< std::fixed << std::setprecision(3)
+		<< std::setw(10) << p50
+		<< std::setw(10) << result.Percentile(0.9)
+		<< std::setw(10) << result.Percentile(0.99)
+		<< std::setw(10) << result.m_Latency.back()
+		<< std::setprecision(1)
+		<< std::setw(10) << (p50 > 0 ? 1000.0 / p50 : 0)
+		<< std::setw(10) << (p50 > 0 ? 1000.0 * result.m_MegaPixels / p50 : 0);
+	if (g_AllocationCountingWorks)
+		std::cout << std::setprecision(2) << std::setw(10) << result.m_AllocationsPerFrame;
+	else
+		std::cout << std::setw(10) << "n/a";
+	std::cout << std::endl;
+}
+
+/// Baseline file format: one line per stage and resolution holding
+/// <I>stage resolution p50 p99 allocations</I>.
+unsigned long SaveBaseline(const std::string& filename, const std::vector<t_BenchmarkResult>& results)
+{
+	std::ofstream file(filename.c_str());
+	if (!file.is_open())
+	{
+		std::cerr << "ERROR - SaveBaseline:" << std::endl;
+		std::cerr << "\t ... Could not open '" << filename << "'" << std::endl;
+		return (RET_FAILED | RET_FAILED_OPEN_FILE);
+	}
+	file << std::setprecision(6);
+	for (size_t i=0; i<results.size(); i++)
+		file << results[i].m_Stage << " " << results[i].m_Resolution << " " << results[i].Percentile(0.5) << " "
+			<< results[i].Percentile(0.99) << " " << results[i].m_AllocationsPerFrame << "\n";
+	return RET_OK;
+}
+
+/// Compares the results against a baseline.
+/// A stage regresses if its median latency exceeds the baseline by more than the tolerance
+/// or if it allocates more often than in the baseline.
+unsigned long CompareBaseline(const std::string& filename, const std::vector<t_BenchmarkResult>& results, double tolerance)
+{
+	std::ifstream file(filename.c_str());
+	if (!file.is_open())
+	{
+		std::cerr << "ERROR - CompareBaseline:" << std::endl;
+		std::cerr << "\t ... Could not open '" << filename << "'" << std::endl;
+		return (RET_FAILED | RET_FAILED_OPEN_FILE);
+	}
+
+	std::map<std::string, std::pair<double, double> > baseline;
+	std::string stage, resolution;
+	double p50, p99, allocations;
+	while (file >> stage >> resolution >> p50 >> p99 >> allocations)
+		baseline[stage + " " + resolution] = std::make_pair(p50, allocations);
+
+	unsigned long ret = RET_OK;
+	for (size_t i=0; i<results.size(); i++)
+	{
+		std::string key = results[i].m_Stage + " " + results[i].m_Resolution;
+		std::map<std::string, std::pair<double, double> >::const_iterator it = baseline.find(key);
+		if (it == baseline.end())
+			continue;
+
+		double current = results[i].Percentile(0.5);
+		if (current > it->second.first * (1.0 + tolerance))
+		{
+			std::cerr << "REGRESSION - " << key << ": median " << current << " ms, baseline " << it->second.first << " ms" << std::endl;
+			ret = RET_FAILED;
+		}
+		if (g_AllocationCountingWorks && results[i].m_AllocationsPerFrame > it->second.second + 0.01)
+		{
+			std::cerr << "REGRESSION - " << key << ": " << results[i].m_AllocationsPerFrame
+				<< " allocations per frame, baseline " << it->second.second << std::endl;
+			ret = RET_FAILED;
+		}
+	}
+	return ret;
+}
+
+/// Self-test of the allocation counter: creating one cv::Mat has to be counted,
+/// whichever allocator OpenCV has been built with.
+/// @return True, when allocations are counted.
+bool CheckAllocationCounting()
+{
+	if (!ALLOCATION_COUNTING_AVAILABLE)
+		return false;
+
+	long before = g_AllocationCount;
+	{
+		cv::Mat probe(64, 64, CV_8UC1);
+		probe.setTo(0);
+	}
+	long counted = g_AllocationCount - before;
+	if (counted < 1)
+	{
+		std::cerr << "WARNING - CheckAllocationCounting:" << std::endl;
+		std::cerr << "\t ... Creating a cv::Mat was not counted, allocations are not reported" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void PrintUsage()
+{
+	std::cout <<
+		"usage: \t benchmark_camera_sensors [options] \n"
+		"\t -n <iterations> \t Iterations per stage and resolution (default 50) \n"
+		"\t -s <stage> \t\t Only run stages whose name contains <stage> \n"
+		"\t -r <resolution> \t Only run VGA, SXGA or 4MP \n"
+		"\t -save <file> \t\t Save results as baseline \n"
+		"\t -compare <file> \t Compare against baseline, return 1 on regression \n"
+		"\t -tolerance <t> \t Allowed relative slowdown of the median (default 0.15) \n"
+		"\t -cache <dir> \t\t Undistortion map cache (default /tmp/benchmark_camera_sensors_maps) \n"
+	<< std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	int iterations = 50;
+	std::string stageFilter, resolutionFilter, saveFile, compareFile;
+	double tolerance = 0.15;
+	std::string cacheDirectory = "/tmp/benchmark_camera_sensors_maps";
+
+	for (int i=1; i<argc; i++)
+	{
+		std::string arg = argv[i];
+		if (i+1 < argc && arg == "-n")
+			iterations = std::max(1, atoi(argv[++i]));
+		else if (i+1 < argc && arg == "-s")
+			stageFilter = argv[++i];
+		else if (i+1 < argc && arg == "-r")
+			resolutionFilter = argv[++i];
+		else if (i+1 < argc && arg == "-save")
+			saveFile = argv[++i];
+		else if (i+1 < argc && arg == "-compare")
+			compareFile = argv[++i];
+		else if (i+1 < argc && arg == "-tolerance")
+			tolerance = atof(argv[++i]);
+		else if (i+1 < argc && arg == "-cache")
+			cacheDirectory = argv[++i];
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	g_AllocationCountingWorks = CheckAllocationCounting();
+
+	std::vector<BenchmarkStage*> stages;
+	stages.push_back(new BackProjectionStage());
+	stages.push_back(new DepthToRangeStage());
+	stages.push_back(new DemosaicingStage(DEBAYERING_BILINEAR, "demosaic_bilinear"));
+	stages.push_back(new DemosaicingStage(DEBAYERING_EDGE_AWARE, "demosaic_edge_aware"));
+	stages.push_back(new DemosaicingStage(DEBAYERING_EDGE_AWARE_WEIGHTED, "demosaic_edge_weighted"));
+	stages.push_back(new YUVConversionStage());
+	stages.push_back(new UndistortionStage());
+	stages.push_back(new FixedPointUndistortionStage(cacheDirectory));
+	stages.push_back(new UndistortMapLoadStage(cacheDirectory));
+	stages.push_back(new PolynomialCalibrationStage());
+
+	const char* resolutionNames[] = {"VGA", "SXGA", "4MP"};
+	const int resolutionWidths[] = {640, 1280, 2048};
+	const int resolutionHeights[] = {480, 1024, 2048};
+
+	std::cout << std::left << std::setw(26) << "stage" << std::setw(7) << "res" << std::right
+		<< std::setw(10) << "p50 ms" << std::setw(10) << "p90 ms" << std::setw(10) << "p99 ms" << std::setw(10) << "max ms"
+		<< std::setw(10) << "fps" << std::setw(10) << "MPix/s" << std::setw(10) << "allocs" << std::endl;
+
+	std::vector<t_BenchmarkResult> results;
+	for (int r=0; r<3; r++)
+	{
+		if (!resolutionFilter.empty() && resolutionFilter != resolutionNames[r])
+			continue;
+
+		t_BenchmarkFrames frames;
+		CreateBenchmarkFrames(resolutionNames[r], resolutionWidths[r], resolutionHeights[r], frames);
+
+		for (size_t s=0; s<stages.size(); s++)
+		{
+			if (!stageFilter.empty() && stages[s]->Name().find(stageFilter) == std::string::npos)
+				continue;
+
+			results.push_back(t_BenchmarkResult());
+			RunStage(*stages[s], frames, iterations, results.back());
+			PrintResult(results.back());
+		}
+	}
+
+	for (size_t s=0; s<stages.size(); s++)
+		delete stages[s];
+
+	if (!saveFile.empty() && (SaveBaseline(saveFile, results) & RET_FAILED))
+		return 1;
+
+	if (!compareFile.empty() && (CompareBaseline(compareFile, results, tolerance) & RET_FAILED))
+		return 1;
+
+	return 0;
+}
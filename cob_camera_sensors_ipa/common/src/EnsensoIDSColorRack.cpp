@@ -4,6 +4,7 @@
 
 #ifdef __LINUX__
 	#include "cob_camera_sensors_ipa/EnsensoIDSColorRack.h"	
+	#include "cob_camera_sensors_ipa/AcquisitionProfiler.h"
 	#include "cob_vision_utils/GlobalDefines.h"
 
 	#include "tinyxml.h"
@@ -11,6 +12,7 @@
 	#include <iostream>
 #else
 	#include "cob_bringup_sandbox/cob_camera_sensors_ipa/common/include/cob_camera_sensors_ipa/EnsensoIDSColorRack.h"
+	#include "cob_bringup_sandbox/cob_camera_sensors_ipa/common/include/cob_camera_sensors_ipa/AcquisitionProfiler.h"
 	#include "cob_perception_common/cob_vision_utils/common/include/cob_vision_utils/GlobalDefines.h"
 
 	#include <fstream>
@@ -20,6 +22,13 @@
 
 using namespace ipa_CameraSensors;
 
+static const int s_StageTotal = AcquisitionProfiler::RegisterStage("EnsensoIDSColorRack/total");
+static const int s_StageCapture = AcquisitionProfiler::RegisterStage("EnsensoIDSColorRack/sdk_capture");
+static const int s_StageDisparity = AcquisitionProfiler::RegisterStage("EnsensoIDSColorRack/sdk_disparity");
+static const int s_StageRenderPointMap = AcquisitionProfiler::RegisterStage("EnsensoIDSColorRack/sdk_render_point_map");
+static const int s_StagePointMapConversion = AcquisitionProfiler::RegisterStage("EnsensoIDSColorRack/point_map_conversion");
+static const int s_StageColorConversion = AcquisitionProfiler::RegisterStage("EnsensoIDSColorRack/color_conversion");
+
 #define IDS_SXGA_X_RES 1280
 #define IDS_SXGA_Y_RES 1024
 #define IDS_VGA_X_RES 640
@@ -66,6 +75,8 @@ unsigned long EnsensoIDSColorRack::Init(std::string directory, int cameraIndex)
 		return ipa_Utils::RET_OK;
 	}
 
+	AcquisitionProfiler::InstallDefaultDumpSignalHandler();
+
 	m_parameter_files_directory = directory;
 
 	// Load camera parameters from xml-file
@@ -355,6 +366,8 @@ unsigned long EnsensoIDSColorRack::AcquireImages(cv::Mat* rangeImage, cv::Mat* c
 unsigned long EnsensoIDSColorRack::AcquireImages(int widthStepRange, int widthStepGray, int widthStepCartesian, char* rangeImageData, char* colorImageData, char* cartesianImageData,
 										bool getLatestFrame, bool undistort, ipa_CameraSensors::t_ToFGrayImageType grayImageType)
 {
+	ScopedStageTimer totalTimer(s_StageTotal);
+
 	// point map z --> range image
 	// point map --> cartesian image
 	// ids image --> color image
@@ -366,15 +379,20 @@ unsigned long EnsensoIDSColorRack::AcquireImages(int widthStepRange, int widthSt
 		std::string cameras_str = "[\"" + m_ensensoSerial + "\",\"" + m_idsUEyeSerial + "\"]";
 
 		// grab an image
+		ScopedStageTimer captureTimer(s_StageCapture);
 		NxLibCommand capture(cmdCapture);
 		capture.parameters()[itmCameras].setJson(cameras_str, true);
 		capture.execute();
+		captureTimer.Stop();
 
 		// compute the disparity map, this is the actual, computation intensive stereo matching task
+		ScopedStageTimer disparityTimer(s_StageDisparity);
 		NxLibCommand computeDisparity(cmdComputeDisparityMap);
 		computeDisparity.parameters()[itmCameras].setJson(cameras_str, true);
 		computeDisparity.execute();
+		disparityTimer.Stop();
 		
+		ScopedStageTimer renderPointMapTimer(s_StageRenderPointMap);
 		NxLibItem root; // Reference to the API tree root
 		root[itmParameters][itmRenderPointMap][itmTexture] = true;
 		//root[itmParameters][itmRenderPointMap][itmUseOpenGL] = false;
@@ -388,8 +406,10 @@ unsigned long EnsensoIDSColorRack::AcquireImages(int widthStepRange, int widthSt
 		renderPointMap.parameters()[itmFillXYCoordinates] = false;
 		renderPointMap.parameters()[itmZBufferOnly] = false;
 		renderPointMap.execute();
+		renderPointMapTimer.Stop();
 
 		// get info about the computed point map and copy it into a std::vector
+		ScopedStageTimer pointMapConversionTimer(s_StagePointMapConversion);
 		std::vector<float> pointMap;
 		int range_width=0, range_height=0;
 		root[itmImages][itmRenderPointMap].getBinaryDataInfo(&range_width, &range_height, 0,0,0,0);
@@ -418,8 +438,10 @@ unsigned long EnsensoIDSColorRack::AcquireImages(int widthStepRange, int widthSt
 				++p_rangeImageData;
 			}
 		}
+		pointMapConversionTimer.Stop();
 
 		// get the color image
+		ScopedStageTimer colorConversionTimer(s_StageColorConversion);
 		std::vector<unsigned char> texture;
 		int color_width=0, color_height=0;
 		NxLibItem ids_camera = root[itmCameras][itmBySerialNo][m_idsUEyeSerial];
@@ -4,6 +4,7 @@
 
 #ifdef __LINUX__
 	#include "cob_camera_sensors_ipa/EnsensoN30.h"	
+	#include "cob_camera_sensors_ipa/AcquisitionProfiler.h"
 	#include "cob_vision_utils/GlobalDefines.h"
 
 	#include "tinyxml.h"
@@ -11,12 +12,21 @@
 	#include <iostream>
 #else
 	#include "cob_bringup_sandbox/cob_camera_sensors_ipa/common/include/cob_camera_sensors_ipa/EnsensoN30.h"
+	#include "cob_bringup_sandbox/cob_camera_sensors_ipa/common/include/cob_camera_sensors_ipa/AcquisitionProfiler.h"
 	#include "cob_perception_common/cob_vision_utils/common/include/cob_vision_utils/GlobalDefines.h"
 #endif
 
 
 
 using namespace ipa_CameraSensors;
+
+static const int s_StageTotal = AcquisitionProfiler::RegisterStage("EnsensoN30/total");
+static const int s_StageCapture = AcquisitionProfiler::RegisterStage("EnsensoN30/sdk_capture");
+static const int s_StageDisparity = AcquisitionProfiler::RegisterStage("EnsensoN30/sdk_disparity");
+static const int s_StagePointMap = AcquisitionProfiler::RegisterStage("EnsensoN30/sdk_point_map");
+static const int s_StagePointMapConversion = AcquisitionProfiler::RegisterStage("EnsensoN30/point_map_conversion");
+static const int s_StageImageConversion = AcquisitionProfiler::RegisterStage("EnsensoN30/gray_conversion");
+
 #define AVG(a,b) (((int)(a) + (int)(b)) >> 1)
 #define AVG3(a,b,c) (((int)(a) + (int)(b) + (int)(c)) / 3)
 #define AVG4(a,b,c,d) (((int)(a) + (int)(b) + (int)(c) + (int)(d)) >> 2)
@@ -68,6 +78,8 @@ unsigned long EnsensoN30::Init(std::string directory, int cameraIndex)
 		return ipa_Utils::RET_OK;
 	}
 
+	AcquisitionProfiler::InstallDefaultDumpSignalHandler();
+
 	// Load camera parameters from xml-file
 	if (LoadParameters((directory + "cameraSensorsIni.xml").c_str(), cameraIndex) & RET_FAILED)
 	{
@@ -341,6 +353,8 @@ unsigned long EnsensoN30::AcquireImages(cv::Mat* rangeImage, cv::Mat* grayImage,
 unsigned long EnsensoN30::AcquireImages(int widthStepRange, int widthStepGray, int widthStepCartesian, char* rangeImageData, char* grayImageData, char* cartesianImageData,
 										bool getLatestFrame, bool undistort, ipa_CameraSensors::t_ToFGrayImageType grayImageType)
 {
+	ScopedStageTimer totalTimer(s_StageTotal);
+
 	// point map z --> range image
 	// point map --> cartesian image
 	// rectified left --> gray image
@@ -350,21 +364,28 @@ unsigned long EnsensoN30::AcquireImages(int widthStepRange, int widthStepGray, i
 	{
 		// execute the 'Capture', 'ComputeDisparityMap' and 'ComputePointMap' commands
 		// grab an image
+		ScopedStageTimer captureTimer(s_StageCapture);
 		NxLibCommand capture(cmdCapture);
 		capture.parameters()[itmCameras] = m_Serial;
 		capture.execute();
+		captureTimer.Stop();
 
 		// compute the disparity map, this is the actual, computation intensive stereo matching task
+		ScopedStageTimer disparityTimer(s_StageDisparity);
 		NxLibCommand computeDisparity(cmdComputeDisparityMap);
 		computeDisparity.parameters()[itmCameras] = m_Serial;
 		computeDisparity.execute();
+		disparityTimer.Stop();
 
 		// generating point map from disparity map, this converts the disparity map into XYZ data for each pixel
+		ScopedStageTimer pointMapTimer(s_StagePointMap);
 		NxLibCommand computePointMap(cmdComputePointMap);
 		computePointMap.parameters()[itmCameras] = m_Serial;
 		computePointMap.execute();
+		pointMapTimer.Stop();
 
 		// get info about the computed point map and copy it into a std::vector
+		ScopedStageTimer pointMapConversionTimer(s_StagePointMapConversion);
 		std::vector<float> pointMap;
 		int range_width=0, range_height=0;
 		m_Camera[itmImages][itmPointMap].getBinaryDataInfo(&range_width, &range_height, 0,0,0,0);
@@ -393,8 +414,10 @@ unsigned long EnsensoN30::AcquireImages(int widthStepRange, int widthStepGray, i
 				++p_rangeImageData;
 			}
 		}
+		pointMapConversionTimer.Stop();
 
 		// get the intensity image
+		ScopedStageTimer imageConversionTimer(s_StageImageConversion);
 		std::vector<unsigned char> imageLeft;
 		int color_width=0, color_height=0;
 		m_Camera[itmImages][itmRectified][itmLeft].getBinaryDataInfo(&color_width, &color_height, 0,0,0,0);
@@ -0,0 +1,1015 @@
+/****************************************************************
+*
+* Copyright (c) 2026
+*
+* Fraunhofer Institute for Manufacturing Engineering
+* and Automation (IPA)
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Project name: care-o-bot
+* ROS stack name: cob_bringup_sandbox
+* ROS package name: cob_camera_sensors_ipa
+* Description: Binary log of camera frames for recording and replay.
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Date of creation: October 2026
+* ToDo:
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer.
+* * Redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution.
+* * Neither the name of the Fraunhofer Institute for Manufacturing
+* Engineering and Automation (IPA) nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License LGPL as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License LGPL for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License LGPL along with this program.
+* If not, see <http://www.gnu.org/licenses/>.
+*
+****************************************************************/
+
+#include <cob_vision_utils/StdAfx.h>
+#ifdef __LINUX__
+	#include "cob_camera_sensors_ipa/FrameLog.h"
+	#include "cob_vision_utils/GlobalDefines.h"
+
+	#include "tinyxml.h"
+	#include <iostream>
+#else
+	#include "cob_bringup_sandbox/cob_camera_sensors_ipa/common/include/cob_camera_sensors_ipa/FrameLog.h"
+	#include "cob_perception_common/cob_vision_utils/common/include/cob_vision_utils/GlobalDefines.h"
+#endif
+
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+#include <cstring>
+
+#ifdef __USE_LZ4__
+	#include <lz4.h>
+#endif
+
+using namespace ipa_CameraSensors;
+
+/// The payload of each stream is padded to a multiple of this size, so that the mapped data is aligned.
+#define FRAMELOG_RECORD_ALIGNMENT 8
+
+namespace
+{
+	size_t AlignRecordSize(size_t size)
+	{
+		return (size + FRAMELOG_RECORD_ALIGNMENT - 1) & ~((size_t)FRAMELOG_RECORD_ALIGNMENT - 1);
+	}
+}
+
+//*******************************************************************************
+// FrameLogWriter
+//*******************************************************************************
+
+FrameLogWriter::FrameLogWriter()
+{
+	m_GeometryFixed = false;
+	m_HeaderWritten = false;
+	m_Offset = 0;
+	m_NumberOfFrames = 0;
+	m_NumberOfDroppedFrames = 0;
+	m_NumberOfRejectedFrames = 0;
+	m_WriteFailed = false;
+	m_StopWriter = false;
+}
+
+FrameLogWriter::~FrameLogWriter()
+{
+	if (isOpen())
+	{
+		Close();
+	}
+}
+
+unsigned long FrameLogWriter::Open(const std::string& filename, t_cameraType cameraType, const t_FrameLogOptions& options)
+{
+	if (isOpen())
+	{
+		Close();
+	}
+
+	m_File.open(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	m_IndexFile.open((filename + ".idx").c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!m_File.is_open() || !m_IndexFile.is_open())
+	{
+		std::cerr << "ERROR - FrameLogWriter::Open:" << std::endl;
+		std::cerr << "\t ... Could not create file '" << filename << "' or its index" << std::endl;
+		m_File.close();
+		m_IndexFile.close();
+		return (RET_FAILED | RET_FAILED_OPEN_FILE);
+	}
+
+	m_Filename = filename;
+	m_Options = options;
+#ifndef __USE_LZ4__
+	if (m_Options.m_Compress)
+	{
+		std::cout << "WARNING - FrameLogWriter::Open:" << std::endl;
+		std::cout << "\t ... Library built without LZ4 support, writing uncompressed frames" << std::endl;
+		m_Options.m_Compress = false;
+	}
+#endif
+
+	std::memset(&m_Header, 0, sizeof(m_Header));
+	std::memcpy(m_Header.m_Magic, FRAMELOG_MAGIC, sizeof(m_Header.m_Magic));
+	m_Header.m_Version = FRAMELOG_VERSION;
+	m_Header.m_HeaderSize = AlignRecordSize(sizeof(t_FrameLogHeader));
+	m_Header.m_CameraType = cameraType;
+	m_GeometryFixed = false;
+	m_HeaderWritten = false;
+	m_Offset = 0;
+	m_NumberOfFrames = 0;
+	m_NumberOfDroppedFrames = 0;
+	m_NumberOfRejectedFrames = 0;
+	m_WriteFailed = false;
+
+	if (m_Options.m_QueueSize > 0)
+	{
+		m_Frames.resize(m_Options.m_QueueSize);
+		m_FreeFrames.clear();
+		m_PendingFrames.clear();
+		for (size_t i=0; i<m_Frames.size(); i++)
+		{
+			m_FreeFrames.push_back(i);
+		}
+		m_StopWriter = false;
+		m_WriterThread = boost::shared_ptr<boost::thread>(new boost::thread(boost::bind(&FrameLogWriter::WriterThread, this)));
+	}
+
+	return RET_OK;
+}
+
+unsigned long FrameLogWriter::Close()
+{
+	if (!isOpen())
+	{
+		return RET_OK;
+	}
+
+	if (m_WriterThread)
+	{
+		{
+			boost::mutex::scoped_lock lock(m_QueueMutex);
+			m_StopWriter = true;
+		}
+		m_QueueCondition.notify_all();
+		m_WriterThread->join();
+		m_WriterThread.reset();
+		m_Frames.clear();
+	}
+
+	m_File.close();
+	m_IndexFile.close();
+	if (m_File.fail() || m_IndexFile.fail() || m_WriteFailed)
+	{
+		std::cerr << "ERROR - FrameLogWriter::Close:" << std::endl;
+		std::cerr << "\t ... Error while writing file '" << m_Filename << "'" << std::endl;
+		return RET_FAILED;
+	}
+
+	if (m_NumberOfRejectedFrames > 0)
+	{
+		std::cout << "WARNING - FrameLogWriter::Close:" << std::endl;
+		std::cout << "\t ... Rejected " << m_NumberOfRejectedFrames << " frames that did not match the geometry of the first frame" << std::endl;
+	}
+
+	if (m_NumberOfDroppedFrames > 0)
+	{
+		std::cout << "WARNING - FrameLogWriter::Close:" << std::endl;
+		std::cout << "\t ... Dropped " << m_NumberOfDroppedFrames << " of " << m_NumberOfFrames + m_NumberOfDroppedFrames
+			<< " frames because writing to '" << m_Filename << "' was too slow" << std::endl;
+	}
+
+	return RET_OK;
+}
+
+size_t FrameLogWriter::GetNumberOfFrames()
+{
+	boost::mutex::scoped_lock lock(m_QueueMutex);
+	return m_NumberOfFrames;
+}
+
+size_t FrameLogWriter::GetNumberOfDroppedFrames()
+{
+	boost::mutex::scoped_lock lock(m_QueueMutex);
+	return m_NumberOfDroppedFrames;
+}
+
+size_t FrameLogWriter::GetNumberOfRejectedFrames()
+{
+	boost::mutex::scoped_lock lock(m_QueueMutex);
+	return m_NumberOfRejectedFrames;
+}
+
+bool FrameLogWriter::HasFailed()
+{
+	boost::mutex::scoped_lock lock(m_QueueMutex);
+	return m_WriteFailed;
+}
+
+unsigned long FrameLogWriter::RejectFrame(const std::string& reason)
+{
+	boost::mutex::scoped_lock lock(m_QueueMutex);
+	// Reported once, the total follows in Close()
+	if (m_NumberOfRejectedFrames++ == 0)
+	{
+		std::cerr << "ERROR - FrameLogWriter::Write:" << std::endl;
+		std::cerr << "\t ... " << reason << ", frame rejected" << std::endl;
+	}
+	return RET_FAILED;
+}
+
+unsigned long FrameLogWriter::SetCalibration(const cv::Mat& intrinsicMatrix, const cv::Mat& extrinsicMatrix)
+{
+	if (m_GeometryFixed)
+	{
+		std::cerr << "ERROR - FrameLogWriter::SetCalibration:" << std::endl;
+		std::cerr << "\t ... Calibration has to be set before the first frame is written" << std::endl;
+		return RET_FAILED;
+	}
+
+	m_Header.m_Flags &= ~(FRAMELOG_HAS_INTRINSICS | FRAMELOG_HAS_EXTRINSICS);
+	if (intrinsicMatrix.rows == 3 && intrinsicMatrix.cols == 3 && intrinsicMatrix.type() == CV_64FC1)
+	{
+		for (int i=0; i<9; i++)
+		{
+			m_Header.m_IntrinsicMatrix[i] = intrinsicMatrix.at<double>(i/3, i%3);
+		}
+		m_Header.m_Flags |= FRAMELOG_HAS_INTRINSICS;
+	}
+	if (extrinsicMatrix.rows >= 3 && extrinsicMatrix.cols == 4 && extrinsicMatrix.type() == CV_64FC1)
+	{
+		for (int i=0; i<12; i++)
+		{
+			m_Header.m_ExtrinsicMatrix[i] = extrinsicMatrix.at<double>(i/4, i%4);
+		}
+		m_Header.m_Flags |= FRAMELOG_HAS_EXTRINSICS;
+	}
+
+	return RET_OK;
+}
+
+unsigned long FrameLogWriter::Write(double timestamp, const cv::Mat* rangeImage, const cv::Mat* colorImage, const cv::Mat* cartesianImage)
+{
+	if (!isOpen())
+	{
+		std::cerr << "ERROR - FrameLogWriter::Write:" << std::endl;
+		std::cerr << "\t ... Log file not open" << std::endl;
+		return RET_FAILED;
+	}
+
+	const cv::Mat* images[FRAMELOG_NUM_STREAMS] = {rangeImage, colorImage, cartesianImage};
+
+	// Reject a frame that does not fit the log right here, so it neither
+	// reaches the writer nor fails the frames that follow
+	if (!m_GeometryFixed)
+	{
+		if (FixGeometry(images) & RET_FAILED)
+		{
+			return RejectFrame("Frame contains no image");
+		}
+	}
+	else
+	{
+		for (int i=0; i<FRAMELOG_NUM_STREAMS; i++)
+		{
+			if (!images[i] || images[i]->empty())
+			{
+				continue;
+			}
+			if (images[i]->cols != m_Header.m_Width[i] || images[i]->rows != m_Header.m_Height[i] ||
+				images[i]->type() != m_Header.m_Type[i])
+			{
+				return RejectFrame("Geometry of a stream differs from the first frame");
+			}
+		}
+	}
+
+	if (!m_WriterThread)
+	{
+		unsigned long ret = WriteRecord(timestamp, images);
+		boost::mutex::scoped_lock lock(m_QueueMutex);
+		if (ret & RET_FAILED)
+		{
+			m_WriteFailed = true;
+		}
+		else
+		{
+			m_NumberOfFrames++;
+		}
+		return ret;
+	}
+
+	// Claim a free buffer, drop the frame if the writer fell behind
+	size_t slot = 0;
+	{
+		boost::mutex::scoped_lock lock(m_QueueMutex);
+		if (m_WriteFailed)
+		{
+			std::cerr << "ERROR - FrameLogWriter::Write:" << std::endl;
+			std::cerr << "\t ... Error while writing to file '" << m_Filename << "'" << std::endl;
+			return RET_FAILED;
+		}
+		if (m_FreeFrames.empty())
+		{
+			m_NumberOfDroppedFrames++;
+			return RET_OK;
+		}
+		slot = m_FreeFrames.front();
+		m_FreeFrames.pop_front();
+	}
+
+	// The buffer is owned exclusively until it is queued, so copy without holding the lock.
+	// copyTo() reuses the buffer's memory once it has the right geometry.
+	t_QueuedFrame& frame = m_Frames[slot];
+	frame.m_Timestamp = timestamp;
+	for (int i=0; i<FRAMELOG_NUM_STREAMS; i++)
+	{
+		frame.m_Valid[i] = (images[i] && !images[i]->empty());
+		if (frame.m_Valid[i])
+		{
+			images[i]->copyTo(frame.m_Images[i]);
+		}
+	}
+
+	{
+		boost::mutex::scoped_lock lock(m_QueueMutex);
+		m_PendingFrames.push_back(slot);
+	}
+	m_QueueCondition.notify_one();
+
+	return RET_OK;
+}
+
+void FrameLogWriter::WriterThread()
+{
+	while (true)
+	{
+		size_t slot = 0;
+		{
+			boost::mutex::scoped_lock lock(m_QueueMutex);
+			while (m_PendingFrames.empty() && !m_StopWriter)
+			{
+				m_QueueCondition.wait(lock);
+			}
+			if (m_PendingFrames.empty())
+			{
+				// Stop requested and all frames written
+				break;
+			}
+			slot = m_PendingFrames.front();
+			m_PendingFrames.pop_front();
+		}
+
+		t_QueuedFrame& frame = m_Frames[slot];
+		const cv::Mat* images[FRAMELOG_NUM_STREAMS];
+		for (int i=0; i<FRAMELOG_NUM_STREAMS; i++)
+		{
+			images[i] = frame.m_Valid[i] ? &frame.m_Images[i] : 0;
+		}
+		unsigned long ret = WriteRecord(frame.m_Timestamp, images);
+
+		{
+			boost::mutex::scoped_lock lock(m_QueueMutex);
+			if (ret & RET_FAILED)
+			{
+				m_WriteFailed = true;
+			}
+			else
+			{
+				m_NumberOfFrames++;
+			}
+			m_FreeFrames.push_back(slot);
+		}
+	}
+}
+
+unsigned long FrameLogWriter::FixGeometry(const cv::Mat* const images[FRAMELOG_NUM_STREAMS])
+{
+	bool hasImage = false;
+	for (int i=0; i<FRAMELOG_NUM_STREAMS; i++)
+	{
+		hasImage = hasImage || (images[i] && !images[i]->empty());
+	}
+	if (!hasImage)
+	{
+		return RET_FAILED;
+	}
+
+	for (int i=0; i<FRAMELOG_NUM_STREAMS; i++)
+	{
+		if (images[i] && !images[i]->empty())
+		{
+			m_Header.m_Width[i] = images[i]->cols;
+			m_Header.m_Height[i] = images[i]->rows;
+			m_Header.m_Type[i] = images[i]->type();
+			m_Header.m_Encoding[i] = FRAMELOG_ENCODING_RAW;
+		}
+	}
+
+	if (m_Options.m_Depth16U && m_Header.m_Type[FRAMELOG_RANGE] == CV_32FC1 &&
+		m_Header.m_Width[FRAMELOG_RANGE] > 0)
+	{
+		m_Header.m_Encoding[FRAMELOG_RANGE] = FRAMELOG_ENCODING_DEPTH_16U_MM;
+	}
+
+	m_GeometryFixed = true;
+	return RET_OK;
+}
+
+void FrameLogWriter::WriteHeader()
+{
+	std::vector<char> header(m_Header.m_HeaderSize, 0);
+	std::memcpy(&header[0], &m_Header, sizeof(m_Header));
+	m_File.write(&header[0], header.size());
+	m_Offset = header.size();
+	m_HeaderWritten = true;
+}
+
+const char* FrameLogWriter::EncodeStream(int stream, const cv::Mat& image, size_t& size, bool& compressed)
+{
+	const char* raw = 0;
+	std::vector<char>& scratch = m_ScratchBuffer[stream];
+
+	if (m_Header.m_Encoding[stream] == FRAMELOG_ENCODING_DEPTH_16U_MM)
+	{
+		size = image.rows * image.cols * sizeof(unsigned short);
+		scratch.resize(size);
+		unsigned short* p_mm = (unsigned short*)&scratch[0];
+		for (int row=0; row<image.rows; row++)
+		{
+			const float* p_m = image.ptr<float>(row);
+			for (int col=0; col<image.cols; col++)
+			{
+				// Invalid, negative and NaN ranges are all mapped to 0
+				float m = p_m[col];
+				*p_mm++ = (m > 0.f && m < 65.535f) ? (unsigned short)(m * 1000.f + 0.5f) : 0;
+			}
+		}
+		raw = &scratch[0];
+	}
+	else
+	{
+		size = image.rows * image.cols * image.elemSize();
+		if (image.isContinuous())
+		{
+			raw = (const char*)image.data;
+		}
+		else
+		{
+			scratch.resize(size);
+			size_t rowSize = image.cols * image.elemSize();
+			for (int row=0; row<image.rows; row++)
+			{
+				std::memcpy(&scratch[row * rowSize], image.ptr(row), rowSize);
+			}
+			raw = &scratch[0];
+		}
+	}
+
+	compressed = false;
+#ifdef __USE_LZ4__
+	if (m_Options.m_Compress)
+	{
+		std::vector<char>& encoded = m_EncodeBuffer[stream];
+		encoded.resize(LZ4_compressBound((int)size));
+		int compressedSize = LZ4_compress_default(raw, &encoded[0], (int)size, (int)encoded.size());
+		// Keep incompressible data, e.g. noisy color images, uncompressed
+		if (compressedSize > 0 && (size_t)compressedSize < size)
+		{
+			size = compressedSize;
+			compressed = true;
+			return &encoded[0];
+		}
+	}
+#endif
+
+	return raw;
+}
+
+unsigned long FrameLogWriter::WriteRecord(double timestamp, const cv::Mat* const images[FRAMELOG_NUM_STREAMS])
+{
+	// Write() has fixed the geometry with the first frame and checked this one against it
+	if (!m_HeaderWritten)
+	{
+		WriteHeader();
+	}
+
+	t_FrameLogRecord record;
+	std::memset(&record, 0, sizeof(record));
+	record.m_Magic = FRAMELOG_RECORD_MAGIC;
+	record.m_Timestamp = timestamp;
+
+	const char* payload[FRAMELOG_NUM_STREAMS] = {0, 0, 0};
+	size_t recordSize = sizeof(record);
+	for (int i=0; i<FRAMELOG_NUM_STREAMS; i++)
+	{
+		if (!images[i] || images[i]->empty())
+		{
+			continue;
+		}
+
+		size_t size = 0;
+		bool compressed = false;
+		payload[i] = EncodeStream(i, *images[i], size, compressed);
+
+		record.m_StreamMask |= (1 << i);
+		record.m_CompressedMask |= compressed ? (1 << i) : 0;
+		record.m_Size[i] = size;
+		recordSize += AlignRecordSize(size);
+	}
+
+	static const char padding[FRAMELOG_RECORD_ALIGNMENT] = {0};
+	m_File.write((const char*)&record, sizeof(record));
+	for (int i=0; i<FRAMELOG_NUM_STREAMS; i++)
+	{
+		if (payload[i])
+		{
+			m_File.write(payload[i], record.m_Size[i]);
+			m_File.write(padding, AlignRecordSize(record.m_Size[i]) - record.m_Size[i]);
+		}
+	}
+
+	// The index entry follows the record, so a crash leaves at most records without index entries
+	t_FrameLogIndexEntry entry;
+	entry.m_Offset = m_Offset;
+	entry.m_Timestamp = timestamp;
+	m_IndexFile.write((const char*)&entry, sizeof(entry));
+	m_Offset += recordSize;
+
+	if (m_File.fail() || m_IndexFile.fail())
+	{
+		std::cerr << "ERROR - FrameLogWriter::WriteRecord:" << std::endl;
+		std::cerr << "\t ... Error while writing to file '" << m_Filename << "'" << std::endl;
+		return RET_FAILED;
+	}
+
+	return RET_OK;
+}
+
+//*******************************************************************************
+// FrameLogReader
+//*******************************************************************************
+
+FrameLogReader::FrameLogReader()
+{
+	m_Data = 0;
+	m_open = false;
+	std::memset(&m_Header, 0, sizeof(m_Header));
+}
+
+FrameLogReader::~FrameLogReader()
+{
+	Close();
+}
+
+unsigned long FrameLogReader::Open(const std::string& filename)
+{
+	Close();
+
+	try
+	{
+		boost::interprocess::file_mapping mapping(filename.c_str(), boost::interprocess::read_only);
+		boost::interprocess::mapped_region region(mapping, boost::interprocess::read_only);
+		m_Mapping.swap(mapping);
+		m_Region.swap(region);
+	}
+	catch (boost::interprocess::interprocess_exception& e)
+	{
+		std::cerr << "ERROR - FrameLogReader::Open:" << std::endl;
+		std::cerr << "\t ... Could not map file '" << filename << "'" << std::endl;
+		std::cerr << "\t ... " << e.what() << std::endl;
+		return (RET_FAILED | RET_FAILED_OPEN_FILE);
+	}
+
+	m_Data = (const char*)m_Region.get_address();
+	size_t fileSize = m_Region.get_size();
+
+	if (fileSize < sizeof(t_FrameLogHeader))
+	{
+		std::cerr << "ERROR - FrameLogReader::Open:" << std::endl;
+		std::cerr << "\t ... File '" << filename << "' contains no frames" << std::endl;
+		Close();
+		return RET_FAILED;
+	}
+
+	std::memcpy(&m_Header, m_Data, sizeof(m_Header));
+	if (std::memcmp(m_Header.m_Magic, FRAMELOG_MAGIC, sizeof(m_Header.m_Magic)) != 0 ||
+		m_Header.m_Version != FRAMELOG_VERSION)
+	{
+		std::cerr << "ERROR - FrameLogReader::Open:" << std::endl;
+		std::cerr << "\t ... File '" << filename << "' is not a frame log of version " << FRAMELOG_VERSION << std::endl;
+		Close();
+		return RET_FAILED;
+	}
+
+	// Take indexed records, then recover records that did not make it into the index
+	size_t offset = ReadIndex(filename, fileSize);
+	size_t recovered = 0;
+	size_t recordSize = 0;
+	while ((recordSize = GetRecordSize(offset, fileSize)) > 0)
+	{
+		m_Records.push_back(offset);
+		offset += recordSize;
+		recovered++;
+	}
+
+	m_open = true;
+	std::cout << "INFO - FrameLogReader::Open:" << std::endl;
+	std::cout << "\t ... Mapped " << m_Records.size() << " frames from '" << filename << "'" << std::endl;
+	if (recovered > 0)
+	{
+		std::cout << "\t ... " << recovered << " frames were missing in the index" << std::endl;
+	}
+
+	return RET_OK;
+}
+
+size_t FrameLogReader::ReadIndex(const std::string& filename, size_t fileSize)
+{
+	std::ifstream indexFile((filename + ".idx").c_str(), std::ios::in | std::ios::binary);
+	if (!indexFile.is_open())
+	{
+		return m_Header.m_HeaderSize;
+	}
+
+	t_FrameLogIndexEntry entry;
+	size_t lastOffset = 0;
+	while (indexFile.read((char*)&entry, sizeof(entry)))
+	{
+		// Stop at entries that do not point into the log
+		if (entry.m_Offset < m_Header.m_HeaderSize || entry.m_Offset >= fileSize ||
+			(!m_Records.empty() && entry.m_Offset <= lastOffset))
+		{
+			break;
+		}
+		m_Records.push_back((size_t)entry.m_Offset);
+		lastOffset = (size_t)entry.m_Offset;
+	}
+
+	// Only the tail of the log can be incomplete
+	while (!m_Records.empty() && GetRecordSize(m_Records.back(), fileSize) == 0)
+	{
+		m_Records.pop_back();
+	}
+
+	if (m_Records.empty())
+	{
+		return m_Header.m_HeaderSize;
+	}
+	return m_Records.back() + GetRecordSize(m_Records.back(), fileSize);
+}
+
+size_t FrameLogReader::GetRecordSize(size_t offset, size_t fileSize) const
+{
+	if (offset + sizeof(t_FrameLogRecord) > fileSize)
+	{
+		return 0;
+	}
+
+	const t_FrameLogRecord* record = (const t_FrameLogRecord*)(m_Data + offset);
+	if (record->m_Magic != FRAMELOG_RECORD_MAGIC)
+	{
+		return 0;
+	}
+
+	size_t recordSize = sizeof(t_FrameLogRecord);
+	for (int i=0; i<FRAMELOG_NUM_STREAMS; i++)
+	{
+		recordSize += AlignRecordSize(record->m_Size[i]);
+	}
+
+	if (offset + recordSize > fileSize)
+	{
+		// Truncated record
+		return 0;
+	}
+
+	return recordSize;
+}
+
+unsigned long FrameLogReader::Close()
+{
+	boost::interprocess::mapped_region emptyRegion;
+	boost::interprocess::file_mapping emptyMapping;
+	m_Region.swap(emptyRegion);
+	m_Mapping.swap(emptyMapping);
+
+	m_Data = 0;
+	m_Records.clear();
+	m_open = false;
+
+	return RET_OK;
+}
+
+cv::Mat FrameLogReader::GetIntrinsicMatrix() const
+{
+	if ((m_Header.m_Flags & FRAMELOG_HAS_INTRINSICS) == 0)
+	{
+		return cv::Mat();
+	}
+	return cv::Mat(3, 3, CV_64FC1, (void*)m_Header.m_IntrinsicMatrix).clone();
+}
+
+cv::Mat FrameLogReader::GetExtrinsicMatrix() const
+{
+	if ((m_Header.m_Flags & FRAMELOG_HAS_EXTRINSICS) == 0)
+	{
+		return cv::Mat();
+	}
+	return cv::Mat(3, 4, CV_64FC1, (void*)m_Header.m_ExtrinsicMatrix).clone();
+}
+
+double FrameLogReader::GetTimestamp(size_t index) const
+{
+	const t_FrameLogRecord* record = (const t_FrameLogRecord*)(m_Data + m_Records[index]);
+	return record->m_Timestamp;
+}
+
+unsigned long FrameLogReader::DecodeStream(size_t index, t_FrameLogStream stream, cv::Mat& image)
+{
+	const t_FrameLogRecord* record = (const t_FrameLogRecord*)(m_Data + m_Records[index]);
+	if ((record->m_StreamMask & (1 << stream)) == 0)
+	{
+		image.release();
+		return RET_OK;
+	}
+
+	const char* data = (const char*)(record + 1);
+	for (int i=0; i<stream; i++)
+	{
+		data += AlignRecordSize(record->m_Size[i]);
+	}
+
+	int width = m_Header.m_Width[stream];
+	int height = m_Header.m_Height[stream];
+	int type = m_Header.m_Type[stream];
+	bool depth16U = (m_Header.m_Encoding[stream] == FRAMELOG_ENCODING_DEPTH_16U_MM);
+	size_t rawSize = width * height * (depth16U ? sizeof(unsigned short) : CV_ELEM_SIZE(type));
+
+	if (record->m_CompressedMask & (1 << stream))
+	{
+#ifdef __USE_LZ4__
+		m_DecodeBuffer.resize(rawSize);
+		int decodedSize = LZ4_decompress_safe(data, &m_DecodeBuffer[0], (int)record->m_Size[stream], (int)rawSize);
+		if (decodedSize != (int)rawSize)
+		{
+			std::cerr << "ERROR - FrameLogReader::DecodeStream:" << std::endl;
+			std::cerr << "\t ... Decompression of frame " << index << " failed" << std::endl;
+			return RET_FAILED;
+		}
+		data = &m_DecodeBuffer[0];
+#else
+		std::cerr << "ERROR - FrameLogReader::DecodeStream:" << std::endl;
+		std::cerr << "\t ... Frame " << index << " is LZ4 compressed, but the library was built without LZ4 support" << std::endl;
+		return RET_FAILED;
+#endif
+	}
+	else if (record->m_Size[stream] != rawSize)
+	{
+		std::cerr << "ERROR - FrameLogReader::DecodeStream:" << std::endl;
+		std::cerr << "\t ... Size of stream " << stream << " in frame " << index << " does not match the header" << std::endl;
+		return RET_FAILED;
+	}
+
+	if (depth16U)
+	{
+		image.create(height, width, CV_32FC1);
+		const unsigned short* p_mm = (const unsigned short*)data;
+		for (int row=0; row<height; row++)
+		{
+			float* p_m = image.ptr<float>(row);
+			for (int col=0; col<width; col++)
+			{
+				p_m[col] = 0.001f * (float)(*p_mm++);
+			}
+		}
+	}
+	else
+	{
+		// The mapping is read-only, the header must not be written through
+		cv::Mat(height, width, type, (void*)data).copyTo(image);
+	}
+
+	return RET_OK;
+}
+
+unsigned long FrameLogReader::GetFrame(size_t index, cv::Mat* rangeImage, cv::Mat* colorImage, cv::Mat* cartesianImage)
+{
+	if (!m_open || index >= m_Records.size())
+	{
+		std::cerr << "ERROR - FrameLogReader::GetFrame:" << std::endl;
+		std::cerr << "\t ... Frame " << index << " not available" << std::endl;
+		return RET_FAILED;
+	}
+
+	cv::Mat* images[FRAMELOG_NUM_STREAMS] = {rangeImage, colorImage, cartesianImage};
+	for (int i=0; i<FRAMELOG_NUM_STREAMS; i++)
+	{
+		if (images[i] && (DecodeStream(index, (t_FrameLogStream)i, *images[i]) & RET_FAILED))
+		{
+			return RET_FAILED;
+		}
+	}
+
+	return RET_OK;
+}
+
+//*******************************************************************************
+// FrameLogPlayer
+//*******************************************************************************
+
+FrameLogPlayer::FrameLogPlayer()
+{
+	m_Reader = 0;
+	m_PlaybackSpeed = 1.;
+	m_Loop = false;
+	m_NextFrame = 0;
+}
+
+void FrameLogPlayer::Reset(const FrameLogReader* reader, double playbackSpeed, bool loop)
+{
+	m_Reader = reader;
+	m_PlaybackSpeed = playbackSpeed;
+	m_Loop = loop;
+	m_NextFrame = 0;
+	m_StartTime = boost::posix_time::not_a_date_time;
+}
+
+boost::posix_time::ptime FrameLogPlayer::DueTime(size_t index) const
+{
+	double offset = (m_Reader->GetTimestamp(index) - m_Reader->GetTimestamp(0)) / m_PlaybackSpeed;
+	return m_StartTime + boost::posix_time::microseconds((long)(offset * 1e6));
+}
+
+long FrameLogPlayer::NextFrame(bool getLatestFrame)
+{
+	if (!m_Reader || m_Reader->GetNumberOfFrames() == 0)
+	{
+		return -1;
+	}
+
+	if (m_NextFrame >= m_Reader->GetNumberOfFrames())
+	{
+		if (!m_Loop)
+		{
+			return -1;
+		}
+		m_NextFrame = 0;
+		m_StartTime = boost::posix_time::not_a_date_time;
+	}
+
+	if (m_PlaybackSpeed <= 0.)
+	{
+		return (long)m_NextFrame++;
+	}
+
+	boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+	if (m_StartTime.is_not_a_date_time())
+	{
+		// Replay time starts with the first requested frame
+		m_StartTime = now;
+	}
+
+	size_t frame = m_NextFrame;
+	if (getLatestFrame)
+	{
+		// Skip all frames that have already been superseded
+		while (frame + 1 < m_Reader->GetNumberOfFrames() && DueTime(frame + 1) <= now)
+		{
+			frame++;
+		}
+	}
+
+	boost::posix_time::ptime due = DueTime(frame);
+	if (due > now)
+	{
+		boost::this_thread::sleep(due - now);
+	}
+
+	m_NextFrame = frame + 1;
+	return (long)frame;
+}
+
+//*******************************************************************************
+// Configuration
+//*******************************************************************************
+
+unsigned long ipa_CameraSensors::LoadFrameLogReplayParameters(const char* filename, const std::string& cameraTag,
+	std::string& path, double& playbackSpeed, bool& loop)
+{
+	boost::shared_ptr<TiXmlDocument> p_configXmlDocument (new TiXmlDocument( filename ));
+	if (!p_configXmlDocument->LoadFile())
+	{
+		std::cerr << "ERROR - LoadFrameLogReplayParameters:" << std::endl;
+		std::cerr << "\t ... Error while loading xml configuration file (Check filename and syntax of the file):\n";
+		std::cerr << "\t ... '" << filename << "'" << std::endl;
+		return (RET_FAILED | RET_FAILED_OPEN_FILE);
+	}
+	std::cout << "INFO - LoadFrameLogReplayParameters:" << std::endl;
+	std::cout << "\t ... Parsing xml configuration file:" << std::endl;
+	std::cout << "\t ... '" << filename << "'" << std::endl;
+
+//************************************************************************************
+//	BEGIN LibCameraSensors
+//************************************************************************************
+	TiXmlElement *p_xmlElement_Root = p_configXmlDocument->FirstChildElement( "LibCameraSensors" );
+	if (!p_xmlElement_Root)
+	{
+		std::cerr << "ERROR - LoadFrameLogReplayParameters:" << std::endl;
+		std::cerr << "\t ... Can't find tag 'LibCameraSensors'." << std::endl;
+		return (RET_FAILED | RET_XML_TAG_NOT_FOUND);
+	}
+
+//************************************************************************************
+//	BEGIN LibCameraSensors->cameraTag
+//************************************************************************************
+	TiXmlElement *p_xmlElement_Camera = p_xmlElement_Root->FirstChildElement( cameraTag );
+	if (!p_xmlElement_Camera)
+	{
+		std::cerr << "ERROR - LoadFrameLogReplayParameters:" << std::endl;
+		std::cerr << "\t ... Can't find tag '" << cameraTag << "'." << std::endl;
+		return (RET_FAILED | RET_XML_TAG_NOT_FOUND);
+	}
+
+//************************************************************************************
+//	BEGIN LibCameraSensors->cameraTag->Path
+//************************************************************************************
+	TiXmlElement* p_xmlElement_Child = p_xmlElement_Camera->FirstChildElement( "Path" );
+	if (!p_xmlElement_Child)
+	{
+		std::cerr << "ERROR - LoadFrameLogReplayParameters:" << std::endl;
+		std::cerr << "\t ... Can't find tag 'Path'." << std::endl;
+		return (RET_FAILED | RET_XML_TAG_NOT_FOUND);
+	}
+	if (p_xmlElement_Child->QueryValueAttribute( "value", &path ) != TIXML_SUCCESS)
+	{
+		std::cerr << "ERROR - LoadFrameLogReplayParameters:" << std::endl;
+		std::cerr << "\t ... Can't find attribute 'value' of tag 'Path'." << std::endl;
+		return (RET_FAILED | RET_XML_ATTR_NOT_FOUND);
+	}
+	if (!path.empty() && path[0] != '/')
+	{
+		std::string configFile(filename);
+		size_t separator = configFile.find_last_of("/\\");
+		if (separator != std::string::npos)
+		{
+			path = configFile.substr(0, separator + 1) + path;
+		}
+	}
+
+//************************************************************************************
+//	BEGIN LibCameraSensors->cameraTag->PlaybackSpeed
+//************************************************************************************
+	playbackSpeed = 1.;
+	p_xmlElement_Child = p_xmlElement_Camera->FirstChildElement( "PlaybackSpeed" );
+	if (p_xmlElement_Child && p_xmlElement_Child->QueryValueAttribute( "value", &playbackSpeed ) != TIXML_SUCCESS)
+	{
+		std::cerr << "ERROR - LoadFrameLogReplayParameters:" << std::endl;
+		std::cerr << "\t ... Can't find attribute 'value' of tag 'PlaybackSpeed'." << std::endl;
+		return (RET_FAILED | RET_XML_ATTR_NOT_FOUND);
+	}
+
+//************************************************************************************
+//	BEGIN LibCameraSensors->cameraTag->Loop
+//************************************************************************************
+	loop = false;
+	p_xmlElement_Child = p_xmlElement_Camera->FirstChildElement( "Loop" );
+	if (p_xmlElement_Child)
+	{
+		std::string tempString;
+		if (p_xmlElement_Child->QueryValueAttribute( "value", &tempString ) != TIXML_SUCCESS)
+		{
+			std::cerr << "ERROR - LoadFrameLogReplayParameters:" << std::endl;
+			std::cerr << "\t ... Can't find attribute 'value' of tag 'Loop'." << std::endl;
+			return (RET_FAILED | RET_XML_ATTR_NOT_FOUND);
+		}
+		loop = (tempString == "true" || tempString == "1");
+	}
+
+	return RET_OK;
+}
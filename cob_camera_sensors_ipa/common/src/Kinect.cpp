@@ -1,6 +1,8 @@
 #include <cob_vision_utils/StdAfx.h>
 #ifdef __LINUX__
 	#include "cob_camera_sensors_ipa/Kinect.h"	
+	#include "cob_camera_sensors_ipa/ProcessingKernels.h"
+	#include "cob_camera_sensors_ipa/AcquisitionProfiler.h"
 	#include "cob_vision_utils/GlobalDefines.h"
 
 	#include "tinyxml.h"
@@ -8,22 +10,29 @@
 	#include <iostream>
 #else
 	#include "cob_bringup_sandbox/cob_camera_sensors_ipa/common/include/cob_camera_sensors_ipa/Kinect.h"
+	#include "cob_bringup_sandbox/cob_camera_sensors_ipa/common/include/cob_camera_sensors_ipa/ProcessingKernels.h"
+	#include "cob_bringup_sandbox/cob_camera_sensors_ipa/common/include/cob_camera_sensors_ipa/AcquisitionProfiler.h"
 	#include "cob_perception_common/cob_vision_utils/common/include/cob_vision_utils/GlobalDefines.h"
 #endif
 
 
 
 using namespace ipa_CameraSensors;
-#define AVG(a,b) (((int)(a) + (int)(b)) >> 1)
-#define AVG3(a,b,c) (((int)(a) + (int)(b) + (int)(c)) / 3)
-#define AVG4(a,b,c,d) (((int)(a) + (int)(b) + (int)(c) + (int)(d)) >> 2)
-#define WAVG4(a,b,c,d,x,y)  ( ( ((int)(a) + (int)(b)) * (int)(x) + ((int)(c) + (int)(d)) * (int)(y) ) / ( 2 * ((int)(x) + (int(y))) ) )
-#define IPA_CLIP_CHAR(c) ((c)>255?255:(c)<0?0:(c))
 #define XN_SXGA_X_RES 1280
 #define XN_SXGA_Y_RES 1024
 #define XN_VGA_X_RES 640
 #define XN_VGA_Y_RES 480
 
+static const int s_StageTotal = AcquisitionProfiler::RegisterStage("Kinect/total");
+static const int s_StageWaitDepth = AcquisitionProfiler::RegisterStage("Kinect/sdk_wait_depth");
+static const int s_StageWaitColor = AcquisitionProfiler::RegisterStage("Kinect/sdk_wait_color");
+static const int s_StageWaitIR = AcquisitionProfiler::RegisterStage("Kinect/sdk_wait_ir");
+static const int s_StageCopy = AcquisitionProfiler::RegisterStage("Kinect/copy");
+static const int s_StageBackProjection = AcquisitionProfiler::RegisterStage("Kinect/back_projection");
+static const int s_StageRegistration = AcquisitionProfiler::RegisterStage("Kinect/registration");
+static const int s_StageRangeConversion = AcquisitionProfiler::RegisterStage("Kinect/range_conversion");
+static const int s_StageColorConversion = AcquisitionProfiler::RegisterStage("Kinect/color_conversion");
+
 __DLL_LIBCAMERASENSORS__ AbstractRangeImagingSensorPtr ipa_CameraSensors::CreateRangeImagingSensor_Kinect()
 {
 	return AbstractRangeImagingSensorPtr(new Kinect());
@@ -59,6 +68,8 @@ unsigned long Kinect::Init(std::string directory, int cameraIndex)
 		return ipa_Utils::RET_OK;
 	}
 
+	AcquisitionProfiler::InstallDefaultDumpSignalHandler();
+
 	//XnStatus retVal = XN_STATUS_OK;
 
 	openni::Status retVal = openni::STATUS_OK;
@@ -537,6 +548,8 @@ unsigned long Kinect::AcquireImages(int widthStepRange, int widthStepColor, int
 	int range_height = m_depth_md.YRes();
 	*/
 
+	ScopedStageTimer totalTimer(s_StageTotal);
+
 	int color_width = m_vs_rgb.getVideoMode().getResolutionX();
 	int color_height = m_vs_rgb.getVideoMode().getResolutionY();
 	
@@ -560,6 +573,7 @@ unsigned long Kinect::AcquireImages(int widthStepRange, int widthStepColor, int
 	openni::Status retVal;
 
 	//get depth frame
+	ScopedStageTimer waitDepthTimer(s_StageWaitDepth);
 	tempStream_d = &m_vs_d;
 	retVal = openni::OpenNI::waitForAnyStream(&tempStream_d, 1, &changedIndex, 2000); //2000ms
 	if (retVal != openni::STATUS_OK)
@@ -569,6 +583,7 @@ unsigned long Kinect::AcquireImages(int widthStepRange, int widthStepColor, int
 		return ipa_Utils::RET_FAILED;;
 	}
 	m_vs_d.readFrame(&m_vfr_d); 
+	waitDepthTimer.Stop();
 	
 	//Debug: show the mittel pixel value
 	/*
@@ -578,6 +593,7 @@ unsigned long Kinect::AcquireImages(int widthStepRange, int widthStepColor, int
 	*/
 
 	//get color frame
+	ScopedStageTimer waitColorTimer(s_StageWaitColor);
 	tempStream_rgb = &m_vs_rgb;
 	retVal = openni::OpenNI::waitForAnyStream(&tempStream_rgb, 1, &changedIndex, 2000); //2000ms
 	if (retVal != openni::STATUS_OK)
@@ -587,6 +603,7 @@ unsigned long Kinect::AcquireImages(int widthStepRange, int widthStepColor, int
 		return ipa_Utils::RET_FAILED;;
 	}
 	m_vs_rgb.readFrame(&m_vfr_rgb); 
+	waitColorTimer.Stop();
 
 	//get ir frame
 	if(grayImageType == IR)
@@ -602,6 +619,7 @@ unsigned long Kinect::AcquireImages(int widthStepRange, int widthStepColor, int
 			return ipa_Utils::RET_FAILED;;
 		}
 
+		ScopedStageTimer waitIRTimer(s_StageWaitIR);
 		tempStream_ir = &m_vs_ir;
 		retVal = openni::OpenNI::waitForAnyStream(&tempStream_ir, 1, &changedIndex, 2000); //2000ms
 		if (retVal != openni::STATUS_OK)
@@ -612,6 +630,7 @@ unsigned long Kinect::AcquireImages(int widthStepRange, int widthStepColor, int
 		}
 		
 		m_vs_ir.readFrame(&m_vfr_ir); 
+		waitIRTimer.Stop();
 
 		m_vfr_ir.getData();
 
@@ -652,20 +671,16 @@ unsigned long Kinect::AcquireImages(int widthStepRange, int widthStepColor, int
 	fy = m_intrinsicMatrix.at<double>(1, 1);
 	cx = m_intrinsicMatrix.at<double>(0, 2);
 	cy = m_intrinsicMatrix.at<double>(1, 2);
-	float constant_x = 0.001 / fx;
-	float constant_y = 0.001 / fy;
 
 	if(rangeImageData || cartesianImageData)
 	{
-		float* p_xyz = 0;
 		unsigned short* p_us_dist = 0;
-		float* p_f_dist = 0;
-		int colTimes3;
 
 		bool createRangeImage = (rangeImageData != 0);
 		bool createXYZImage = (cartesianImageData != 0);
 
 		// Get z values
+		ScopedStageTimer copyTimer(s_StageCopy);
 		char* range_mat_ptr = m_range_mat.ptr<char>(0);
 		//memcpy( range_mat_ptr, m_depth_md.Data(), range_height * range_width * sizeof(XnDepthPixel) );
 		memcpy( range_mat_ptr, m_vfr_d.getData(), range_height * range_width * sizeof(openni::DepthPixel) ); 
@@ -687,95 +702,67 @@ unsigned long Kinect::AcquireImages(int widthStepRange, int widthStepColor, int
 		}
 		else
 			resized_range_mat = m_range_mat;
+		copyTimer.Stop();
 		
 		// Convert zuv values to float xyz
-		cv::Mat transformedXYZ = cv::Mat::zeros(range_height, range_width, CV_32FC3);
 		if (createXYZImage)
 		{
-			int xzy_step = range_width * sizeof(float) * 3;
-			int d_step = range_width * sizeof(unsigned short);
-			
-			m_XYZ.create(3, 1, CV_64FC1);
-
-			double* d_ptr = 0;
-			double x,y,z;
-			int u = 0, v = 0;
-
-			//For fast calculation: avoid using matrix multiplication
-			d_ptr = m_extrinsicMatrix.ptr<double>(0);
-			
-			double er11 = d_ptr[0], er12 = d_ptr[1], er13 = d_ptr[2], et1 = d_ptr[3],
-				   er21 = d_ptr[4], er22 = d_ptr[5], er23 = d_ptr[6], et2 = d_ptr[7],
-				   er31 = d_ptr[8], er32 = d_ptr[9], er33 = d_ptr[10], et3 = d_ptr[11];
+			int xyz_step = range_width * sizeof(float) * 3;
+			ScopedStageTimer backProjectionTimer(s_StageBackProjection);
+			ConvertDepthToCartesian(resized_range_mat, fx, fy, cx, cy, cartesianImageData, xyz_step, m_badDepth);
+			backProjectionTimer.Stop();
 
-			for(unsigned int row=0; row<(unsigned int)range_height; row++)
+			// Calculate the registrated coordinates if the registration is off
+			if (m_CalibrationMethod == MATLAB_NO_Z)
 			{
-				p_xyz = (float*) (cartesianImageData + row * xzy_step);
-				p_us_dist = resized_range_mat.ptr<unsigned short>(row);
-
-				for (unsigned int col = 0; col < (unsigned int)range_width; col++)
+				ScopedStageTimer registrationTimer(s_StageRegistration);
+				cv::Mat transformedXYZ = cv::Mat::zeros(range_height, range_width, CV_32FC3);
+				m_XYZ.create(3, 1, CV_64FC1);
+
+				double* d_ptr = 0;
+				double x,y,z;
+				int u = 0, v = 0;
+				int colTimes3 = 0;
+				float* p_xyz = 0;
+
+				//For fast calculation: avoid using matrix multiplication
+				d_ptr = m_extrinsicMatrix.ptr<double>(0);
+				
+				double er11 = d_ptr[0], er12 = d_ptr[1], er13 = d_ptr[2], et1 = d_ptr[3],
+					   er21 = d_ptr[4], er22 = d_ptr[5], er23 = d_ptr[6], et2 = d_ptr[7],
+					   er31 = d_ptr[8], er32 = d_ptr[9], er33 = d_ptr[10], et3 = d_ptr[11];
+
+				for(unsigned int row=0; row<(unsigned int)range_height; row++)
 				{
-					colTimes3 = 3*col;
-					// Check for invalid measurements
-					if( p_us_dist[col] == m_badDepth ) // not valid
-					{
-						p_xyz[colTimes3] = 0;
-						p_xyz[colTimes3 + 1] = 0;
-						p_xyz[colTimes3 + 2] = 0;
-					}
-					else
-					{
-						p_xyz[colTimes3] = (col - cx) * p_us_dist[col] * constant_x;
-						p_xyz[colTimes3 + 1] = (row - cy) * p_us_dist[col] * constant_y;
-						p_xyz[colTimes3 + 2] = p_us_dist[col] * 0.001;
-
+					p_xyz = (float*) (cartesianImageData + row * xyz_step);
+					p_us_dist = resized_range_mat.ptr<unsigned short>(row);
 
-						// Calculate the registrated coordinates if the registration is off
-						if (m_CalibrationMethod == MATLAB_NO_Z)
-						{	
-							x = p_xyz[colTimes3];
-							y = p_xyz[colTimes3 + 1];
-							z = p_xyz[colTimes3 + 2];
-
-							x *= 1000.0;
-							y *= 1000.0;
-							z *= 1000.0;
+					for (unsigned int col = 0; col < (unsigned int)range_width; col++)
+					{
+						// Check for invalid measurements
+						if( p_us_dist[col] == m_badDepth )
+							continue;
 
-							d_ptr =  m_XYZ.ptr<double>(0);
+						colTimes3 = 3*col;
+						x = p_xyz[colTimes3] * 1000.0;
+						y = p_xyz[colTimes3 + 1] * 1000.0;
+						z = p_xyz[colTimes3 + 2] * 1000.0;
 
-							d_ptr[0] =  er11 * x + er12 * y + er13 * z + et1;
-							d_ptr[1] =  er21 * x + er22 * y + er23 * z + et2;
-							d_ptr[2] =  er31 * x + er32 * y + er33 * z + et3 + m_dZ;
+						d_ptr =  m_XYZ.ptr<double>(0);
 
-							u = cvRound(fx * d_ptr[0] / d_ptr[2] + cx);
-							v = cvRound(fy * d_ptr[1] / d_ptr[2] + cy);
+						d_ptr[0] =  er11 * x + er12 * y + er13 * z + et1;
+						d_ptr[1] =  er21 * x + er22 * y + er23 * z + et2;
+						d_ptr[2] =  er31 * x + er32 * y + er33 * z + et3 + m_dZ;
 
-							d_ptr = m_XYZ.ptr<double>(0);
+						u = cvRound(fx * d_ptr[0] / d_ptr[2] + cx);
+						v = cvRound(fy * d_ptr[1] / d_ptr[2] + cy);
 
-							if (u < range_width && v < range_height && u >= 0 && v >=0)
-							{
-								transformedXYZ.at<cv::Vec3f>(v, u) =  cv::Vec3f(d_ptr[0]*0.001, d_ptr[1]*0.001,d_ptr[2]*0.001);		
-							}
+						if (u < range_width && v < range_height && u >= 0 && v >=0)
+						{
+							transformedXYZ.at<cv::Vec3f>(v, u) =  cv::Vec3f(d_ptr[0]*0.001, d_ptr[1]*0.001,d_ptr[2]*0.001);		
 						}
-						
-						//if (p_xyz[colTimes3 + 2] < 0)
-						//{
-						//	std::cout << "<0: " << row << " " << col << "\n";
-						//}
-
-						//XnPoint3D proj, real;
-						//proj.X = col;
-						//proj.Y = row;
-						//proj.Z = p_dist[col];
-						//m_depth_generator.ConvertProjectiveToRealWorld(1, &proj, &real);
-						//p_xyz[colTimes3] = real.X* 0.001f;
-						//p_xyz[colTimes3 + 1] = real.Y* 0.001f;
-						//p_xyz[colTimes3 + 2] = real.Z* 0.001f;
 					}
 				}
-			}
-			if (m_CalibrationMethod == MATLAB_NO_Z)
-			{
 				memcpy (( unsigned char*) cartesianImageData, transformedXYZ.ptr(0), range_width * sizeof(float) * 3 * range_height);
 			}
 		}
@@ -783,28 +770,9 @@ unsigned long Kinect::AcquireImages(int widthStepRange, int widthStepColor, int
 		// Convert z values to float z
 		if (createRangeImage)
 		{
-			// Get range values
-			unsigned short us_val = 0;
-			int d_step = range_width * sizeof(float);
-
-			for(unsigned int row=0; row<(unsigned int)range_height; row++)
-			{
-				p_f_dist = (float*)(rangeImageData + row * d_step);
-				p_us_dist = resized_range_mat.ptr<unsigned short>(row);
-
-				for (unsigned int col=0; col<(unsigned int)range_width; col++)
-				{
-					us_val = p_us_dist[col];
-					// Convert to float to stay consistent with other range cameras
-					//if (us_val != m_noSampleValue && 
-					//	us_val != m_shadowValue &&
-					//	us_val != 0)
-					if (us_val != 0) // TODO: find out wether it is necessary to get the shadow and no sample value
-						p_f_dist[col] = 0.001 * (float)us_val;
-					else
-						p_f_dist[col] = (float)m_badDepth;
-				}	
-			}
+			// TODO: find out wether it is necessary to get the shadow and no sample value
+			ScopedStageTimer rangeConversionTimer(s_StageRangeConversion);
+			ConvertDepthToRange(resized_range_mat, rangeImageData, range_width * sizeof(float), m_badDepth);
 		}
 	}
 
@@ -821,6 +789,7 @@ unsigned long Kinect::AcquireImages(int widthStepRange, int widthStepColor, int
 	// Check if new data is available
 	else if (colorImageData)
 	{
+		ScopedStageTimer colorConversionTimer(s_StageColorConversion);
 		openni::PixelFormat rgb_pf = m_vs_rgb.getVideoMode().getPixelFormat();
 		//if (XnPixelFormat::XN_PIXEL_FORMAT_GRAYSCALE_8_BIT == m_image_md.PixelFormat())
 		if (openni::PIXEL_FORMAT_GRAY8 == rgb_pf)
@@ -841,23 +810,7 @@ unsigned long Kinect::AcquireImages(int widthStepRange, int widthStepColor, int
 		}
 
 		// Switch red and blue image channels
-		unsigned char temp_val = 0;
-		unsigned char* p_dest = 0;
-		unsigned int colTimes3 = 0;
-		int colInverse = 0;
-		for(unsigned int row=0; row<(unsigned int)color_height; row++)
-		{
-			p_dest = ((unsigned char*)colorImageData) + row * color_width * 3;
-			for (unsigned int col=0; col<(unsigned int)color_width; col++)
-			{
-				colTimes3 = col*3;
-
-				// Switch red and blue image channels
-				temp_val = p_dest[colTimes3];
-				p_dest[colTimes3] = p_dest[colTimes3 + 2];
-				p_dest[colTimes3 + 2] = temp_val;
-			}	
-		}
+		SwapRedBlueChannels((unsigned char*) colorImageData, color_width, color_height, color_width * 3);
 	}
 
 	return  RET_OK;
@@ -865,1197 +818,20 @@ unsigned long Kinect::AcquireImages(int widthStepRange, int widthStepColor, int
 
 unsigned long Kinect::FillRGBYUV422(unsigned width, unsigned height, unsigned char* rgb_buffer)
 {
-	// 0  1   2  3
-	// u  y1  v  y2
-
-	//if (m_image_md.XRes() != width && m_image_md.YRes() != height)
-	if (m_vs_rgb.getVideoMode().getResolutionX() != width && m_vs_rgb.getVideoMode().getResolutionY() != height)
-	{
-		//if (width > m_image_md.XRes () || height > m_image_md.YRes ())
-		if (width > m_vs_rgb.getVideoMode().getResolutionX() || height > m_vs_rgb.getVideoMode().getResolutionY())
-			std::cerr << "ERROR - Kinect::FillRGBYUV422" << std::endl;
-			std::cerr << "\t ... Upsampling not supported" << std::endl;
-			return RET_FAILED;
-
-		//if ( m_image_md.XRes () % width != 0 || m_image_md.YRes () % height != 0
-		//	|| (m_image_md.XRes () / width) & 0x01 || (m_image_md.YRes () / height & 0x01) )
-		if ( m_vs_rgb.getVideoMode().getResolutionX() % width != 0 ||m_vs_rgb.getVideoMode().getResolutionY() % height != 0
-			|| (m_vs_rgb.getVideoMode().getResolutionX() / width) & 0x01 || (m_vs_rgb.getVideoMode().getResolutionY() / height & 0x01) )
-			std::cerr << "ERROR - Kinect::FillRGBYUV422" << std::endl;
-			std::cerr << "\t ... Downsampling only possible for power of two scale in both dimensions" << std::endl;
-			return RET_FAILED;
-	}
-
-	//register const XnUInt8* yuv_buffer = m_image_md.Data();
-	
-	register const uint8_t* yuv_buffer = (const uint8_t*) m_vfr_rgb.getData(); 
-
-	unsigned int rgb_line_step = width * 3 * 2;
-	unsigned rgb_line_skip = 0;
-	if (rgb_line_step != 0)
-		rgb_line_skip = rgb_line_step - width * 3;
-
-	//if (m_image_md.XRes() == width && m_image_md.YRes() == height)
-	if (m_vs_rgb.getVideoMode().getResolutionX() == width && m_vs_rgb.getVideoMode().getResolutionY() == height)
-	{
-		for( register unsigned yIdx = 0; yIdx < height; ++yIdx, rgb_buffer += rgb_line_skip )
-		{
-			for( register unsigned xIdx = 0; xIdx < width; xIdx += 2, rgb_buffer += 6, yuv_buffer += 4 )
-			{
-				int v = yuv_buffer[2] - 128;
-				int u = yuv_buffer[0] - 128;
-
-				rgb_buffer[0] =  IPA_CLIP_CHAR (yuv_buffer[1] + ((v * 18678 + 8192 ) >> 14));
-				rgb_buffer[1] =  IPA_CLIP_CHAR (yuv_buffer[1] + ((v * -9519 - u * 6472 + 8192 ) >> 14));
-				rgb_buffer[2] =  IPA_CLIP_CHAR (yuv_buffer[1] + ((u * 33292 + 8192 ) >> 14));
-
-				rgb_buffer[3] =  IPA_CLIP_CHAR (yuv_buffer[3] + ((v * 18678 + 8192 ) >> 14));
-				rgb_buffer[4] =  IPA_CLIP_CHAR (yuv_buffer[3] + ((v * -9519 - u * 6472 + 8192 ) >> 14));
-				rgb_buffer[5] =  IPA_CLIP_CHAR (yuv_buffer[3] + ((u * 33292 + 8192 ) >> 14));
-			}
-		}
-	}
-	else
-	{
-		//register unsigned yuv_step = m_image_md.XRes() / width;
-		register unsigned yuv_step = m_vs_rgb.getVideoMode().getResolutionX() / width;
-		register unsigned yuv_x_step = yuv_step << 1;
-		//register unsigned yuv_skip = (m_image_md.YRes() / height - 1) * ( m_image_md.XRes() << 1 );
-		register unsigned yuv_skip = (m_vs_rgb.getVideoMode().getResolutionY() / height - 1) * (m_vs_rgb.getVideoMode().getResolutionX() << 1 );
-
-		//for( register unsigned yIdx = 0; yIdx < m_image_md.YRes(); yIdx += yuv_step, yuv_buffer += yuv_skip, rgb_buffer += rgb_line_skip )
-		for( register unsigned yIdx = 0; yIdx <m_vs_rgb.getVideoMode().getResolutionY(); yIdx += yuv_step, yuv_buffer += yuv_skip, rgb_buffer += rgb_line_skip )
-		{
-			//for( register unsigned xIdx = 0; xIdx < m_image_md.XRes(); xIdx += yuv_step, rgb_buffer += 3, yuv_buffer += yuv_x_step )
-			for( register unsigned xIdx = 0; xIdx < m_vs_rgb.getVideoMode().getResolutionX(); xIdx += yuv_step, rgb_buffer += 3, yuv_buffer += yuv_x_step )
-			{
-				int v = yuv_buffer[2] - 128;
-				int u = yuv_buffer[0] - 128;
-
-				rgb_buffer[0] =  IPA_CLIP_CHAR (yuv_buffer[1] + ((v * 18678 + 8192 ) >> 14));
-				rgb_buffer[1] =  IPA_CLIP_CHAR (yuv_buffer[1] + ((v * -9519 - u * 6472 + 8192 ) >> 14));
-				rgb_buffer[2] =  IPA_CLIP_CHAR (yuv_buffer[1] + ((u * 33292 + 8192 ) >> 14));
-			}
-		}
-	}
-	return  RET_OK;
+	return ConvertYUV422ToRGB((const unsigned char*) m_vfr_rgb.getData(), m_vs_rgb.getVideoMode().getResolutionX(),
+		m_vs_rgb.getVideoMode().getResolutionY(), rgb_buffer, width, height);
 }
 
 unsigned long Kinect::FillRGBBayer(unsigned width, unsigned height, unsigned char* rgb_buffer)
 {
-	//if (width != m_image_md.XRes () || height != m_image_md.YRes ())
-	if (width != m_vs_rgb.getVideoMode().getResolutionX() || height != m_vs_rgb.getVideoMode().getResolutionY())
-		// TODO: Throw exception
-		return RET_FAILED;
-	
-	unsigned int rgb_line_step = width * 3;
-
-	// padding skip for destination image
-	unsigned rgb_line_skip = rgb_line_step - width * 3;
-
-	//register const XnUInt8 *bayer_pixel = m_image_md.Data ();
-	register const uint8_t *bayer_pixel = (const uint8_t *) m_vfr_rgb.getData(); //TODO: Type Error?
-	
-	register unsigned yIdx, xIdx;
-
-	//int bayer_line_step = m_image_md.XRes ();
-	//int bayer_line_step2 = m_image_md.XRes () << 1;
-	int bayer_line_step = m_vs_rgb.getVideoMode().getResolutionX();
-	int bayer_line_step2 = m_vs_rgb.getVideoMode().getResolutionX() << 1;
-
-	//int debayering_method = 0; // Bilinear
-	//int debayering_method = 1; // Edge aware
-	int debayering_method = 2; // EdgeAwareWeighted
-
-	if (debayering_method == 0) // Bilinar
+	if (width != (unsigned)m_vs_rgb.getVideoMode().getResolutionX() || height != (unsigned)m_vs_rgb.getVideoMode().getResolutionY())
 	{
-		// first two pixel values for first two lines
-		// Bayer         0 1 2
-		//         0     G r g
-		// line_step     b g b
-		// line_step2    g r g
-
-		rgb_buffer[3] = rgb_buffer[0] = bayer_pixel[1]; // red pixel
-		rgb_buffer[1] = bayer_pixel[0]; // green pixel
-		rgb_buffer[rgb_line_step + 2] = rgb_buffer[2] = bayer_pixel[bayer_line_step]; // blue;
-
-		// Bayer         0 1 2
-		//         0     g R g
-		// line_step     b g b
-		// line_step2    g r g
-		//rgb_pixel[3] = bayer_pixel[1];
-		rgb_buffer[4] = AVG3 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1]);
-		rgb_buffer[rgb_line_step + 5] = rgb_buffer[5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
-
-		// BGBG line
-		// Bayer         0 1 2
-		//         0     g r g
-		// line_step     B g b
-		// line_step2    g r g
-		rgb_buffer[rgb_line_step + 3] = rgb_buffer[rgb_line_step ] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
-		rgb_buffer[rgb_line_step + 1] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step + 1], bayer_pixel[bayer_line_step2]);
-		//rgb_pixel[rgb_line_step + 2] = bayer_pixel[line_step];
-
-		// pixel (1, 1)  0 1 2
-		//         0     g r g
-		// line_step     b G b
-		// line_step2    g r g
-		//rgb_pixel[rgb_line_step + 3] = AVG( bayer_pixel[1] , bayer_pixel[line_step2+1] );
-		rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-		//rgb_pixel[rgb_line_step + 5] = AVG( bayer_pixel[line_step] , bayer_pixel[line_step+2] );
-
-		rgb_buffer += 6;
-		bayer_pixel += 2;
-		// rest of the first two lines
-
-		for (xIdx = 2; xIdx < width - 2; xIdx += 2, rgb_buffer += 6, bayer_pixel += 2)
-		{
-			// GRGR line
-			// Bayer        -1 0 1 2
-			//           0   r G r g
-			//   line_step   g b g b
-			// line_step2    r g r g
-			rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
-			rgb_buffer[1] = bayer_pixel[0];
-			rgb_buffer[2] = bayer_pixel[bayer_line_step + 1];
-
-			// Bayer        -1 0 1 2
-			//          0    r g R g
-			//  line_step    g b g b
-			// line_step2    r g r g
-			rgb_buffer[3] = bayer_pixel[1];
-			rgb_buffer[4] = AVG3 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1]);
-			rgb_buffer[rgb_line_step + 5] = rgb_buffer[5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
-
-			// BGBG line
-			// Bayer         -1 0 1 2
-			//         0      r g r g
-			// line_step      g B g b
-			// line_step2     r g r g
-			rgb_buffer[rgb_line_step ] = AVG4 (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1], bayer_pixel[-1], bayer_pixel[bayer_line_step2 - 1]);
-			rgb_buffer[rgb_line_step + 1] = AVG4 (bayer_pixel[0], bayer_pixel[bayer_line_step2], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
-			rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
-
-			// Bayer         -1 0 1 2
-			//         0      r g r g
-			// line_step      g b G b
-			// line_step2     r g r g
-			rgb_buffer[rgb_line_step + 3] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
-			rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-			//rgb_pixel[rgb_line_step + 5] = AVG( bayer_pixel[line_step] , bayer_pixel[line_step+2] );
-		}
-
-		// last two pixel values for first two lines
-		// GRGR line
-		// Bayer        -1 0 1
-		//           0   r G r
-		//   line_step   g b g
-		// line_step2    r g r
-		rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
-		rgb_buffer[1] = bayer_pixel[0];
-		rgb_buffer[rgb_line_step + 5] = rgb_buffer[rgb_line_step + 2] = rgb_buffer[5] = rgb_buffer[2] = bayer_pixel[bayer_line_step];
-
-		// Bayer        -1 0 1
-		//          0    r g R
-		//  line_step    g b g
-		// line_step2    r g r
-		rgb_buffer[3] = bayer_pixel[1];
-		rgb_buffer[4] = AVG (bayer_pixel[0], bayer_pixel[bayer_line_step + 1]);
-		//rgb_pixel[5] = bayer_pixel[line_step];
-
-		// BGBG line
-		// Bayer        -1 0 1
-		//          0    r g r
-		//  line_step    g B g
-		// line_step2    r g r
-		rgb_buffer[rgb_line_step ] = AVG4 (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1], bayer_pixel[-1], bayer_pixel[bayer_line_step2 - 1]);
-		rgb_buffer[rgb_line_step + 1] = AVG4 (bayer_pixel[0], bayer_pixel[bayer_line_step2], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
-		//rgb_pixel[rgb_line_step + 2] = bayer_pixel[line_step];
-
-		// Bayer         -1 0 1
-		//         0      r g r
-		// line_step      g b G
-		// line_step2     r g r
-		rgb_buffer[rgb_line_step + 3] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
-		rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-		//rgb_pixel[rgb_line_step + 5] = bayer_pixel[line_step];
-
-		bayer_pixel += bayer_line_step + 2;
-		rgb_buffer += rgb_line_step + 6 + rgb_line_skip;
-
-		// main processing
-
-		for (yIdx = 2; yIdx < height - 2; yIdx += 2)
-		{
-			// first two pixel values
-			// Bayer         0 1 2
-			//        -1     b g b
-			//         0     G r g
-			// line_step     b g b
-			// line_step2    g r g
-
-			rgb_buffer[3] = rgb_buffer[0] = bayer_pixel[1]; // red pixel
-			rgb_buffer[1] = bayer_pixel[0]; // green pixel
-			rgb_buffer[2] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[-bayer_line_step]); // blue;
-
-			// Bayer         0 1 2
-			//        -1     b g b
-			//         0     g R g
-			// line_step     b g b
-			// line_step2    g r g
-			//rgb_pixel[3] = bayer_pixel[1];
-			rgb_buffer[4] = AVG4 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1], bayer_pixel[1 - bayer_line_step]);
-			rgb_buffer[5] = AVG4 (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2], bayer_pixel[-bayer_line_step], bayer_pixel[2 - bayer_line_step]);
-
-			// BGBG line
-			// Bayer         0 1 2
-			//         0     g r g
-			// line_step     B g b
-			// line_step2    g r g
-			rgb_buffer[rgb_line_step + 3] = rgb_buffer[rgb_line_step ] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
-			rgb_buffer[rgb_line_step + 1] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step + 1], bayer_pixel[bayer_line_step2]);
-			rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
-
-			// pixel (1, 1)  0 1 2
-			//         0     g r g
-			// line_step     b G b
-			// line_step2    g r g
-			//rgb_pixel[rgb_line_step + 3] = AVG( bayer_pixel[1] , bayer_pixel[line_step2+1] );
-			rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-			rgb_buffer[rgb_line_step + 5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
-
-			rgb_buffer += 6;
-			bayer_pixel += 2;
-			// continue with rest of the line
-			for (xIdx = 2; xIdx < width - 2; xIdx += 2, rgb_buffer += 6, bayer_pixel += 2)
-			{
-				// GRGR line
-				// Bayer        -1 0 1 2
-				//          -1   g b g b
-				//           0   r G r g
-				//   line_step   g b g b
-				// line_step2    r g r g
-				rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
-				rgb_buffer[1] = bayer_pixel[0];
-				rgb_buffer[2] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[-bayer_line_step]);
-
-				// Bayer        -1 0 1 2
-				//          -1   g b g b
-				//          0    r g R g
-				//  line_step    g b g b
-				// line_step2    r g r g
-				rgb_buffer[3] = bayer_pixel[1];
-				rgb_buffer[4] = AVG4 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1], bayer_pixel[1 - bayer_line_step]);
-				rgb_buffer[5] = AVG4 (bayer_pixel[-bayer_line_step], bayer_pixel[2 - bayer_line_step], bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
-
-				// BGBG line
-				// Bayer         -1 0 1 2
-				//         -1     g b g b
-				//          0     r g r g
-				// line_step      g B g b
-				// line_step2     r g r g
-				rgb_buffer[rgb_line_step ] = AVG4 (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1], bayer_pixel[-1], bayer_pixel[bayer_line_step2 - 1]);
-				rgb_buffer[rgb_line_step + 1] = AVG4 (bayer_pixel[0], bayer_pixel[bayer_line_step2], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
-				rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
-
-				// Bayer         -1 0 1 2
-				//         -1     g b g b
-				//          0     r g r g
-				// line_step      g b G b
-				// line_step2     r g r g
-				rgb_buffer[rgb_line_step + 3] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
-				rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-				rgb_buffer[rgb_line_step + 5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
-			}
-
-			// last two pixels of the line
-			// last two pixel values for first two lines
-			// GRGR line
-			// Bayer        -1 0 1
-			//           0   r G r
-			//   line_step   g b g
-			// line_step2    r g r
-			rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
-			rgb_buffer[1] = bayer_pixel[0];
-			rgb_buffer[rgb_line_step + 5] = rgb_buffer[rgb_line_step + 2] = rgb_buffer[5] = rgb_buffer[2] = bayer_pixel[bayer_line_step];
-
-			// Bayer        -1 0 1
-			//          0    r g R
-			//  line_step    g b g
-			// line_step2    r g r
-			rgb_buffer[3] = bayer_pixel[1];
-			rgb_buffer[4] = AVG (bayer_pixel[0], bayer_pixel[bayer_line_step + 1]);
-			//rgb_pixel[5] = bayer_pixel[line_step];
-
-			// BGBG line
-			// Bayer        -1 0 1
-			//          0    r g r
-			//  line_step    g B g
-			// line_step2    r g r
-			rgb_buffer[rgb_line_step ] = AVG4 (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1], bayer_pixel[-1], bayer_pixel[bayer_line_step2 - 1]);
-			rgb_buffer[rgb_line_step + 1] = AVG4 (bayer_pixel[0], bayer_pixel[bayer_line_step2], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
-			//rgb_pixel[rgb_line_step + 2] = bayer_pixel[line_step];
-
-			// Bayer         -1 0 1
-			//         0      r g r
-			// line_step      g b G
-			// line_step2     r g r
-			rgb_buffer[rgb_line_step + 3] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
-			rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-			//rgb_pixel[rgb_line_step + 5] = bayer_pixel[line_step];
-
-			bayer_pixel += bayer_line_step + 2;
-			rgb_buffer += rgb_line_step + 6 + rgb_line_skip;
-		}
-
-		//last two lines
-		// Bayer         0 1 2
-		//        -1     b g b
-		//         0     G r g
-		// line_step     b g b
-
-		rgb_buffer[rgb_line_step + 3] = rgb_buffer[rgb_line_step ] = rgb_buffer[3] = rgb_buffer[0] = bayer_pixel[1]; // red pixel
-		rgb_buffer[1] = bayer_pixel[0]; // green pixel
-		rgb_buffer[rgb_line_step + 2] = rgb_buffer[2] = bayer_pixel[bayer_line_step]; // blue;
-
-		// Bayer         0 1 2
-		//        -1     b g b
-		//         0     g R g
-		// line_step     b g b
-		//rgb_pixel[3] = bayer_pixel[1];
-		rgb_buffer[4] = AVG4 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1], bayer_pixel[1 - bayer_line_step]);
-		rgb_buffer[5] = AVG4 (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2], bayer_pixel[-bayer_line_step], bayer_pixel[2 - bayer_line_step]);
-
-		// BGBG line
-		// Bayer         0 1 2
-		//        -1     b g b
-		//         0     g r g
-		// line_step     B g b
-		//rgb_pixel[rgb_line_step    ] = bayer_pixel[1];
-		rgb_buffer[rgb_line_step + 1] = AVG (bayer_pixel[0], bayer_pixel[bayer_line_step + 1]);
-		rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
-
-		// Bayer         0 1 2
-		//        -1     b g b
-		//         0     g r g
-		// line_step     b G b
-		//rgb_pixel[rgb_line_step + 3] = AVG( bayer_pixel[1] , bayer_pixel[line_step2+1] );
-		rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-		rgb_buffer[rgb_line_step + 5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
-
-		rgb_buffer += 6;
-		bayer_pixel += 2;
-		// rest of the last two lines
-		for (xIdx = 2; xIdx < width - 2; xIdx += 2, rgb_buffer += 6, bayer_pixel += 2)
-		{
-			// GRGR line
-			// Bayer       -1 0 1 2
-			//        -1    g b g b
-			//         0    r G r g
-			// line_step    g b g b
-			rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
-			rgb_buffer[1] = bayer_pixel[0];
-			rgb_buffer[2] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[-bayer_line_step]);
-
-			// Bayer       -1 0 1 2
-			//        -1    g b g b
-			//         0    r g R g
-			// line_step    g b g b
-			rgb_buffer[rgb_line_step + 3] = rgb_buffer[3] = bayer_pixel[1];
-			rgb_buffer[4] = AVG4 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1], bayer_pixel[1 - bayer_line_step]);
-			rgb_buffer[5] = AVG4 (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2], bayer_pixel[-bayer_line_step], bayer_pixel[-bayer_line_step + 2]);
-
-			// BGBG line
-			// Bayer       -1 0 1 2
-			//        -1    g b g b
-			//         0    r g r g
-			// line_step    g B g b
-			rgb_buffer[rgb_line_step ] = AVG (bayer_pixel[-1], bayer_pixel[1]);
-			rgb_buffer[rgb_line_step + 1] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
-			rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
-
-
-			// Bayer       -1 0 1 2
-			//        -1    g b g b
-			//         0    r g r g
-			// line_step    g b G b
-			//rgb_pixel[rgb_line_step + 3] = bayer_pixel[1];
-			rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-			rgb_buffer[rgb_line_step + 5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
-		}
-
-		// last two pixel values for first two lines
-		// GRGR line
-		// Bayer       -1 0 1
-		//        -1    g b g
-		//         0    r G r
-		// line_step    g b g
-		rgb_buffer[rgb_line_step ] = rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
-		rgb_buffer[1] = bayer_pixel[0];
-		rgb_buffer[5] = rgb_buffer[2] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[-bayer_line_step]);
-
-		// Bayer       -1 0 1
-		//        -1    g b g
-		//         0    r g R
-		// line_step    g b g
-		rgb_buffer[rgb_line_step + 3] = rgb_buffer[3] = bayer_pixel[1];
-		rgb_buffer[4] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step + 1], bayer_pixel[-bayer_line_step + 1]);
-		//rgb_pixel[5] = AVG( bayer_pixel[line_step], bayer_pixel[-line_step] );
-
-		// BGBG line
-		// Bayer       -1 0 1
-		//        -1    g b g
-		//         0    r g r
-		// line_step    g B g
-		//rgb_pixel[rgb_line_step    ] = AVG2( bayer_pixel[-1], bayer_pixel[1] );
-		rgb_buffer[rgb_line_step + 1] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
-		rgb_buffer[rgb_line_step + 5] = rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
-
-		// Bayer       -1 0 1
-		//        -1    g b g
-		//         0    r g r
-		// line_step    g b G
-		//rgb_pixel[rgb_line_step + 3] = bayer_pixel[1];
-		rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-		//rgb_pixel[rgb_line_step + 5] = bayer_pixel[line_step];
-	}
-	else if (debayering_method == 1) // Edge aware
-	{
-		int dh, dv;
-
-		// first two pixel values for first two lines
-		// Bayer         0 1 2
-		//         0     G r g
-		// line_step     b g b
-		// line_step2    g r g
-
-		rgb_buffer[3] = rgb_buffer[0] = bayer_pixel[1]; // red pixel
-		rgb_buffer[1] = bayer_pixel[0]; // green pixel
-		rgb_buffer[rgb_line_step + 2] = rgb_buffer[2] = bayer_pixel[bayer_line_step]; // blue;
-
-		// Bayer         0 1 2
-		//         0     g R g
-		// line_step     b g b
-		// line_step2    g r g
-		//rgb_pixel[3] = bayer_pixel[1];
-		rgb_buffer[4] = AVG3 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1]);
-		rgb_buffer[rgb_line_step + 5] = rgb_buffer[5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
-
-		// BGBG line
-		// Bayer         0 1 2
-		//         0     g r g
-		// line_step     B g b
-		// line_step2    g r g
-		rgb_buffer[rgb_line_step + 3] = rgb_buffer[rgb_line_step ] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
-		rgb_buffer[rgb_line_step + 1] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step + 1], bayer_pixel[bayer_line_step2]);
-		//rgb_pixel[rgb_line_step + 2] = bayer_pixel[line_step];
-
-		// pixel (1, 1)  0 1 2
-		//         0     g r g
-		// line_step     b G b
-		// line_step2    g r g
-		//rgb_pixel[rgb_line_step + 3] = AVG( bayer_pixel[1] , bayer_pixel[line_step2+1] );
-		rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-		//rgb_pixel[rgb_line_step + 5] = AVG( bayer_pixel[line_step] , bayer_pixel[line_step+2] );
-
-		rgb_buffer += 6;
-		bayer_pixel += 2;
-		// rest of the first two lines
-		for (xIdx = 2; xIdx < width - 2; xIdx += 2, rgb_buffer += 6, bayer_pixel += 2)
-		{
-			// GRGR line
-			// Bayer        -1 0 1 2
-			//           0   r G r g
-			//   line_step   g b g b
-			// line_step2    r g r g
-			rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
-			rgb_buffer[1] = bayer_pixel[0];
-			rgb_buffer[2] = bayer_pixel[bayer_line_step + 1];
-
-			// Bayer        -1 0 1 2
-			//          0    r g R g
-			//  line_step    g b g b
-			// line_step2    r g r g
-			rgb_buffer[3] = bayer_pixel[1];
-			rgb_buffer[4] = AVG3 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1]);
-			rgb_buffer[rgb_line_step + 5] = rgb_buffer[5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
-
-			// BGBG line
-			// Bayer         -1 0 1 2
-			//         0      r g r g
-			// line_step      g B g b
-			// line_step2     r g r g
-			rgb_buffer[rgb_line_step ] = AVG4 (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1], bayer_pixel[-1], bayer_pixel[bayer_line_step2 - 1]);
-			rgb_buffer[rgb_line_step + 1] = AVG4 (bayer_pixel[0], bayer_pixel[bayer_line_step2], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
-			rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
-
-			// Bayer         -1 0 1 2
-			//         0      r g r g
-			// line_step      g b G b
-			// line_step2     r g r g
-			rgb_buffer[rgb_line_step + 3] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
-			rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-			//rgb_pixel[rgb_line_step + 5] = AVG( bayer_pixel[line_step] , bayer_pixel[line_step+2] );
-		}
-
-		// last two pixel values for first two lines
-		// GRGR line
-		// Bayer        -1 0 1
-		//           0   r G r
-		//   line_step   g b g
-		// line_step2    r g r
-		rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
-		rgb_buffer[1] = bayer_pixel[0];
-		rgb_buffer[rgb_line_step + 5] = rgb_buffer[rgb_line_step + 2] = rgb_buffer[5] = rgb_buffer[2] = bayer_pixel[bayer_line_step];
-
-		// Bayer        -1 0 1
-		//          0    r g R
-		//  line_step    g b g
-		// line_step2    r g r
-		rgb_buffer[3] = bayer_pixel[1];
-		rgb_buffer[4] = AVG (bayer_pixel[0], bayer_pixel[bayer_line_step + 1]);
-		//rgb_pixel[5] = bayer_pixel[line_step];
-
-		// BGBG line
-		// Bayer        -1 0 1
-		//          0    r g r
-		//  line_step    g B g
-		// line_step2    r g r
-		rgb_buffer[rgb_line_step ] = AVG4 (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1], bayer_pixel[-1], bayer_pixel[bayer_line_step2 - 1]);
-		rgb_buffer[rgb_line_step + 1] = AVG4 (bayer_pixel[0], bayer_pixel[bayer_line_step2], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
-		//rgb_pixel[rgb_line_step + 2] = bayer_pixel[line_step];
-
-		// Bayer         -1 0 1
-		//         0      r g r
-		// line_step      g b G
-		// line_step2     r g r
-		rgb_buffer[rgb_line_step + 3] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
-		rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-		//rgb_pixel[rgb_line_step + 5] = bayer_pixel[line_step];
-
-		bayer_pixel += bayer_line_step + 2;
-		rgb_buffer += rgb_line_step + 6 + rgb_line_skip;
-		// main processing
-		for (yIdx = 2; yIdx < height - 2; yIdx += 2)
-		{
-			// first two pixel values
-			// Bayer         0 1 2
-			//        -1     b g b
-			//         0     G r g
-			// line_step     b g b
-			// line_step2    g r g
-
-			rgb_buffer[3] = rgb_buffer[0] = bayer_pixel[1]; // red pixel
-			rgb_buffer[1] = bayer_pixel[0]; // green pixel
-			rgb_buffer[2] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[-bayer_line_step]); // blue;
-
-			// Bayer         0 1 2
-			//        -1     b g b
-			//         0     g R g
-			// line_step     b g b
-			// line_step2    g r g
-			//rgb_pixel[3] = bayer_pixel[1];
-			rgb_buffer[4] = AVG4 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1], bayer_pixel[1 - bayer_line_step]);
-			rgb_buffer[5] = AVG4 (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2], bayer_pixel[-bayer_line_step], bayer_pixel[2 - bayer_line_step]);
-
-			// BGBG line
-			// Bayer         0 1 2
-			//         0     g r g
-			// line_step     B g b
-			// line_step2    g r g
-			rgb_buffer[rgb_line_step + 3] = rgb_buffer[rgb_line_step ] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
-			rgb_buffer[rgb_line_step + 1] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step + 1], bayer_pixel[bayer_line_step2]);
-			rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
-
-			// pixel (1, 1)  0 1 2
-			//         0     g r g
-			// line_step     b G b
-			// line_step2    g r g
-			//rgb_pixel[rgb_line_step + 3] = AVG( bayer_pixel[1] , bayer_pixel[line_step2+1] );
-			rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-			rgb_buffer[rgb_line_step + 5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
-
-			rgb_buffer += 6;
-			bayer_pixel += 2;
-			// continue with rest of the line
-			for (xIdx = 2; xIdx < width - 2; xIdx += 2, rgb_buffer += 6, bayer_pixel += 2)
-			{
-				// GRGR line
-				// Bayer        -1 0 1 2
-				//          -1   g b g b
-				//           0   r G r g
-				//   line_step   g b g b
-				// line_step2    r g r g
-				rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
-				rgb_buffer[1] = bayer_pixel[0];
-				rgb_buffer[2] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[-bayer_line_step]);
-
-				// Bayer        -1 0 1 2
-				//          -1   g b g b
-				//          0    r g R g
-				//  line_step    g b g b
-				// line_step2    r g r g
-
-				dh = abs (bayer_pixel[0] - bayer_pixel[2]);
-				dv = abs (bayer_pixel[-bayer_line_step + 1] - bayer_pixel[bayer_line_step + 1]);
-
-				if (dh > dv)
-					rgb_buffer[4] = AVG (bayer_pixel[-bayer_line_step + 1], bayer_pixel[bayer_line_step + 1]);
-				else if (dv > dh)
-					rgb_buffer[4] = AVG (bayer_pixel[0], bayer_pixel[2]);
-				else
-					rgb_buffer[4] = AVG4 (bayer_pixel[-bayer_line_step + 1], bayer_pixel[bayer_line_step + 1], bayer_pixel[0], bayer_pixel[2]);
-
-				rgb_buffer[3] = bayer_pixel[1];
-				rgb_buffer[5] = AVG4 (bayer_pixel[-bayer_line_step], bayer_pixel[2 - bayer_line_step], bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
-
-				// BGBG line
-				// Bayer         -1 0 1 2
-				//         -1     g b g b
-				//          0     r g r g
-				// line_step      g B g b
-				// line_step2     r g r g
-				rgb_buffer[rgb_line_step ] = AVG4 (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1], bayer_pixel[-1], bayer_pixel[bayer_line_step2 - 1]);
-				rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
-
-				dv = abs (bayer_pixel[0] - bayer_pixel[bayer_line_step2]);
-				dh = abs (bayer_pixel[bayer_line_step - 1] - bayer_pixel[bayer_line_step + 1]);
-
-				if (dv > dh)
-					rgb_buffer[rgb_line_step + 1] = AVG (bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
-				else if (dh > dv)
-					rgb_buffer[rgb_line_step + 1] = AVG (bayer_pixel[0], bayer_pixel[bayer_line_step2]);
-				else
-					rgb_buffer[rgb_line_step + 1] = AVG4 (bayer_pixel[0], bayer_pixel[bayer_line_step2], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
-
-				// Bayer         -1 0 1 2
-				//         -1     g b g b
-				//          0     r g r g
-				// line_step      g b G b
-				// line_step2     r g r g
-				rgb_buffer[rgb_line_step + 3] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
-				rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-				rgb_buffer[rgb_line_step + 5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
-			}
-
-			// last two pixels of the line
-			// last two pixel values for first two lines
-			// GRGR line
-			// Bayer        -1 0 1
-			//           0   r G r
-			//   line_step   g b g
-			// line_step2    r g r
-			rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
-			rgb_buffer[1] = bayer_pixel[0];
-			rgb_buffer[rgb_line_step + 5] = rgb_buffer[rgb_line_step + 2] = rgb_buffer[5] = rgb_buffer[2] = bayer_pixel[bayer_line_step];
-
-			// Bayer        -1 0 1
-			//          0    r g R
-			//  line_step    g b g
-			// line_step2    r g r
-			rgb_buffer[3] = bayer_pixel[1];
-			rgb_buffer[4] = AVG (bayer_pixel[0], bayer_pixel[bayer_line_step + 1]);
-			//rgb_pixel[5] = bayer_pixel[line_step];
-
-			// BGBG line
-			// Bayer        -1 0 1
-			//          0    r g r
-			//  line_step    g B g
-			// line_step2    r g r
-			rgb_buffer[rgb_line_step ] = AVG4 (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1], bayer_pixel[-1], bayer_pixel[bayer_line_step2 - 1]);
-			rgb_buffer[rgb_line_step + 1] = AVG4 (bayer_pixel[0], bayer_pixel[bayer_line_step2], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
-			//rgb_pixel[rgb_line_step + 2] = bayer_pixel[line_step];
-
-			// Bayer         -1 0 1
-			//         0      r g r
-			// line_step      g b G
-			// line_step2     r g r
-			rgb_buffer[rgb_line_step + 3] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
-			rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-			//rgb_pixel[rgb_line_step + 5] = bayer_pixel[line_step];
-
-			bayer_pixel += bayer_line_step + 2;
-			rgb_buffer += rgb_line_step + 6 + rgb_line_skip;
-		}
-
-		//last two lines
-		// Bayer         0 1 2
-		//        -1     b g b
-		//         0     G r g
-		// line_step     b g b
-
-		rgb_buffer[rgb_line_step + 3] = rgb_buffer[rgb_line_step ] = rgb_buffer[3] = rgb_buffer[0] = bayer_pixel[1]; // red pixel
-		rgb_buffer[1] = bayer_pixel[0]; // green pixel
-		rgb_buffer[rgb_line_step + 2] = rgb_buffer[2] = bayer_pixel[bayer_line_step]; // blue;
-
-		// Bayer         0 1 2
-		//        -1     b g b
-		//         0     g R g
-		// line_step     b g b
-		//rgb_pixel[3] = bayer_pixel[1];
-		rgb_buffer[4] = AVG4 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1], bayer_pixel[1 - bayer_line_step]);
-		rgb_buffer[5] = AVG4 (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2], bayer_pixel[-bayer_line_step], bayer_pixel[2 - bayer_line_step]);
-
-		// BGBG line
-		// Bayer         0 1 2
-		//        -1     b g b
-		//         0     g r g
-		// line_step     B g b
-		//rgb_pixel[rgb_line_step    ] = bayer_pixel[1];
-		rgb_buffer[rgb_line_step + 1] = AVG (bayer_pixel[0], bayer_pixel[bayer_line_step + 1]);
-		rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
-
-		// Bayer         0 1 2
-		//        -1     b g b
-		//         0     g r g
-		// line_step     b G b
-		//rgb_pixel[rgb_line_step + 3] = AVG( bayer_pixel[1] , bayer_pixel[line_step2+1] );
-		rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-		rgb_buffer[rgb_line_step + 5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
-
-		rgb_buffer += 6;
-		bayer_pixel += 2;
-		// rest of the last two lines
-		for (xIdx = 2; xIdx < width - 2; xIdx += 2, rgb_buffer += 6, bayer_pixel += 2)
-		{
-			// GRGR line
-			// Bayer       -1 0 1 2
-			//        -1    g b g b
-			//         0    r G r g
-			// line_step    g b g b
-			rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
-			rgb_buffer[1] = bayer_pixel[0];
-			rgb_buffer[2] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[-bayer_line_step]);
-
-			// Bayer       -1 0 1 2
-			//        -1    g b g b
-			//         0    r g R g
-			// line_step    g b g b
-			rgb_buffer[rgb_line_step + 3] = rgb_buffer[3] = bayer_pixel[1];
-			rgb_buffer[4] = AVG4 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1], bayer_pixel[1 - bayer_line_step]);
-			rgb_buffer[5] = AVG4 (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2], bayer_pixel[-bayer_line_step], bayer_pixel[-bayer_line_step + 2]);
-
-			// BGBG line
-			// Bayer       -1 0 1 2
-			//        -1    g b g b
-			//         0    r g r g
-			// line_step    g B g b
-			rgb_buffer[rgb_line_step ] = AVG (bayer_pixel[-1], bayer_pixel[1]);
-			rgb_buffer[rgb_line_step + 1] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
-			rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
-
-
-			// Bayer       -1 0 1 2
-			//        -1    g b g b
-			//         0    r g r g
-			// line_step    g b G b
-			//rgb_pixel[rgb_line_step + 3] = bayer_pixel[1];
-			rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-			rgb_buffer[rgb_line_step + 5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
-		}
-
-		// last two pixel values for first two lines
-		// GRGR line
-		// Bayer       -1 0 1
-		//        -1    g b g
-		//         0    r G r
-		// line_step    g b g
-		rgb_buffer[rgb_line_step ] = rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
-		rgb_buffer[1] = bayer_pixel[0];
-		rgb_buffer[5] = rgb_buffer[2] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[-bayer_line_step]);
-
-		// Bayer       -1 0 1
-		//        -1    g b g
-		//         0    r g R
-		// line_step    g b g
-		rgb_buffer[rgb_line_step + 3] = rgb_buffer[3] = bayer_pixel[1];
-		rgb_buffer[4] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step + 1], bayer_pixel[-bayer_line_step + 1]);
-		//rgb_pixel[5] = AVG( bayer_pixel[line_step], bayer_pixel[-line_step] );
-
-		// BGBG line
-		// Bayer       -1 0 1
-		//        -1    g b g
-		//         0    r g r
-		// line_step    g B g
-		//rgb_pixel[rgb_line_step    ] = AVG2( bayer_pixel[-1], bayer_pixel[1] );
-		rgb_buffer[rgb_line_step + 1] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
-		rgb_buffer[rgb_line_step + 5] = rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
-
-		// Bayer       -1 0 1
-		//        -1    g b g
-		//         0    r g r
-		// line_step    g b G
-		//rgb_pixel[rgb_line_step + 3] = bayer_pixel[1];
-		rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-		//rgb_pixel[rgb_line_step + 5] = bayer_pixel[line_step];
-	}
-	else if (debayering_method == 2) // EdgeAwareWeighted
-	{
-		int dh, dv;
-
-		// first two pixel values for first two lines
-		// Bayer         0 1 2
-		//         0     G r g
-		// line_step     b g b
-		// line_step2    g r g
-
-		rgb_buffer[3] = rgb_buffer[0] = bayer_pixel[1]; // red pixel
-		rgb_buffer[1] = bayer_pixel[0]; // green pixel
-		rgb_buffer[rgb_line_step + 2] = rgb_buffer[2] = bayer_pixel[bayer_line_step]; // blue;
-
-		// Bayer         0 1 2
-		//         0     g R g
-		// line_step     b g b
-		// line_step2    g r g
-		//rgb_pixel[3] = bayer_pixel[1];
-		rgb_buffer[4] = AVG3 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1]);
-		rgb_buffer[rgb_line_step + 5] = rgb_buffer[5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
-
-		// BGBG line
-		// Bayer         0 1 2
-		//         0     g r g
-		// line_step     B g b
-		// line_step2    g r g
-		rgb_buffer[rgb_line_step + 3] = rgb_buffer[rgb_line_step ] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
-		rgb_buffer[rgb_line_step + 1] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step + 1], bayer_pixel[bayer_line_step2]);
-		//rgb_pixel[rgb_line_step + 2] = bayer_pixel[line_step];
-
-		// pixel (1, 1)  0 1 2
-		//         0     g r g
-		// line_step     b G b
-		// line_step2    g r g
-		//rgb_pixel[rgb_line_step + 3] = AVG( bayer_pixel[1] , bayer_pixel[line_step2+1] );
-		rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-		//rgb_pixel[rgb_line_step + 5] = AVG( bayer_pixel[line_step] , bayer_pixel[line_step+2] );
-
-		rgb_buffer += 6;
-		bayer_pixel += 2;
-		// rest of the first two lines
-		for (xIdx = 2; xIdx < width - 2; xIdx += 2, rgb_buffer += 6, bayer_pixel += 2)
-		{
-			// GRGR line
-			// Bayer        -1 0 1 2
-			//           0   r G r g
-			//   line_step   g b g b
-			// line_step2    r g r g
-			rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
-			rgb_buffer[1] = bayer_pixel[0];
-			rgb_buffer[2] = bayer_pixel[bayer_line_step + 1];
-
-			// Bayer        -1 0 1 2
-			//          0    r g R g
-			//  line_step    g b g b
-			// line_step2    r g r g
-			rgb_buffer[3] = bayer_pixel[1];
-			rgb_buffer[4] = AVG3 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1]);
-			rgb_buffer[rgb_line_step + 5] = rgb_buffer[5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
-
-			// BGBG line
-			// Bayer         -1 0 1 2
-			//         0      r g r g
-			// line_step      g B g b
-			// line_step2     r g r g
-			rgb_buffer[rgb_line_step ] = AVG4 (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1], bayer_pixel[-1], bayer_pixel[bayer_line_step2 - 1]);
-			rgb_buffer[rgb_line_step + 1] = AVG4 (bayer_pixel[0], bayer_pixel[bayer_line_step2], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
-			rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
-
-			// Bayer         -1 0 1 2
-			//         0      r g r g
-			// line_step      g b G b
-			// line_step2     r g r g
-			rgb_buffer[rgb_line_step + 3] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
-			rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-			//rgb_pixel[rgb_line_step + 5] = AVG( bayer_pixel[line_step] , bayer_pixel[line_step+2] );
-		}
-
-		// last two pixel values for first two lines
-		// GRGR line
-		// Bayer        -1 0 1
-		//           0   r G r
-		//   line_step   g b g
-		// line_step2    r g r
-		rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
-		rgb_buffer[1] = bayer_pixel[0];
-		rgb_buffer[rgb_line_step + 5] = rgb_buffer[rgb_line_step + 2] = rgb_buffer[5] = rgb_buffer[2] = bayer_pixel[bayer_line_step];
-
-		// Bayer        -1 0 1
-		//          0    r g R
-		//  line_step    g b g
-		// line_step2    r g r
-		rgb_buffer[3] = bayer_pixel[1];
-		rgb_buffer[4] = AVG (bayer_pixel[0], bayer_pixel[bayer_line_step + 1]);
-		//rgb_pixel[5] = bayer_pixel[line_step];
-
-		// BGBG line
-		// Bayer        -1 0 1
-		//          0    r g r
-		//  line_step    g B g
-		// line_step2    r g r
-		rgb_buffer[rgb_line_step ] = AVG4 (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1], bayer_pixel[-1], bayer_pixel[bayer_line_step2 - 1]);
-		rgb_buffer[rgb_line_step + 1] = AVG4 (bayer_pixel[0], bayer_pixel[bayer_line_step2], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
-		//rgb_pixel[rgb_line_step + 2] = bayer_pixel[line_step];
-
-		// Bayer         -1 0 1
-		//         0      r g r
-		// line_step      g b G
-		// line_step2     r g r
-		rgb_buffer[rgb_line_step + 3] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
-		rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-		//rgb_pixel[rgb_line_step + 5] = bayer_pixel[line_step];
-
-		bayer_pixel += bayer_line_step + 2;
-		rgb_buffer += rgb_line_step + 6 + rgb_line_skip;
-		// main processing
-		for (yIdx = 2; yIdx < height - 2; yIdx += 2)
-		{
-			// first two pixel values
-			// Bayer         0 1 2
-			//        -1     b g b
-			//         0     G r g
-			// line_step     b g b
-			// line_step2    g r g
-
-			rgb_buffer[3] = rgb_buffer[0] = bayer_pixel[1]; // red pixel
-			rgb_buffer[1] = bayer_pixel[0]; // green pixel
-			rgb_buffer[2] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[-bayer_line_step]); // blue;
-
-			// Bayer         0 1 2
-			//        -1     b g b
-			//         0     g R g
-			// line_step     b g b
-			// line_step2    g r g
-			//rgb_pixel[3] = bayer_pixel[1];
-			rgb_buffer[4] = AVG4 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1], bayer_pixel[1 - bayer_line_step]);
-			rgb_buffer[5] = AVG4 (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2], bayer_pixel[-bayer_line_step], bayer_pixel[2 - bayer_line_step]);
-
-			// BGBG line
-			// Bayer         0 1 2
-			//         0     g r g
-			// line_step     B g b
-			// line_step2    g r g
-			rgb_buffer[rgb_line_step + 3] = rgb_buffer[rgb_line_step ] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
-			rgb_buffer[rgb_line_step + 1] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step + 1], bayer_pixel[bayer_line_step2]);
-			rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
-
-			// pixel (1, 1)  0 1 2
-			//         0     g r g
-			// line_step     b G b
-			// line_step2    g r g
-			//rgb_pixel[rgb_line_step + 3] = AVG( bayer_pixel[1] , bayer_pixel[line_step2+1] );
-			rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-			rgb_buffer[rgb_line_step + 5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
-
-			rgb_buffer += 6;
-			bayer_pixel += 2;
-			// continue with rest of the line
-			for (xIdx = 2; xIdx < width - 2; xIdx += 2, rgb_buffer += 6, bayer_pixel += 2)
-			{
-				// GRGR line
-				// Bayer        -1 0 1 2
-				//          -1   g b g b
-				//           0   r G r g
-				//   line_step   g b g b
-				// line_step2    r g r g
-				rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
-				rgb_buffer[1] = bayer_pixel[0];
-				rgb_buffer[2] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[-bayer_line_step]);
-
-				// Bayer        -1 0 1 2
-				//          -1   g b g b
-				//          0    r g R g
-				//  line_step    g b g b
-				// line_step2    r g r g
-
-				dh = abs (bayer_pixel[0] - bayer_pixel[2]);
-				dv = abs (bayer_pixel[-bayer_line_step + 1] - bayer_pixel[bayer_line_step + 1]);
-
-				if (dv == 0 && dh == 0)
-					rgb_buffer[4] = AVG4 (bayer_pixel[1 - bayer_line_step], bayer_pixel[1 + bayer_line_step], bayer_pixel[0], bayer_pixel[2]);
-				else
-					rgb_buffer[4] = WAVG4 (bayer_pixel[1 - bayer_line_step], bayer_pixel[1 + bayer_line_step], bayer_pixel[0], bayer_pixel[2], dh, dv);
-				rgb_buffer[3] = bayer_pixel[1];
-				rgb_buffer[5] = AVG4 (bayer_pixel[-bayer_line_step], bayer_pixel[2 - bayer_line_step], bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
-
-				// BGBG line
-				// Bayer         -1 0 1 2
-				//         -1     g b g b
-				//          0     r g r g
-				// line_step      g B g b
-				// line_step2     r g r g
-				rgb_buffer[rgb_line_step ] = AVG4 (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1], bayer_pixel[-1], bayer_pixel[bayer_line_step2 - 1]);
-				rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
-
-				dv = abs (bayer_pixel[0] - bayer_pixel[bayer_line_step2]);
-				dh = abs (bayer_pixel[bayer_line_step - 1] - bayer_pixel[bayer_line_step + 1]);
-
-				if (dv == 0 && dh == 0)
-					rgb_buffer[rgb_line_step + 1] = AVG4 (bayer_pixel[0], bayer_pixel[bayer_line_step2], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
-				else
-					rgb_buffer[rgb_line_step + 1] = WAVG4 (bayer_pixel[0], bayer_pixel[bayer_line_step2], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1], dh, dv);
-
-				// Bayer         -1 0 1 2
-				//         -1     g b g b
-				//          0     r g r g
-				// line_step      g b G b
-				// line_step2     r g r g
-				rgb_buffer[rgb_line_step + 3] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
-				rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-				rgb_buffer[rgb_line_step + 5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
-			}
-
-			// last two pixels of the line
-			// last two pixel values for first two lines
-			// GRGR line
-			// Bayer        -1 0 1
-			//           0   r G r
-			//   line_step   g b g
-			// line_step2    r g r
-			rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
-			rgb_buffer[1] = bayer_pixel[0];
-			rgb_buffer[rgb_line_step + 5] = rgb_buffer[rgb_line_step + 2] = rgb_buffer[5] = rgb_buffer[2] = bayer_pixel[bayer_line_step];
-
-			// Bayer        -1 0 1
-			//          0    r g R
-			//  line_step    g b g
-			// line_step2    r g r
-			rgb_buffer[3] = bayer_pixel[1];
-			rgb_buffer[4] = AVG (bayer_pixel[0], bayer_pixel[bayer_line_step + 1]);
-			//rgb_pixel[5] = bayer_pixel[line_step];
-
-			// BGBG line
-			// Bayer        -1 0 1
-			//          0    r g r
-			//  line_step    g B g
-			// line_step2    r g r
-			rgb_buffer[rgb_line_step ] = AVG4 (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1], bayer_pixel[-1], bayer_pixel[bayer_line_step2 - 1]);
-			rgb_buffer[rgb_line_step + 1] = AVG4 (bayer_pixel[0], bayer_pixel[bayer_line_step2], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
-			//rgb_pixel[rgb_line_step + 2] = bayer_pixel[line_step];
-
-			// Bayer         -1 0 1
-			//         0      r g r
-			// line_step      g b G
-			// line_step2     r g r
-			rgb_buffer[rgb_line_step + 3] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
-			rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-			//rgb_pixel[rgb_line_step + 5] = bayer_pixel[line_step];
-
-			bayer_pixel += bayer_line_step + 2;
-			rgb_buffer += rgb_line_step + 6 + rgb_line_skip;
-		}
-
-		//last two lines
-		// Bayer         0 1 2
-		//        -1     b g b
-		//         0     G r g
-		// line_step     b g b
-
-		rgb_buffer[rgb_line_step + 3] = rgb_buffer[rgb_line_step ] = rgb_buffer[3] = rgb_buffer[0] = bayer_pixel[1]; // red pixel
-		rgb_buffer[1] = bayer_pixel[0]; // green pixel
-		rgb_buffer[rgb_line_step + 2] = rgb_buffer[2] = bayer_pixel[bayer_line_step]; // blue;
-
-		// Bayer         0 1 2
-		//        -1     b g b
-		//         0     g R g
-		// line_step     b g b
-		//rgb_pixel[3] = bayer_pixel[1];
-		rgb_buffer[4] = AVG4 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1], bayer_pixel[1 - bayer_line_step]);
-		rgb_buffer[5] = AVG4 (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2], bayer_pixel[-bayer_line_step], bayer_pixel[2 - bayer_line_step]);
-
-		// BGBG line
-		// Bayer         0 1 2
-		//        -1     b g b
-		//         0     g r g
-		// line_step     B g b
-		//rgb_pixel[rgb_line_step    ] = bayer_pixel[1];
-		rgb_buffer[rgb_line_step + 1] = AVG (bayer_pixel[0], bayer_pixel[bayer_line_step + 1]);
-		rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
-
-		// Bayer         0 1 2
-		//        -1     b g b
-		//         0     g r g
-		// line_step     b G b
-		//rgb_pixel[rgb_line_step + 3] = AVG( bayer_pixel[1] , bayer_pixel[line_step2+1] );
-		rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-		rgb_buffer[rgb_line_step + 5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
-
-		rgb_buffer += 6;
-		bayer_pixel += 2;
-		// rest of the last two lines
-		for (xIdx = 2; xIdx < width - 2; xIdx += 2, rgb_buffer += 6, bayer_pixel += 2)
-		{
-			// GRGR line
-			// Bayer       -1 0 1 2
-			//        -1    g b g b
-			//         0    r G r g
-			// line_step    g b g b
-			rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
-			rgb_buffer[1] = bayer_pixel[0];
-			rgb_buffer[2] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[-bayer_line_step]);
-
-			// Bayer       -1 0 1 2
-			//        -1    g b g b
-			//         0    r g R g
-			// line_step    g b g b
-			rgb_buffer[rgb_line_step + 3] = rgb_buffer[3] = bayer_pixel[1];
-			rgb_buffer[4] = AVG4 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1], bayer_pixel[1 - bayer_line_step]);
-			rgb_buffer[5] = AVG4 (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2], bayer_pixel[-bayer_line_step], bayer_pixel[-bayer_line_step + 2]);
-
-			// BGBG line
-			// Bayer       -1 0 1 2
-			//        -1    g b g b
-			//         0    r g r g
-			// line_step    g B g b
-			rgb_buffer[rgb_line_step ] = AVG (bayer_pixel[-1], bayer_pixel[1]);
-			rgb_buffer[rgb_line_step + 1] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
-			rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
-
-
-			// Bayer       -1 0 1 2
-			//        -1    g b g b
-			//         0    r g r g
-			// line_step    g b G b
-			//rgb_pixel[rgb_line_step + 3] = bayer_pixel[1];
-			rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-			rgb_buffer[rgb_line_step + 5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
-		}
-
-		// last two pixel values for first two lines
-		// GRGR line
-		// Bayer       -1 0 1
-		//        -1    g b g
-		//         0    r G r
-		// line_step    g b g
-		rgb_buffer[rgb_line_step ] = rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
-		rgb_buffer[1] = bayer_pixel[0];
-		rgb_buffer[5] = rgb_buffer[2] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[-bayer_line_step]);
-
-		// Bayer       -1 0 1
-		//        -1    g b g
-		//         0    r g R
-		// line_step    g b g
-		rgb_buffer[rgb_line_step + 3] = rgb_buffer[3] = bayer_pixel[1];
-		rgb_buffer[4] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step + 1], bayer_pixel[-bayer_line_step + 1]);
-		//rgb_pixel[5] = AVG( bayer_pixel[line_step], bayer_pixel[-line_step] );
-
-		// BGBG line
-		// Bayer       -1 0 1
-		//        -1    g b g
-		//         0    r g r
-		// line_step    g B g
-		//rgb_pixel[rgb_line_step    ] = AVG2( bayer_pixel[-1], bayer_pixel[1] );
-		rgb_buffer[rgb_line_step + 1] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
-		rgb_buffer[rgb_line_step + 5] = rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
-
-		// Bayer       -1 0 1
-		//        -1    g b g
-		//         0    r g r
-		// line_step    g b G
-		//rgb_pixel[rgb_line_step + 3] = bayer_pixel[1];
-		rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
-		//rgb_pixel[rgb_line_step + 5] = bayer_pixel[line_step];
+		std::cerr << "ERROR - Kinect::FillRGBBayer:" << std::endl;
+		std::cerr << "\t ... Resizing of bayer images not supported" << std::endl;
+		return RET_FAILED;
 	}
 
-	return  RET_OK;
+	return ConvertBayerGRBGToRGB((const unsigned char*) m_vfr_rgb.getData(), width, height, rgb_buffer, DEBAYERING_EDGE_AWARE_WEIGHTED);
 }
 
 
@@ -1,12 +1,14 @@
 #include <cob_vision_utils/StdAfx.h>
 #ifdef __LINUX__
 	#include "cob_camera_sensors_ipa/PMDCamCube.h"
+	#include "cob_camera_sensors_ipa/AcquisitionProfiler.h"
 
 	#include "cob_vision_utils/VisionUtils.h"
 	#include "tinyxml.h"
 	#include <iostream>
 #else
 	#include "cob_bringup_sandbox/cob_camera_sensors_ipa/common/include/cob_camera_sensors_ipa/PMDCamCube.h"
+	#include "cob_bringup_sandbox/cob_camera_sensors_ipa/common/include/cob_camera_sensors_ipa/AcquisitionProfiler.h"
 
 	#include "cob_perception_common/cob_vision_utils/common/include/cob_vision_utils/VisionUtils.h"
 #endif
@@ -15,6 +17,14 @@
 
 using namespace ipa_CameraSensors;
 
+static const int s_StageTotal = AcquisitionProfiler::RegisterStage("PMDCamCube/total");
+static const int s_StageUpdate = AcquisitionProfiler::RegisterStage("PMDCamCube/sdk_update");
+static const int s_StageRangeRead = AcquisitionProfiler::RegisterStage("PMDCamCube/range_read");
+static const int s_StageGrayRead = AcquisitionProfiler::RegisterStage("PMDCamCube/gray_read");
+static const int s_StageCartesianRead = AcquisitionProfiler::RegisterStage("PMDCamCube/cartesian_read");
+static const int s_StageUndistortion = AcquisitionProfiler::RegisterStage("PMDCamCube/undistortion");
+static const int s_StageBackProjection = AcquisitionProfiler::RegisterStage("PMDCamCube/back_projection");
+
 __DLL_LIBCAMERASENSORS__ AbstractRangeImagingSensorPtr ipa_CameraSensors::CreateRangeImagingSensor_PMDCam()
 {
 	return AbstractRangeImagingSensorPtr(new PMDCamCube());
@@ -49,6 +59,8 @@ unsigned long PMDCamCube::Init(std::string directory, int cameraIndex)
 		return (RET_OK | RET_CAMERA_ALREADY_INITIALIZED);
 	}
 
+	AcquisitionProfiler::InstallDefaultDumpSignalHandler();
+
 	m_CameraType = ipa_CameraSensors::CAM_PMDCAM;
 
 	// Load SR parameters from xml-file
@@ -59,6 +71,8 @@ unsigned long PMDCamCube::Init(std::string directory, int cameraIndex)
 		return (RET_FAILED | RET_INIT_CAMERA_FAILED);	
 	}
 	
+	m_UndistortMapDirectory = directory + "UndistortMaps/";
+
 	m_CoeffsInitialized = true;
 	if (m_CalibrationMethod == MATLAB)
 	{
@@ -266,6 +280,24 @@ unsigned long PMDCamCube::Open()
 	std::cout << "*************************************************" << std::endl << std::endl;
 	m_open = true;
 
+	// Undistortion maps of the configured lens calibration, memory-mapped from
+	// the cache after the first start. SetIntrinsics() replaces them.
+	if (!m_LensDistortion.empty())
+	{
+		ipa_CameraSensors::t_cameraProperty cameraProperty;
+		cameraProperty.propertyID = PROP_CAMERA_RESOLUTION;
+		GetProperty(&cameraProperty);
+		cv::Size imageSize(cameraProperty.cameraResolution.xResolution, cameraProperty.cameraResolution.yResolution);
+		if (m_UndistortMaps.Load(m_UndistortMapDirectory, m_LensIntrinsics, m_LensDistortion, imageSize) & RET_FAILED)
+		{
+			std::cerr << "ERROR - PMDCamCube::Open:" << std::endl;
+			std::cerr << "\t ... Could not create the undistortion maps" << std::endl;
+			Close();
+			return RET_FAILED;
+		}
+		m_intrinsicMatrix = m_LensIntrinsics.clone();
+	}
+
 	return RET_OK;
 }
 
@@ -853,6 +885,8 @@ unsigned long PMDCamCube::AcquireImages(int widthStepRange, int widthStepGray, i
 		return (RET_FAILED | RET_CAMERA_NOT_OPEN);
 	}
 
+	ScopedStageTimer totalTimer(s_StageTotal);
+
 	int width = -1;
 	int height = -1;
 	ipa_CameraSensors::t_cameraProperty cameraProperty;
@@ -862,7 +896,9 @@ unsigned long PMDCamCube::AcquireImages(int widthStepRange, int widthStepGray, i
 	height = cameraProperty.cameraResolution.yResolution;
 
 	// Acquire new image data
+	ScopedStageTimer updateTimer(s_StageUpdate);
 	ret = pmdUpdate (m_PMDCam);
+	updateTimer.Stop();
 	if (ret != PMD_OK)
 	{
 		pmdGetLastError (m_PMDCam, err, 128);
@@ -881,6 +917,7 @@ unsigned long PMDCamCube::AcquireImages(int widthStepRange, int widthStepGray, i
 		float* f_ptr_dst = 0;
 		cv::Mat pmdData(height, width, CV_32FC1 );
 
+		ScopedStageTimer rangeReadTimer(s_StageRangeRead);
 		ret = pmdGetAmplitudes(m_PMDCam, (float*) pmdData.data, height*width*sizeof(float));
 		if (ret != PMD_OK)
 		{
@@ -902,14 +939,16 @@ unsigned long PMDCamCube::AcquireImages(int widthStepRange, int widthStepGray, i
 				f_ptr_dst[width - col - 1] = f_ptr[col];
 			}	
 		}
+		rangeReadTimer.Stop();
 
 		if (undistort)
 		{
+			ScopedStageTimer undistortionTimer(s_StageUndistortion);
 			cv::Mat undistortedData (height, width, CV_32FC1, (float*) rangeImageData);
-			cv::Mat distortedData;
+			undistortedData.copyTo(m_DistortedData);
  
-			assert (!m_undistortMapX.empty() && !m_undistortMapY.empty());
-			cv::remap(distortedData, undistortedData, m_undistortMapX, m_undistortMapY, cv::INTER_LINEAR);
+			assert (m_UndistortMaps.isValid());
+			m_UndistortMaps.Remap(m_DistortedData, undistortedData, cv::INTER_LINEAR);
 		}
 
 	} // End if (rangeImage)
@@ -923,6 +962,7 @@ unsigned long PMDCamCube::AcquireImages(int widthStepRange, int widthStepGray, i
 		float* f_ptr_dst = 0;
 		cv::Mat pmdData(height, width, CV_32FC1 );
 		
+		ScopedStageTimer grayReadTimer(s_StageGrayRead);
 		if (grayImageType == ipa_CameraSensors::INTENSITY_32F1)
 		{
 			ret = pmdGetIntensities(m_PMDCam, (float*) pmdData.data, height*width*sizeof (float));
@@ -952,14 +992,16 @@ unsigned long PMDCamCube::AcquireImages(int widthStepRange, int widthStepGray, i
 				f_ptr_dst[width - col -1] = f_ptr[col];
 			}	
 		}
+		grayReadTimer.Stop();
 		
 		if (undistort)
 		{
+			ScopedStageTimer undistortionTimer(s_StageUndistortion);
 			cv::Mat undistortedData (height, width, CV_32FC1, (float*) grayImageData);
-			cv::Mat distortedData;
+			undistortedData.copyTo(m_DistortedData);
  
-			assert (!m_undistortMapX.empty() && !m_undistortMapY.empty());
-			cv::remap(distortedData, undistortedData, m_undistortMapX, m_undistortMapY, cv::INTER_LINEAR);
+			assert (m_UndistortMaps.isValid());
+			m_UndistortMaps.Remap(m_DistortedData, undistortedData, cv::INTER_LINEAR);
 		}
 
 	}
@@ -1052,6 +1094,7 @@ unsigned long PMDCamCube::AcquireImages(int widthStepRange, int widthStepGray, i
 			cv::Mat pmdData(height, 3*width, CV_32FC1);
 			cv::Mat distortedData(height, width, CV_32FC1);
 
+			ScopedStageTimer cartesianReadTimer(s_StageCartesianRead);
 			//ret = pmdGetDistances(m_PMDCam, ((float*) distortedData->data.ptr), height*width*sizeof (float));
 			ret = pmdGet3DCoordinates(m_PMDCam, (float*) pmdData.data, 3*height*width*sizeof (float));
 			if (ret != PMD_OK)
@@ -1074,14 +1117,18 @@ unsigned long PMDCamCube::AcquireImages(int widthStepRange, int widthStepGray, i
 					f_ptr_dst[width - col - 1] = f_ptr[col*3 + 2];
 				}	
 			}
+			cartesianReadTimer.Stop();
 
 			// Undistort
+			ScopedStageTimer undistortionTimer(s_StageUndistortion);
 			cv::Mat undistortedData;
 
-			assert (!m_undistortMapX.empty() && !m_undistortMapY.empty());
-			cv::remap(distortedData, undistortedData, m_undistortMapX, m_undistortMapY, cv::INTER_LINEAR);
+			assert (m_UndistortMaps.isValid());
+			m_UndistortMaps.Remap(distortedData, undistortedData, cv::INTER_LINEAR);
+			undistortionTimer.Stop();
 
 			// Calculate X and Y based on instrinsic rotation and translation
+			ScopedStageTimer backProjectionTimer(s_StageBackProjection);
 			for(unsigned int row=0; row<(unsigned int)height; row++)
 			{
 				zCalibratedPtr = undistortedData.ptr<float>(row);
@@ -1101,6 +1148,7 @@ unsigned long PMDCamCube::AcquireImages(int widthStepRange, int widthStepGray, i
 		else if(m_CalibrationMethod==NATIVE)
 		{
 			cv::Mat pmdData(height, 3*width, CV_32FC1 );
+			ScopedStageTimer cartesianReadTimer(s_StageCartesianRead);
 			//ret = pmdGet3DCoordinates(m_PMDCam, ((float*) cartesianImageData), 3*height*width*sizeof (float));
 			ret = pmdGet3DCoordinates(m_PMDCam, (float*) pmdData.data, 3*height*width*sizeof (float));
 			if (ret != PMD_OK)
@@ -1145,6 +1193,16 @@ unsigned long PMDCamCube::SaveParameters(const char* filename)
 	return RET_FUNCTION_NOT_IMPLEMENTED;
 }
 
+unsigned long PMDCamCube::SetIntrinsics(cv::Mat& intrinsicMatrix,
+		cv::Mat& undistortMapX, cv::Mat& undistortMapY)
+{
+	unsigned long ret = AbstractRangeImagingSensor::SetIntrinsics(intrinsicMatrix, undistortMapX, undistortMapY);
+	if (ret & RET_FAILED)
+		return ret;
+
+	return m_UndistortMaps.SetMaps(undistortMapX, undistortMapY);
+}
+
 unsigned long PMDCamCube::GetCalibratedZMatlab(int u, int v, float zRaw, float& zCalibrated)
 {
 	double c[7] = {m_CoeffsA0.at<double>(v,u), m_CoeffsA1.at<double>(v,u), m_CoeffsA2.at<double>(v,u), 
@@ -1742,6 +1800,40 @@ unsigned long PMDCamCube::LoadParameters(const char* filename, int cameraIndex)
 					std::cerr << "\t ... Can't find tag 'CalibrationMethod'." << std::endl;
 					return (RET_FAILED | RET_XML_TAG_NOT_FOUND);
 				}
+
+//************************************************************************************
+//	BEGIN LibCameraSensors->PMDCamCube->IntrinsicParameters, DistortionCoeffs
+//************************************************************************************
+				// Optional subtag elements "IntrinsicParameters" and "DistortionCoeffs" of Xml Inifile.
+				// With both, Open() loads the undistortion maps from the map cache.
+				m_LensIntrinsics.release();
+				m_LensDistortion.release();
+				TiXmlElement *p_xmlElement_Intrinsics = p_xmlElement_Root_SR31->FirstChildElement( "IntrinsicParameters" );
+				TiXmlElement *p_xmlElement_Distortion = p_xmlElement_Root_SR31->FirstChildElement( "DistortionCoeffs" );
+				if ( p_xmlElement_Intrinsics && p_xmlElement_Distortion )
+				{
+					double fx, fy, cx, cy, k1, k2, p1, p2;
+					if ( p_xmlElement_Intrinsics->QueryValueAttribute( "fx", &fx ) != TIXML_SUCCESS ||
+						p_xmlElement_Intrinsics->QueryValueAttribute( "fy", &fy ) != TIXML_SUCCESS ||
+						p_xmlElement_Intrinsics->QueryValueAttribute( "cx", &cx ) != TIXML_SUCCESS ||
+						p_xmlElement_Intrinsics->QueryValueAttribute( "cy", &cy ) != TIXML_SUCCESS)
+					{
+						std::cerr << "ERROR - PMDCamCube::LoadParameters:" << std::endl;
+						std::cerr << "\t ... Can't find attributes 'fx', 'fy', 'cx' and 'cy' of tag 'IntrinsicParameters'." << std::endl;
+						return (RET_FAILED | RET_XML_ATTR_NOT_FOUND);
+					}
+					if ( p_xmlElement_Distortion->QueryValueAttribute( "k1", &k1 ) != TIXML_SUCCESS ||
+						p_xmlElement_Distortion->QueryValueAttribute( "k2", &k2 ) != TIXML_SUCCESS ||
+						p_xmlElement_Distortion->QueryValueAttribute( "p1", &p1 ) != TIXML_SUCCESS ||
+						p_xmlElement_Distortion->QueryValueAttribute( "p2", &p2 ) != TIXML_SUCCESS)
+					{
+						std::cerr << "ERROR - PMDCamCube::LoadParameters:" << std::endl;
+						std::cerr << "\t ... Can't find attributes 'k1', 'k2', 'p1' and 'p2' of tag 'DistortionCoeffs'." << std::endl;
+						return (RET_FAILED | RET_XML_ATTR_NOT_FOUND);
+					}
+					m_LensIntrinsics = (cv::Mat_<double>(3, 3) << fx, 0, cx, 0, fy, cy, 0, 0, 1);
+					m_LensDistortion = (cv::Mat_<double>(1, 4) << k1, k2, p1, p2);
+				}
 			}
 //************************************************************************************
 //	END LibCameraSensors->PMDCamCube
@@ -0,0 +1,1381 @@
+/****************************************************************
+*
+* Copyright (c) 2026
+*
+* Fraunhofer Institute for Manufacturing Engineering
+* and Automation (IPA)
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Project name: care-o-bot
+* ROS stack name: cob_bringup_sandbox
+* ROS package name: cob_camera_sensors_ipa
+* Description: Image processing kernels shared by the camera drivers.
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Date of creation: October 2026
+* ToDo:
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer.
+* * Redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution.
+* * Neither the name of the Fraunhofer Institute for Manufacturing
+* Engineering and Automation (IPA) nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License LGPL as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License LGPL for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License LGPL along with this program.
+* If not, see <http://www.gnu.org/licenses/>.
+*
+****************************************************************/
+
+#include <cob_vision_utils/StdAfx.h>
+#ifdef __LINUX__
+	#include "cob_camera_sensors_ipa/ProcessingKernels.h"
+	#include "cob_vision_utils/GlobalDefines.h"
+
+	#include <iostream>
+#else
+	#include "cob_bringup_sandbox/cob_camera_sensors_ipa/common/include/cob_camera_sensors_ipa/ProcessingKernels.h"
+	#include "cob_perception_common/cob_vision_utils/common/include/cob_vision_utils/GlobalDefines.h"
+#endif
+
+using namespace ipa_CameraSensors;
+
+#define AVG(a,b) (((int)(a) + (int)(b)) >> 1)
+#define AVG3(a,b,c) (((int)(a) + (int)(b) + (int)(c)) / 3)
+#define AVG4(a,b,c,d) (((int)(a) + (int)(b) + (int)(c) + (int)(d)) >> 2)
+#define WAVG4(a,b,c,d,x,y)  ( ( ((int)(a) + (int)(b)) * (int)(x) + ((int)(c) + (int)(d)) * (int)(y) ) / ( 2 * ((int)(x) + (int(y))) ) )
+#define IPA_CLIP_CHAR(c) ((c)>255?255:(c)<0?0:(c))
+
+unsigned long ipa_CameraSensors::ConvertYUV422ToRGB(const unsigned char* yuvData, unsigned yuvWidth, unsigned yuvHeight,
+	unsigned char* rgb_buffer, unsigned width, unsigned height)
+{
+	// 0  1   2  3
+	// u  y1  v  y2
+
+	if (yuvWidth != width || yuvHeight != height)
+	{
+		if (width > yuvWidth || height > yuvHeight)
+		{
+			std::cerr << "ERROR - ipa_CameraSensors::ConvertYUV422ToRGB:" << std::endl;
+			std::cerr << "\t ... Upsampling not supported" << std::endl;
+			return RET_FAILED;
+		}
+
+		if ( yuvWidth % width != 0 || yuvHeight % height != 0
+			|| (yuvWidth / width) & 0x01 || (yuvHeight / height) & 0x01 )
+		{
+			std::cerr << "ERROR - ipa_CameraSensors::ConvertYUV422ToRGB:" << std::endl;
+			std::cerr << "\t ... Downsampling only possible for even integer scale in both dimensions" << std::endl;
+			return RET_FAILED;
+		}
+	}
+
+	register const unsigned char* yuv_buffer = yuvData;
+
+	if (yuvWidth == width && yuvHeight == height)
+	{
+		for( register unsigned yIdx = 0; yIdx < height; ++yIdx )
+		{
+			for( register unsigned xIdx = 0; xIdx < width; xIdx += 2, rgb_buffer += 6, yuv_buffer += 4 )
+			{
+				int v = yuv_buffer[2] - 128;
+				int u = yuv_buffer[0] - 128;
+
+				rgb_buffer[0] =  IPA_CLIP_CHAR (yuv_buffer[1] + ((v * 18678 + 8192 ) >> 14));
+				rgb_buffer[1] =  IPA_CLIP_CHAR (yuv_buffer[1] + ((v * -9519 - u * 6472 + 8192 ) >> 14));
+				rgb_buffer[2] =  IPA_CLIP_CHAR (yuv_buffer[1] + ((u * 33292 + 8192 ) >> 14));
+
+				rgb_buffer[3] =  IPA_CLIP_CHAR (yuv_buffer[3] + ((v * 18678 + 8192 ) >> 14));
+				rgb_buffer[4] =  IPA_CLIP_CHAR (yuv_buffer[3] + ((v * -9519 - u * 6472 + 8192 ) >> 14));
+				rgb_buffer[5] =  IPA_CLIP_CHAR (yuv_buffer[3] + ((u * 33292 + 8192 ) >> 14));
+			}
+		}
+	}
+	else
+	{
+		register unsigned yuv_step = yuvWidth / width;
+		register unsigned yuv_x_step = yuv_step << 1;
+		register unsigned yuv_skip = (yuvHeight / height - 1) * ( yuvWidth << 1 );
+
+		for( register unsigned yIdx = 0; yIdx < yuvHeight; yIdx += yuv_step, yuv_buffer += yuv_skip )
+		{
+			for( register unsigned xIdx = 0; xIdx < yuvWidth; xIdx += yuv_step, rgb_buffer += 3, yuv_buffer += yuv_x_step )
+			{
+				int v = yuv_buffer[2] - 128;
+				int u = yuv_buffer[0] - 128;
+
+				rgb_buffer[0] =  IPA_CLIP_CHAR (yuv_buffer[1] + ((v * 18678 + 8192 ) >> 14));
+				rgb_buffer[1] =  IPA_CLIP_CHAR (yuv_buffer[1] + ((v * -9519 - u * 6472 + 8192 ) >> 14));
+				rgb_buffer[2] =  IPA_CLIP_CHAR (yuv_buffer[1] + ((u * 33292 + 8192 ) >> 14));
+			}
+		}
+	}
+	return RET_OK;
+}
+
+unsigned long ipa_CameraSensors::ConvertBayerGRBGToRGB(const unsigned char* bayerData, unsigned width, unsigned height,
+	unsigned char* rgb_buffer, t_DebayeringMethod debayeringMethod)
+{
+	unsigned int rgb_line_step = width * 3;
+
+	// padding skip for destination image
+	unsigned rgb_line_skip = rgb_line_step - width * 3;
+
+	register const unsigned char *bayer_pixel = bayerData;
+	
+	register unsigned yIdx, xIdx;
+
+	int bayer_line_step = width;
+	int bayer_line_step2 = width << 1;
+
+	if (debayeringMethod == DEBAYERING_BILINEAR)
+	{
+		// first two pixel values for first two lines
+		// Bayer         0 1 2
+		//         0     G r g
+		// line_step     b g b
+		// line_step2    g r g
+
+		rgb_buffer[3] = rgb_buffer[0] = bayer_pixel[1]; // red pixel
+		rgb_buffer[1] = bayer_pixel[0]; // green pixel
+		rgb_buffer[rgb_line_step + 2] = rgb_buffer[2] = bayer_pixel[bayer_line_step]; // blue;
+
+		// Bayer         0 1 2
+		//         0     g R g
+		// line_step     b g b
+		// line_step2    g r g
+		//rgb_pixel[3] = bayer_pixel[1];
+		rgb_buffer[4] = AVG3 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1]);
+		rgb_buffer[rgb_line_step + 5] = rgb_buffer[5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
+
+		// BGBG line
+		// Bayer         0 1 2
+		//         0     g r g
+		// line_step     B g b
+		// line_step2    g r g
+		rgb_buffer[rgb_line_step + 3] = rgb_buffer[rgb_line_step ] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
+		rgb_buffer[rgb_line_step + 1] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step + 1], bayer_pixel[bayer_line_step2]);
+		//rgb_pixel[rgb_line_step + 2] = bayer_pixel[line_step];
+
+		// pixel (1, 1)  0 1 2
+		//         0     g r g
+		// line_step     b G b
+		// line_step2    g r g
+		//rgb_pixel[rgb_line_step + 3] = AVG( bayer_pixel[1] , bayer_pixel[line_step2+1] );
+		rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+		//rgb_pixel[rgb_line_step + 5] = AVG( bayer_pixel[line_step] , bayer_pixel[line_step+2] );
+
+		rgb_buffer += 6;
+		bayer_pixel += 2;
+		// rest of the first two lines
+
+		for (xIdx = 2; xIdx < width - 2; xIdx += 2, rgb_buffer += 6, bayer_pixel += 2)
+		{
+			// GRGR line
+			// Bayer        -1 0 1 2
+			//           0   r G r g
+			//   line_step   g b g b
+			// line_step2    r g r g
+			rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
+			rgb_buffer[1] = bayer_pixel[0];
+			rgb_buffer[2] = bayer_pixel[bayer_line_step + 1];
+
+			// Bayer        -1 0 1 2
+			//          0    r g R g
+			//  line_step    g b g b
+			// line_step2    r g r g
+			rgb_buffer[3] = bayer_pixel[1];
+			rgb_buffer[4] = AVG3 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1]);
+			rgb_buffer[rgb_line_step + 5] = rgb_buffer[5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
+
+			// BGBG line
+			// Bayer         -1 0 1 2
+			//         0      r g r g
+			// line_step      g B g b
+			// line_step2     r g r g
+			rgb_buffer[rgb_line_step ] = AVG4 (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1], bayer_pixel[-1], bayer_pixel[bayer_line_step2 - 1]);
+			rgb_buffer[rgb_line_step + 1] = AVG4 (bayer_pixel[0], bayer_pixel[bayer_line_step2], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
+			rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
+
+			// Bayer         -1 0 1 2
+			//         0      r g r g
+			// line_step      g b G b
+			// line_step2     r g r g
+			rgb_buffer[rgb_line_step + 3] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
+			rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+			//rgb_pixel[rgb_line_step + 5] = AVG( bayer_pixel[line_step] , bayer_pixel[line_step+2] );
+		}
+
+		// last two pixel values for first two lines
+		// GRGR line
+		// Bayer        -1 0 1
+		//           0   r G r
+		//   line_step   g b g
+		// line_step2    r g r
+		rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
+		rgb_buffer[1] = bayer_pixel[0];
+		rgb_buffer[rgb_line_step + 5] = rgb_buffer[rgb_line_step + 2] = rgb_buffer[5] = rgb_buffer[2] = bayer_pixel[bayer_line_step];
+
+		// Bayer        -1 0 1
+		//          0    r g R
+		//  line_step    g b g
+		// line_step2    r g r
+		rgb_buffer[3] = bayer_pixel[1];
+		rgb_buffer[4] = AVG (bayer_pixel[0], bayer_pixel[bayer_line_step + 1]);
+		//rgb_pixel[5] = bayer_pixel[line_step];
+
+		// BGBG line
+		// Bayer        -1 0 1
+		//          0    r g r
+		//  line_step    g B g
+		// line_step2    r g r
+		rgb_buffer[rgb_line_step ] = AVG4 (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1], bayer_pixel[-1], bayer_pixel[bayer_line_step2 - 1]);
+		rgb_buffer[rgb_line_step + 1] = AVG4 (bayer_pixel[0], bayer_pixel[bayer_line_step2], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
+		//rgb_pixel[rgb_line_step + 2] = bayer_pixel[line_step];
+
+		// Bayer         -1 0 1
+		//         0      r g r
+		// line_step      g b G
+		// line_step2     r g r
+		rgb_buffer[rgb_line_step + 3] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
+		rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+		//rgb_pixel[rgb_line_step + 5] = bayer_pixel[line_step];
+
+		bayer_pixel += bayer_line_step + 2;
+		rgb_buffer += rgb_line_step + 6 + rgb_line_skip;
+
+		// main processing
+
+		for (yIdx = 2; yIdx < height - 2; yIdx += 2)
+		{
+			// first two pixel values
+			// Bayer         0 1 2
+			//        -1     b g b
+			//         0     G r g
+			// line_step     b g b
+			// line_step2    g r g
+
+			rgb_buffer[3] = rgb_buffer[0] = bayer_pixel[1]; // red pixel
+			rgb_buffer[1] = bayer_pixel[0]; // green pixel
+			rgb_buffer[2] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[-bayer_line_step]); // blue;
+
+			// Bayer         0 1 2
+			//        -1     b g b
+			//         0     g R g
+			// line_step     b g b
+			// line_step2    g r g
+			//rgb_pixel[3] = bayer_pixel[1];
+			rgb_buffer[4] = AVG4 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1], bayer_pixel[1 - bayer_line_step]);
+			rgb_buffer[5] = AVG4 (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2], bayer_pixel[-bayer_line_step], bayer_pixel[2 - bayer_line_step]);
+
+			// BGBG line
+			// Bayer         0 1 2
+			//         0     g r g
+			// line_step     B g b
+			// line_step2    g r g
+			rgb_buffer[rgb_line_step + 3] = rgb_buffer[rgb_line_step ] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
+			rgb_buffer[rgb_line_step + 1] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step + 1], bayer_pixel[bayer_line_step2]);
+			rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
+
+			// pixel (1, 1)  0 1 2
+			//         0     g r g
+			// line_step     b G b
+			// line_step2    g r g
+			//rgb_pixel[rgb_line_step + 3] = AVG( bayer_pixel[1] , bayer_pixel[line_step2+1] );
+			rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+			rgb_buffer[rgb_line_step + 5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
+
+			rgb_buffer += 6;
+			bayer_pixel += 2;
+			// continue with rest of the line
+			for (xIdx = 2; xIdx < width - 2; xIdx += 2, rgb_buffer += 6, bayer_pixel += 2)
+			{
+				// GRGR line
+				// Bayer        -1 0 1 2
+				//          -1   g b g b
+				//           0   r G r g
+				//   line_step   g b g b
+				// line_step2    r g r g
+				rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
+				rgb_buffer[1] = bayer_pixel[0];
+				rgb_buffer[2] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[-bayer_line_step]);
+
+				// Bayer        -1 0 1 2
+				//          -1   g b g b
+				//          0    r g R g
+				//  line_step    g b g b
+				// line_step2    r g r g
+				rgb_buffer[3] = bayer_pixel[1];
+				rgb_buffer[4] = AVG4 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1], bayer_pixel[1 - bayer_line_step]);
+				rgb_buffer[5] = AVG4 (bayer_pixel[-bayer_line_step], bayer_pixel[2 - bayer_line_step], bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
+
+				// BGBG line
+				// Bayer         -1 0 1 2
+				//         -1     g b g b
+				//          0     r g r g
+				// line_step      g B g b
+				// line_step2     r g r g
+				rgb_buffer[rgb_line_step ] = AVG4 (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1], bayer_pixel[-1], bayer_pixel[bayer_line_step2 - 1]);
+				rgb_buffer[rgb_line_step + 1] = AVG4 (bayer_pixel[0], bayer_pixel[bayer_line_step2], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
+				rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
+
+				// Bayer         -1 0 1 2
+				//         -1     g b g b
+				//          0     r g r g
+				// line_step      g b G b
+				// line_step2     r g r g
+				rgb_buffer[rgb_line_step + 3] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
+				rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+				rgb_buffer[rgb_line_step + 5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
+			}
+
+			// last two pixels of the line
+			// last two pixel values for first two lines
+			// GRGR line
+			// Bayer        -1 0 1
+			//           0   r G r
+			//   line_step   g b g
+			// line_step2    r g r
+			rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
+			rgb_buffer[1] = bayer_pixel[0];
+			rgb_buffer[rgb_line_step + 5] = rgb_buffer[rgb_line_step + 2] = rgb_buffer[5] = rgb_buffer[2] = bayer_pixel[bayer_line_step];
+
+			// Bayer        -1 0 1
+			//          0    r g R
+			//  line_step    g b g
+			// line_step2    r g r
+			rgb_buffer[3] = bayer_pixel[1];
+			rgb_buffer[4] = AVG (bayer_pixel[0], bayer_pixel[bayer_line_step + 1]);
+			//rgb_pixel[5] = bayer_pixel[line_step];
+
+			// BGBG line
+			// Bayer        -1 0 1
+			//          0    r g r
+			//  line_step    g B g
+			// line_step2    r g r
+			rgb_buffer[rgb_line_step ] = AVG4 (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1], bayer_pixel[-1], bayer_pixel[bayer_line_step2 - 1]);
+			rgb_buffer[rgb_line_step + 1] = AVG4 (bayer_pixel[0], bayer_pixel[bayer_line_step2], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
+			//rgb_pixel[rgb_line_step + 2] = bayer_pixel[line_step];
+
+			// Bayer         -1 0 1
+			//         0      r g r
+			// line_step      g b G
+			// line_step2     r g r
+			rgb_buffer[rgb_line_step + 3] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
+			rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+			//rgb_pixel[rgb_line_step + 5] = bayer_pixel[line_step];
+
+			bayer_pixel += bayer_line_step + 2;
+			rgb_buffer += rgb_line_step + 6 + rgb_line_skip;
+		}
+
+		//last two lines
+		// Bayer         0 1 2
+		//        -1     b g b
+		//         0     G r g
+		// line_step     b g b
+
+		rgb_buffer[rgb_line_step + 3] = rgb_buffer[rgb_line_step ] = rgb_buffer[3] = rgb_buffer[0] = bayer_pixel[1]; // red pixel
+		rgb_buffer[1] = bayer_pixel[0]; // green pixel
+		rgb_buffer[rgb_line_step + 2] = rgb_buffer[2] = bayer_pixel[bayer_line_step]; // blue;
+
+		// Bayer         0 1 2
+		//        -1     b g b
+		//         0     g R g
+		// line_step     b g b
+		//rgb_pixel[3] = bayer_pixel[1];
+		rgb_buffer[4] = AVG4 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1], bayer_pixel[1 - bayer_line_step]);
+		rgb_buffer[5] = AVG4 (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2], bayer_pixel[-bayer_line_step], bayer_pixel[2 - bayer_line_step]);
+
+		// BGBG line
+		// Bayer         0 1 2
+		//        -1     b g b
+		//         0     g r g
+		// line_step     B g b
+		//rgb_pixel[rgb_line_step    ] = bayer_pixel[1];
+		rgb_buffer[rgb_line_step + 1] = AVG (bayer_pixel[0], bayer_pixel[bayer_line_step + 1]);
+		rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
+
+		// Bayer         0 1 2
+		//        -1     b g b
+		//         0     g r g
+		// line_step     b G b
+		//rgb_pixel[rgb_line_step + 3] = AVG( bayer_pixel[1] , bayer_pixel[line_step2+1] );
+		rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+		rgb_buffer[rgb_line_step + 5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
+
+		rgb_buffer += 6;
+		bayer_pixel += 2;
+		// rest of the last two lines
+		for (xIdx = 2; xIdx < width - 2; xIdx += 2, rgb_buffer += 6, bayer_pixel += 2)
+		{
+			// GRGR line
+			// Bayer       -1 0 1 2
+			//        -1    g b g b
+			//         0    r G r g
+			// line_step    g b g b
+			rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
+			rgb_buffer[1] = bayer_pixel[0];
+			rgb_buffer[2] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[-bayer_line_step]);
+
+			// Bayer       -1 0 1 2
+			//        -1    g b g b
+			//         0    r g R g
+			// line_step    g b g b
+			rgb_buffer[rgb_line_step + 3] = rgb_buffer[3] = bayer_pixel[1];
+			rgb_buffer[4] = AVG4 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1], bayer_pixel[1 - bayer_line_step]);
+			rgb_buffer[5] = AVG4 (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2], bayer_pixel[-bayer_line_step], bayer_pixel[-bayer_line_step + 2]);
+
+			// BGBG line
+			// Bayer       -1 0 1 2
+			//        -1    g b g b
+			//         0    r g r g
+			// line_step    g B g b
+			rgb_buffer[rgb_line_step ] = AVG (bayer_pixel[-1], bayer_pixel[1]);
+			rgb_buffer[rgb_line_step + 1] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
+			rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
+
+
+			// Bayer       -1 0 1 2
+			//        -1    g b g b
+			//         0    r g r g
+			// line_step    g b G b
+			//rgb_pixel[rgb_line_step + 3] = bayer_pixel[1];
+			rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+			rgb_buffer[rgb_line_step + 5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
+		}
+
+		// last two pixel values for first two lines
+		// GRGR line
+		// Bayer       -1 0 1
+		//        -1    g b g
+		//         0    r G r
+		// line_step    g b g
+		rgb_buffer[rgb_line_step ] = rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
+		rgb_buffer[1] = bayer_pixel[0];
+		rgb_buffer[5] = rgb_buffer[2] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[-bayer_line_step]);
+
+		// Bayer       -1 0 1
+		//        -1    g b g
+		//         0    r g R
+		// line_step    g b g
+		rgb_buffer[rgb_line_step + 3] = rgb_buffer[3] = bayer_pixel[1];
+		rgb_buffer[4] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step + 1], bayer_pixel[-bayer_line_step + 1]);
+		//rgb_pixel[5] = AVG( bayer_pixel[line_step], bayer_pixel[-line_step] );
+
+		// BGBG line
+		// Bayer       -1 0 1
+		//        -1    g b g
+		//         0    r g r
+		// line_step    g B g
+		//rgb_pixel[rgb_line_step    ] = AVG2( bayer_pixel[-1], bayer_pixel[1] );
+		rgb_buffer[rgb_line_step + 1] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
+		rgb_buffer[rgb_line_step + 5] = rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
+
+		// Bayer       -1 0 1
+		//        -1    g b g
+		//         0    r g r
+		// line_step    g b G
+		//rgb_pixel[rgb_line_step + 3] = bayer_pixel[1];
+		rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+		//rgb_pixel[rgb_line_step + 5] = bayer_pixel[line_step];
+	}
+	else if (debayeringMethod == DEBAYERING_EDGE_AWARE)
+	{
+		int dh, dv;
+
+		// first two pixel values for first two lines
+		// Bayer         0 1 2
+		//         0     G r g
+		// line_step     b g b
+		// line_step2    g r g
+
+		rgb_buffer[3] = rgb_buffer[0] = bayer_pixel[1]; // red pixel
+		rgb_buffer[1] = bayer_pixel[0]; // green pixel
+		rgb_buffer[rgb_line_step + 2] = rgb_buffer[2] = bayer_pixel[bayer_line_step]; // blue;
+
+		// Bayer         0 1 2
+		//         0     g R g
+		// line_step     b g b
+		// line_step2    g r g
+		//rgb_pixel[3] = bayer_pixel[1];
+		rgb_buffer[4] = AVG3 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1]);
+		rgb_buffer[rgb_line_step + 5] = rgb_buffer[5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
+
+		// BGBG line
+		// Bayer         0 1 2
+		//         0     g r g
+		// line_step     B g b
+		// line_step2    g r g
+		rgb_buffer[rgb_line_step + 3] = rgb_buffer[rgb_line_step ] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
+		rgb_buffer[rgb_line_step + 1] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step + 1], bayer_pixel[bayer_line_step2]);
+		//rgb_pixel[rgb_line_step + 2] = bayer_pixel[line_step];
+
+		// pixel (1, 1)  0 1 2
+		//         0     g r g
+		// line_step     b G b
+		// line_step2    g r g
+		//rgb_pixel[rgb_line_step + 3] = AVG( bayer_pixel[1] , bayer_pixel[line_step2+1] );
+		rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+		//rgb_pixel[rgb_line_step + 5] = AVG( bayer_pixel[line_step] , bayer_pixel[line_step+2] );
+
+		rgb_buffer += 6;
+		bayer_pixel += 2;
+		// rest of the first two lines
+		for (xIdx = 2; xIdx < width - 2; xIdx += 2, rgb_buffer += 6, bayer_pixel += 2)
+		{
+			// GRGR line
+			// Bayer        -1 0 1 2
+			//           0   r G r g
+			//   line_step   g b g b
+			// line_step2    r g r g
+			rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
+			rgb_buffer[1] = bayer_pixel[0];
+			rgb_buffer[2] = bayer_pixel[bayer_line_step + 1];
+
+			// Bayer        -1 0 1 2
+			//          0    r g R g
+			//  line_step    g b g b
+			// line_step2    r g r g
+			rgb_buffer[3] = bayer_pixel[1];
+			rgb_buffer[4] = AVG3 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1]);
+			rgb_buffer[rgb_line_step + 5] = rgb_buffer[5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
+
+			// BGBG line
+			// Bayer         -1 0 1 2
+			//         0      r g r g
+			// line_step      g B g b
+			// line_step2     r g r g
+			rgb_buffer[rgb_line_step ] = AVG4 (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1], bayer_pixel[-1], bayer_pixel[bayer_line_step2 - 1]);
+			rgb_buffer[rgb_line_step + 1] = AVG4 (bayer_pixel[0], bayer_pixel[bayer_line_step2], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
+			rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
+
+			// Bayer         -1 0 1 2
+			//         0      r g r g
+			// line_step      g b G b
+			// line_step2     r g r g
+			rgb_buffer[rgb_line_step + 3] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
+			rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+			//rgb_pixel[rgb_line_step + 5] = AVG( bayer_pixel[line_step] , bayer_pixel[line_step+2] );
+		}
+
+		// last two pixel values for first two lines
+		// GRGR line
+		// Bayer        -1 0 1
+		//           0   r G r
+		//   line_step   g b g
+		// line_step2    r g r
+		rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
+		rgb_buffer[1] = bayer_pixel[0];
+		rgb_buffer[rgb_line_step + 5] = rgb_buffer[rgb_line_step + 2] = rgb_buffer[5] = rgb_buffer[2] = bayer_pixel[bayer_line_step];
+
+		// Bayer        -1 0 1
+		//          0    r g R
+		//  line_step    g b g
+		// line_step2    r g r
+		rgb_buffer[3] = bayer_pixel[1];
+		rgb_buffer[4] = AVG (bayer_pixel[0], bayer_pixel[bayer_line_step + 1]);
+		//rgb_pixel[5] = bayer_pixel[line_step];
+
+		// BGBG line
+		// Bayer        -1 0 1
+		//          0    r g r
+		//  line_step    g B g
+		// line_step2    r g r
+		rgb_buffer[rgb_line_step ] = AVG4 (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1], bayer_pixel[-1], bayer_pixel[bayer_line_step2 - 1]);
+		rgb_buffer[rgb_line_step + 1] = AVG4 (bayer_pixel[0], bayer_pixel[bayer_line_step2], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
+		//rgb_pixel[rgb_line_step + 2] = bayer_pixel[line_step];
+
+		// Bayer         -1 0 1
+		//         0      r g r
+		// line_step      g b G
+		// line_step2     r g r
+		rgb_buffer[rgb_line_step + 3] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
+		rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+		//rgb_pixel[rgb_line_step + 5] = bayer_pixel[line_step];
+
+		bayer_pixel += bayer_line_step + 2;
+		rgb_buffer += rgb_line_step + 6 + rgb_line_skip;
+		// main processing
+		for (yIdx = 2; yIdx < height - 2; yIdx += 2)
+		{
+			// first two pixel values
+			// Bayer         0 1 2
+			//        -1     b g b
+			//         0     G r g
+			// line_step     b g b
+			// line_step2    g r g
+
+			rgb_buffer[3] = rgb_buffer[0] = bayer_pixel[1]; // red pixel
+			rgb_buffer[1] = bayer_pixel[0]; // green pixel
+			rgb_buffer[2] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[-bayer_line_step]); // blue;
+
+			// Bayer         0 1 2
+			//        -1     b g b
+			//         0     g R g
+			// line_step     b g b
+			// line_step2    g r g
+			//rgb_pixel[3] = bayer_pixel[1];
+			rgb_buffer[4] = AVG4 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1], bayer_pixel[1 - bayer_line_step]);
+			rgb_buffer[5] = AVG4 (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2], bayer_pixel[-bayer_line_step], bayer_pixel[2 - bayer_line_step]);
+
+			// BGBG line
+			// Bayer         0 1 2
+			//         0     g r g
+			// line_step     B g b
+			// line_step2    g r g
+			rgb_buffer[rgb_line_step + 3] = rgb_buffer[rgb_line_step ] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
+			rgb_buffer[rgb_line_step + 1] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step + 1], bayer_pixel[bayer_line_step2]);
+			rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
+
+			// pixel (1, 1)  0 1 2
+			//         0     g r g
+			// line_step     b G b
+			// line_step2    g r g
+			//rgb_pixel[rgb_line_step + 3] = AVG( bayer_pixel[1] , bayer_pixel[line_step2+1] );
+			rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+			rgb_buffer[rgb_line_step + 5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
+
+			rgb_buffer += 6;
+			bayer_pixel += 2;
+			// continue with rest of the line
+			for (xIdx = 2; xIdx < width - 2; xIdx += 2, rgb_buffer += 6, bayer_pixel += 2)
+			{
+				// GRGR line
+				// Bayer        -1 0 1 2
+				//          -1   g b g b
+				//           0   r G r g
+				//   line_step   g b g b
+				// line_step2    r g r g
+				rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
+				rgb_buffer[1] = bayer_pixel[0];
+				rgb_buffer[2] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[-bayer_line_step]);
+
+				// Bayer        -1 0 1 2
+				//          -1   g b g b
+				//          0    r g R g
+				//  line_step    g b g b
+				// line_step2    r g r g
+
+				dh = abs (bayer_pixel[0] - bayer_pixel[2]);
+				dv = abs (bayer_pixel[-bayer_line_step + 1] - bayer_pixel[bayer_line_step + 1]);
+
+				if (dh > dv)
+					rgb_buffer[4] = AVG (bayer_pixel[-bayer_line_step + 1], bayer_pixel[bayer_line_step + 1]);
+				else if (dv > dh)
+					rgb_buffer[4] = AVG (bayer_pixel[0], bayer_pixel[2]);
+				else
+					rgb_buffer[4] = AVG4 (bayer_pixel[-bayer_line_step + 1], bayer_pixel[bayer_line_step + 1], bayer_pixel[0], bayer_pixel[2]);
+
+				rgb_buffer[3] = bayer_pixel[1];
+				rgb_buffer[5] = AVG4 (bayer_pixel[-bayer_line_step], bayer_pixel[2 - bayer_line_step], bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
+
+				// BGBG line
+				// Bayer         -1 0 1 2
+				//         -1     g b g b
+				//          0     r g r g
+				// line_step      g B g b
+				// line_step2     r g r g
+				rgb_buffer[rgb_line_step ] = AVG4 (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1], bayer_pixel[-1], bayer_pixel[bayer_line_step2 - 1]);
+				rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
+
+				dv = abs (bayer_pixel[0] - bayer_pixel[bayer_line_step2]);
+				dh = abs (bayer_pixel[bayer_line_step - 1] - bayer_pixel[bayer_line_step + 1]);
+
+				if (dv > dh)
+					rgb_buffer[rgb_line_step + 1] = AVG (bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
+				else if (dh > dv)
+					rgb_buffer[rgb_line_step + 1] = AVG (bayer_pixel[0], bayer_pixel[bayer_line_step2]);
+				else
+					rgb_buffer[rgb_line_step + 1] = AVG4 (bayer_pixel[0], bayer_pixel[bayer_line_step2], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
+
+				// Bayer         -1 0 1 2
+				//         -1     g b g b
+				//          0     r g r g
+				// line_step      g b G b
+				// line_step2     r g r g
+				rgb_buffer[rgb_line_step + 3] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
+				rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+				rgb_buffer[rgb_line_step + 5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
+			}
+
+			// last two pixels of the line
+			// last two pixel values for first two lines
+			// GRGR line
+			// Bayer        -1 0 1
+			//           0   r G r
+			//   line_step   g b g
+			// line_step2    r g r
+			rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
+			rgb_buffer[1] = bayer_pixel[0];
+			rgb_buffer[rgb_line_step + 5] = rgb_buffer[rgb_line_step + 2] = rgb_buffer[5] = rgb_buffer[2] = bayer_pixel[bayer_line_step];
+
+			// Bayer        -1 0 1
+			//          0    r g R
+			//  line_step    g b g
+			// line_step2    r g r
+			rgb_buffer[3] = bayer_pixel[1];
+			rgb_buffer[4] = AVG (bayer_pixel[0], bayer_pixel[bayer_line_step + 1]);
+			//rgb_pixel[5] = bayer_pixel[line_step];
+
+			// BGBG line
+			// Bayer        -1 0 1
+			//          0    r g r
+			//  line_step    g B g
+			// line_step2    r g r
+			rgb_buffer[rgb_line_step ] = AVG4 (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1], bayer_pixel[-1], bayer_pixel[bayer_line_step2 - 1]);
+			rgb_buffer[rgb_line_step + 1] = AVG4 (bayer_pixel[0], bayer_pixel[bayer_line_step2], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
+			//rgb_pixel[rgb_line_step + 2] = bayer_pixel[line_step];
+
+			// Bayer         -1 0 1
+			//         0      r g r
+			// line_step      g b G
+			// line_step2     r g r
+			rgb_buffer[rgb_line_step + 3] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
+			rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+			//rgb_pixel[rgb_line_step + 5] = bayer_pixel[line_step];
+
+			bayer_pixel += bayer_line_step + 2;
+			rgb_buffer += rgb_line_step + 6 + rgb_line_skip;
+		}
+
+		//last two lines
+		// Bayer         0 1 2
+		//        -1     b g b
+		//         0     G r g
+		// line_step     b g b
+
+		rgb_buffer[rgb_line_step + 3] = rgb_buffer[rgb_line_step ] = rgb_buffer[3] = rgb_buffer[0] = bayer_pixel[1]; // red pixel
+		rgb_buffer[1] = bayer_pixel[0]; // green pixel
+		rgb_buffer[rgb_line_step + 2] = rgb_buffer[2] = bayer_pixel[bayer_line_step]; // blue;
+
+		// Bayer         0 1 2
+		//        -1     b g b
+		//         0     g R g
+		// line_step     b g b
+		//rgb_pixel[3] = bayer_pixel[1];
+		rgb_buffer[4] = AVG4 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1], bayer_pixel[1 - bayer_line_step]);
+		rgb_buffer[5] = AVG4 (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2], bayer_pixel[-bayer_line_step], bayer_pixel[2 - bayer_line_step]);
+
+		// BGBG line
+		// Bayer         0 1 2
+		//        -1     b g b
+		//         0     g r g
+		// line_step     B g b
+		//rgb_pixel[rgb_line_step    ] = bayer_pixel[1];
+		rgb_buffer[rgb_line_step + 1] = AVG (bayer_pixel[0], bayer_pixel[bayer_line_step + 1]);
+		rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
+
+		// Bayer         0 1 2
+		//        -1     b g b
+		//         0     g r g
+		// line_step     b G b
+		//rgb_pixel[rgb_line_step + 3] = AVG( bayer_pixel[1] , bayer_pixel[line_step2+1] );
+		rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+		rgb_buffer[rgb_line_step + 5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
+
+		rgb_buffer += 6;
+		bayer_pixel += 2;
+		// rest of the last two lines
+		for (xIdx = 2; xIdx < width - 2; xIdx += 2, rgb_buffer += 6, bayer_pixel += 2)
+		{
+			// GRGR line
+			// Bayer       -1 0 1 2
+			//        -1    g b g b
+			//         0    r G r g
+			// line_step    g b g b
+			rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
+			rgb_buffer[1] = bayer_pixel[0];
+			rgb_buffer[2] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[-bayer_line_step]);
+
+			// Bayer       -1 0 1 2
+			//        -1    g b g b
+			//         0    r g R g
+			// line_step    g b g b
+			rgb_buffer[rgb_line_step + 3] = rgb_buffer[3] = bayer_pixel[1];
+			rgb_buffer[4] = AVG4 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1], bayer_pixel[1 - bayer_line_step]);
+			rgb_buffer[5] = AVG4 (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2], bayer_pixel[-bayer_line_step], bayer_pixel[-bayer_line_step + 2]);
+
+			// BGBG line
+			// Bayer       -1 0 1 2
+			//        -1    g b g b
+			//         0    r g r g
+			// line_step    g B g b
+			rgb_buffer[rgb_line_step ] = AVG (bayer_pixel[-1], bayer_pixel[1]);
+			rgb_buffer[rgb_line_step + 1] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
+			rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
+
+
+			// Bayer       -1 0 1 2
+			//        -1    g b g b
+			//         0    r g r g
+			// line_step    g b G b
+			//rgb_pixel[rgb_line_step + 3] = bayer_pixel[1];
+			rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+			rgb_buffer[rgb_line_step + 5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
+		}
+
+		// last two pixel values for first two lines
+		// GRGR line
+		// Bayer       -1 0 1
+		//        -1    g b g
+		//         0    r G r
+		// line_step    g b g
+		rgb_buffer[rgb_line_step ] = rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
+		rgb_buffer[1] = bayer_pixel[0];
+		rgb_buffer[5] = rgb_buffer[2] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[-bayer_line_step]);
+
+		// Bayer       -1 0 1
+		//        -1    g b g
+		//         0    r g R
+		// line_step    g b g
+		rgb_buffer[rgb_line_step + 3] = rgb_buffer[3] = bayer_pixel[1];
+		rgb_buffer[4] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step + 1], bayer_pixel[-bayer_line_step + 1]);
+		//rgb_pixel[5] = AVG( bayer_pixel[line_step], bayer_pixel[-line_step] );
+
+		// BGBG line
+		// Bayer       -1 0 1
+		//        -1    g b g
+		//         0    r g r
+		// line_step    g B g
+		//rgb_pixel[rgb_line_step    ] = AVG2( bayer_pixel[-1], bayer_pixel[1] );
+		rgb_buffer[rgb_line_step + 1] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
+		rgb_buffer[rgb_line_step + 5] = rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
+
+		// Bayer       -1 0 1
+		//        -1    g b g
+		//         0    r g r
+		// line_step    g b G
+		//rgb_pixel[rgb_line_step + 3] = bayer_pixel[1];
+		rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+		//rgb_pixel[rgb_line_step + 5] = bayer_pixel[line_step];
+	}
+	else if (debayeringMethod == DEBAYERING_EDGE_AWARE_WEIGHTED)
+	{
+		int dh, dv;
+
+		// first two pixel values for first two lines
+		// Bayer         0 1 2
+		//         0     G r g
+		// line_step     b g b
+		// line_step2    g r g
+
+		rgb_buffer[3] = rgb_buffer[0] = bayer_pixel[1]; // red pixel
+		rgb_buffer[1] = bayer_pixel[0]; // green pixel
+		rgb_buffer[rgb_line_step + 2] = rgb_buffer[2] = bayer_pixel[bayer_line_step]; // blue;
+
+		// Bayer         0 1 2
+		//         0     g R g
+		// line_step     b g b
+		// line_step2    g r g
+		//rgb_pixel[3] = bayer_pixel[1];
+		rgb_buffer[4] = AVG3 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1]);
+		rgb_buffer[rgb_line_step + 5] = rgb_buffer[5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
+
+		// BGBG line
+		// Bayer         0 1 2
+		//         0     g r g
+		// line_step     B g b
+		// line_step2    g r g
+		rgb_buffer[rgb_line_step + 3] = rgb_buffer[rgb_line_step ] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
+		rgb_buffer[rgb_line_step + 1] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step + 1], bayer_pixel[bayer_line_step2]);
+		//rgb_pixel[rgb_line_step + 2] = bayer_pixel[line_step];
+
+		// pixel (1, 1)  0 1 2
+		//         0     g r g
+		// line_step     b G b
+		// line_step2    g r g
+		//rgb_pixel[rgb_line_step + 3] = AVG( bayer_pixel[1] , bayer_pixel[line_step2+1] );
+		rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+		//rgb_pixel[rgb_line_step + 5] = AVG( bayer_pixel[line_step] , bayer_pixel[line_step+2] );
+
+		rgb_buffer += 6;
+		bayer_pixel += 2;
+		// rest of the first two lines
+		for (xIdx = 2; xIdx < width - 2; xIdx += 2, rgb_buffer += 6, bayer_pixel += 2)
+		{
+			// GRGR line
+			// Bayer        -1 0 1 2
+			//           0   r G r g
+			//   line_step   g b g b
+			// line_step2    r g r g
+			rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
+			rgb_buffer[1] = bayer_pixel[0];
+			rgb_buffer[2] = bayer_pixel[bayer_line_step + 1];
+
+			// Bayer        -1 0 1 2
+			//          0    r g R g
+			//  line_step    g b g b
+			// line_step2    r g r g
+			rgb_buffer[3] = bayer_pixel[1];
+			rgb_buffer[4] = AVG3 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1]);
+			rgb_buffer[rgb_line_step + 5] = rgb_buffer[5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
+
+			// BGBG line
+			// Bayer         -1 0 1 2
+			//         0      r g r g
+			// line_step      g B g b
+			// line_step2     r g r g
+			rgb_buffer[rgb_line_step ] = AVG4 (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1], bayer_pixel[-1], bayer_pixel[bayer_line_step2 - 1]);
+			rgb_buffer[rgb_line_step + 1] = AVG4 (bayer_pixel[0], bayer_pixel[bayer_line_step2], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
+			rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
+
+			// Bayer         -1 0 1 2
+			//         0      r g r g
+			// line_step      g b G b
+			// line_step2     r g r g
+			rgb_buffer[rgb_line_step + 3] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
+			rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+			//rgb_pixel[rgb_line_step + 5] = AVG( bayer_pixel[line_step] , bayer_pixel[line_step+2] );
+		}
+
+		// last two pixel values for first two lines
+		// GRGR line
+		// Bayer        -1 0 1
+		//           0   r G r
+		//   line_step   g b g
+		// line_step2    r g r
+		rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
+		rgb_buffer[1] = bayer_pixel[0];
+		rgb_buffer[rgb_line_step + 5] = rgb_buffer[rgb_line_step + 2] = rgb_buffer[5] = rgb_buffer[2] = bayer_pixel[bayer_line_step];
+
+		// Bayer        -1 0 1
+		//          0    r g R
+		//  line_step    g b g
+		// line_step2    r g r
+		rgb_buffer[3] = bayer_pixel[1];
+		rgb_buffer[4] = AVG (bayer_pixel[0], bayer_pixel[bayer_line_step + 1]);
+		//rgb_pixel[5] = bayer_pixel[line_step];
+
+		// BGBG line
+		// Bayer        -1 0 1
+		//          0    r g r
+		//  line_step    g B g
+		// line_step2    r g r
+		rgb_buffer[rgb_line_step ] = AVG4 (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1], bayer_pixel[-1], bayer_pixel[bayer_line_step2 - 1]);
+		rgb_buffer[rgb_line_step + 1] = AVG4 (bayer_pixel[0], bayer_pixel[bayer_line_step2], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
+		//rgb_pixel[rgb_line_step + 2] = bayer_pixel[line_step];
+
+		// Bayer         -1 0 1
+		//         0      r g r
+		// line_step      g b G
+		// line_step2     r g r
+		rgb_buffer[rgb_line_step + 3] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
+		rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+		//rgb_pixel[rgb_line_step + 5] = bayer_pixel[line_step];
+
+		bayer_pixel += bayer_line_step + 2;
+		rgb_buffer += rgb_line_step + 6 + rgb_line_skip;
+		// main processing
+		for (yIdx = 2; yIdx < height - 2; yIdx += 2)
+		{
+			// first two pixel values
+			// Bayer         0 1 2
+			//        -1     b g b
+			//         0     G r g
+			// line_step     b g b
+			// line_step2    g r g
+
+			rgb_buffer[3] = rgb_buffer[0] = bayer_pixel[1]; // red pixel
+			rgb_buffer[1] = bayer_pixel[0]; // green pixel
+			rgb_buffer[2] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[-bayer_line_step]); // blue;
+
+			// Bayer         0 1 2
+			//        -1     b g b
+			//         0     g R g
+			// line_step     b g b
+			// line_step2    g r g
+			//rgb_pixel[3] = bayer_pixel[1];
+			rgb_buffer[4] = AVG4 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1], bayer_pixel[1 - bayer_line_step]);
+			rgb_buffer[5] = AVG4 (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2], bayer_pixel[-bayer_line_step], bayer_pixel[2 - bayer_line_step]);
+
+			// BGBG line
+			// Bayer         0 1 2
+			//         0     g r g
+			// line_step     B g b
+			// line_step2    g r g
+			rgb_buffer[rgb_line_step + 3] = rgb_buffer[rgb_line_step ] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
+			rgb_buffer[rgb_line_step + 1] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step + 1], bayer_pixel[bayer_line_step2]);
+			rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
+
+			// pixel (1, 1)  0 1 2
+			//         0     g r g
+			// line_step     b G b
+			// line_step2    g r g
+			//rgb_pixel[rgb_line_step + 3] = AVG( bayer_pixel[1] , bayer_pixel[line_step2+1] );
+			rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+			rgb_buffer[rgb_line_step + 5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
+
+			rgb_buffer += 6;
+			bayer_pixel += 2;
+			// continue with rest of the line
+			for (xIdx = 2; xIdx < width - 2; xIdx += 2, rgb_buffer += 6, bayer_pixel += 2)
+			{
+				// GRGR line
+				// Bayer        -1 0 1 2
+				//          -1   g b g b
+				//           0   r G r g
+				//   line_step   g b g b
+				// line_step2    r g r g
+				rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
+				rgb_buffer[1] = bayer_pixel[0];
+				rgb_buffer[2] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[-bayer_line_step]);
+
+				// Bayer        -1 0 1 2
+				//          -1   g b g b
+				//          0    r g R g
+				//  line_step    g b g b
+				// line_step2    r g r g
+
+				dh = abs (bayer_pixel[0] - bayer_pixel[2]);
+				dv = abs (bayer_pixel[-bayer_line_step + 1] - bayer_pixel[bayer_line_step + 1]);
+
+				if (dv == 0 && dh == 0)
+					rgb_buffer[4] = AVG4 (bayer_pixel[1 - bayer_line_step], bayer_pixel[1 + bayer_line_step], bayer_pixel[0], bayer_pixel[2]);
+				else
+					rgb_buffer[4] = WAVG4 (bayer_pixel[1 - bayer_line_step], bayer_pixel[1 + bayer_line_step], bayer_pixel[0], bayer_pixel[2], dh, dv);
+				rgb_buffer[3] = bayer_pixel[1];
+				rgb_buffer[5] = AVG4 (bayer_pixel[-bayer_line_step], bayer_pixel[2 - bayer_line_step], bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
+
+				// BGBG line
+				// Bayer         -1 0 1 2
+				//         -1     g b g b
+				//          0     r g r g
+				// line_step      g B g b
+				// line_step2     r g r g
+				rgb_buffer[rgb_line_step ] = AVG4 (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1], bayer_pixel[-1], bayer_pixel[bayer_line_step2 - 1]);
+				rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
+
+				dv = abs (bayer_pixel[0] - bayer_pixel[bayer_line_step2]);
+				dh = abs (bayer_pixel[bayer_line_step - 1] - bayer_pixel[bayer_line_step + 1]);
+
+				if (dv == 0 && dh == 0)
+					rgb_buffer[rgb_line_step + 1] = AVG4 (bayer_pixel[0], bayer_pixel[bayer_line_step2], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
+				else
+					rgb_buffer[rgb_line_step + 1] = WAVG4 (bayer_pixel[0], bayer_pixel[bayer_line_step2], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1], dh, dv);
+
+				// Bayer         -1 0 1 2
+				//         -1     g b g b
+				//          0     r g r g
+				// line_step      g b G b
+				// line_step2     r g r g
+				rgb_buffer[rgb_line_step + 3] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
+				rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+				rgb_buffer[rgb_line_step + 5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
+			}
+
+			// last two pixels of the line
+			// last two pixel values for first two lines
+			// GRGR line
+			// Bayer        -1 0 1
+			//           0   r G r
+			//   line_step   g b g
+			// line_step2    r g r
+			rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
+			rgb_buffer[1] = bayer_pixel[0];
+			rgb_buffer[rgb_line_step + 5] = rgb_buffer[rgb_line_step + 2] = rgb_buffer[5] = rgb_buffer[2] = bayer_pixel[bayer_line_step];
+
+			// Bayer        -1 0 1
+			//          0    r g R
+			//  line_step    g b g
+			// line_step2    r g r
+			rgb_buffer[3] = bayer_pixel[1];
+			rgb_buffer[4] = AVG (bayer_pixel[0], bayer_pixel[bayer_line_step + 1]);
+			//rgb_pixel[5] = bayer_pixel[line_step];
+
+			// BGBG line
+			// Bayer        -1 0 1
+			//          0    r g r
+			//  line_step    g B g
+			// line_step2    r g r
+			rgb_buffer[rgb_line_step ] = AVG4 (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1], bayer_pixel[-1], bayer_pixel[bayer_line_step2 - 1]);
+			rgb_buffer[rgb_line_step + 1] = AVG4 (bayer_pixel[0], bayer_pixel[bayer_line_step2], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
+			//rgb_pixel[rgb_line_step + 2] = bayer_pixel[line_step];
+
+			// Bayer         -1 0 1
+			//         0      r g r
+			// line_step      g b G
+			// line_step2     r g r
+			rgb_buffer[rgb_line_step + 3] = AVG (bayer_pixel[1], bayer_pixel[bayer_line_step2 + 1]);
+			rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+			//rgb_pixel[rgb_line_step + 5] = bayer_pixel[line_step];
+
+			bayer_pixel += bayer_line_step + 2;
+			rgb_buffer += rgb_line_step + 6 + rgb_line_skip;
+		}
+
+		//last two lines
+		// Bayer         0 1 2
+		//        -1     b g b
+		//         0     G r g
+		// line_step     b g b
+
+		rgb_buffer[rgb_line_step + 3] = rgb_buffer[rgb_line_step ] = rgb_buffer[3] = rgb_buffer[0] = bayer_pixel[1]; // red pixel
+		rgb_buffer[1] = bayer_pixel[0]; // green pixel
+		rgb_buffer[rgb_line_step + 2] = rgb_buffer[2] = bayer_pixel[bayer_line_step]; // blue;
+
+		// Bayer         0 1 2
+		//        -1     b g b
+		//         0     g R g
+		// line_step     b g b
+		//rgb_pixel[3] = bayer_pixel[1];
+		rgb_buffer[4] = AVG4 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1], bayer_pixel[1 - bayer_line_step]);
+		rgb_buffer[5] = AVG4 (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2], bayer_pixel[-bayer_line_step], bayer_pixel[2 - bayer_line_step]);
+
+		// BGBG line
+		// Bayer         0 1 2
+		//        -1     b g b
+		//         0     g r g
+		// line_step     B g b
+		//rgb_pixel[rgb_line_step    ] = bayer_pixel[1];
+		rgb_buffer[rgb_line_step + 1] = AVG (bayer_pixel[0], bayer_pixel[bayer_line_step + 1]);
+		rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
+
+		// Bayer         0 1 2
+		//        -1     b g b
+		//         0     g r g
+		// line_step     b G b
+		//rgb_pixel[rgb_line_step + 3] = AVG( bayer_pixel[1] , bayer_pixel[line_step2+1] );
+		rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+		rgb_buffer[rgb_line_step + 5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
+
+		rgb_buffer += 6;
+		bayer_pixel += 2;
+		// rest of the last two lines
+		for (xIdx = 2; xIdx < width - 2; xIdx += 2, rgb_buffer += 6, bayer_pixel += 2)
+		{
+			// GRGR line
+			// Bayer       -1 0 1 2
+			//        -1    g b g b
+			//         0    r G r g
+			// line_step    g b g b
+			rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
+			rgb_buffer[1] = bayer_pixel[0];
+			rgb_buffer[2] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[-bayer_line_step]);
+
+			// Bayer       -1 0 1 2
+			//        -1    g b g b
+			//         0    r g R g
+			// line_step    g b g b
+			rgb_buffer[rgb_line_step + 3] = rgb_buffer[3] = bayer_pixel[1];
+			rgb_buffer[4] = AVG4 (bayer_pixel[0], bayer_pixel[2], bayer_pixel[bayer_line_step + 1], bayer_pixel[1 - bayer_line_step]);
+			rgb_buffer[5] = AVG4 (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2], bayer_pixel[-bayer_line_step], bayer_pixel[-bayer_line_step + 2]);
+
+			// BGBG line
+			// Bayer       -1 0 1 2
+			//        -1    g b g b
+			//         0    r g r g
+			// line_step    g B g b
+			rgb_buffer[rgb_line_step ] = AVG (bayer_pixel[-1], bayer_pixel[1]);
+			rgb_buffer[rgb_line_step + 1] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
+			rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
+
+
+			// Bayer       -1 0 1 2
+			//        -1    g b g b
+			//         0    r g r g
+			// line_step    g b G b
+			//rgb_pixel[rgb_line_step + 3] = bayer_pixel[1];
+			rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+			rgb_buffer[rgb_line_step + 5] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[bayer_line_step + 2]);
+		}
+
+		// last two pixel values for first two lines
+		// GRGR line
+		// Bayer       -1 0 1
+		//        -1    g b g
+		//         0    r G r
+		// line_step    g b g
+		rgb_buffer[rgb_line_step ] = rgb_buffer[0] = AVG (bayer_pixel[1], bayer_pixel[-1]);
+		rgb_buffer[1] = bayer_pixel[0];
+		rgb_buffer[5] = rgb_buffer[2] = AVG (bayer_pixel[bayer_line_step], bayer_pixel[-bayer_line_step]);
+
+		// Bayer       -1 0 1
+		//        -1    g b g
+		//         0    r g R
+		// line_step    g b g
+		rgb_buffer[rgb_line_step + 3] = rgb_buffer[3] = bayer_pixel[1];
+		rgb_buffer[4] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step + 1], bayer_pixel[-bayer_line_step + 1]);
+		//rgb_pixel[5] = AVG( bayer_pixel[line_step], bayer_pixel[-line_step] );
+
+		// BGBG line
+		// Bayer       -1 0 1
+		//        -1    g b g
+		//         0    r g r
+		// line_step    g B g
+		//rgb_pixel[rgb_line_step    ] = AVG2( bayer_pixel[-1], bayer_pixel[1] );
+		rgb_buffer[rgb_line_step + 1] = AVG3 (bayer_pixel[0], bayer_pixel[bayer_line_step - 1], bayer_pixel[bayer_line_step + 1]);
+		rgb_buffer[rgb_line_step + 5] = rgb_buffer[rgb_line_step + 2] = bayer_pixel[bayer_line_step];
+
+		// Bayer       -1 0 1
+		//        -1    g b g
+		//         0    r g r
+		// line_step    g b G
+		//rgb_pixel[rgb_line_step + 3] = bayer_pixel[1];
+		rgb_buffer[rgb_line_step + 4] = bayer_pixel[bayer_line_step + 1];
+		//rgb_pixel[rgb_line_step + 5] = bayer_pixel[line_step];
+	}
+
+
+	return RET_OK;
+}
+
+void ipa_CameraSensors::SwapRedBlueChannels(unsigned char* data, unsigned width, unsigned height, int widthStep)
+{
+	unsigned char temp_val = 0;
+	unsigned char* p_dest = 0;
+	unsigned int colTimes3 = 0;
+	for(unsigned int row=0; row<height; row++)
+	{
+		p_dest = data + row * widthStep;
+		for (unsigned int col=0; col<width; col++)
+		{
+			colTimes3 = col*3;
+			temp_val = p_dest[colTimes3];
+			p_dest[colTimes3] = p_dest[colTimes3 + 2];
+			p_dest[colTimes3 + 2] = temp_val;
+		}	
+	}
+}
+
+unsigned long ipa_CameraSensors::ConvertDepthToRange(const cv::Mat& depthImage, char* rangeData, int widthStep,
+	unsigned short badDepth)
+{
+	if (depthImage.type() != CV_16UC1)
+	{
+		std::cerr << "ERROR - ipa_CameraSensors::ConvertDepthToRange:" << std::endl;
+		std::cerr << "\t ... Depth image must be of type CV_16UC1" << std::endl;
+		return RET_FAILED;
+	}
+
+	unsigned short us_val = 0;
+	const unsigned short* p_us_dist = 0;
+	float* p_f_dist = 0;
+
+	for(int row=0; row<depthImage.rows; row++)
+	{
+		p_f_dist = (float*)(rangeData + row * widthStep);
+		p_us_dist = depthImage.ptr<unsigned short>(row);
+
+		for (int col=0; col<depthImage.cols; col++)
+		{
+			us_val = p_us_dist[col];
+			// Convert to float to stay consistent with other range cameras
+			if (us_val != 0)
+				p_f_dist[col] = 0.001 * (float)us_val;
+			else
+				p_f_dist[col] = (float)badDepth;
+		}	
+	}
+
+	return RET_OK;
+}
+
+unsigned long ipa_CameraSensors::ConvertDepthToCartesian(const cv::Mat& depthImage, double fx, double fy, double cx, double cy,
+	char* cartesianData, int widthStep, unsigned short badDepth)
+{
+	if (depthImage.type() != CV_16UC1)
+	{
+		std::cerr << "ERROR - ipa_CameraSensors::ConvertDepthToCartesian:" << std::endl;
+		std::cerr << "\t ... Depth image must be of type CV_16UC1" << std::endl;
+		return RET_FAILED;
+	}
+
+	float constant_x = 0.001 / fx;
+	float constant_y = 0.001 / fy;
+
+	float* p_xyz = 0;
+	const unsigned short* p_us_dist = 0;
+	int colTimes3 = 0;
+
+	for(int row=0; row<depthImage.rows; row++)
+	{
+		p_xyz = (float*) (cartesianData + row * widthStep);
+		p_us_dist = depthImage.ptr<unsigned short>(row);
+
+		for (int col = 0; col < depthImage.cols; col++)
+		{
+			colTimes3 = 3*col;
+			// Check for invalid measurements
+			if( p_us_dist[col] == badDepth )
+			{
+				p_xyz[colTimes3] = 0;
+				p_xyz[colTimes3 + 1] = 0;
+				p_xyz[colTimes3 + 2] = 0;
+			}
+			else
+			{
+				p_xyz[colTimes3] = (col - cx) * p_us_dist[col] * constant_x;
+				p_xyz[colTimes3 + 1] = (row - cy) * p_us_dist[col] * constant_y;
+				p_xyz[colTimes3 + 2] = p_us_dist[col] * 0.001;
+			}
+		}
+	}
+
+	return RET_OK;
+}
+
+unsigned long ipa_CameraSensors::EvaluateRangePolynomial(const cv::Mat& rawRange, const std::vector<cv::Mat>& coefficients,
+	cv::Mat& calibratedRange)
+{
+	if (rawRange.type() != CV_32FC1 || coefficients.empty())
+	{
+		std::cerr << "ERROR - ipa_CameraSensors::EvaluateRangePolynomial:" << std::endl;
+		std::cerr << "\t ... Raw range image must be of type CV_32FC1 and at least one coefficient is required" << std::endl;
+		return RET_FAILED;
+	}
+	for (size_t i=0; i<coefficients.size(); i++)
+	{
+		if (coefficients[i].type() != CV_64FC1 || coefficients[i].rows != rawRange.rows || coefficients[i].cols != rawRange.cols)
+		{
+			std::cerr << "ERROR - ipa_CameraSensors::EvaluateRangePolynomial:" << std::endl;
+			std::cerr << "\t ... Coefficient " << i << " does not match the size of the range image" << std::endl;
+			return RET_FAILED;
+		}
+	}
+
+	calibratedRange.create(rawRange.rows, rawRange.cols, CV_32FC1);
+
+	int degree = (int)coefficients.size() - 1;
+	std::vector<const double*> p_coeffs(coefficients.size());
+	for(int row=0; row<rawRange.rows; row++)
+	{
+		const float* p_raw = rawRange.ptr<float>(row);
+		float* p_calibrated = calibratedRange.ptr<float>(row);
+		for (int i=0; i<=degree; i++)
+			p_coeffs[i] = coefficients[i].ptr<double>(row);
+
+		for (int col=0; col<rawRange.cols; col++)
+		{
+			// Horner scheme, same order of evaluation as ipa_Utils::EvaluatePolynomial
+			double x = p_raw[col];
+			double y = p_coeffs[degree][col];
+			for (int i=degree-1; i>=0; i--)
+				y = y*x + p_coeffs[i][col];
+			p_calibrated[col] = (float)y;
+		}
+	}
+
+	return RET_OK;
+}
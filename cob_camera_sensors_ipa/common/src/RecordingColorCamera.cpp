@@ -0,0 +1,222 @@
+/****************************************************************
+*
+* Copyright (c) 2026
+*
+* Fraunhofer Institute for Manufacturing Engineering
+* and Automation (IPA)
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Project name: care-o-bot
+* ROS stack name: cob_bringup_sandbox
+* ROS package name: cob_camera_sensors_ipa
+* Description: Records the frames of any color camera to a frame log.
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Date of creation: October 2026
+* ToDo:
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer.
+* * Redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution.
+* * Neither the name of the Fraunhofer Institute for Manufacturing
+* Engineering and Automation (IPA) nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License LGPL as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License LGPL for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License LGPL along with this program.
+* If not, see <http://www.gnu.org/licenses/>.
+*
+****************************************************************/
+
+#include <cob_vision_utils/StdAfx.h>
+#ifdef __LINUX__
+	#include "cob_camera_sensors_ipa/RecordingColorCamera.h"
+	#include "cob_vision_utils/GlobalDefines.h"
+
+	#include <iostream>
+	#include <cstring>
+#else
+	#include "cob_bringup_sandbox/cob_camera_sensors_ipa/common/include/cob_camera_sensors_ipa/RecordingColorCamera.h"
+	#include "cob_perception_common/cob_vision_utils/common/include/cob_vision_utils/GlobalDefines.h"
+#endif
+
+using namespace ipa_CameraSensors;
+
+__DLL_LIBCAMERASENSORS__ AbstractColorCameraPtr ipa_CameraSensors::CreateColorCamera_Recording(AbstractColorCameraPtr camera)
+{
+	return AbstractColorCameraPtr(new RecordingColorCamera(camera));
+}
+
+RecordingColorCamera::RecordingColorCamera(AbstractColorCameraPtr camera)
+	: m_Camera(camera)
+{
+}
+
+RecordingColorCamera::~RecordingColorCamera()
+{
+	StopRecording();
+}
+
+unsigned long RecordingColorCamera::Init(std::string directory, int cameraIndex)
+{
+	return m_Camera->Init(directory, cameraIndex);
+}
+
+bool RecordingColorCamera::isInitialized()
+{
+	return m_Camera->isInitialized();
+}
+
+bool RecordingColorCamera::isOpen()
+{
+	return m_Camera->isOpen();
+}
+
+unsigned long RecordingColorCamera::Open()
+{
+	return m_Camera->Open();
+}
+
+unsigned long RecordingColorCamera::Close()
+{
+	StopRecording();
+	return m_Camera->Close();
+}
+
+unsigned long RecordingColorCamera::GetColorImage(char* colorImageData, bool getLatestFrame)
+{
+	if (!isRecording())
+	{
+		return m_Camera->GetColorImage(colorImageData, getLatestFrame);
+	}
+
+	if (GetColorImage(&m_ColorMat, getLatestFrame) & RET_FAILED)
+	{
+		return RET_FAILED;
+	}
+
+	size_t rowSize = m_ColorMat.cols * m_ColorMat.elemSize();
+	for (int row=0; row<m_ColorMat.rows; row++)
+	{
+		std::memcpy(colorImageData + row*rowSize, m_ColorMat.ptr(row), rowSize);
+	}
+
+	return RET_OK;
+}
+
+unsigned long RecordingColorCamera::GetColorImage(cv::Mat* colorImage, bool getLatestFrame)
+{
+	unsigned long ret = m_Camera->GetColorImage(colorImage, getLatestFrame);
+	if ((ret & RET_FAILED) || !isRecording())
+	{
+		return ret;
+	}
+
+	boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+	double timestamp = (boost::posix_time::microsec_clock::universal_time() - epoch).total_microseconds() * 1e-6;
+	// Frames rejected by the writer are counted there, only an I/O error ends the recording
+	if ((m_Writer.Write(timestamp, 0, colorImage, 0) & RET_FAILED) && m_Writer.HasFailed())
+	{
+		std::cerr << "ERROR - RecordingColorCamera::GetColorImage:" << std::endl;
+		std::cerr << "\t ... Writing frame to log failed, recording stopped." << std::endl;
+		StopRecording();
+	}
+
+	return ret;
+}
+
+t_cameraType RecordingColorCamera::GetCameraType()
+{
+	return m_Camera->GetCameraType();
+}
+
+unsigned long RecordingColorCamera::SetProperty(t_cameraProperty* cameraProperty)
+{
+	return m_Camera->SetProperty(cameraProperty);
+}
+
+unsigned long RecordingColorCamera::SetPropertyDefaults()
+{
+	return m_Camera->SetPropertyDefaults();
+}
+
+unsigned long RecordingColorCamera::GetProperty(t_cameraProperty* cameraProperty)
+{
+	return m_Camera->GetProperty(cameraProperty);
+}
+
+unsigned long RecordingColorCamera::PrintCameraInformation()
+{
+	return m_Camera->PrintCameraInformation();
+}
+
+unsigned long RecordingColorCamera::SaveParameters(const char* filename)
+{
+	return m_Camera->SaveParameters(filename);
+}
+
+unsigned long RecordingColorCamera::TestCamera(const char* filename)
+{
+	return m_Camera->TestCamera(filename);
+}
+
+int RecordingColorCamera::GetNumberOfImages()
+{
+	return m_Camera->GetNumberOfImages();
+}
+
+unsigned long RecordingColorCamera::SetPathToImages(std::string path)
+{
+	return m_Camera->SetPathToImages(path);
+}
+
+unsigned long RecordingColorCamera::StartRecording(const std::string& filename, const t_FrameLogOptions& options,
+		const cv::Mat& intrinsicMatrix, const cv::Mat& extrinsicMatrix)
+{
+	if (m_Writer.Open(filename, m_Camera->GetCameraType(), options) & RET_FAILED)
+	{
+		std::cerr << "ERROR - RecordingColorCamera::StartRecording:" << std::endl;
+		std::cerr << "\t ... Could not create frame log '" << filename << "'" << std::endl;
+		return RET_FAILED;
+	}
+	m_Writer.SetCalibration(intrinsicMatrix, extrinsicMatrix);
+
+	std::cout << "INFO - RecordingColorCamera::StartRecording:" << std::endl;
+	std::cout << "\t ... Recording to '" << filename << "'" << std::endl;
+	return RET_OK;
+}
+
+unsigned long RecordingColorCamera::StopRecording()
+{
+	if (!isRecording())
+	{
+		return RET_OK;
+	}
+
+	std::cout << "INFO - RecordingColorCamera::StopRecording:" << std::endl;
+	unsigned long ret = m_Writer.Close();
+	std::cout << "\t ... Recorded " << m_Writer.GetNumberOfFrames() << " frames, dropped "
+		<< m_Writer.GetNumberOfDroppedFrames() << " frames, rejected "
+		<< m_Writer.GetNumberOfRejectedFrames() << " frames" << std::endl;
+	return ret;
+}
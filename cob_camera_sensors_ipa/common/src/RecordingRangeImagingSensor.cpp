@@ -0,0 +1,228 @@
+/****************************************************************
+*
+* Copyright (c) 2026
+*
+* Fraunhofer Institute for Manufacturing Engineering
+* and Automation (IPA)
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Project name: care-o-bot
+* ROS stack name: cob_bringup_sandbox
+* ROS package name: cob_camera_sensors_ipa
+* Description: Records the frames of any range imaging sensor to a frame log.
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Date of creation: October 2026
+* ToDo:
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer.
+* * Redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution.
+* * Neither the name of the Fraunhofer Institute for Manufacturing
+* Engineering and Automation (IPA) nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License LGPL as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License LGPL for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License LGPL along with this program.
+* If not, see <http://www.gnu.org/licenses/>.
+*
+****************************************************************/
+
+#include <cob_vision_utils/StdAfx.h>
+#ifdef __LINUX__
+	#include "cob_camera_sensors_ipa/RecordingRangeImagingSensor.h"
+	#include "cob_vision_utils/GlobalDefines.h"
+
+	#include <iostream>
+	#include <cstring>
+#else
+	#include "cob_bringup_sandbox/cob_camera_sensors_ipa/common/include/cob_camera_sensors_ipa/RecordingRangeImagingSensor.h"
+	#include "cob_perception_common/cob_vision_utils/common/include/cob_vision_utils/GlobalDefines.h"
+#endif
+
+using namespace ipa_CameraSensors;
+
+__DLL_LIBCAMERASENSORS__ AbstractRangeImagingSensorPtr ipa_CameraSensors::CreateRangeImagingSensor_Recording(AbstractRangeImagingSensorPtr sensor)
+{
+	return AbstractRangeImagingSensorPtr(new RecordingRangeImagingSensor(sensor));
+}
+
+RecordingRangeImagingSensor::RecordingRangeImagingSensor(AbstractRangeImagingSensorPtr sensor)
+	: m_Sensor(sensor)
+{
+	m_initialized = false;
+	m_open = false;
+
+	m_BufferSize = 1;
+}
+
+RecordingRangeImagingSensor::~RecordingRangeImagingSensor()
+{
+	StopRecording();
+}
+
+unsigned long RecordingRangeImagingSensor::Init(std::string directory, int cameraIndex)
+{
+	return m_Sensor->Init(directory, cameraIndex);
+}
+
+unsigned long RecordingRangeImagingSensor::Open()
+{
+	return m_Sensor->Open();
+}
+
+unsigned long RecordingRangeImagingSensor::Close()
+{
+	StopRecording();
+	return m_Sensor->Close();
+}
+
+unsigned long RecordingRangeImagingSensor::SetProperty(t_cameraProperty* cameraProperty)
+{
+	return m_Sensor->SetProperty(cameraProperty);
+}
+
+unsigned long RecordingRangeImagingSensor::SetPropertyDefaults()
+{
+	return m_Sensor->SetPropertyDefaults();
+}
+
+unsigned long RecordingRangeImagingSensor::GetProperty(t_cameraProperty* cameraProperty)
+{
+	return m_Sensor->GetProperty(cameraProperty);
+}
+
+unsigned long RecordingRangeImagingSensor::AcquireImages(int widthStepRange, int widthStepGray, int widthStepCartesian, char* rangeImageData, char* grayImageData, char* cartesianImageData,
+										bool getLatestFrame, bool undistort, ipa_CameraSensors::t_ToFGrayImageType grayImageType)
+{
+	if (!isRecording())
+	{
+		return m_Sensor->AcquireImages(widthStepRange, widthStepGray, widthStepCartesian, rangeImageData, grayImageData, cartesianImageData,
+			getLatestFrame, undistort, grayImageType);
+	}
+
+	// The cv::Mat interface knows the image types, so record through it and copy the rows out
+	if (AcquireImages(rangeImageData ? &m_RangeMat : 0, grayImageData ? &m_GrayMat : 0, cartesianImageData ? &m_CartesianMat : 0,
+		getLatestFrame, undistort, grayImageType) & RET_FAILED)
+	{
+		return RET_FAILED;
+	}
+
+	char* data[3] = {rangeImageData, grayImageData, cartesianImageData};
+	int widthStep[3] = {widthStepRange, widthStepGray, widthStepCartesian};
+	const cv::Mat* images[3] = {&m_RangeMat, &m_GrayMat, &m_CartesianMat};
+	for (int i=0; i<3; i++)
+	{
+		if (!data[i])
+		{
+			continue;
+		}
+		size_t rowSize = images[i]->cols * images[i]->elemSize();
+		for (int row=0; row<images[i]->rows; row++)
+		{
+			std::memcpy(data[i] + row*widthStep[i], images[i]->ptr(row), rowSize);
+		}
+	}
+
+	return RET_OK;
+}
+
+unsigned long RecordingRangeImagingSensor::AcquireImages(cv::Mat* rangeImage, cv::Mat* grayImage, cv::Mat* cartesianImage,
+										bool getLatestFrame, bool undistort, ipa_CameraSensors::t_ToFGrayImageType grayImageType)
+{
+	unsigned long ret = m_Sensor->AcquireImages(rangeImage, grayImage, cartesianImage, getLatestFrame, undistort, grayImageType);
+	if ((ret & RET_FAILED) || !isRecording())
+	{
+		return ret;
+	}
+
+	boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+	double timestamp = (boost::posix_time::microsec_clock::universal_time() - epoch).total_microseconds() * 1e-6;
+	// Frames rejected by the writer are counted there, only an I/O error ends the recording
+	if ((m_Writer.Write(timestamp, rangeImage, grayImage, cartesianImage) & RET_FAILED) && m_Writer.HasFailed())
+	{
+		std::cerr << "ERROR - RecordingRangeImagingSensor::AcquireImages:" << std::endl;
+		std::cerr << "\t ... Writing frame to log failed, recording stopped." << std::endl;
+		StopRecording();
+	}
+
+	return ret;
+}
+
+unsigned long RecordingRangeImagingSensor::SaveParameters(const char* filename)
+{
+	return m_Sensor->SaveParameters(filename);
+}
+
+bool RecordingRangeImagingSensor::isInitialized()
+{
+	return m_Sensor->isInitialized();
+}
+
+bool RecordingRangeImagingSensor::isOpen()
+{
+	return m_Sensor->isOpen();
+}
+
+t_cameraType RecordingRangeImagingSensor::GetCameraType()
+{
+	return m_Sensor->GetCameraType();
+}
+
+unsigned long RecordingRangeImagingSensor::SetIntrinsics(cv::Mat& intrinsicMatrix,
+		cv::Mat& undistortMapX, cv::Mat& undistortMapY)
+{
+	intrinsicMatrix.copyTo(m_RecordedIntrinsicMatrix);
+	return m_Sensor->SetIntrinsics(intrinsicMatrix, undistortMapX, undistortMapY);
+}
+
+unsigned long RecordingRangeImagingSensor::StartRecording(const std::string& filename, const t_FrameLogOptions& options,
+		const cv::Mat& extrinsicMatrix)
+{
+	if (m_Writer.Open(filename, m_Sensor->GetCameraType(), options) & RET_FAILED)
+	{
+		std::cerr << "ERROR - RecordingRangeImagingSensor::StartRecording:" << std::endl;
+		std::cerr << "\t ... Could not create frame log '" << filename << "'" << std::endl;
+		return RET_FAILED;
+	}
+	m_Writer.SetCalibration(m_RecordedIntrinsicMatrix, extrinsicMatrix);
+
+	std::cout << "INFO - RecordingRangeImagingSensor::StartRecording:" << std::endl;
+	std::cout << "\t ... Recording to '" << filename << "'" << std::endl;
+	return RET_OK;
+}
+
+unsigned long RecordingRangeImagingSensor::StopRecording()
+{
+	if (!isRecording())
+	{
+		return RET_OK;
+	}
+
+	std::cout << "INFO - RecordingRangeImagingSensor::StopRecording:" << std::endl;
+	unsigned long ret = m_Writer.Close();
+	std::cout << "\t ... Recorded " << m_Writer.GetNumberOfFrames() << " frames, dropped "
+		<< m_Writer.GetNumberOfDroppedFrames() << " frames, rejected "
+		<< m_Writer.GetNumberOfRejectedFrames() << " frames" << std::endl;
+	return ret;
+}
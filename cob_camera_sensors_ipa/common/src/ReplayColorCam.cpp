@@ -0,0 +1,306 @@
+/****************************************************************
+*
+* Copyright (c) 2026
+*
+* Fraunhofer Institute for Manufacturing Engineering
+* and Automation (IPA)
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Project name: care-o-bot
+* ROS stack name: cob_bringup_sandbox
+* ROS package name: cob_camera_sensors_ipa
+* Description: Virtual color camera replaying a frame log.
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Date of creation: October 2026
+* ToDo:
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer.
+* * Redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution.
+* * Neither the name of the Fraunhofer Institute for Manufacturing
+* Engineering and Automation (IPA) nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License LGPL as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License LGPL for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License LGPL along with this program.
+* If not, see <http://www.gnu.org/licenses/>.
+*
+****************************************************************/
+
+#include <cob_vision_utils/StdAfx.h>
+#ifdef __LINUX__
+	#include "cob_camera_sensors_ipa/ReplayColorCam.h"
+	#include "cob_vision_utils/GlobalDefines.h"
+
+	#include <iostream>
+#else
+	#include "cob_bringup_sandbox/cob_camera_sensors_ipa/common/include/cob_camera_sensors_ipa/ReplayColorCam.h"
+	#include "cob_perception_common/cob_vision_utils/common/include/cob_vision_utils/GlobalDefines.h"
+#endif
+
+#include <cstring>
+#include <sstream>
+
+using namespace ipa_CameraSensors;
+
+__DLL_LIBCAMERASENSORS__ AbstractColorCameraPtr ipa_CameraSensors::CreateColorCamera_ReplayColorCam()
+{
+	return AbstractColorCameraPtr(new ReplayColorCam());
+}
+
+ReplayColorCam::ReplayColorCam()
+{
+	m_initialized = false;
+	m_open = false;
+	m_BufferSize = 1;
+
+	m_PlaybackSpeed = 1.;
+	m_Loop = false;
+}
+
+ReplayColorCam::~ReplayColorCam()
+{
+	if (isOpen())
+	{
+		Close();
+	}
+}
+
+unsigned long ReplayColorCam::Init(std::string directory, int cameraIndex)
+{
+	if (isInitialized())
+	{
+		return (RET_OK | RET_CAMERA_ALREADY_INITIALIZED);
+	}
+
+	m_CameraType = ipa_CameraSensors::CAM_VIRTUALCOLOR;
+
+	if (LoadParameters((directory + "cameraSensorsIni.xml").c_str(), cameraIndex) & RET_FAILED)
+	{
+		std::cerr << "ERROR - ReplayColorCam::Init:" << std::endl;
+		std::cerr << "\t ... Parsing xml configuration file failed." << std::endl;
+		return RET_FAILED;
+	}
+
+	m_initialized = true;
+	return RET_OK;
+}
+
+unsigned long ReplayColorCam::Open()
+{
+	if (!isInitialized())
+	{
+		std::cerr << "ERROR - ReplayColorCam::Open:" << std::endl;
+		std::cerr << "\t ... Camera not initialized." << std::endl;
+		return (RET_FAILED | RET_CAMERA_NOT_INITIALIZED);
+	}
+
+	if (isOpen())
+	{
+		return (RET_OK | RET_CAMERA_ALREADY_OPEN);
+	}
+
+	if (m_Reader.Open(m_Path) & RET_FAILED)
+	{
+		std::cerr << "ERROR - ReplayColorCam::Open:" << std::endl;
+		std::cerr << "\t ... Could not open frame log '" << m_Path << "'" << std::endl;
+		return RET_FAILED;
+	}
+
+	if (!m_Reader.HasStream(FRAMELOG_COLOR))
+	{
+		std::cerr << "ERROR - ReplayColorCam::Open:" << std::endl;
+		std::cerr << "\t ... Frame log '" << m_Path << "' contains no color images" << std::endl;
+		m_Reader.Close();
+		return RET_FAILED;
+	}
+
+	m_Player.Reset(&m_Reader, m_PlaybackSpeed, m_Loop);
+
+	m_open = true;
+	return RET_OK;
+}
+
+unsigned long ReplayColorCam::Close()
+{
+	if (!isOpen())
+	{
+		return RET_OK;
+	}
+
+	m_Reader.Close();
+	m_Player.Reset(0, m_PlaybackSpeed, m_Loop);
+
+	m_open = false;
+	return RET_OK;
+}
+
+unsigned long ReplayColorCam::GetColorImage(char* colorImageData, bool getLatestFrame)
+{
+	if (GetColorImage(&m_ColorMat, getLatestFrame) & RET_FAILED)
+	{
+		return RET_FAILED;
+	}
+
+	size_t rowSize = m_ColorMat.cols * m_ColorMat.elemSize();
+	for (int row=0; row<m_ColorMat.rows; row++)
+	{
+		std::memcpy(colorImageData + row*rowSize, m_ColorMat.ptr(row), rowSize);
+	}
+
+	return RET_OK;
+}
+
+unsigned long ReplayColorCam::GetColorImage(cv::Mat* colorImage, bool getLatestFrame)
+{
+	if (!isOpen())
+	{
+		std::cerr << "ERROR - ReplayColorCam::GetColorImage:" << std::endl;
+		std::cerr << "\t ... Camera not open." << std::endl;
+		return (RET_FAILED | RET_CAMERA_NOT_OPEN);
+	}
+
+	long index = m_Player.NextFrame(getLatestFrame);
+	if (index < 0)
+	{
+		std::cerr << "ERROR - ReplayColorCam::GetColorImage:" << std::endl;
+		std::cerr << "\t ... End of frame log reached." << std::endl;
+		return RET_FAILED;
+	}
+
+	if (m_Reader.GetFrame((size_t)index, 0, colorImage, 0) & RET_FAILED)
+	{
+		return RET_FAILED;
+	}
+
+	if (colorImage->empty())
+	{
+		std::cerr << "ERROR - ReplayColorCam::GetColorImage:" << std::endl;
+		std::cerr << "\t ... Frame " << index << " contains no color image." << std::endl;
+		return RET_FAILED;
+	}
+
+	return RET_OK;
+}
+
+unsigned long ReplayColorCam::GetProperty(t_cameraProperty* cameraProperty)
+{
+	switch (cameraProperty->propertyID)
+	{
+	case PROP_CAMERA_RESOLUTION:
+		if (!isOpen())
+		{
+			std::cerr << "ERROR - ReplayColorCam::GetProperty:" << std::endl;
+			std::cerr << "\t ... Camera not open" << std::endl;
+			return (RET_FAILED | RET_CAMERA_NOT_OPEN);
+		}
+		cameraProperty->cameraResolution.xResolution = m_Reader.GetHeader().m_Width[FRAMELOG_COLOR];
+		cameraProperty->cameraResolution.yResolution = m_Reader.GetHeader().m_Height[FRAMELOG_COLOR];
+		cameraProperty->propertyType = TYPE_CAMERA_RESOLUTION;
+		break;
+
+	default:
+		std::cerr << "ERROR - ReplayColorCam::GetProperty:" << std::endl;
+		std::cerr << "\t ... Property " << cameraProperty->propertyID << " unspecified." << std::endl;
+		return RET_FAILED;
+	}
+
+	return RET_OK;
+}
+
+unsigned long ReplayColorCam::PrintCameraInformation()
+{
+	std::cout << "INFO - ReplayColorCam::PrintCameraInformation:" << std::endl;
+	std::cout << "\t ... Frame log: '" << m_Path << "'" << std::endl;
+	std::cout << "\t ... Playback speed: " << m_PlaybackSpeed << (m_Loop ? " (looped)" : "") << std::endl;
+	if (isOpen())
+	{
+		std::cout << "\t ... Frames: " << m_Reader.GetNumberOfFrames() << std::endl;
+		std::cout << "\t ... Resolution: " << m_Reader.GetHeader().m_Width[FRAMELOG_COLOR] << "x"
+			<< m_Reader.GetHeader().m_Height[FRAMELOG_COLOR] << std::endl;
+	}
+
+	return RET_OK;
+}
+
+unsigned long ReplayColorCam::TestCamera(const char* filename)
+{
+	if (!isOpen() && (Open() & RET_FAILED))
+	{
+		std::cerr << "ERROR - ReplayColorCam::TestCamera:" << std::endl;
+		std::cerr << "\t ... Could not open camera." << std::endl;
+		return RET_FAILED;
+	}
+
+	PrintCameraInformation();
+
+	cv::Mat image;
+	boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+	int frames = 0;
+	for (int i=0; i<GetNumberOfImages(); i++)
+	{
+		if (GetColorImage(&image, false) & RET_FAILED)
+		{
+			break;
+		}
+		frames++;
+	}
+	double duration = (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds() * 1e-6;
+
+	std::cout << "INFO - ReplayColorCam::TestCamera:" << std::endl;
+	std::cout << "\t ... Replayed " << frames << " frames in " << duration << " s" << std::endl;
+
+	return Close();
+}
+
+int ReplayColorCam::GetNumberOfImages()
+{
+	if (!isOpen())
+	{
+		return 0;
+	}
+
+	return (int)m_Reader.GetNumberOfFrames();
+}
+
+unsigned long ReplayColorCam::SetPathToImages(std::string path)
+{
+	m_Path = path;
+
+	if (isOpen())
+	{
+		Close();
+		return Open();
+	}
+
+	return RET_OK;
+}
+
+unsigned long ReplayColorCam::LoadParameters(const char* filename, int cameraIndex)
+{
+	std::stringstream ss;
+	ss << "ReplayColorCam_" << cameraIndex;
+
+	return LoadFrameLogReplayParameters(filename, ss.str(), m_Path, m_PlaybackSpeed, m_Loop);
+}
@@ -0,0 +1,303 @@
+/****************************************************************
+*
+* Copyright (c) 2026
+*
+* Fraunhofer Institute for Manufacturing Engineering
+* and Automation (IPA)
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Project name: care-o-bot
+* ROS stack name: cob_bringup_sandbox
+* ROS package name: cob_camera_sensors_ipa
+* Description: Virtual range imaging sensor replaying a frame log.
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Date of creation: October 2026
+* ToDo:
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer.
+* * Redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution.
+* * Neither the name of the Fraunhofer Institute for Manufacturing
+* Engineering and Automation (IPA) nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License LGPL as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License LGPL for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License LGPL along with this program.
+* If not, see <http://www.gnu.org/licenses/>.
+*
+****************************************************************/
+
+#include <cob_vision_utils/StdAfx.h>
+#ifdef __LINUX__
+	#include "cob_camera_sensors_ipa/ReplayRangeCam.h"
+	#include "cob_vision_utils/GlobalDefines.h"
+
+	#include <iostream>
+#else
+	#include "cob_bringup_sandbox/cob_camera_sensors_ipa/common/include/cob_camera_sensors_ipa/ReplayRangeCam.h"
+	#include "cob_perception_common/cob_vision_utils/common/include/cob_vision_utils/GlobalDefines.h"
+#endif
+
+#include <cstring>
+#include <sstream>
+
+using namespace ipa_CameraSensors;
+
+namespace
+{
+	/// Copies an image into a caller supplied buffer with the given line width.
+	void CopyToBuffer(const cv::Mat& image, char* data, int widthStep)
+	{
+		if (!data || image.empty())
+		{
+			return;
+		}
+
+		size_t rowSize = image.cols * image.elemSize();
+		if (widthStep < 0)
+		{
+			widthStep = (int)rowSize;
+		}
+
+		for (int row=0; row<image.rows; row++)
+		{
+			std::memcpy(data + row*widthStep, image.ptr(row), rowSize);
+		}
+	}
+}
+
+__DLL_LIBCAMERASENSORS__ AbstractRangeImagingSensorPtr ipa_CameraSensors::CreateRangeImagingSensor_ReplayRangeCam()
+{
+	return AbstractRangeImagingSensorPtr(new ReplayRangeCam());
+}
+
+ReplayRangeCam::ReplayRangeCam()
+{
+	m_initialized = false;
+	m_open = false;
+
+	m_BufferSize = 1;
+
+	m_PlaybackSpeed = 1.;
+	m_Loop = false;
+}
+
+ReplayRangeCam::~ReplayRangeCam()
+{
+	if (isOpen())
+	{
+		Close();
+	}
+}
+
+unsigned long ReplayRangeCam::Init(std::string directory, int cameraIndex)
+{
+	if (isInitialized())
+	{
+		return (RET_OK | RET_CAMERA_ALREADY_INITIALIZED);
+	}
+
+	m_CameraType = ipa_CameraSensors::CAM_VIRTUALRANGE;
+
+	if (LoadParameters((directory + "cameraSensorsIni.xml").c_str(), cameraIndex) & RET_FAILED)
+	{
+		std::cerr << "ERROR - ReplayRangeCam::Init:" << std::endl;
+		std::cerr << "\t ... Parsing xml configuration file failed." << std::endl;
+		return RET_FAILED;
+	}
+
+	m_initialized = true;
+	return RET_OK;
+}
+
+unsigned long ReplayRangeCam::Open()
+{
+	if (!isInitialized())
+	{
+		std::cerr << "ERROR - ReplayRangeCam::Open:" << std::endl;
+		std::cerr << "\t ... Camera not initialized." << std::endl;
+		return (RET_FAILED | RET_CAMERA_NOT_INITIALIZED);
+	}
+
+	if (isOpen())
+	{
+		return (RET_OK | RET_CAMERA_ALREADY_OPEN);
+	}
+
+	if (m_Reader.Open(m_Path) & RET_FAILED)
+	{
+		std::cerr << "ERROR - ReplayRangeCam::Open:" << std::endl;
+		std::cerr << "\t ... Could not open frame log '" << m_Path << "'" << std::endl;
+		return RET_FAILED;
+	}
+
+	// Use the calibration of the recorded sensor, unless it has been set explicitly
+	if (m_intrinsicMatrix.empty())
+	{
+		m_intrinsicMatrix = m_Reader.GetIntrinsicMatrix();
+	}
+	if (m_extrinsicMatrix.empty())
+	{
+		m_extrinsicMatrix = m_Reader.GetExtrinsicMatrix();
+	}
+
+	m_Player.Reset(&m_Reader, m_PlaybackSpeed, m_Loop);
+
+	std::cout << "**************************************************" << std::endl;
+	std::cout << "ReplayRangeCam::Open: Replaying " << m_Reader.GetNumberOfFrames() << " frames" << std::endl;
+	std::cout << "**************************************************" << std::endl;
+
+	m_open = true;
+	return RET_OK;
+}
+
+unsigned long ReplayRangeCam::Close()
+{
+	if (!isOpen())
+	{
+		return RET_OK;
+	}
+
+	m_Reader.Close();
+	m_Player.Reset(0, m_PlaybackSpeed, m_Loop);
+
+	m_open = false;
+	return RET_OK;
+}
+
+unsigned long ReplayRangeCam::SetProperty(t_cameraProperty* cameraProperty)
+{
+	return RET_OK;
+}
+
+unsigned long ReplayRangeCam::SetPropertyDefaults()
+{
+	return RET_OK;
+}
+
+unsigned long ReplayRangeCam::GetProperty(t_cameraProperty* cameraProperty)
+{
+	switch (cameraProperty->propertyID)
+	{
+	case PROP_CAMERA_RESOLUTION:
+		if (isOpen())
+		{
+			const t_FrameLogHeader& header = m_Reader.GetHeader();
+			t_FrameLogStream stream = m_Reader.HasStream(FRAMELOG_RANGE) ? FRAMELOG_RANGE : FRAMELOG_CARTESIAN;
+			cameraProperty->cameraResolution.xResolution = header.m_Width[stream];
+			cameraProperty->cameraResolution.yResolution = header.m_Height[stream];
+			cameraProperty->propertyType = TYPE_CAMERA_RESOLUTION;
+		}
+		else
+		{
+			std::cerr << "ERROR - ReplayRangeCam::GetProperty:" << std::endl;
+			std::cerr << "\t ... Camera not open" << std::endl;
+			return (RET_FAILED | RET_CAMERA_NOT_OPEN);
+		}
+		break;
+
+	default:
+		std::cerr << "ERROR - ReplayRangeCam::GetProperty:" << std::endl;
+		std::cerr << "\t ... Property " << cameraProperty->propertyID << " unspecified." << std::endl;
+		return RET_FAILED;
+	}
+
+	return RET_OK;
+}
+
+unsigned long ReplayRangeCam::AcquireImages(cv::Mat* rangeImage, cv::Mat* grayImage, cv::Mat* cartesianImage,
+										bool getLatestFrame, bool undistort, ipa_CameraSensors::t_ToFGrayImageType grayImageType)
+{
+	if (!isOpen())
+	{
+		std::cerr << "ERROR - ReplayRangeCam::AcquireImages:" << std::endl;
+		std::cerr << "\t ... Camera not open." << std::endl;
+		return (RET_FAILED | RET_CAMERA_NOT_OPEN);
+	}
+
+	// Frames are replayed as recorded, i.e. undistortion and gray image type
+	// have been applied by the driver that produced the log
+	long index = m_Player.NextFrame(getLatestFrame);
+	if (index < 0)
+	{
+		std::cerr << "ERROR - ReplayRangeCam::AcquireImages:" << std::endl;
+		std::cerr << "\t ... End of frame log reached." << std::endl;
+		return RET_FAILED;
+	}
+
+	return m_Reader.GetFrame((size_t)index, rangeImage, grayImage, cartesianImage);
+}
+
+unsigned long ReplayRangeCam::AcquireImages(int widthStepRange, int widthStepGray, int widthStepCartesian, char* rangeImageData, char* grayImageData, char* cartesianImageData,
+										bool getLatestFrame, bool undistort, ipa_CameraSensors::t_ToFGrayImageType grayImageType)
+{
+	unsigned long ret = AcquireImages(rangeImageData ? &m_RangeMat : 0, grayImageData ? &m_GrayMat : 0,
+		cartesianImageData ? &m_CartesianMat : 0, getLatestFrame, undistort, grayImageType);
+	if (ret & RET_FAILED)
+	{
+		return ret;
+	}
+
+	CopyToBuffer(m_RangeMat, rangeImageData, widthStepRange);
+	CopyToBuffer(m_GrayMat, grayImageData, widthStepGray);
+	CopyToBuffer(m_CartesianMat, cartesianImageData, widthStepCartesian);
+
+	return RET_OK;
+}
+
+unsigned long ReplayRangeCam::SaveParameters(const char* filename)
+{
+	return (RET_FAILED | RET_FUNCTION_NOT_IMPLEMENTED);
+}
+
+int ReplayRangeCam::GetNumberOfImages()
+{
+	if (!isOpen())
+	{
+		return 0;
+	}
+
+	return (int)m_Reader.GetNumberOfFrames();
+}
+
+unsigned long ReplayRangeCam::SetPathToImages(std::string path)
+{
+	m_Path = path;
+
+	if (isOpen())
+	{
+		Close();
+		return Open();
+	}
+
+	return RET_OK;
+}
+
+unsigned long ReplayRangeCam::LoadParameters(const char* filename, int cameraIndex)
+{
+	std::stringstream ss;
+	ss << "ReplayRangeCam_" << cameraIndex;
+
+	return LoadFrameLogReplayParameters(filename, ss.str(), m_Path, m_PlaybackSpeed, m_Loop);
+}
@@ -57,11 +57,13 @@
 
 #ifdef __LINUX__
 	#include "cob_camera_sensors_ipa/SoftkineticCamera.h"	
+	#include "cob_camera_sensors_ipa/AcquisitionProfiler.h"
 	#include "cob_vision_utils/GlobalDefines.h"
 	#include "tinyxml.h"
 	#include <iostream>
 #else
 	#include "cob_bringup_sandbox/cob_camera_sensors_ipa/common/include/cob_camera_sensors_ipa/SoftkineticCamera.h"
+	#include "cob_bringup_sandbox/cob_camera_sensors_ipa/common/include/cob_camera_sensors_ipa/AcquisitionProfiler.h"
 	#include "cob_perception_common/cob_vision_utils/common/include/cob_vision_utils/GlobalDefines.h"
 	#include <functional>
 #endif
@@ -70,6 +72,12 @@
 
 using namespace ipa_CameraSensors;
 
+static const int s_StageTotal = AcquisitionProfiler::RegisterStage("SoftkineticCamera/total");
+static const int s_StageDepthCallback = AcquisitionProfiler::RegisterStage("SoftkineticCamera/depth_callback");
+static const int s_StageColorCallback = AcquisitionProfiler::RegisterStage("SoftkineticCamera/color_callback");
+static const int s_StageResize = AcquisitionProfiler::RegisterStage("SoftkineticCamera/resize");
+static const int s_StageCopy = AcquisitionProfiler::RegisterStage("SoftkineticCamera/copy");
+
 // Macro to disable unused parameter compiler warnings
 #define UNUSED(x) (void)(x)
 
@@ -106,6 +114,8 @@ unsigned long SoftkineticCamera::Init(std::string directory, int cameraIndex)
 		return ipa_Utils::RET_OK;
 	}
 
+	AcquisitionProfiler::InstallDefaultDumpSignalHandler();
+
 	m_CameraType = ipa_CameraSensors::CAM_SOFTKINETIC;
 	m_parameter_files_directory = directory;
 
@@ -517,6 +527,7 @@ void SoftkineticCamera::ConfigureColorNode(DepthSense::ColorNode& color_node)
 void SoftkineticCamera::OnNewDepthSample(DepthSense::DepthNode node, DepthSense::DepthNode::NewSampleReceivedData data)
 {
 	UNUSED(node);
+	ScopedStageTimer callbackTimer(s_StageDepthCallback);
 	//ros::Time depth_timestamp = ros::Time::now();
 	//// Setup the camerainfo messages if they aren't already populated
 	//if (g_rgb_camerainfo_set == false)
@@ -763,6 +774,7 @@ inline bool SoftkineticCamera::is_uv_valid(float u, float v)
 void SoftkineticCamera::OnNewColorSample(DepthSense::ColorNode node, DepthSense::ColorNode::NewSampleReceivedData data)
 {
 	UNUSED(node);
+	ScopedStageTimer callbackTimer(s_StageColorCallback);
 	// Make new OpenCV container
 	int32_t width = 0;
 	int32_t height = 0;
@@ -913,11 +925,14 @@ unsigned long SoftkineticCamera::AcquireImages(cv::Mat* rangeImage, cv::Mat* col
 unsigned long SoftkineticCamera::AcquireImages(int widthStepRange, int widthStepGray, int widthStepCartesian, char* rangeImageData, char* colorImageData, char* cartesianImageData,
 										bool getLatestFrame, bool undistort, ipa_CameraSensors::t_ToFGrayImageType grayImageType)
 {
+	ScopedStageTimer totalTimer(s_StageTotal);
+
 	// rescale everything to the color image resolution
 	int32_t width = 0;
 	int32_t height = 0;
 	DepthSense::FrameFormat_toResolution(m_color_config.base_config.frameFormat, &width, &height);
 
+	ScopedStageTimer resizeTimer(s_StageResize);
 	cv::Mat cartesian_image;
 	m_current_cartesian_image_mutex.lock();
 	if (m_current_cartesian_image.rows != height || m_current_cartesian_image.cols != width)
@@ -933,10 +948,12 @@ unsigned long SoftkineticCamera::AcquireImages(int widthStepRange, int widthStep
 	else
 		range_image = m_current_depth_image.clone();
 	m_current_depth_image_mutex.unlock();
+	resizeTimer.Stop();
 
 	cv::imshow("m_current_color_image", m_current_color_image);
 	cv::waitKey();
 
+	ScopedStageTimer copyTimer(s_StageCopy);
 	if (colorImageData)
 	{
 		m_current_color_image_mutex.lock();
@@ -0,0 +1,320 @@
+/****************************************************************
+*
+* Copyright (c) 2026
+*
+* Fraunhofer Institute for Manufacturing Engineering
+* and Automation (IPA)
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Project name: care-o-bot
+* ROS stack name: cob_bringup_sandbox
+* ROS package name: cob_camera_sensors_ipa
+* Description: Disk cache of fixed-point undistortion maps.
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Date of creation: October 2026
+* ToDo:
+*
+* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright
+* notice, this list of conditions and the following disclaimer.
+* * Redistributions in binary form must reproduce the above copyright
+* notice, this list of conditions and the following disclaimer in the
+* documentation and/or other materials provided with the distribution.
+* * Neither the name of the Fraunhofer Institute for Manufacturing
+* Engineering and Automation (IPA) nor the names of its
+* contributors may be used to endorse or promote products derived from
+* this software without specific prior written permission.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License LGPL as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License LGPL for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License LGPL along with this program.
+* If not, see <http://www.gnu.org/licenses/>.
+*
+****************************************************************/
+
+#include <cob_vision_utils/StdAfx.h>
+#ifdef __LINUX__
+	#include "cob_camera_sensors_ipa/UndistortMapCache.h"
+	#include "cob_vision_utils/GlobalDefines.h"
+
+	#include <iostream>
+#else
+	#include "cob_bringup_sandbox/cob_camera_sensors_ipa/common/include/cob_camera_sensors_ipa/UndistortMapCache.h"
+	#include "cob_perception_common/cob_vision_utils/common/include/cob_vision_utils/GlobalDefines.h"
+#endif
+
+#include <boost/filesystem.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+using namespace ipa_CameraSensors;
+
+namespace
+{
+	const unsigned long long FNV_OFFSET_BASIS = 14695981039346656037ULL;
+	const unsigned long long FNV_PRIME = 1099511628211ULL;
+
+	void HashBytes(unsigned long long& hash, const void* data, size_t size)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i=0; i<size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= FNV_PRIME;
+		}
+	}
+
+	/// Hashes the values of a matrix as doubles, so the hash does not depend on the matrix type.
+	/// The dimensions are hashed as well to separate e.g. 4 and 5 distortion coefficients.
+	void HashMatrix(unsigned long long& hash, const cv::Mat& mat)
+	{
+		int dims[2] = {mat.rows, mat.cols};
+		HashBytes(hash, dims, sizeof(dims));
+		if (mat.empty())
+			return;
+
+		cv::Mat values;
+		mat.convertTo(values, CV_64F);
+		for (int row=0; row<values.rows; row++)
+			HashBytes(hash, values.ptr<double>(row), values.cols * values.channels() * sizeof(double));
+	}
+}
+
+UndistortMapCache::UndistortMapCache()
+{
+}
+
+UndistortMapCache::~UndistortMapCache()
+{
+	Release();
+}
+
+unsigned long long UndistortMapCache::GetCalibrationHash(const cv::Mat& intrinsicMatrix, const cv::Mat& distortionCoeffs,
+	const cv::Size& imageSize, const cv::Mat& rectificationMatrix, const cv::Mat& newIntrinsicMatrix)
+{
+	unsigned long long hash = FNV_OFFSET_BASIS;
+	HashBytes(hash, &UNDISTORTMAP_VERSION, sizeof(UNDISTORTMAP_VERSION));
+	int size[2] = {imageSize.width, imageSize.height};
+	HashBytes(hash, size, sizeof(size));
+	HashMatrix(hash, intrinsicMatrix);
+	HashMatrix(hash, distortionCoeffs);
+	HashMatrix(hash, rectificationMatrix);
+	HashMatrix(hash, newIntrinsicMatrix);
+	return hash;
+}
+
+std::string UndistortMapCache::GetCacheFilename(const std::string& cacheDirectory, unsigned long long hash)
+{
+	std::stringstream filename;
+	filename << "undistort_" << std::hex << std::setw(16) << std::setfill('0') << hash << ".map";
+	return (boost::filesystem::path(cacheDirectory) / filename.str()).string();
+}
+
+unsigned long UndistortMapCache::Load(const std::string& cacheDirectory, const cv::Mat& intrinsicMatrix, const cv::Mat& distortionCoeffs,
+	const cv::Size& imageSize, const cv::Mat& rectificationMatrix, const cv::Mat& newIntrinsicMatrix)
+{
+	Release();
+
+	if (intrinsicMatrix.rows != 3 || intrinsicMatrix.cols != 3 || imageSize.width <= 0 || imageSize.height <= 0)
+	{
+		std::cerr << "ERROR - UndistortMapCache::Load:" << std::endl;
+		std::cerr << "\t ... Invalid intrinsic matrix or image size" << std::endl;
+		return RET_FAILED;
+	}
+
+	unsigned long long hash = GetCalibrationHash(intrinsicMatrix, distortionCoeffs, imageSize, rectificationMatrix, newIntrinsicMatrix);
+	std::string filename = GetCacheFilename(cacheDirectory, hash);
+
+	boost::system::error_code error;
+	if (boost::filesystem::exists(filename, error) && (MapFile(filename, hash, imageSize) & RET_OK))
+		return RET_OK;
+
+	// Compute the maps in fixed point directly, no float maps are allocated
+	cv::Mat newCameraMatrix = newIntrinsicMatrix.empty() ? intrinsicMatrix : newIntrinsicMatrix;
+	cv::initUndistortRectifyMap(intrinsicMatrix, distortionCoeffs, rectificationMatrix, newCameraMatrix,
+		imageSize, CV_16SC2, m_Map1, m_Map2);
+
+	boost::filesystem::create_directories(cacheDirectory, error);
+	if (WriteFile(filename, hash) & RET_FAILED)
+	{
+		std::cerr << "\t ... Maps are used without caching" << std::endl;
+		return RET_OK;
+	}
+
+	std::cout << "INFO - UndistortMapCache::Load:" << std::endl;
+	std::cout << "\t ... Stored undistortion maps in '" << filename << "'" << std::endl;
+	return RET_OK;
+}
+
+unsigned long UndistortMapCache::SetMaps(const cv::Mat& mapX, const cv::Mat& mapY)
+{
+	Release();
+
+	if (mapX.empty())
+	{
+		std::cerr << "ERROR - UndistortMapCache::SetMaps:" << std::endl;
+		std::cerr << "\t ... Maps are empty" << std::endl;
+		return RET_FAILED;
+	}
+
+	if (mapX.type() == CV_16SC2)
+	{
+		m_Map1 = mapX.clone();
+		m_Map2 = mapY.clone();
+		return RET_OK;
+	}
+
+	if (mapX.type() != CV_32FC1 || mapY.type() != CV_32FC1 || mapX.rows != mapY.rows || mapX.cols != mapY.cols)
+	{
+		std::cerr << "ERROR - UndistortMapCache::SetMaps:" << std::endl;
+		std::cerr << "\t ... Maps must be a pair of CV_32FC1 or CV_16SC2/CV_16UC1 matrices of equal size" << std::endl;
+		return RET_FAILED;
+	}
+
+	cv::convertMaps(mapX, mapY, m_Map1, m_Map2, CV_16SC2);
+	return RET_OK;
+}
+
+void UndistortMapCache::Release()
+{
+	m_Map1.release();
+	m_Map2.release();
+
+	boost::interprocess::mapped_region emptyRegion;
+	boost::interprocess::file_mapping emptyMapping;
+	m_Region.swap(emptyRegion);
+	m_Mapping.swap(emptyMapping);
+}
+
+unsigned long UndistortMapCache::Remap(const cv::Mat& src, cv::Mat& dst, int interpolation) const
+{
+	if (!isValid())
+	{
+		std::cerr << "ERROR - UndistortMapCache::Remap:" << std::endl;
+		std::cerr << "\t ... No undistortion maps available" << std::endl;
+		return RET_FAILED;
+	}
+
+	if (src.rows != m_Map1.rows || src.cols != m_Map1.cols)
+	{
+		std::cerr << "ERROR - UndistortMapCache::Remap:" << std::endl;
+		std::cerr << "\t ... Image size " << src.cols << "x" << src.rows << " does not match the map size "
+			<< m_Map1.cols << "x" << m_Map1.rows << std::endl;
+		return RET_FAILED;
+	}
+
+	cv::remap(src, dst, m_Map1, m_Map2, interpolation, cv::BORDER_CONSTANT);
+	return RET_OK;
+}
+
+unsigned long UndistortMapCache::MapFile(const std::string& filename, unsigned long long hash, const cv::Size& imageSize)
+{
+	try
+	{
+		boost::interprocess::file_mapping mapping(filename.c_str(), boost::interprocess::read_only);
+		boost::interprocess::mapped_region region(mapping, boost::interprocess::read_only);
+		m_Mapping.swap(mapping);
+		m_Region.swap(region);
+	}
+	catch (boost::interprocess::interprocess_exception& e)
+	{
+		std::cerr << "ERROR - UndistortMapCache::MapFile:" << std::endl;
+		std::cerr << "\t ... Could not map file '" << filename << "'" << std::endl;
+		std::cerr << "\t ... " << e.what() << std::endl;
+		return (RET_FAILED | RET_FAILED_OPEN_FILE);
+	}
+
+	const char* data = (const char*)m_Region.get_address();
+	size_t fileSize = m_Region.get_size();
+	size_t map1Size = (size_t)imageSize.width * imageSize.height * 2 * sizeof(short);
+	size_t map2Size = (size_t)imageSize.width * imageSize.height * sizeof(unsigned short);
+
+	t_UndistortMapFileHeader header;
+	bool valid = (fileSize >= sizeof(header));
+	if (valid)
+	{
+		std::memcpy(&header, data, sizeof(header));
+		valid = std::memcmp(header.m_Magic, UNDISTORTMAP_MAGIC, sizeof(header.m_Magic)) == 0 &&
+			header.m_Version == UNDISTORTMAP_VERSION &&
+			header.m_HeaderSize == sizeof(header) &&
+			header.m_Hash == hash &&
+			header.m_Width == imageSize.width &&
+			header.m_Height == imageSize.height &&
+			fileSize == sizeof(header) + map1Size + map2Size;
+	}
+
+	if (!valid)
+	{
+		std::cerr << "ERROR - UndistortMapCache::MapFile:" << std::endl;
+		std::cerr << "\t ... File '" << filename << "' does not hold the maps of the calibration, recomputing" << std::endl;
+		Release();
+		return RET_FAILED;
+	}
+
+	// The maps are only read, so the data of the read only mapping is never written
+	char* maps = const_cast<char*>(data) + sizeof(header);
+	m_Map1 = cv::Mat(imageSize.height, imageSize.width, CV_16SC2, maps);
+	m_Map2 = cv::Mat(imageSize.height, imageSize.width, CV_16UC1, maps + map1Size);
+	return RET_OK;
+}
+
+unsigned long UndistortMapCache::WriteFile(const std::string& filename, unsigned long long hash) const
+{
+	t_UndistortMapFileHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.m_Magic, UNDISTORTMAP_MAGIC, sizeof(header.m_Magic));
+	header.m_Version = UNDISTORTMAP_VERSION;
+	header.m_HeaderSize = sizeof(header);
+	header.m_Hash = hash;
+	header.m_Width = m_Map1.cols;
+	header.m_Height = m_Map1.rows;
+
+	// Several processes may build the same maps, each writes its own temporary file
+	boost::system::error_code error;
+	std::string tempFilename = boost::filesystem::unique_path(filename + ".%%%%%%%%.tmp", error).string();
+
+	std::ofstream file(tempFilename.c_str(), std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cerr << "ERROR - UndistortMapCache::WriteFile:" << std::endl;
+		std::cerr << "\t ... Could not open '" << tempFilename << "'" << std::endl;
+		return (RET_FAILED | RET_FAILED_OPEN_FILE);
+	}
+
+	file.write((const char*)&header, sizeof(header));
+	for (int row=0; row<m_Map1.rows; row++)
+		file.write((const char*)m_Map1.ptr(row), m_Map1.cols * m_Map1.elemSize());
+	for (int row=0; row<m_Map2.rows; row++)
+		file.write((const char*)m_Map2.ptr(row), m_Map2.cols * m_Map2.elemSize());
+	file.close();
+
+	if (file.fail() || std::rename(tempFilename.c_str(), filename.c_str()) != 0)
+	{
+		std::cerr << "ERROR - UndistortMapCache::WriteFile:" << std::endl;
+		std::cerr << "\t ... Could not write '" << filename << "'" << std::endl;
+		std::remove(tempFilename.c_str());
+		return RET_FAILED;
+	}
+
+	return RET_OK;
+}
@@ -0,0 +1,150 @@
+#ifndef BIASESTIMATOR_INCLUDEDEF_H
+#define BIASESTIMATOR_INCLUDEDEF_H
+//-----------------------------------------------
+#include <cstddef>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+//-----------------------------------------------
+
+/**
+ * Estimates the zero offset of the six wrench axes from the running sample stream.
+ * After start() every sample passed to add() is collected until the window is
+ * full; then samples deviating from the median by more than a number of robust
+ * standard deviations (1.4826 * median absolute deviation) on any axis are
+ * discarded and the rest is averaged. Collecting never blocks and all buffers
+ * are allocated in the constructor.
+ *
+ * With a known tool load the load at the time of each sample is subtracted before
+ * averaging, see add(), so the bias does not depend on the sensor orientation.
+ */
+class BiasEstimator
+{
+public:
+	/**
+	 * @param iWindow number of samples per estimate
+	 * @param dOutlierSigma rejection threshold in robust standard deviations, 0 keeps all samples
+	 */
+	BiasEstimator(int iWindow = 100, double dOutlierSigma = 3.0)
+		: m_iWindow(iWindow < 1 ? 1 : iWindow), m_dOutlierSigma(dOutlierSigma),
+		  m_Samples(m_iWindow * 6), m_Scratch(m_iWindow), m_Keep(m_iWindow),
+		  m_iCount(0), m_bActive(false), m_bValid(false), m_iRejected(0)
+	{
+		for( int i = 0; i < 6; i++ )
+			m_dBias[i] = 0.0;
+	}
+
+	/// Begins a new estimate, a running one is restarted.
+	void start()
+	{
+		m_iCount = 0;
+		m_bActive = true;
+	}
+
+	/**
+	 * Collects one sample while an estimate is running.
+	 * @param pWrench Fx, Fy, Fz, Tx, Ty, Tz as measured
+	 * @param pLoad wrench of the tool load at the time of the sample, or NULL
+	 * @return true if this sample completed the estimate.
+	 */
+	bool add(const double* pWrench, const double* pLoad = NULL)
+	{
+		if( !m_bActive )
+			return false;
+
+		double* pSample = &m_Samples[m_iCount * 6];
+		for( int i = 0; i < 6; i++ )
+			pSample[i] = pLoad ? pWrench[i] - pLoad[i] : pWrench[i];
+
+		if( ++m_iCount < m_iWindow )
+			return false;
+
+		estimate();
+		m_bActive = false;
+		m_bValid = true;
+		return true;
+	}
+
+	bool isActive() const { return m_bActive; }
+
+	/// True once an estimate has completed.
+	bool isValid() const { return m_bValid; }
+
+	/// Result of the last completed estimate, zero before the first one.
+	void getBias(double* pBias) const
+	{
+		for( int i = 0; i < 6; i++ )
+			pBias[i] = m_dBias[i];
+	}
+
+	/// Samples discarded as outliers by the last estimate.
+	int getRejected() const { return m_iRejected; }
+
+private:
+	void estimate()
+	{
+		for( int j = 0; j < m_iWindow; j++ )
+			m_Keep[j] = 1;
+
+		if( m_dOutlierSigma > 0.0 )
+		{
+			for( int i = 0; i < 6; i++ )
+			{
+				double dMedian = median(i);
+				double dThreshold = m_dOutlierSigma * 1.4826 * median(i, dMedian, true);
+				// a constant axis has no spread to judge by
+				if( dThreshold <= 0.0 )
+					continue;
+				for( int j = 0; j < m_iWindow; j++ )
+				{
+					if( std::fabs(m_Samples[j * 6 + i] - dMedian) > dThreshold )
+						m_Keep[j] = 0;
+				}
+			}
+		}
+
+		double dSum[6] = {0, 0, 0, 0, 0, 0};
+		int iKept = 0;
+		for( int j = 0; j < m_iWindow; j++ )
+		{
+			if( !m_Keep[j] )
+				continue;
+			for( int i = 0; i < 6; i++ )
+				dSum[i] += m_Samples[j * 6 + i];
+			iKept++;
+		}
+		m_iRejected = m_iWindow - iKept;
+
+		// every axis keeps at least half of the samples, so iKept > 0 unless
+		// several axes reject disjoint halves; fall back to the median then
+		for( int i = 0; i < 6; i++ )
+			m_dBias[i] = (iKept > 0) ? dSum[i] / iKept : median(i);
+	}
+
+	// median of one axis, of the absolute deviations from dCenter if bAbs
+	double median(int iAxis, double dCenter = 0.0, bool bAbs = false)
+	{
+		for( int j = 0; j < m_iWindow; j++ )
+		{
+			double dValue = m_Samples[j * 6 + iAxis] - dCenter;
+			m_Scratch[j] = bAbs ? std::fabs(dValue) : dValue;
+		}
+		std::vector<double>::iterator itMid = m_Scratch.begin() + m_iWindow / 2;
+		std::nth_element(m_Scratch.begin(), itMid, m_Scratch.end());
+		return *itMid;
+	}
+
+	int m_iWindow;
+	double m_dOutlierSigma;
+	/// m_iWindow samples of six values each
+	std::vector<double> m_Samples;
+	std::vector<double> m_Scratch;
+	std::vector<char> m_Keep;
+	int m_iCount;
+	bool m_bActive;
+	bool m_bValid;
+	int m_iRejected;
+	double m_dBias[6];
+};
+//-----------------------------------------------
+#endif
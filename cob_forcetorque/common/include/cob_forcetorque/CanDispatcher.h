@@ -0,0 +1,381 @@
+#ifndef CANDISPATCHER_INCLUDEDEF_H
+#define CANDISPATCHER_INCLUDEDEF_H
+//-----------------------------------------------
+#include <iostream>
+#include <vector>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sched.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <cob_forcetorque/CanItf.h>
+#include <cob_forcetorque/Mutex.h>
+#include <cob_forcetorque/SpscRing.h>
+//-----------------------------------------------
+
+/**
+ * Shares one CAN interface between several sensors.
+ * The dispatcher owns the interface and is the only one reading from it: a
+ * single thread receives all frames and copies each one into the queue of
+ * every subscription whose identifier filter matches. Subscribers read their
+ * queue from their own thread without locking and transmit through the
+ * dispatcher, or use a Port, which wraps both as a CanItf for existing drivers.
+ */
+class CanDispatcher
+{
+public:
+	/**
+	 * Identifier filter and frame queue of one subscriber.
+	 * A frame matches if (id & m_iMask) == m_iID, or if m_iID <= id <= m_iLast
+	 * for range filters.
+	 */
+	class Subscription
+	{
+	public:
+		/**
+		 * Fetches the oldest queued frame with its reception time, see CanMsg::getStamp().
+		 * Never blocks. Lock-free, call from one thread only.
+		 * @return false if no frame is queued.
+		 */
+		bool pop(CanMsg& CMsg) { return m_Queue.pop(CMsg); }
+
+		/**
+		 * Like pop(), but waits up to iTimeOutMs for a frame to arrive.
+		 */
+		bool popWait(CanMsg& CMsg, int iTimeOutMs)
+		{
+			if( m_Queue.pop(CMsg) )
+				return true;
+
+			timespec Deadline;
+			clock_gettime(CLOCK_REALTIME, &Deadline);
+			Deadline.tv_sec += iTimeOutMs / 1000;
+			Deadline.tv_nsec += (iTimeOutMs % 1000) * 1000000L;
+			if( Deadline.tv_nsec >= 1000000000L )
+			{
+				Deadline.tv_sec++;
+				Deadline.tv_nsec -= 1000000000L;
+			}
+
+			// one post per queued frame; posts of frames already taken by
+			// pop() only cause an extra turn of the loop
+			while( !m_Queue.pop(CMsg) )
+			{
+				if( sem_timedwait(&m_Arrived, &Deadline) != 0 && errno != EINTR )
+					return m_Queue.pop(CMsg);
+			}
+			return true;
+		}
+
+		/// Number of queued frames.
+		size_t size() const { return m_Queue.size(); }
+
+		/// Frames lost because the queue was full.
+		unsigned long getDropped() const { return m_ulDropped; }
+
+	private:
+		friend class CanDispatcher;
+
+		Subscription(int iID, int iLast, int iMask, size_t iQueueSize)
+			: m_iID(iID), m_iLast(iLast), m_iMask(iMask), m_Queue(iQueueSize), m_ulDropped(0)
+		{
+			sem_init(&m_Arrived, 0, 0);
+		}
+
+		~Subscription()
+		{
+			sem_destroy(&m_Arrived);
+		}
+
+		bool matches(int iID) const
+		{
+			if( m_iLast >= 0 )
+				return (m_iID <= iID) && (iID <= m_iLast);
+			return (iID & m_iMask) == m_iID;
+		}
+
+		void push(const CanMsg& CMsg)
+		{
+			if( !m_Queue.push(CMsg) )
+				m_ulDropped++;
+			else
+				sem_post(&m_Arrived);
+		}
+
+		int m_iID;
+		/// last identifier of a range filter, -1 for exact and mask filters
+		int m_iLast;
+		int m_iMask;
+		SpscRing<CanMsg> m_Queue;
+		volatile unsigned long m_ulDropped;
+		/// wakes popWait()
+		sem_t m_Arrived;
+	};
+
+	/**
+	 * A subscription and the dispatcher's transmit functions as a CanItf, so a
+	 * driver written against CanItf runs on a shared interface unchanged.
+	 * Receiving must happen from one thread only.
+	 */
+	class Port : public CanItf
+	{
+	public:
+		/// Unsubscribes.
+		~Port() { m_pDispatcher->unsubscribe(m_pSubscription); }
+
+		void init() {}
+
+		bool transmitMsg(const CanMsg& CMsg, bool bBlocking = true)
+		{
+			return m_pDispatcher->transmitMsg(CMsg, bBlocking);
+		}
+
+		int transmitMsgs(const CanMsg* pCMsg, int iCount, bool bBlocking = true)
+		{
+			return m_pDispatcher->transmitMsgs(pCMsg, iCount, bBlocking);
+		}
+
+		bool receiveMsg(CanMsg* pCMsg) { return m_pSubscription->pop(*pCMsg); }
+
+		bool receiveMsgTimeout(CanMsg* pCMsg, int iTimeOutMs)
+		{
+			return m_pSubscription->popWait(*pCMsg, iTimeOutMs);
+		}
+
+		int receiveMsgs(CanMsg* pCMsg, int iMaxCount, int iTimeOutMs)
+		{
+			if( iMaxCount <= 0 || !m_pSubscription->popWait(pCMsg[0], iTimeOutMs) )
+				return 0;
+			int iCount = 1;
+			while( iCount < iMaxCount && m_pSubscription->pop(pCMsg[iCount]) )
+				iCount++;
+			return iCount;
+		}
+
+		/// Waits 10 ms per retry, like CanESD.
+		bool receiveMsgRetry(CanMsg* pCMsg, int iNrOfRetry)
+		{
+			return m_pSubscription->popWait(*pCMsg, 10 * iNrOfRetry);
+		}
+
+		bool isObjectMode() { return false; }
+
+		Subscription* getSubscription() { return m_pSubscription; }
+
+	private:
+		friend class CanDispatcher;
+
+		Port(CanDispatcher* pDispatcher, Subscription* pSubscription)
+			: m_pDispatcher(pDispatcher), m_pSubscription(pSubscription)
+		{
+		}
+
+		CanDispatcher* m_pDispatcher;
+		Subscription* m_pSubscription;
+	};
+
+	/**
+	 * @param pCan opened CAN interface, deleted by the dispatcher.
+	 */
+	CanDispatcher(CanItf* pCan)
+		: m_pCan(pCan), m_bRunning(false), m_ulUnrouted(0), m_ulErrors(0)
+	{
+	}
+
+	~CanDispatcher()
+	{
+		stop();
+		for( size_t i = 0; i < m_Subscriptions.size(); i++ )
+			delete m_Subscriptions[i];
+		delete m_pCan;
+	}
+
+	/**
+	 * Subscribes to the frames with exactly the given identifier.
+	 * The subscription is owned by the dispatcher.
+	 */
+	Subscription* subscribeID(int iID, size_t iQueueSize = DEFAULT_QUEUE_SIZE)
+	{
+		return subscribe(new Subscription(iID, -1, ID_MASK, iQueueSize));
+	}
+
+	/**
+	 * Subscribes to the frames with an identifier in [iFirst, iLast].
+	 */
+	Subscription* subscribeRange(int iFirst, int iLast, size_t iQueueSize = DEFAULT_QUEUE_SIZE)
+	{
+		return subscribe(new Subscription(iFirst, iLast, ID_MASK, iQueueSize));
+	}
+
+	/**
+	 * Subscribes to the frames with (id & iMask) == (iID & iMask),
+	 * e.g. a node id in the low bits of the identifier.
+	 */
+	Subscription* subscribeMask(int iID, int iMask, size_t iQueueSize = DEFAULT_QUEUE_SIZE)
+	{
+		return subscribe(new Subscription(iID & iMask, -1, iMask, iQueueSize));
+	}
+
+	/**
+	 * Opens a port receiving the frames with an identifier in [iFirst, iLast].
+	 * The caller owns the port and must delete it before the dispatcher.
+	 */
+	Port* openPort(int iFirst, int iLast, size_t iQueueSize = DEFAULT_QUEUE_SIZE)
+	{
+		return new Port(this, subscribeRange(iFirst, iLast, iQueueSize));
+	}
+
+	/**
+	 * Removes and deletes a subscription, its owner must not use it anymore.
+	 */
+	void unsubscribe(Subscription* pSubscription)
+	{
+		m_Mutex.lock();
+		for( size_t i = 0; i < m_Subscriptions.size(); i++ )
+		{
+			if( m_Subscriptions[i] == pSubscription )
+			{
+				m_Subscriptions.erase(m_Subscriptions.begin() + i);
+				delete pSubscription;
+				break;
+			}
+		}
+		m_Mutex.unlock();
+	}
+
+	/**
+	 * Starts the receive thread.
+	 * @param iPriority SCHED_FIFO priority, 0 keeps the normal scheduling.
+	 */
+	bool start(int iPriority = 0)
+	{
+		if( m_bRunning )
+			return true;
+
+		m_bRunning = true;
+		if( pthread_create(&m_Thread, NULL, thread, this) != 0 )
+		{
+			std::cout << "Error: Could not start the CAN dispatcher thread" << std::endl;
+			m_bRunning = false;
+			return false;
+		}
+
+		if( iPriority > 0 )
+		{
+			sched_param Param;
+			Param.sched_priority = iPriority;
+			if( pthread_setschedparam(m_Thread, SCHED_FIFO, &Param) != 0 )
+				std::cout << "Warning: No real-time priority for the CAN dispatcher thread" << std::endl;
+		}
+		return true;
+	}
+
+	void stop()
+	{
+		if( !m_bRunning )
+			return;
+		// noticed after at most RX_TIMEOUT_MS
+		m_bRunning = false;
+		pthread_join(m_Thread, NULL);
+	}
+
+	bool isRunning() const { return m_bRunning; }
+
+	/**
+	 * Sends on the shared interface, may be called from any thread.
+	 */
+	bool transmitMsg(const CanMsg& CMsg, bool bBlocking = true)
+	{
+		m_TxMutex.lock();
+		bool bRet = m_pCan->transmitMsg(CMsg, bBlocking);
+		m_TxMutex.unlock();
+		return bRet;
+	}
+
+	int transmitMsgs(const CanMsg* pCMsg, int iCount, bool bBlocking = true)
+	{
+		m_TxMutex.lock();
+		int iRet = m_pCan->transmitMsgs(pCMsg, iCount, bBlocking);
+		m_TxMutex.unlock();
+		return iRet;
+	}
+
+	/// Frames no subscription matched.
+	unsigned long getUnrouted() const { return m_ulUnrouted; }
+
+	/// Failed driver reads, each followed by a pause of RX_TIMEOUT_MS.
+	unsigned long getErrors() const { return m_ulErrors; }
+
+private:
+	enum
+	{
+		ID_MASK = 0x7FF,
+		DEFAULT_QUEUE_SIZE = 256,
+		RX_BATCH = 16,
+		RX_TIMEOUT_MS = 100
+	};
+
+	Subscription* subscribe(Subscription* pSubscription)
+	{
+		m_Mutex.lock();
+		m_Subscriptions.push_back(pSubscription);
+		m_Mutex.unlock();
+		return pSubscription;
+	}
+
+	static void* thread(void* pArg)
+	{
+		((CanDispatcher*)pArg)->loop();
+		return NULL;
+	}
+
+	void loop()
+	{
+		CanMsg Msgs[RX_BATCH];
+
+		while( m_bRunning )
+		{
+			int iCount = m_pCan->receiveMsgs(Msgs, RX_BATCH, RX_TIMEOUT_MS);
+			if( iCount < 0 )
+			{
+				// e.g. bus off or a closed handle, the driver returns at once
+				m_ulErrors++;
+				usleep(RX_TIMEOUT_MS * 1000);
+				continue;
+			}
+			if( iCount == 0 )
+				continue;
+
+			// held per batch, only contended while (un)subscribing
+			m_Mutex.lock();
+			for( int i = 0; i < iCount; i++ )
+			{
+				bool bRouted = false;
+				for( size_t j = 0; j < m_Subscriptions.size(); j++ )
+				{
+					if( m_Subscriptions[j]->matches(Msgs[i].getID()) )
+					{
+						m_Subscriptions[j]->push(Msgs[i]);
+						bRouted = true;
+					}
+				}
+				if( !bRouted )
+					m_ulUnrouted++;
+			}
+			m_Mutex.unlock();
+		}
+	}
+
+	CanItf* m_pCan;
+	std::vector<Subscription*> m_Subscriptions;
+	/// Guards m_Subscriptions.
+	Mutex m_Mutex;
+	Mutex m_TxMutex;
+	pthread_t m_Thread;
+	volatile bool m_bRunning;
+	volatile unsigned long m_ulUnrouted;
+	volatile unsigned long m_ulErrors;
+};
+//-----------------------------------------------
+#endif
@@ -30,6 +30,24 @@
 #include <libntcan/ntcan.h>
 //#include <Neobotix/Utilities/IniFile.h>
 #include <cob_forcetorque/Mutex.h>
+#include <cob_forcetorque/TimeStamp.h>
+#include <pthread.h>
+
+//-----------------------------------------------
+/**
+ * Receiver of the messages with one CAN identifier, see CanESD::addRxHandler().
+ */
+class CanRxHandler
+{
+public:
+	virtual ~CanRxHandler() {}
+
+	/**
+	 * Called on the receive thread for every message with a registered identifier.
+	 * Should return quickly, the next messages wait meanwhile.
+	 */
+	virtual void handleMsg(const CanMsg& CMsg) = 0;
+};
 
 //-----------------------------------------------
 /**
@@ -43,23 +61,69 @@ private:
 	BYTE m_BaudRate;
 	int m_Handle;
 	int m_LastID;
+	int m_iRxTimeOut;
 	bool m_bObjectMode;
 	bool m_bIsTXError;
 	Mutex m_Mutex;
 
+	/// Handlers indexed by the 11-bit identifier, NULL if none.
+	CanRxHandler* volatile m_pRxHandler[0x800];
+	pthread_t m_RxThread;
+	volatile bool m_bRxThreadRunning;
+	volatile unsigned long m_ulRxUnhandled;
+
+	/// Frames carry time stamps of the controller, see readMsgs().
+	bool m_bHwTimeStamps;
+	/// Time stamp counter frequency in Hz.
+	double m_dTsFreq;
+	/// CLOCK_MONOTONIC minus controller time in seconds.
+	double m_dTsOffset;
+	bool m_bTsOffsetValid;
+
 	//IniFile m_IniFile;
 
 	void initIntern();
+	int readMsgs(CanMsg* pCMsg, int32_t* pLen, bool bWait);
+	void updateTsOffset(uint64_t iTimeStamp, double dReadTime);
+	static void* rxThread(void* pArg);
+	void rxLoop();
 
 public:
 	CanESD(const char* cIniFile, bool bObjectMode = false);
 	~CanESD();
 	void init(){};
-	bool transmitMsg(CanMsg CMsg, bool bBlocking = true);
+	bool transmitMsg(const CanMsg& CMsg, bool bBlocking = true);
+	int transmitMsgs(const CanMsg* pCMsg, int iCount, bool bBlocking = true);
 	bool receiveMsgRetry(CanMsg* pCMsg, int iNrOfRetry);
 	bool receiveMsg(CanMsg* pCMsg);
+	bool receiveMsgTimeout(CanMsg* pCMsg, int iTimeOutMs);
+	int receiveMsgs(CanMsg* pCMsg, int iMaxCount, int iTimeOutMs);
 	bool isObjectMode() { return m_bObjectMode; }
 	bool isTransmitError() { return m_bIsTXError; }
+	/// Whether the receive time stamps come from the controller instead of the read time.
+	bool hasHwTimeStamps() { return m_bHwTimeStamps; }
+
+	/**
+	 * Registers the handler for all messages with the given identifier,
+	 * replacing a previous one. Handlers are called by the receive thread.
+	 * A removed handler may still be running until stopRxThread() returns.
+	 * @return false if the identifier is out of range.
+	 */
+	bool addRxHandler(int iID, CanRxHandler* pHandler);
+	void removeRxHandler(int iID);
+
+	/**
+	 * Starts a thread that sleeps in the driver until messages arrive and
+	 * dispatches them to the registered handlers. While it runs, the
+	 * receiveMsg*() functions must not be used.
+	 * @param iPriority SCHED_FIFO priority, 0 keeps the normal scheduling.
+	 */
+	bool startRxThread(int iPriority = 0);
+	void stopRxThread();
+	bool isRxThreadRunning() { return m_bRxThreadRunning; }
+
+	/// Messages received by the thread without a handler for their identifier.
+	unsigned long getRxUnhandled() { return m_ulRxUnhandled; }
 protected:
 
     /*!
@@ -80,6 +144,7 @@ protected:
 	int canIdAddGroup(int handle, int id);
 
 	std::string GetErrorStr(int ntstatus) const;
+	bool setRxTimeOut(int iTimeOutMs);
 	int readEvent();
 };
 //-----------------------------------------------
@@ -58,7 +58,15 @@ public:
 	 * @param pCMsg CAN message
 	 * @param bBlocking specifies whether send should be blocking or non-blocking
 	 */
-	virtual bool transmitMsg(CanMsg CMsg, bool bBlocking = true) = 0;
+	virtual bool transmitMsg(const CanMsg& CMsg, bool bBlocking = true) = 0;
+
+	/**
+	 * Sends several CAN messages with a single driver call.
+	 * @param pCMsg array of iCount CAN messages
+	 * @param bBlocking specifies whether send should be blocking or non-blocking
+	 * @return number of messages sent, a non-blocking send may not take all of them
+	 */
+	virtual int transmitMsgs(const CanMsg* pCMsg, int iCount, bool bBlocking = true) = 0;
 
 	/**
 	 * Reads a CAN message.
@@ -66,6 +74,24 @@ public:
 	 */
 	virtual bool receiveMsg(CanMsg* pCMsg) = 0;
 
+	/**
+	 * Reads a CAN message, waiting at most the given time for one to arrive.
+	 * The calling thread sleeps in the driver meanwhile.
+	 * @param pCMsg CAN message
+	 * @param iTimeOutMs timeout in milliseconds
+	 * @return true if a message was received
+	 */
+	virtual bool receiveMsgTimeout(CanMsg* pCMsg, int iTimeOutMs) = 0;
+
+	/**
+	 * Reads all received CAN messages, up to the given number, with a single driver call.
+	 * Waits at most the given time for the first one to arrive.
+	 * @param pCMsg array for iMaxCount CAN messages
+	 * @param iTimeOutMs timeout in milliseconds
+	 * @return number of messages read, 0 on timeout, -1 on a driver error
+	 */
+	virtual int receiveMsgs(CanMsg* pCMsg, int iMaxCount, int iTimeOutMs) = 0;
+
 	/**
 	 * Reads a CAN message.
 	 * The function blocks between the attempts.
@@ -43,6 +43,8 @@ public:
 	int m_iLen;
 	/// @todo This should be private.
 	int m_iType;
+	/// Reception time in seconds of CLOCK_MONOTONIC, 0 if unknown.
+	double m_dStamp;
 
 protected:
 	/**
@@ -59,6 +61,7 @@ public:
 		m_iID = 0;
 		m_iLen = 8;
 		m_iType = 0x00;
+		m_dStamp = 0;
 	}
 
 	/**
@@ -87,7 +90,7 @@ public:
 	/**
 	 * Gets the bytes of the telegram.
 	 */
-	void get(BYTE* pData0, BYTE* pData1, BYTE* pData2, BYTE* pData3, BYTE* pData4, BYTE* pData5, BYTE* pData6, BYTE* pData7)
+	void get(BYTE* pData0, BYTE* pData1, BYTE* pData2, BYTE* pData3, BYTE* pData4, BYTE* pData5, BYTE* pData6, BYTE* pData7) const
 	{
 		*pData0 = m_bDat[0];
 		*pData1 = m_bDat[1];
@@ -103,7 +106,7 @@ public:
 	 * Returns a spezific byte of the telegram.
 	 * @param iNr number of the byte.
 	 */
-	int getAt(int iNr)
+	int getAt(int iNr) const
 	{
 		return m_bDat[iNr];
 	}
@@ -129,7 +132,7 @@ public:
 	/**
 	 * Prints the telegram.
 	 */
-	void print()
+	void print() const
 	{
 		std::cout << "id= " << m_iID << " type= " << m_iType << " len= " << m_iLen << " data= " <<
 			(int)m_bDat[0] << " " << (int)m_bDat[1] << " " << (int)m_bDat[2] << " " << (int)m_bDat[3] << " " <<
@@ -139,7 +142,7 @@ public:
 	/**
 	 * @deprecated function uses a spetific format of the telegram.
 	 */
-	int getStatus()
+	int getStatus() const
 	{
 		//bit 0 and bit 1 contain MsgStatus
 		return (int)(m_bDat[7] & 0x0003);
@@ -148,7 +151,7 @@ public:
 	/**
 	 * @deprecated function uses a spetific format of the telegram.
 	 */
-	int getCmd()
+	int getCmd() const
 	{
 		return (m_bDat[7] >> 2);
 	}
@@ -157,7 +160,7 @@ public:
 	 * Get the identifier stored in this message structure.
 	 * @return the message identifier.
 	 */
-	int getID()
+	int getID() const
 	{
 		return m_iID;
 	}
@@ -177,7 +180,7 @@ public:
 	 * Get the message length set within this data structure.
 	 * @return The message length in the range [0..8].
 	 */
-	int getLength()
+	int getLength() const
 	{
 		return m_iLen;
 	}
@@ -196,7 +199,7 @@ public:
 	 * Get the message type. By default, the type is 0x00.
 	 * @return The message type.
 	 */
-	int getType()
+	int getType() const
 	{
 		return m_iType;
 	}
@@ -210,6 +213,21 @@ public:
 		m_iType = type;
 	}
 
+	/**
+	 * Get the reception time. The CAN driver sets it from the hardware time stamp of
+	 * the frame if the controller supports it, else when reading the frame.
+	 * @return Seconds of CLOCK_MONOTONIC, see Neobotix::TimeStamp::MonotonicNow().
+	 */
+	double getStamp() const
+	{
+		return m_dStamp;
+	}
+
+	void setStamp(double stamp)
+	{
+		m_dStamp = stamp;
+	}
+
 
 };
 //-----------------------------------------------
@@ -5,11 +5,15 @@
 
 
 #include <cob_forcetorque/CanESD.h>
+#include <cob_forcetorque/CanDispatcher.h>
+#include <cob_forcetorque/SpscRing.h>
+#include <cob_forcetorque/TimeStamp.h>
 #include <Eigen/Core>
 #include <fstream>
+#include <pthread.h>
 
 //opCodes for the ForceTorque Can Interface
-//set as Can Message ID
+//set as Can Message ID, relative to READ_SG for sensors with another base id
 #define READ_SG 	0x200
 #define READ_MATRIX 	0x202
 #define READ_CALIB	0x205
@@ -18,16 +22,49 @@
 #define SET_BAUD	0x214
 #define READ_FIRMWARE	0x215
 
+/**
+ * One sample of the streaming mode.
+ */
+struct FTSample
+{
+	/// Fx, Fy, Fz, Tx, Ty, Tz
+	double dWrench[6];
+	/// Raw strain gauge values.
+	int iSG[6];
+	/// Status word of the sensor, 0 if ok.
+	int iStatus;
+	/// Reception of the last reply frame, seconds of CLOCK_MONOTONIC.
+	double dStamp;
+	/// Consecutive number, gaps mean samples were dropped.
+	unsigned int uiSeq;
+};
+
 class ForceTorqueCtrl
 {
 	public:	
+		/// Fixed sizes, so the per sample math is unrolled and never allocates.
+		typedef Eigen::Matrix<float, 6, 6> Matrix6f;
+		typedef Eigen::Matrix<float, 6, 1> Vector6f;
+
+		// m_mXCalibMatrix is a vectorizable fixed-size member
+		EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
 		ForceTorqueCtrl();
 		~ForceTorqueCtrl();
 
 		bool Init();
+		/**
+		 * Runs on a CAN interface shared with other devices instead of opening one.
+		 * Receives the identifiers iBaseID ... iBaseID + 0x1F, the sensor's base id
+		 * is 0x200 unless changed with SET_BASEID.
+		 */
+		bool Init(CanDispatcher* pDispatcher, int iBaseID = READ_SG);
 		void ReadFTSerialNumber();
 		void SetActiveCalibrationMatrix(int num);
-		void ReadSGData(double &Fx, double &Fy, double &Fz, double &Tx, double &Ty, double &Tz);
+		/// @return false if the reply was lost, the outputs are unchanged then.
+		bool ReadSGData(double &Fx, double &Fy, double &Fz, double &Tx, double &Ty, double &Tz);
+		/// Reception of the data of the last ReadSGData(), seconds of CLOCK_MONOTONIC.
+		double GetLastStamp() { return m_dLastStamp; }
 		void ReadFirmwareVersion();
 		void ReadCalibrationMatrix();
 
@@ -43,6 +80,36 @@ class ForceTorqueCtrl
 		void SetCalibMatrix();
 		void CalcCalibMatrix();
 		void StrainGaugeToForce(int& sg0, int& sg1, int& sg2, int& sg3, int& sg4, int& sg5);
+
+		/**
+		 * Converts iCount raw samples at once.
+		 * @param pSG iCount * 6 strain gauge values, sample after sample
+		 * @param pWrench receives iCount * 6 values Fx, Fy, Fz, Tx, Ty, Tz
+		 */
+		void StrainGaugeToForce(const int* pSG, double* pWrench, int iCount) const;
+
+		/**
+		 * Starts continuous acquisition on a dedicated (real-time if permitted) thread.
+		 * READ_SG requests are pipelined with iInFlight of them outstanding, so samples
+		 * arrive at the rate the bus and sensor allow instead of one per round trip.
+		 * The other Read* functions must not be used while streaming.
+		 * @param iInFlight number of outstanding requests, at most 8
+		 * @param iRingSize number of samples buffered for GetSample()
+		 */
+		bool StartStreaming(int iInFlight = 2, int iRingSize = 1024);
+		void StopStreaming();
+		bool IsStreaming() { return m_bStreaming; }
+
+		/**
+		 * Fetches the oldest buffered sample. Lock-free, call from one thread only.
+		 * @return false if no sample is available.
+		 */
+		bool GetSample(FTSample& Sample);
+
+		/// Samples lost because the consumer did not keep up.
+		unsigned long GetDroppedSamples() { return m_ulDropped; }
+		/// Times the sensor did not answer and the request pipeline was restarted.
+		unsigned long GetTimeOuts() { return m_ulTimeOuts; }
 	
 	protected:
 		void initCan();
@@ -51,22 +118,48 @@ class ForceTorqueCtrl
 		CanMsg CMsg;
 		CanItf* m_Can;
 		unsigned int d_len;
-		Eigen::VectorXf m_v3StrainGaigeOffset;
-		Eigen::VectorXf m_v3GaugeGain;
-		Eigen::VectorXf m_v3FXGain;
-		Eigen::VectorXf m_v3FYGain;
-		Eigen::VectorXf m_v3FZGain;
-		Eigen::VectorXf m_v3TXGain;
-		Eigen::VectorXf m_v3TYGain;
-		Eigen::VectorXf m_v3TZGain;
-		Eigen::MatrixXf m_mXCalibMatrix;
-		Eigen::MatrixXf m_vForceData;
+		Vector6f m_v3StrainGaigeOffset;
+		Vector6f m_v3GaugeGain;
+		Vector6f m_v3FXGain;
+		Vector6f m_v3FYGain;
+		Vector6f m_v3FZGain;
+		Vector6f m_v3TXGain;
+		Vector6f m_v3TYGain;
+		Vector6f m_v3TZGain;
+		/// Gains as loaded, one row per axis.
+		Matrix6f m_mXGainMatrix;
+		/// m_mXGainMatrix with the unit scale applied, the gauge offsets
+		/// folded into m_vForceOffset: wrench = matrix * sg - offset
+		Matrix6f m_mXCalibMatrix;
+		Vector6f m_vForceOffset;
+		Vector6f m_vForceData;
+		double m_dLastStamp;
 		
 		
 
 		// the Parameter indicates the Axis row to Read
 		// Fx = 0 | Fy = 1 | Fz = 2 | Tx = 3 | Ty = 4 | Tz = 5
-		void ReadMatrix(int axis, Eigen::VectorXf& vec);
+		void ReadMatrix(int axis, Vector6f& vec);
+
+		// CAN identifier of an opcode for the sensor's base id
+		int CanID(int iOpCode) const { return m_iBaseID + iOpCode - READ_SG; }
+		int m_iBaseID;
+
+		// receives the iCount frames answering a request
+		bool ReceiveReply(CanMsg* pReply, int iCount);
+
+		// precomputes m_mXCalibMatrix and m_vForceOffset
+		void UpdateCalibration();
+
+		static void* StreamThread(void* pArg);
+		void StreamLoop();
+
+		pthread_t m_StreamThread;
+		volatile bool m_bStreaming;
+		int m_iInFlight;
+		SpscRing<FTSample>* m_pSampleRing;
+		volatile unsigned long m_ulDropped;
+		volatile unsigned long m_ulTimeOuts;
 		
 
 		union
@@ -0,0 +1,97 @@
+#ifndef SPSCRING_INCLUDEDEF_H
+#define SPSCRING_INCLUDEDEF_H
+//-----------------------------------------------
+#include <cstddef>
+#include <vector>
+//-----------------------------------------------
+
+/**
+ * Bounded lock-free ring buffer for exactly one producer and one consumer thread.
+ * Neither side ever blocks or takes a lock: push() fails when the ring is full,
+ * pop() when it is empty.
+ */
+template <typename T>
+class SpscRing
+{
+public:
+	/**
+	 * @param iCapacity maximum number of elements held at once.
+	 */
+	SpscRing(size_t iCapacity)
+		: m_Buffer(iCapacity + 1), m_iHead(0), m_iTail(0)
+	{
+	}
+
+	/**
+	 * Appends an element. Producer thread only.
+	 * @return false if the ring is full, the element is not stored then.
+	 */
+	bool push(const T& Elem)
+	{
+		size_t iTail = m_iTail;
+		size_t iNext = increment(iTail);
+		if(iNext == load(m_iHead))
+			return false;
+		m_Buffer[iTail] = Elem;
+		store(m_iTail, iNext);
+		return true;
+	}
+
+	/**
+	 * Removes the oldest element. Consumer thread only.
+	 * @return false if the ring is empty.
+	 */
+	bool pop(T& Elem)
+	{
+		size_t iHead = m_iHead;
+		if(iHead == load(m_iTail))
+			return false;
+		Elem = m_Buffer[iHead];
+		store(m_iHead, increment(iHead));
+		return true;
+	}
+
+	/**
+	 * Number of stored elements, exact only when called by the producer or consumer.
+	 */
+	size_t size() const
+	{
+		size_t iHead = load(m_iHead), iTail = load(m_iTail);
+		return (iTail >= iHead) ? (iTail - iHead) : (iTail + m_Buffer.size() - iHead);
+	}
+
+	size_t capacity() const
+	{
+		return m_Buffer.size() - 1;
+	}
+
+private:
+	size_t increment(size_t i) const
+	{
+		return (++i == m_Buffer.size()) ? 0 : i;
+	}
+
+	// Full barriers around the index accesses; the toolchain predates <atomic>.
+	static size_t load(const volatile size_t& iIndex)
+	{
+		size_t iValue = iIndex;
+		__sync_synchronize();
+		return iValue;
+	}
+
+	static void store(volatile size_t& iIndex, size_t iValue)
+	{
+		__sync_synchronize();
+		iIndex = iValue;
+	}
+
+	std::vector<T> m_Buffer;
+	/// Written by the consumer only.
+	volatile size_t m_iHead;
+	/// Keeps head and tail on separate cache lines.
+	char m_cPad[64 - sizeof(size_t)];
+	/// Written by the producer only.
+	volatile size_t m_iTail;
+};
+//-----------------------------------------------
+#endif
@@ -34,6 +34,9 @@ class TimeStamp
 		/// Makes time measurement.
 		void SetNow();
 
+		/// Seconds of CLOCK_MONOTONIC, unaffected by adjustments of the system time.
+		static double MonotonicNow();
+
 		/// Retrieves time difference in seconds.
 		double operator- ( const TimeStamp& EarlierTime ) const;
 
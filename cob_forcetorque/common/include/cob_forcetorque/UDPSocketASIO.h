@@ -3,7 +3,16 @@
 #include <boost/bind.hpp>
 #include <boost/asio.hpp>
 #include "boost/date_time/posix_time/posix_time_types.hpp"
-#include "TimeStamp.h""
+#include <cstring>
+#include <cerrno>
+#include <map>
+#include <algorithm>
+#include <pthread.h>
+#include <stdint.h>
+#include <boost/array.hpp>
+#include "TimeStamp.h"
+#include "SpscRing.h"
+#include "Mutex.h"
 
 
 #ifndef UDPSOCKET_INCLUDEDEF_H
@@ -17,17 +26,50 @@ union DblBuf
 
 
 using boost::asio::ip::udp;
+
+// values older than this count as lost connection, in seconds
+static const double RCV_STALE_TIME = 0.1;
+
+/**
+ * Receives packets of doubles and keeps the latest values.
+ * The asio thread publishes every packet through a sequence lock, so readers
+ * on other threads never block it and never see half written values, and
+ * nothing is allocated per packet.
+ */
 class RCVServer
 {
 public:
+  enum { MAX_VALUES = 6 };
+
+  /// Latest received values.
+  struct Values
+  {
+    double dValues[MAX_VALUES];
+    /// number of valid entries of dValues
+    int iCount;
+    /// reception, seconds of CLOCK_MONOTONIC
+    double dStamp;
+    /// packet number, 0 before the first packet
+    unsigned long ulSeq;
+  };
+
   RCVServer(boost::asio::io_service& io_service, short port)
     : io_service_(io_service),
-      socket_(io_service, udp::endpoint(udp::v4(), port))
+      socket_(io_service, udp::endpoint(udp::v4(), port)),
+      m_uiSeqLock(0),
+      m_iWaiters(0)
   {
-    m_CurrentValues.push_back(0.0);
-    m_CurrentValues.push_back(0.0);
-    m_CurrentValues.push_back(0.0);
-   m_TimeStamp.SetNow();
+    memset(&m_Values, 0, sizeof(m_Values));
+    m_Values.iCount = 3;
+    m_Values.dStamp = Neobotix::TimeStamp::MonotonicNow();
+
+    pthread_mutex_init(&m_WaitMutex, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&m_WaitCond, &attr);
+    pthread_condattr_destroy(&attr);
+
     //    RCV_service = io_service;
     socket_.async_receive_from(
         boost::asio::buffer(data_, max_length), sender_endpoint_,
@@ -36,25 +78,40 @@ public:
           boost::asio::placeholders::bytes_transferred));
   }
 
+  ~RCVServer()
+  {
+    pthread_cond_destroy(&m_WaitCond);
+    pthread_mutex_destroy(&m_WaitMutex);
+  }
+
   boost::asio::io_service RCV_service;
 
 
   void handle_receive_from(const boost::system::error_code& error,
       size_t bytes_recvd)
   {
-    std::vector<double> v;
-    if(bytes_recvd >= 3*sizeof(double))
+    if(!error && bytes_recvd >= 3*sizeof(double))
     {
-        for(int i=0; i < 3; i++)
-        {
-            union DblBuf db;
-            for(int j=0;j<sizeof(double);j++)
-                db.buf[j] = data_[(j+i*sizeof(double))];
-            v.push_back(db.d);
-        }
-    }    
-    m_CurrentValues = v;
-	m_TimeStamp.SetNow();
+      int count = bytes_recvd / sizeof(double);
+      if(count > MAX_VALUES)
+        count = MAX_VALUES;
+
+      // odd while writing
+      __sync_fetch_and_add(&m_uiSeqLock, 1);
+      memcpy(m_Values.dValues, data_, count * sizeof(double));
+      m_Values.iCount = count;
+      m_Values.dStamp = Neobotix::TimeStamp::MonotonicNow();
+      m_Values.ulSeq++;
+      __sync_fetch_and_add(&m_uiSeqLock, 1);
+
+      if(m_iWaiters > 0)
+      {
+        pthread_mutex_lock(&m_WaitMutex);
+        pthread_cond_broadcast(&m_WaitCond);
+        pthread_mutex_unlock(&m_WaitMutex);
+      }
+    }
+
     if (!error && bytes_recvd > 0)
     {
       socket_.async_send_to(
@@ -82,21 +139,78 @@ public:
           boost::asio::placeholders::bytes_transferred));
   }
 
+  /**
+   * Copies the latest values, never blocks the receiving thread.
+   */
+  void getLatest(Values& values)
+  {
+    for(;;)
+    {
+      unsigned int seq = m_uiSeqLock;
+      __sync_synchronize();
+      if(seq & 1)
+        continue;
+      values = m_Values;
+      __sync_synchronize();
+      if(seq == m_uiSeqLock)
+        return;
+    }
+  }
+
+  /**
+   * Waits for values newer than the ones last returned.
+   * @param values holds the previous values (ulSeq 0 initially), receives the new ones
+   * @param timeout in seconds
+   * @return false on timeout, values are unchanged then
+   */
+  bool waitForNext(Values& values, double timeout)
+  {
+    unsigned long last = values.ulSeq;
+    Values latest;
+    getLatest(latest);
+    if(latest.ulSeq != last)
+    {
+      values = latest;
+      return true;
+    }
+
+    timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    long nsec = deadline.tv_nsec + (long)((timeout - (long)timeout) * 1e9);
+    deadline.tv_sec += (long)timeout + nsec / 1000000000;
+    deadline.tv_nsec = nsec % 1000000000;
+
+    pthread_mutex_lock(&m_WaitMutex);
+    __sync_fetch_and_add(&m_iWaiters, 1);
+    int ret = 0;
+    for(;;)
+    {
+      getLatest(latest);
+      if(latest.ulSeq != last || ret == ETIMEDOUT)
+        break;
+      ret = pthread_cond_timedwait(&m_WaitCond, &m_WaitMutex, &deadline);
+    }
+    __sync_fetch_and_sub(&m_iWaiters, 1);
+    pthread_mutex_unlock(&m_WaitMutex);
+
+    if(latest.ulSeq == last)
+      return false;
+    values = latest;
+    return true;
+  }
+
+  /**
+   * The first three values, zero if nothing was received for RCV_STALE_TIME.
+   */
   std::vector<double> getCurrentValues()
     {
-        std::vector<double> ret = m_CurrentValues;
-		Neobotix::TimeStamp curtime;
-		curtime.SetNow();	
-		if((curtime - m_TimeStamp)>0.1)
-		  {
-		    std::vector<double> zero;
-		    zero.push_back(0.0);
-		    zero.push_back(0.0);
-		    zero.push_back(0.0);
-		    m_CurrentValues = zero;
-		  }
+        Values values;
+        getLatest(values);
+        std::vector<double> ret(3, 0.0);
+        if((Neobotix::TimeStamp::MonotonicNow() - values.dStamp) <= RCV_STALE_TIME)
+          for(int i = 0; i < 3; i++)
+            ret[i] = values.dValues[i];
         return ret;
-
     }
   
   boost::asio::io_service& io_service_;
@@ -105,8 +219,13 @@ private:
   udp::endpoint sender_endpoint_;
   enum { max_length = 1024 };
   char data_[max_length];
-  std::vector<double> m_CurrentValues;
-  Neobotix::TimeStamp m_TimeStamp;
+  /// even while m_Values is consistent
+  volatile unsigned int m_uiSeqLock;
+  Values m_Values;
+  /// threads in waitForNext(), the receiver only signals if there are any
+  volatile int m_iWaiters;
+  pthread_mutex_t m_WaitMutex;
+  pthread_cond_t m_WaitCond;
 };
 
 
@@ -116,115 +235,296 @@ public:
   SNDServer(boost::asio::io_service& io_service,
       const boost::asio::ip::address& multicast_address, short port)
     : endpoint_(multicast_address, port),
-      socket_(io_service, udp::v4()),
-      timer_(io_service),
-      message_count_(0)
+      socket_(io_service, udp::v4())
   {
-    std::ostringstream os;
-    std::cout << "Message " << message_count_ << "\n";
-    os << "Message " << message_count_++;
-    message_ = os.str();
-
-    socket_.async_send_to(
-        boost::asio::buffer(message_), endpoint_,
-        boost::bind(&SNDServer::handle_send_to, this,
-          boost::asio::placeholders::error));
   }
 
-  void handle_send_to(const boost::system::error_code& error)
-  {
-    if (!error)
-    {
-      /*timer_.expires_from_now(boost::posix_time::seconds(1));
-      timer_.async_wait(
-          boost::bind(&SNDServer::handle_timeout, this,
-            boost::asio::placeholders::error));
-        */
-    }
-    else
+  // Sent synchronously, a UDP send doesn't wait for the receiver and the
+  // request buffer is only valid during the call.
+  void sendPose(double x, double y, double z)
     {
-        std::cout << "Send error\n";
+        double request[3] = { x, y, z };
+        send(request, sizeof(request));
     }
-  }
 
-  void handle_timeout(const boost::system::error_code& error)
-  {
-    if (!error)
+  void sendForce(double Fx, double Fy, double Fz, double Tx, double Ty, double Tz)
     {
-      std::ostringstream os;
-      std::cout << "Message " << message_count_ << "\n";
-      os << "Message " << message_count_++;
-      message_ = os.str();
-
-      socket_.async_send_to(
-          boost::asio::buffer(message_), endpoint_,
-          boost::bind(&SNDServer::handle_send_to, this,
-            boost::asio::placeholders::error));
+        double request[6] = { Fx, Fy, Fz, Tx, Ty, Tz };
+        send(request, sizeof(request));
     }
-    else
+
+private:
+  void send(const void* data, size_t length)
     {
-        std::cout << "error\n";
+      boost::system::error_code error;
+      socket_.send_to(boost::asio::buffer(data, length), endpoint_, 0, error);
+      if (error)
+        std::cout << "Send error: " << error.message() << "\n";
     }
+
+  boost::asio::ip::udp::endpoint endpoint_;
+  boost::asio::ip::udp::socket socket_;
+};
+
+
+/*
+ * Binary wrench streaming.
+ * A datagram is a WrenchPacketHeader followed by usCount WrenchSamples, all
+ * in host byte order (little endian on our machines), without padding.
+ */
+enum
+{
+  WRENCH_PACKET_MAGIC = 0x434e5257, // "WRNC"
+  WRENCH_PACKET_VERSION = 1,
+  // keeps a full packet below the Ethernet MTU
+  WRENCH_PACKET_MAX_SAMPLES = 16,
+  // samples further back than this are taken as a restart of the sender
+  WRENCH_REORDER_WINDOW = 64
+};
+
+struct WrenchPacketHeader
+{
+  uint32_t uiMagic;
+  uint16_t usVersion;
+  uint16_t usCount;
+  /// distinguishes the sensors streaming to one group
+  uint32_t uiSensorId;
+  /// consecutive datagram number of the sensor
+  uint32_t uiPacketSeq;
+};
+
+struct WrenchSample
+{
+  /// consecutive sample number of the sensor
+  uint32_t uiSeq;
+  /// sensor status word, 0 if ok
+  uint32_t uiStatus;
+  /// sample time, nanoseconds since the epoch
+  int64_t iStampNs;
+  /// Fx, Fy, Fz, Tx, Ty, Tz
+  double dWrench[6];
+};
+
+
+/**
+ * Sends wrench samples to a (multicast) group, batching up to a given number
+ * of samples per datagram. Sends are synchronous and never wait for receivers.
+ */
+class WrenchStreamer
+{
+public:
+  /**
+   * @param batch samples per datagram, at most WRENCH_PACKET_MAX_SAMPLES
+   * @param ttl multicast hops
+   */
+  WrenchStreamer(boost::asio::io_service& io_service,
+      const boost::asio::ip::address& address, short port,
+      uint32_t sensor_id, int batch = 1, int ttl = 1)
+    : endpoint_(address, port),
+      socket_(io_service, udp::v4()),
+      batch_(batch < 1 ? 1 : (batch > WRENCH_PACKET_MAX_SAMPLES ? WRENCH_PACKET_MAX_SAMPLES : batch)),
+      sent_(0),
+      errors_(0)
+  {
+    if (address.is_multicast())
+      socket_.set_option(boost::asio::ip::multicast::hops(ttl));
+    header_.uiMagic = WRENCH_PACKET_MAGIC;
+    header_.usVersion = WRENCH_PACKET_VERSION;
+    header_.usCount = 0;
+    header_.uiSensorId = sensor_id;
+    header_.uiPacketSeq = 0;
   }
-  void sendPose(double x, double y, double z)
+
+  /// Queues a sample, the datagram goes out once the batch is full.
+  void add(const WrenchSample& sample)
     {
-        char request[3*sizeof(double)] ;
-        union DblBuf db;
-        db.d = x;
-        for(int i = 0; i < sizeof(double);i++)
-            request[i] = db.buf[i];
-        db.d = y;
-        for(int i = 0; i < sizeof(double);i++)
-            request[i+sizeof(double)] = db.buf[i];
-        db.d = z;
-        for(int i = 0; i < sizeof(double);i++)
-            request[i+2*sizeof(double)] = db.buf[i];
-        size_t request_length = 3*sizeof(double);
-        
-
-        socket_.async_send_to(
-          boost::asio::buffer(request, request_length), endpoint_,
-          boost::bind(&SNDServer::handle_send_to, this,
-            boost::asio::placeholders::error));
+      samples_[header_.usCount++] = sample;
+      if (header_.usCount >= batch_)
+        flush();
     }
 
-  void sendForce(double Fx, double Fy, double Fz, double Tx, double Ty, double Tz)
+  /// Sends the queued samples right away, e.g. at the end of a control cycle.
+  void flush()
     {
-        char request[6*sizeof(double)] ;
-        union DblBuf db;
-        db.d = Fx;
-        for(int i = 0; i < sizeof(double);i++)
-	  request[i] = db.buf[i];
-        db.d = Fy;
-        for(int i = 0; i < sizeof(double);i++)
-	  request[i+sizeof(double)] = db.buf[i];
-        db.d = Fz;
-        for(int i = 0; i < sizeof(double);i++)
-	  request[i+2*sizeof(double)] = db.buf[i];
-	db.d = Tx;
-	for(int i = 0; i < sizeof(double);i++)
-	  request[i+3*sizeof(double)] = db.buf[i];
-	db.d = Ty;
-	for(int i = 0; i < sizeof(double);i++)
-	  request[i+4*sizeof(double)] = db.buf[i];
-	db.d = Tz;
-	for(int i = 0; i < sizeof(double);i++)
-	  request[i+5*sizeof(double)] = db.buf[i];
-        size_t request_length = 6*sizeof(double);
-        
-
-        socket_.async_send_to(
-          boost::asio::buffer(request, request_length), endpoint_,
-          boost::bind(&SNDServer::handle_send_to, this,
-            boost::asio::placeholders::error));
+      if (header_.usCount == 0)
+        return;
+
+      boost::array<boost::asio::const_buffer, 2> buffers = {{
+        boost::asio::buffer(&header_, sizeof(header_)),
+        boost::asio::buffer(samples_, header_.usCount * sizeof(WrenchSample)) }};
+      boost::system::error_code error;
+      socket_.send_to(buffers, endpoint_, 0, error);
+      if (error)
+        errors_++;
+      else
+        sent_++;
+
+      header_.uiPacketSeq++;
+      header_.usCount = 0;
     }
 
+  unsigned long getSentPackets() const { return sent_; }
+  unsigned long getSendErrors() const { return errors_; }
+
 private:
   boost::asio::ip::udp::endpoint endpoint_;
   boost::asio::ip::udp::socket socket_;
-  boost::asio::deadline_timer timer_;
-  int message_count_;
-  std::string message_;
+  int batch_;
+  WrenchPacketHeader header_;
+  WrenchSample samples_[WRENCH_PACKET_MAX_SAMPLES];
+  unsigned long sent_;
+  unsigned long errors_;
+};
+
+
+/**
+ * Receives the datagrams of WrenchStreamers on the asio thread and queues the
+ * samples for one consumer thread, lock-free. Keeps loss and reordering
+ * statistics per sensor, based on the sample numbers.
+ */
+class WrenchReceiver
+{
+public:
+  struct Received
+  {
+    uint32_t uiSensorId;
+    WrenchSample Sample;
+  };
+
+  struct Statistics
+  {
+    unsigned long ulReceived;
+    /// missing sample numbers, late samples are taken off again
+    unsigned long ulLost;
+    /// samples older than one received before, by less than WRENCH_REORDER_WINDOW
+    unsigned long ulReordered;
+    /// larger jumps back, e.g. the sender restarted; counting starts over there
+    unsigned long ulResets;
+    /// samples that didn't fit into the queue
+    unsigned long ulDropped;
+    uint32_t uiNextSeq;
+  };
+
+  /**
+   * @param group multicast group to join, or any unicast address to listen on
+   */
+  WrenchReceiver(boost::asio::io_service& io_service,
+      const boost::asio::ip::address& group, short port, size_t queue_size = 1024)
+    : socket_(io_service),
+      queue_(queue_size),
+      invalid_(0)
+  {
+    udp::endpoint listen_endpoint(boost::asio::ip::address_v4::any(), port);
+    socket_.open(listen_endpoint.protocol());
+    socket_.set_option(udp::socket::reuse_address(true));
+    socket_.bind(listen_endpoint);
+    if (group.is_multicast())
+      socket_.set_option(boost::asio::ip::multicast::join_group(group));
+    receive();
+  }
+
+  /// Oldest queued sample, never blocks. Call from one thread only.
+  bool pop(Received& received) { return queue_.pop(received); }
+
+  /// Statistics of one sensor, false if nothing was received from it.
+  bool getStatistics(uint32_t sensor_id, Statistics& stats)
+    {
+      stats_mutex_.lock();
+      std::map<uint32_t, Statistics>::const_iterator it = stats_.find(sensor_id);
+      bool found = (it != stats_.end());
+      if (found)
+        stats = it->second;
+      stats_mutex_.unlock();
+      return found;
+    }
+
+  /// Datagrams that weren't wrench packets.
+  unsigned long getInvalidPackets() const { return invalid_; }
+
+private:
+  void receive()
+    {
+      socket_.async_receive_from(
+          boost::asio::buffer(data_, sizeof(data_)), sender_endpoint_,
+          boost::bind(&WrenchReceiver::handle_receive_from, this,
+            boost::asio::placeholders::error,
+            boost::asio::placeholders::bytes_transferred));
+    }
+
+  void handle_receive_from(const boost::system::error_code& error, size_t bytes_recvd)
+    {
+      if (error)
+      {
+        if (error != boost::asio::error::operation_aborted)
+          receive();
+        return;
+      }
+
+      WrenchPacketHeader header;
+      memcpy(&header, data_, std::min(bytes_recvd, sizeof(header)));
+      if (bytes_recvd < sizeof(header) || header.uiMagic != WRENCH_PACKET_MAGIC ||
+          header.usVersion != WRENCH_PACKET_VERSION || header.usCount > WRENCH_PACKET_MAX_SAMPLES ||
+          bytes_recvd < sizeof(header) + header.usCount * sizeof(WrenchSample))
+      {
+        invalid_++;
+        receive();
+        return;
+      }
+
+      stats_mutex_.lock();
+      std::map<uint32_t, Statistics>::iterator it = stats_.find(header.uiSensorId);
+      if (it == stats_.end())
+      {
+        Statistics init = { 0, 0, 0, 0, 0, 0 };
+        it = stats_.insert(std::make_pair(header.uiSensorId, init)).first;
+      }
+      Statistics& stats = it->second;
+      bool first = (stats.ulReceived == 0);
+
+      Received received;
+      received.uiSensorId = header.uiSensorId;
+      for (int i = 0; i < header.usCount; i++)
+      {
+        memcpy(&received.Sample, data_ + sizeof(header) + i * sizeof(WrenchSample), sizeof(WrenchSample));
+        uint32_t seq = received.Sample.uiSeq;
+        // signed distance, correct across the wrap around
+        int32_t ahead = (int32_t)(seq - stats.uiNextSeq);
+        if (first || ahead >= 0)
+        {
+          if (!first)
+            stats.ulLost += ahead;
+          stats.uiNextSeq = seq + 1;
+          first = false;
+        }
+        else if (ahead > -WRENCH_REORDER_WINDOW)
+        {
+          stats.ulReordered++;
+          if (stats.ulLost > 0)
+            stats.ulLost--;
+        }
+        else
+        {
+          stats.ulResets++;
+          stats.uiNextSeq = seq + 1;
+        }
+        stats.ulReceived++;
+
+        if (!queue_.push(received))
+          stats.ulDropped++;
+      }
+      stats_mutex_.unlock();
+
+      receive();
+    }
+
+  udp::socket socket_;
+  udp::endpoint sender_endpoint_;
+  char data_[sizeof(WrenchPacketHeader) + WRENCH_PACKET_MAX_SAMPLES * sizeof(WrenchSample)];
+  SpscRing<Received> queue_;
+  std::map<uint32_t, Statistics> stats_;
+  /// guards stats_ against getStatistics()
+  Mutex stats_mutex_;
+  unsigned long invalid_;
 };
 
 
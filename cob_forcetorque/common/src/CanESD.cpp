@@ -7,13 +7,54 @@
 //-----------------------------------------------
 //#include "stdafx.h"
 #include <cob_forcetorque/CanESD.h>
+#include <sched.h>
+#include <unistd.h>
+
+// the receive thread checks for stopRxThread() at least this often
+static const int RX_THREAD_TIMEOUT_MS = 100;
+// messages per canRead/canWrite of the batch functions and the receive thread
+static const int MSG_BATCH = 16;
+// receiveMsgRetry waits this long per retry
+static const int RX_RETRY_INTERVAL_MS = 10;
+// how fast the mapping of hardware time stamps follows a drift of the clocks
+static const double TS_OFFSET_GAIN = 0.001;
+
+#ifdef NTCAN_MODE_TIMESTAMPED
+#define CANESD_HW_TIMESTAMPS
+#endif
 
+//-----------------------------------------------
+static void toNTCAN(const CanMsg& CMsg, CMSG& NTCANMsg)
+{
+	NTCANMsg.id = CMsg.m_iID;
+	NTCANMsg.len = CMsg.m_iLen;
+	for(int i=0; i<8; i++)
+		NTCANMsg.data[i] = CMsg.getAt(i);
+}
+
+//-----------------------------------------------
+template <class T>
+static void fromNTCAN(const T& NTCANMsg, CanMsg* pCMsg)
+{
+	pCMsg->m_iID = NTCANMsg.id;
+	pCMsg->m_iLen = NTCANMsg.len;
+	pCMsg->set(NTCANMsg.data[0], NTCANMsg.data[1], NTCANMsg.data[2], NTCANMsg.data[3],
+		NTCANMsg.data[4], NTCANMsg.data[5], NTCANMsg.data[6], NTCANMsg.data[7]);
+}
 
 //-----------------------------------------------
 CanESD::CanESD(const char* cIniFile, bool bObjectMode)
 {
 	m_bObjectMode = bObjectMode;
 	m_bIsTXError = false;
+	m_bRxThreadRunning = false;
+	m_ulRxUnhandled = 0;
+	m_bHwTimeStamps = false;
+	m_dTsFreq = 0;
+	m_dTsOffset = 0;
+	m_bTsOffsetValid = false;
+	for(int i = 0; i < 0x800; i++)
+		m_pRxHandler[i] = NULL;
 	//m_IniFile.SetFileName(cIniFile, "CanESD.cpp");
 	initIntern();
 }
@@ -25,6 +66,7 @@ CanESD::CanESD(const char* cIniFile, bool bObjectMode)
  */
 CanESD::~CanESD()
 {
+	stopRxThread();
 	std::cout << "Closing CAN handle" << std::endl;
 	canClose(m_Handle);
 	//~CanItf();
@@ -66,16 +108,33 @@ void CanESD::initIntern()
 	std::cout << "Initializing CAN network with id =" << iCanNet << ", baudrate=" << iBaudrateVal << std::endl;
 
 	int iRet;
+	// canRead blocks without timeout unless receiveMsgTimeout() sets one
+	m_iRxTimeOut = 0;
 	if( m_bObjectMode )
 		//iRet = canOpen(iCanNet, NTCAN_MODE_OBJECT, 10000, 10000, 0, 0, &m_Handle);
 		iRet = canOpen(iCanNet, NTCAN_MODE_OBJECT, 10000, 10000, 1000, 0, &m_Handle);
 	else
+	{
 		//iRet = canOpen(iCanNet, 0, 10000, 10000, 0, 0, &m_Handle);
-		iRet = canOpen(iCanNet, 0, 10000, 10000, 1000, 0, &m_Handle);
-	sleep(0.3);
+#ifdef CANESD_HW_TIMESTAMPS
+		// controllers without time stamps refuse the mode
+		iRet = canOpen(iCanNet, NTCAN_MODE_TIMESTAMPED, 10000, 10000, 1000, 0, &m_Handle);
+		if(iRet == NTCAN_SUCCESS)
+		{
+			uint64_t freq = 0;
+			if( (canIoctl(m_Handle, NTCAN_IOCTL_GET_TIMESTAMP_FREQ, &freq) == NTCAN_SUCCESS) && (freq > 0) )
+			{
+				m_bHwTimeStamps = true;
+				m_dTsFreq = (double)freq;
+			}
+		}
+		else
+#endif
+			iRet = canOpen(iCanNet, 0, 10000, 10000, 1000, 0, &m_Handle);
+	}
 
 	if(iRet == NTCAN_SUCCESS)
-		std::cout << "CanESD::CanESD(), init ok" << std::endl;
+		std::cout << "CanESD::CanESD(), init ok" << (m_bHwTimeStamps ? ", hardware time stamps" : "") << std::endl;
 	else
 		std::cout << "error in CANESD::receiveMsg: " << GetErrorStr(iRet) << std::endl;
 
@@ -100,7 +159,6 @@ void CanESD::initIntern()
 		std::cout << "CanESD::CanESD(), canSetBaudrate ok" << std::endl;
 	else
 		std::cout << "error in CANESD::receiveMsg: " << GetErrorStr(iRet) << std::endl;
-	sleep(0.3);
 
 	long lArg;
 	iRet = canIoctl(m_Handle, NTCAN_IOCTL_FLUSH_RX_FIFO, NULL);
@@ -193,7 +251,6 @@ void CanESD::initIntern()
 		}
 	}
 */
-	sleep(0.3);
 
 	m_LastID = -1;
 
@@ -207,7 +264,7 @@ void CanESD::initIntern()
  * @param CMsg Structure containing the CAN message.
  * @return true on success, false on failure.
  */
-bool CanESD::transmitMsg(CanMsg CMsg, bool bBlocking)
+bool CanESD::transmitMsg(const CanMsg& CMsg, bool bBlocking)
 {
 	CMSG NTCANMsg;
 	NTCANMsg.id = CMsg.m_iID;
@@ -252,76 +309,68 @@ bool CanESD::transmitMsg(CanMsg CMsg, bool bBlocking)
 //-----------------------------------------------
 bool CanESD::receiveMsgRetry(CanMsg* pCMsg, int iNrOfRetry)
 {
-	int id = pCMsg->m_iID;
+	if( iNrOfRetry < 1 )
+		iNrOfRetry = 1;
+
+	// sleep in the driver until a message arrives instead of polling
+	if( !isObjectMode() )
+		return receiveMsgTimeout(pCMsg, iNrOfRetry * RX_RETRY_INTERVAL_MS);
+
+	// objects are not queued, poll the latest one
 	CMSG NTCANMsg;
-	NTCANMsg.len = 8;
-	
-	//long len;
 	int32_t len;
-	int i, ret;
-	bool bRet = true;
-	
-	i=0;
-	
-	len = 1;
-	//NTCANMsg.id = pCMsg->m_iID;
-	//ret = canTake(m_Handle, &NTCANMsg, &len);
-	/**/
+	int i = 0, ret;
+
+	NTCANMsg.id = pCMsg->m_iID;
 	do
 	{
 		len = 1;
-		//m_Mutex.lock();
 		ret = canTake(m_Handle, &NTCANMsg, &len);
-		//m_Mutex.unlock();
-		//if( NTCANMsg.id == id ) break;
-		i++;
-		sleep(0.01);
+		if( (ret == NTCAN_SUCCESS) && (len == 1) )
+			break;
+		usleep(RX_RETRY_INTERVAL_MS * 1000);
 	}
-	//while((len != 1) && (i < iNrOfRetry));
-	//while((len != 1) && (i < iNrOfRetry));
-	while((len == 0) && (i < iNrOfRetry));
-	/**/
-	
-	//if((i == iNrOfRetry) || (ret != NTCAN_SUCCESS ))
+	while( ++i < iNrOfRetry );
+
 	if(i == iNrOfRetry)
-	//if( (ret != NTCAN_SUCCESS) || (len & 0x10) || (len == 0) )
 	{
 		if( ret != NTCAN_SUCCESS )
 			std::cout << "error in CANESD::receiveMsgRetry: " << GetErrorStr(ret) << std::endl;
-		//std::cout << "PCan:ReceiveMessage error, msg id= " << m_LastID << std::endl;
-		//std::cout.unsetf(std::ios::dec);
-		//std::cout.setf(std::ios::hex);
-		//std::cout << "PCan:ReceiveMessage error, msg id= " << pCMsg->m_iID << std::endl;
-		//std::cout.unsetf(std::ios::hex);
-		//std::cout.setf(std::ios::dec);
-		bRet = false;
+		return false;
 	}
-	else
-	{
-		pCMsg->m_iID = NTCANMsg.id;
-		pCMsg->m_iLen = NTCANMsg.len;
-		pCMsg->set(NTCANMsg.data[0], NTCANMsg.data[1], NTCANMsg.data[2], NTCANMsg.data[3],
-			NTCANMsg.data[4], NTCANMsg.data[5], NTCANMsg.data[6], NTCANMsg.data[7]);
-	}
-		
-	//readEvent();
 
-	return bRet;
+	fromNTCAN(NTCANMsg, pCMsg);
+	pCMsg->setStamp(Neobotix::TimeStamp::MonotonicNow());
+	return true;
 }
 
 //-----------------------------------------------
 bool CanESD::receiveMsg(CanMsg* pCMsg)
 {
-	CMSG NTCANMsg;
-	NTCANMsg.len = 8;
-
 	int ret;
 	//long len;
 	int32_t len;
-	bool bRet = true;
 	
 	len = 1;
 
+	if( !isObjectMode() ) {
+		// blocking read as opened, receiveMsgTimeout() may have changed it
+		setRxTimeOut(0);
+
+		ret = readMsgs(pCMsg, &len, true);
+		if( (len == 1) && (ret == NTCAN_SUCCESS) )
+			return true;
+
+		// no message
+		if( ret != NTCAN_SUCCESS)
+			std::cout << "error in CANESD::receiveMsg: " << GetErrorStr(ret) << std::endl;
+		pCMsg->m_iID = 0;
+		pCMsg->set(0,0,0,0,0,0,0,0);
+		return false;
+	}
+
+	CMSG NTCANMsg;
+
 	// Debug valgrind
 	NTCANMsg.data[0] = 0;
 	NTCANMsg.data[1] = 0;
@@ -332,62 +381,25 @@ bool CanESD::receiveMsg(CanMsg* pCMsg)
 	NTCANMsg.data[6] = 0;
 	NTCANMsg.data[7] = 0;
 	NTCANMsg.msg_lost = 0;
-	NTCANMsg.id = 0;
 	NTCANMsg.len = 0;
+	NTCANMsg.id = pCMsg->m_iID;
 
 	pCMsg->set(0,0,0,0,0,0,0,0);
 
-	
-	if( !isObjectMode() ) {
-		pCMsg->m_iID = 0;
-	} else {
-		NTCANMsg.id = pCMsg->m_iID;
-	}
-
 	//m_Mutex.lock();
 	ret = canRead(m_Handle, &NTCANMsg, &len, NULL);
 	//m_Mutex.unlock();
 
-	if( !isObjectMode() ) {
-		if( (len == 1) && (ret == NTCAN_SUCCESS) )
-		{
-			// message received
-			pCMsg->m_iID = NTCANMsg.id;
-			pCMsg->m_iLen = NTCANMsg.len;
-			pCMsg->set(NTCANMsg.data[0], NTCANMsg.data[1], NTCANMsg.data[2], NTCANMsg.data[3],
-				NTCANMsg.data[4], NTCANMsg.data[5], NTCANMsg.data[6], NTCANMsg.data[7]);
-			bRet = true;
-		}
-		else
-		{
-			// no message
-			if( ret != NTCAN_SUCCESS)
-			{
-				// error
-				std::cout << "error in CANESD::receiveMsg: " << GetErrorStr(ret) << std::endl;
-			}
-	
-			pCMsg->m_iID = NTCANMsg.id;
-			pCMsg->set(0,0,0,0,0,0,0,0);
-	
-//			std::cout << "len=" << len << "; ret = " << GetErrorStr(ret) << std::endl;
-			bRet = false;
-		}
-	} else {
-		//std::cout << "ID=" << NTCANMsg.id << "; len=" << (int)len << std::endl;
-		if( len == 16 ) {
-			// No message was received yet.
-			pCMsg->m_iID = NTCANMsg.id;
-			pCMsg->set(0,0,0,0,0,0,0,0);
-			bRet = false;
-		} else {
-			pCMsg->m_iID = NTCANMsg.id;
-			pCMsg->m_iLen = NTCANMsg.len;
-			pCMsg->set(NTCANMsg.data[0], NTCANMsg.data[1], NTCANMsg.data[2], NTCANMsg.data[3],
-				   NTCANMsg.data[4], NTCANMsg.data[5], NTCANMsg.data[6], NTCANMsg.data[7]);
-			bRet = true;
-		}
+	//std::cout << "ID=" << NTCANMsg.id << "; len=" << (int)len << std::endl;
+	if( len == 16 ) {
+		// No message was received yet.
+		pCMsg->m_iID = NTCANMsg.id;
+		pCMsg->set(0,0,0,0,0,0,0,0);
+		return false;
 	}
+
+	fromNTCAN(NTCANMsg, pCMsg);
+	pCMsg->setStamp(Neobotix::TimeStamp::MonotonicNow());
 	
 	if( NTCANMsg.msg_lost != 0 )
 		std::cout << (int)(NTCANMsg.msg_lost) << " messages lost!" << std::endl;
@@ -400,9 +412,307 @@ bool CanESD::receiveMsg(CanMsg* pCMsg)
 	if( status == NTCAN_SUCCESS )
 		std::cout << (int)(lArg) << " messages in CAN receive queue" << std::endl;
 	*/
-	return bRet;
+	return true;
+}
+
+
+//-----------------------------------------------
+bool CanESD::receiveMsgTimeout(CanMsg* pCMsg, int iTimeOutMs)
+{
+	if( isObjectMode() || !setRxTimeOut(iTimeOutMs) )
+		return false;
+
+	int32_t len = 1;
+	int ret = readMsgs(pCMsg, &len, true);
+
+	if( (ret != NTCAN_SUCCESS) || (len != 1) )
+	{
+		if( (ret != NTCAN_SUCCESS) && (ret != NTCAN_RX_TIMEOUT) )
+			std::cout << "error in CANESD::receiveMsgTimeout: " << GetErrorStr(ret) << std::endl;
+		return false;
+	}
+	return true;
+}
+
+//-----------------------------------------------
+/**
+ * Read up to *pLen (at most MSG_BATCH) messages in FIFO mode, with their time stamps.
+ * @param bWait wait for the first message as set by setRxTimeOut(), or return right away.
+ * @return NTCAN status, *pLen is set to the number of messages read.
+ */
+int CanESD::readMsgs(CanMsg* pCMsg, int32_t* pLen, bool bWait)
+{
+	int ret;
+	double dReadTime;
+
+#ifdef CANESD_HW_TIMESTAMPS
+	if( m_bHwTimeStamps )
+	{
+		CMSG_T NTCANMsg[MSG_BATCH];
+		if( bWait )
+			ret = canReadT(m_Handle, NTCANMsg, pLen, NULL);
+		else
+			ret = canTakeT(m_Handle, NTCANMsg, pLen);
+		dReadTime = Neobotix::TimeStamp::MonotonicNow();
+		if( (ret != NTCAN_SUCCESS) || (*pLen == 0) )
+			return ret;
+
+		// the last frame waited least for being read
+		updateTsOffset(NTCANMsg[*pLen - 1].timestamp, dReadTime);
+		for( int i = 0; i < *pLen; i++ )
+		{
+			fromNTCAN(NTCANMsg[i], &pCMsg[i]);
+			pCMsg[i].setStamp(NTCANMsg[i].timestamp / m_dTsFreq + m_dTsOffset);
+			if( NTCANMsg[i].msg_lost != 0 )
+				std::cout << (int)(NTCANMsg[i].msg_lost) << " messages lost!" << std::endl;
+		}
+		return ret;
+	}
+#endif
+
+	CMSG NTCANMsg[MSG_BATCH];
+	if( bWait )
+		ret = canRead(m_Handle, NTCANMsg, pLen, NULL);
+	else
+		ret = canTake(m_Handle, NTCANMsg, pLen);
+	dReadTime = Neobotix::TimeStamp::MonotonicNow();
+	if( ret != NTCAN_SUCCESS )
+		return ret;
+
+	for( int i = 0; i < *pLen; i++ )
+	{
+		fromNTCAN(NTCANMsg[i], &pCMsg[i]);
+		pCMsg[i].setStamp(dReadTime);
+		if( NTCANMsg[i].msg_lost != 0 )
+			std::cout << (int)(NTCANMsg[i].msg_lost) << " messages lost!" << std::endl;
+	}
+	return ret;
+}
+
+//-----------------------------------------------
+/**
+ * Track the offset between the time stamp counter of the controller and CLOCK_MONOTONIC.
+ * A frame is always read after its reception, so the smallest difference seen is the
+ * best estimate; it is slowly relaxed towards newer differences to follow clock drift.
+ */
+void CanESD::updateTsOffset(uint64_t iTimeStamp, double dReadTime)
+{
+	double dOffset = dReadTime - iTimeStamp / m_dTsFreq;
+	if( !m_bTsOffsetValid || (dOffset < m_dTsOffset) )
+		m_dTsOffset = dOffset;
+	else
+		m_dTsOffset += TS_OFFSET_GAIN * (dOffset - m_dTsOffset);
+	m_bTsOffsetValid = true;
+}
+
+//-----------------------------------------------
+/**
+ * Transmit several messages, MSG_BATCH of them per driver call.
+ * The error flag is set as in transmitMsg().
+ */
+int CanESD::transmitMsgs(const CanMsg* pCMsg, int iCount, bool bBlocking)
+{
+	CMSG NTCANMsg[MSG_BATCH];
+	int iSent = 0;
+
+	while( iSent < iCount )
+	{
+		int32_t len = iCount - iSent;
+		if( len > MSG_BATCH )
+			len = MSG_BATCH;
+		for( int i = 0; i < len; i++ )
+			toNTCAN(pCMsg[iSent + i], NTCANMsg[i]);
+
+		int32_t iRequested = len;
+		int ret;
+		if (bBlocking)
+			ret = canWrite(m_Handle, NTCANMsg, &len, NULL);
+		else
+			ret = canSend(m_Handle, NTCANMsg, &len);
+
+		if( ret != NTCAN_SUCCESS )
+		{
+			std::cout << "error in CANESD::transmitMsgs: " << GetErrorStr(ret) << std::endl;
+			m_bIsTXError = true;
+			return iSent;
+		}
+		iSent += len;
+		m_LastID = (int)NTCANMsg[len - 1].data[0];
+		// transmit queue full
+		if( len < iRequested )
+			break;
+	}
+
+	m_bIsTXError = false;
+	return iSent;
+}
+
+//-----------------------------------------------
+/**
+ * The first canRead waits for a message, everything else already queued
+ * is fetched without waiting.
+ */
+int CanESD::receiveMsgs(CanMsg* pCMsg, int iMaxCount, int iTimeOutMs)
+{
+	if( isObjectMode() || !setRxTimeOut(iTimeOutMs) )
+		return -1;
+
+	int iReceived = 0;
+
+	while( iReceived < iMaxCount )
+	{
+		int32_t len = iMaxCount - iReceived;
+		if( len > MSG_BATCH )
+			len = MSG_BATCH;
+		int32_t iRequested = len;
+
+		int ret = readMsgs(pCMsg + iReceived, &len, iReceived == 0);
+
+		if( ret != NTCAN_SUCCESS )
+		{
+			if( ret != NTCAN_RX_TIMEOUT )
+			{
+				std::cout << "error in CANESD::receiveMsgs: " << GetErrorStr(ret) << std::endl;
+				// report the error unless there are messages to hand out
+				if( iReceived == 0 )
+					return -1;
+			}
+			break;
+		}
+
+		iReceived += len;
+		// queue drained
+		if( len < iRequested )
+			break;
+	}
+	return iReceived;
+}
+
+//-----------------------------------------------
+/**
+ * Set the timeout of canRead, skipping the ioctl if it is already in effect.
+ * @param iTimeOutMs timeout in milliseconds, 0 blocks indefinitely.
+ * @return true on success.
+ */
+bool CanESD::setRxTimeOut(int iTimeOutMs)
+{
+	if( iTimeOutMs == m_iRxTimeOut )
+		return true;
+
+	int32_t timeout = iTimeOutMs;
+	int ret = canIoctl(m_Handle, NTCAN_IOCTL_SET_RX_TIMEOUT, &timeout);
+	if( ret != NTCAN_SUCCESS )
+	{
+		std::cout << "error in CANESD::setRxTimeOut: " << GetErrorStr(ret) << std::endl;
+		return false;
+	}
+	m_iRxTimeOut = iTimeOutMs;
+	return true;
 }
 
+//-----------------------------------------------
+bool CanESD::addRxHandler(int iID, CanRxHandler* pHandler)
+{
+	if( (iID < 0) || (iID >= 0x800) )
+	{
+		std::cout << "error in CANESD::addRxHandler: invalid id " << iID << std::endl;
+		return false;
+	}
+	m_pRxHandler[iID] = pHandler;
+	return true;
+}
+
+//-----------------------------------------------
+void CanESD::removeRxHandler(int iID)
+{
+	if( (iID >= 0) && (iID < 0x800) )
+		m_pRxHandler[iID] = NULL;
+}
+
+//-----------------------------------------------
+bool CanESD::startRxThread(int iPriority)
+{
+	if( m_bRxThreadRunning )
+		return true;
+	if( isObjectMode() )
+	{
+		std::cout << "error in CANESD::startRxThread: not available in object mode" << std::endl;
+		return false;
+	}
+	// set here, so a failure is reported instead of ending the thread unjoined
+	if( !setRxTimeOut(RX_THREAD_TIMEOUT_MS) )
+	{
+		std::cout << "error in CANESD::startRxThread: could not set the receive timeout" << std::endl;
+		return false;
+	}
+
+	m_bRxThreadRunning = true;
+	if( pthread_create(&m_RxThread, NULL, rxThread, this) != 0 )
+	{
+		std::cout << "error in CANESD::startRxThread: could not create thread" << std::endl;
+		m_bRxThreadRunning = false;
+		return false;
+	}
+
+	if( iPriority > 0 )
+	{
+		sched_param Param;
+		Param.sched_priority = iPriority;
+		if( pthread_setschedparam(m_RxThread, SCHED_FIFO, &Param) != 0 )
+			std::cout << "CanESD::startRxThread(), no real-time priority for the receive thread" << std::endl;
+	}
+	return true;
+}
+
+//-----------------------------------------------
+void CanESD::stopRxThread()
+{
+	if( !m_bRxThreadRunning )
+		return;
+	// noticed after at most RX_THREAD_TIMEOUT_MS
+	m_bRxThreadRunning = false;
+	pthread_join(m_RxThread, NULL);
+}
+
+//-----------------------------------------------
+void* CanESD::rxThread(void* pArg)
+{
+	((CanESD*)pArg)->rxLoop();
+	return NULL;
+}
+
+//-----------------------------------------------
+void CanESD::rxLoop()
+{
+	CanMsg CMsg[MSG_BATCH];
+
+	while( m_bRxThreadRunning )
+	{
+		int32_t len = MSG_BATCH;
+		int ret = readMsgs(CMsg, &len, true);
+		if( ret != NTCAN_SUCCESS )
+		{
+			if( ret != NTCAN_RX_TIMEOUT )
+			{
+				std::cout << "error in CANESD::rxLoop: " << GetErrorStr(ret) << std::endl;
+				// don't spin on a persistent error
+				usleep(RX_THREAD_TIMEOUT_MS * 1000);
+			}
+			continue;
+		}
+
+		for( int i = 0; i < len; i++ )
+		{
+			CanRxHandler* pHandler = m_pRxHandler[CMsg[i].getID() & 0x7FF];
+			if( pHandler == NULL )
+			{
+				m_ulRxUnhandled++;
+				continue;
+			}
+			pHandler->handleMsg(CMsg[i]);
+		}
+	}
+}
 
 /*!
     \fn CanESD::canIdAddGroup(m_Handle, int id, int number)
@@ -1,13 +1,31 @@
 #include <cob_forcetorque/ForceTorqueCtrl.h>
 #include <unistd.h>
+#include <sched.h>
+
+// Without a reply for this long the outstanding requests count as lost
+static const int STREAM_TIMEOUT_MS = 50;
+static const int STREAM_PRIORITY = 80;
+// upper bound of the requests pipelined by the streaming thread
+static const int STREAM_MAX_IN_FLIGHT = 8;
+// waiting time for each part of a reply to a single request
+static const int REPLY_TIMEOUT_MS = 1000;
 
 ForceTorqueCtrl::ForceTorqueCtrl()
+	: m_Can(NULL), m_dLastStamp(0), m_iBaseID(READ_SG), m_bStreaming(false), m_iInFlight(2), m_pSampleRing(NULL),
+	  m_ulDropped(0), m_ulTimeOuts(0)
 {
+	m_v3StrainGaigeOffset.setZero();
+	m_v3GaugeGain.setOnes();
+	m_mXGainMatrix.setZero();
+	UpdateCalibration();
 	out.open("force.txt"); 
 }
 
 ForceTorqueCtrl::~ForceTorqueCtrl()
 { 
+	StopStreaming();
+	delete m_pSampleRing;
+	delete m_Can;
 }
 
 bool ForceTorqueCtrl::Init()
@@ -17,6 +35,13 @@ bool ForceTorqueCtrl::Init()
 	//ReadCalibrationMatrix();
 }
 
+bool ForceTorqueCtrl::Init(CanDispatcher* pDispatcher, int iBaseID)
+{
+	m_iBaseID = iBaseID;
+	m_Can = pDispatcher->openPort(iBaseID, iBaseID + 0x1F);
+	return true;
+}
+
 void ForceTorqueCtrl::initCan()
 {	
 	std::cout << "initESDCan" << std::endl;
@@ -27,7 +52,7 @@ void ForceTorqueCtrl::ReadFTSerialNumber()
 {	
 	std::cout << "\n\n*********CheckCalMatrix**********" << std::endl;
 	CanMsg CMsg;
-	CMsg.setID(0x205);
+	CMsg.setID(CanID(READ_CALIB));
 	CMsg.setLength(0);
 
 	bool ret = m_Can->transmitMsg(CMsg, true);
@@ -38,7 +63,8 @@ void ForceTorqueCtrl::ReadFTSerialNumber()
 	replyMsg.set(0,2);
 	replyMsg.set(0,3);
 	replyMsg.set(0,4);
-	bool ret2 = m_Can->receiveMsg(&replyMsg);
+	if(!ReceiveReply(&replyMsg, 1))
+		return;
 	int length = replyMsg.getLength();
 	std::cout << "reply ID: \t" << replyMsg.getID()<<std::endl;
 	std::cout << "reply Length: \t" << replyMsg.getLength()<<std::endl;
@@ -53,19 +79,20 @@ void ForceTorqueCtrl::SetActiveCalibrationMatrix(int num)
 	std::cout << "\n\n*******Setting Active Calibration Matrix Num to: "<< num <<"********"<< std::endl;
 	BYTE b = 0;
 	CanMsg CMsg;
-	CMsg.setID(0x206);
+	CMsg.setID(CanID(SET_CALIB));
 	CMsg.setLength(1);
 	CMsg.setAt(num,0);
 
 	bool ret = m_Can->transmitMsg(CMsg, true);
 
 	CanMsg replyMsg;
-	bool ret2 = m_Can->receiveMsg(&replyMsg);
+	// the reply takes a while, and a dispatcher port does not block in receiveMsg()
+	bool ret2 = ReceiveReply(&replyMsg, 1);
 	if(ret2)
 	{
 		std::cout<<"reply ID: \t"<<replyMsg.getID()<<std::endl;
 		std::cout<<"reply Length: \t"<<replyMsg.getLength()<<std::endl;
-		if(replyMsg.getID() == 0x206)
+		if(replyMsg.getID() == CanID(SET_CALIB))
 		{
 			std::cout<<"Setting Calibration Matrix succeed!"<<std::endl;
 			std::cout<<"Calibration Matrix: "<<replyMsg.getAt(0)<<" is Activ!"<<std::endl;
@@ -73,15 +100,13 @@ void ForceTorqueCtrl::SetActiveCalibrationMatrix(int num)
 		else
 			std::cout<<"Error: Received wrong opcode!"<<std::endl;
 	}
-	else
-		std::cout<<"Error: Receiving Message failed!"<<std::endl;
 
 }
 
 
 void ForceTorqueCtrl::ReadCalibrationMatrix()
 {
-	Eigen::VectorXf vCoef(6);
+	Vector6f vCoef;
 
 	//Read Fx coefficients
 	ReadMatrix(0, vCoef);
@@ -109,13 +134,12 @@ void ForceTorqueCtrl::ReadCalibrationMatrix()
 	SetCalibMatrix();
 }
 
-void ForceTorqueCtrl::ReadMatrix(int axis, Eigen::VectorXf& vec)
+void ForceTorqueCtrl::ReadMatrix(int axis, Vector6f& vec)
 {
 	std::cout << "\n\n*******Read Matrix**********"<<std::endl;
-	float statusCode = 0, sg0 = 0.0, sg1 = 0.0, sg2 = 0.0, sg3 = 0.0, sg4 = 0.0, sg5 = 0.0;
 
 	CanMsg CMsg;
-	CMsg.setID(0x202);
+	CMsg.setID(CanID(READ_MATRIX));
 	CMsg.setLength(1);
 	CMsg.setAt(axis,0);
 
@@ -126,86 +150,37 @@ void ForceTorqueCtrl::ReadMatrix(int axis, Eigen::VectorXf& vec)
 		return;
 	}
 
-	CanMsg replyMsg;
-	bool ret2 = m_Can->receiveMsg(&replyMsg);
-	if(ret2)
-	{
-		std::cout << "reply ID: \t" << replyMsg.getID()<<std::endl;
-		std::cout << "reply Length: \t" << replyMsg.getLength()<<std::endl;
-		std::cout << "reply Data: \t" << replyMsg.getAt(0) << " " << replyMsg.getAt(1) << " " 
-				      << replyMsg.getAt(2) << " " << replyMsg.getAt(3) << " " 
-				      << replyMsg.getAt(4) << " " << replyMsg.getAt(5) << " " 
-				      << replyMsg.getAt(6) << " " << replyMsg.getAt(7) << std::endl;
-		
-		fbBuf.bytes[0] = replyMsg.getAt(3);
-		fbBuf.bytes[1] = replyMsg.getAt(2);
-		fbBuf.bytes[2] = replyMsg.getAt(1);
-		fbBuf.bytes[3] = replyMsg.getAt(0);
-		sg0 = fbBuf.value;
-		
-		
-		fbBuf.bytes[0] = replyMsg.getAt(7);
-		fbBuf.bytes[1] = replyMsg.getAt(6);
-		fbBuf.bytes[2] = replyMsg.getAt(5);
-		fbBuf.bytes[3] = replyMsg.getAt(4);
-		sg1 = fbBuf.value;
-
-	}
-	else
+	// three frames with two big endian floats each
+	CanMsg replyMsg[3];
+	if(!ReceiveReply(replyMsg, 3))
 		return;
 
-	ret2 = m_Can->receiveMsg(&replyMsg);
-	if(ret2)
-	{
-		std::cout << "reply ID: \t" << replyMsg.getID()<<std::endl;
-		std::cout << "reply Length: \t" << replyMsg.getLength()<<std::endl;
-		std::cout << "reply Data: \t" << replyMsg.getAt(0) << " " << replyMsg.getAt(1) << " " 
-				      << replyMsg.getAt(2) << " " << replyMsg.getAt(3) << " " 
-				      << replyMsg.getAt(4) << " " << replyMsg.getAt(5) << " " 
-				      << replyMsg.getAt(6) << " " << replyMsg.getAt(7) << std::endl;
-
-		fbBuf.bytes[0] = replyMsg.getAt(3);
-		fbBuf.bytes[1] = replyMsg.getAt(2);
-		fbBuf.bytes[2] = replyMsg.getAt(1);
-		fbBuf.bytes[3] = replyMsg.getAt(0);
-		sg2 = fbBuf.value;
-		
-		fbBuf.bytes[0] = replyMsg.getAt(7);
-		fbBuf.bytes[1] = replyMsg.getAt(6);
-		fbBuf.bytes[2] = replyMsg.getAt(5);
-		fbBuf.bytes[3] = replyMsg.getAt(4);
-		sg3 = fbBuf.value;
-	}
-	else
-		return;
-
-	ret2 = m_Can->receiveMsg(&replyMsg);
-	if(ret2)
+	float sg[6];
+	for(int i = 0; i < 3; i++)
 	{
-		std::cout << "reply ID: \t" << replyMsg.getID()<<std::endl;
-		std::cout << "reply Length: \t" << replyMsg.getLength()<<std::endl;
-		std::cout << "reply Data: \t" << replyMsg.getAt(0) << " " << replyMsg.getAt(1) << " " 
-				      << replyMsg.getAt(2) << " " << replyMsg.getAt(3) << " " 
-				      << replyMsg.getAt(4) << " " << replyMsg.getAt(5) << " " 
-				      << replyMsg.getAt(6) << " " << replyMsg.getAt(7) << std::endl;
-
-		fbBuf.bytes[0] = replyMsg.getAt(3);
-		fbBuf.bytes[1] = replyMsg.getAt(2);
-		fbBuf.bytes[2] = replyMsg.getAt(1);
-		fbBuf.bytes[3] = replyMsg.getAt(0);
-		sg4 = fbBuf.value;
-		
-		fbBuf.bytes[0] = replyMsg.getAt(7);
-		fbBuf.bytes[1] = replyMsg.getAt(6);
-		fbBuf.bytes[2] = replyMsg.getAt(5);
-		fbBuf.bytes[3] = replyMsg.getAt(4);
-		sg5 = fbBuf.value;
+		std::cout << "reply ID: \t" << replyMsg[i].getID()<<std::endl;
+		std::cout << "reply Length: \t" << replyMsg[i].getLength()<<std::endl;
+		std::cout << "reply Data: \t" << replyMsg[i].getAt(0) << " " << replyMsg[i].getAt(1) << " " 
+				      << replyMsg[i].getAt(2) << " " << replyMsg[i].getAt(3) << " " 
+				      << replyMsg[i].getAt(4) << " " << replyMsg[i].getAt(5) << " " 
+				      << replyMsg[i].getAt(6) << " " << replyMsg[i].getAt(7) << std::endl;
+
+		fbBuf.bytes[0] = replyMsg[i].getAt(3);
+		fbBuf.bytes[1] = replyMsg[i].getAt(2);
+		fbBuf.bytes[2] = replyMsg[i].getAt(1);
+		fbBuf.bytes[3] = replyMsg[i].getAt(0);
+		sg[2*i] = fbBuf.value;
+
+		fbBuf.bytes[0] = replyMsg[i].getAt(7);
+		fbBuf.bytes[1] = replyMsg[i].getAt(6);
+		fbBuf.bytes[2] = replyMsg[i].getAt(5);
+		fbBuf.bytes[3] = replyMsg[i].getAt(4);
+		sg[2*i+1] = fbBuf.value;
 	}
-	else
-		return;
 
-	vec[0] = sg0; vec[1] = sg1; vec[2] = sg2; vec[3] = sg3; vec[4] = sg4; vec[5] = sg5;
-	std::cout<<"Matix:  SG0: "<<sg0<<" SG1: "<<sg1<<" SG2: "<<sg2<<" SG3: "<<sg3<<" SG4: "<<sg4<<" SG5: "<<sg5<<std::endl;
+	for(int i = 0; i < 6; i++)
+		vec[i] = sg[i];
+	std::cout<<"Matix:  SG0: "<<sg[0]<<" SG1: "<<sg[1]<<" SG2: "<<sg[2]<<" SG3: "<<sg[3]<<" SG4: "<<sg[4]<<" SG5: "<<sg[5]<<std::endl;
 }
 
 void ForceTorqueCtrl::ReadFirmwareVersion()
@@ -213,18 +188,19 @@ void ForceTorqueCtrl::ReadFirmwareVersion()
 	std::cout << "\n\n*******Reading Firmware Version: "<< std::endl;
 	BYTE b = 0;
 	CanMsg CMsg;
-	CMsg.setID(0x20F);
+	CMsg.setID(CanID(0x20F));
 	CMsg.setLength(0);
 
 	bool ret = m_Can->transmitMsg(CMsg, true);
 
 	CanMsg replyMsg;
-	bool ret2 = m_Can->receiveMsg(&replyMsg);
+	// the reply takes a while, and a dispatcher port does not block in receiveMsg()
+	bool ret2 = ReceiveReply(&replyMsg, 1);
 	if(ret2)
 	{
 		std::cout<<"reply ID: \t"<<replyMsg.getID()<<std::endl;
 		std::cout<<"reply Length: \t"<<replyMsg.getLength()<<std::endl;
-		if(replyMsg.getID() == 0x20F)
+		if(replyMsg.getID() == CanID(0x20F))
 		{
 			std::cout<<"Reading Firmware Succeed!"<<std::endl;
 			std::cout << "reply Data: \t" << replyMsg.getAt(0) << " " << replyMsg.getAt(1) << " " 
@@ -235,264 +211,273 @@ void ForceTorqueCtrl::ReadFirmwareVersion()
 		else
 			std::cout<<"Error: Received wrong opcode!"<<std::endl;
 	}
-	else
-		std::cout<<"Error: Receiving Message failed!"<<std::endl;
 }
 
-void ForceTorqueCtrl::ReadSGData(double &Fx, double &Fy, double &Fz, double &Tx, double &Ty, double &Tz)
+bool ForceTorqueCtrl::ReadSGData(double &Fx, double &Fy, double &Fz, double &Tx, double &Ty, double &Tz)
 {
-	int statusCode = 0, sg0 = 0, sg1 = 0, sg2 = 0, sg3 = 0, sg4 = 0, sg5 = 0;
+	int sg0 = 0, sg1 = 0, sg2 = 0, sg3 = 0, sg4 = 0, sg5 = 0;
 
 	CanMsg CMsg;
-	CMsg.setID(0x200);
+	CMsg.setID(CanID(READ_SG));
 	CMsg.setLength(0);
 
 	bool ret = m_Can->transmitMsg(CMsg, true);
+	if(!ret)
+		return false;
 
-	CanMsg replyMsg;
-	bool ret2 = m_Can->receiveMsg(&replyMsg);
-	unsigned char c[2];
-	if(ret2)
-	{
-		int length = replyMsg.getLength();
+	// both frames of the reply usually come with one driver call
+	CanMsg replyMsg[2];
+	if(!ReceiveReply(replyMsg, 2))
+		return false;
 
-		c[0] = replyMsg.getAt(0); //status code
-		c[1] = replyMsg.getAt(1);
-		//statusCode = (((char)c[0] << 8) | c[1]);
-		
-		c[0] = replyMsg.getAt(2); //sg0
-		c[1] = replyMsg.getAt(3);
+	// status code, sg0, sg1, sg2
+	sg0 = (short)((replyMsg[0].getAt(2) << 8) | replyMsg[0].getAt(3));
+	sg1 = (short)((replyMsg[0].getAt(4) << 8) | replyMsg[0].getAt(5));
+	sg2 = (short)((replyMsg[0].getAt(6) << 8) | replyMsg[0].getAt(7));
 
-		//sg0 = (((char)c[0] << 8) | c[1]);
-		sg0 = (short)((c[0] << 8) | c[1]);
+	// sg3, sg4, sg5
+	sg3 = (short)((replyMsg[1].getAt(0) << 8) | replyMsg[1].getAt(1));
+	sg4 = (short)((replyMsg[1].getAt(2) << 8) | replyMsg[1].getAt(3));
+	sg5 = (short)((replyMsg[1].getAt(4) << 8) | replyMsg[1].getAt(5));
+	m_dLastStamp = replyMsg[1].getStamp();
 
-		c[0] = replyMsg.getAt(4); //sg1
-		c[1] = replyMsg.getAt(5);
-		sg1 = (short)((c[0] << 8) | c[1]);
+	//std::cout<<"\nsg0: "<<sg0<<" sg1: "<<sg1<<" sg2: "<<sg2<<" sg3: "<<sg3<<" sg4: "<<sg4<<" sg5: "<<sg5<<std::endl;
+	//out<<"sg0: "<<sg0<<" sg1: "<<sg1<<" sg2: "<<sg2<<" sg3: "<<sg3<<" sg4: "<<sg4<<" sg5: "<<sg5<<std::endl;
+	
+	StrainGaugeToForce(sg0, sg1, sg2, sg3, sg4, sg5);
+	
+	Fx = m_vForceData(0); Fy = m_vForceData(1); Fz = m_vForceData(2); 
+	Tx = m_vForceData(3); Ty= m_vForceData(4); Tz = m_vForceData(5);
+	//out<<"Fx: "<<Fx<<" Fy: "<<Fy<<" Fz: "<<Fz<<" Tx: "<<Tx<<" Ty: "<<Ty<<" Tz: "<<Tz<<std::endl;
+	return true;
+}
 
-		c[0] = replyMsg.getAt(6); //sg2
-		c[1] = replyMsg.getAt(7);
-		sg2 = (short)((c[0] << 8) | c[1]);
+bool ForceTorqueCtrl::ReceiveReply(CanMsg* pReply, int iCount)
+{
+	int iReceived = 0;
+	while(iReceived < iCount)
+	{
+		int iRet = m_Can->receiveMsgs(pReply + iReceived, iCount - iReceived, REPLY_TIMEOUT_MS);
+		if(iRet <= 0)
+		{
+			std::cout << "Error: Receiving Message failed!" << std::endl;
+			return false;
+		}
+		iReceived += iRet;
 	}
-	else
-		return;
+	return true;
+}
 
-	ret2 = m_Can->receiveMsg(&replyMsg);
-	if(ret2)
+bool ForceTorqueCtrl::StartStreaming(int iInFlight, int iRingSize)
+{
+	if(m_bStreaming)
+		return true;
+	if(m_Can == NULL)
 	{
-		int length = replyMsg.getLength();
-
-		c[0] = replyMsg.getAt(0); //sg3
-		c[1] = replyMsg.getAt(1);
-		sg3 = (short)((c[0] << 8) | c[1]);
+		std::cout << "Error: Init() must be called before StartStreaming()" << std::endl;
+		return false;
+	}
 
-		c[0] = replyMsg.getAt(2); //sg4
-		c[1] = replyMsg.getAt(3);
-		sg4 = (short)((c[0] << 8) | c[1]);
+	m_iInFlight = (iInFlight < 1) ? 1 : iInFlight;
+	if(m_iInFlight > STREAM_MAX_IN_FLIGHT)
+		m_iInFlight = STREAM_MAX_IN_FLIGHT;
+	delete m_pSampleRing;
+	m_pSampleRing = new SpscRing<FTSample>(iRingSize);
+	m_ulDropped = 0;
+	m_ulTimeOuts = 0;
 
-		c[0] = replyMsg.getAt(4); //sg5
-		c[1] = replyMsg.getAt(5);
-		sg5 = (short)((c[0] << 8) | c[1]);
+	m_bStreaming = true;
+	if(pthread_create(&m_StreamThread, NULL, StreamThread, this) != 0)
+	{
+		std::cout << "Error: Could not start the streaming thread" << std::endl;
+		m_bStreaming = false;
+		return false;
 	}
-	else
+
+	sched_param Param;
+	Param.sched_priority = STREAM_PRIORITY;
+	if(pthread_setschedparam(m_StreamThread, SCHED_FIFO, &Param) != 0)
+		std::cout << "Warning: No real-time priority for the streaming thread, "
+			  << "raise the rtprio limit to reduce sample jitter" << std::endl;
+	return true;
+}
+
+void ForceTorqueCtrl::StopStreaming()
+{
+	if(!m_bStreaming)
 		return;
+	// the thread notices within STREAM_TIMEOUT_MS
+	m_bStreaming = false;
+	pthread_join(m_StreamThread, NULL);
+}
 
+bool ForceTorqueCtrl::GetSample(FTSample& Sample)
+{
+	return (m_pSampleRing != NULL) && m_pSampleRing->pop(Sample);
+}
 
-	//std::cout<<"\nsg0: "<<sg0<<" sg1: "<<sg1<<" sg2: "<<sg2<<" sg3: "<<sg3<<" sg4: "<<sg4<<" sg5: "<<sg5<<std::endl;
-	//out<<"sg0: "<<sg0<<" sg1: "<<sg1<<" sg2: "<<sg2<<" sg3: "<<sg3<<" sg4: "<<sg4<<" sg5: "<<sg5<<std::endl;
-	
-	StrainGaugeToForce(sg0, sg1, sg2, sg3, sg4, sg5);
-	
-	Fx = m_vForceData(0); Fy = m_vForceData(1); Fz = m_vForceData(2); 
-	Tx = m_vForceData(3); Ty= m_vForceData(4); Tz = m_vForceData(5);
-	//out<<"Fx: "<<Fx<<" Fy: "<<Fy<<" Fz: "<<Fz<<" Tx: "<<Tx<<" Ty: "<<Ty<<" Tz: "<<Tz<<std::endl;
-	
+void* ForceTorqueCtrl::StreamThread(void* pArg)
+{
+	((ForceTorqueCtrl*)pArg)->StreamLoop();
+	return NULL;
+}
+
+void ForceTorqueCtrl::StreamLoop()
+{
+	CanMsg Request[STREAM_MAX_IN_FLIGHT];
+	for(int i = 0; i < STREAM_MAX_IN_FLIGHT; i++)
+	{
+		Request[i].setID(CanID(READ_SG));
+		Request[i].setLength(0);
+	}
+	// each request is answered by two frames
+	CanMsg Reply[2 * STREAM_MAX_IN_FLIGHT];
+
+	FTSample Sample;
+	unsigned int uiSeq = 0;
+	int iPending = 0;
+	bool bHaveFirst = false;
+
+	while(m_bStreaming)
+	{
+		// Keep the pipeline full
+		if(iPending < m_iInFlight)
+			iPending += m_Can->transmitMsgs(Request, m_iInFlight - iPending, false);
+
+		int iReplies = m_Can->receiveMsgs(Reply, 2 * STREAM_MAX_IN_FLIGHT, STREAM_TIMEOUT_MS);
+		if(iReplies <= 0)
+		{
+			// a driver error returns at once, don't spin on it
+			if(iReplies < 0)
+				usleep(STREAM_TIMEOUT_MS * 1000);
+			// replies got lost, start over
+			m_ulTimeOuts++;
+			iPending = 0;
+			bHaveFirst = false;
+			continue;
+		}
+
+		for(int i = 0; i < iReplies; i++)
+		{
+			if(Reply[i].getID() == CanID(READ_SG))
+			{
+				// status code, sg0, sg1, sg2
+				Sample.iStatus = (Reply[i].getAt(0) << 8) | Reply[i].getAt(1);
+				Sample.iSG[0] = (short)((Reply[i].getAt(2) << 8) | Reply[i].getAt(3));
+				Sample.iSG[1] = (short)((Reply[i].getAt(4) << 8) | Reply[i].getAt(5));
+				Sample.iSG[2] = (short)((Reply[i].getAt(6) << 8) | Reply[i].getAt(7));
+				bHaveFirst = true;
+			}
+			else if(Reply[i].getID() == CanID(READ_SG) + 1)
+			{
+				// sg3, sg4, sg5
+				if(iPending > 0)
+					iPending--;
+				if(!bHaveFirst)
+					continue; // first half got lost
+				bHaveFirst = false;
+
+				Sample.iSG[3] = (short)((Reply[i].getAt(0) << 8) | Reply[i].getAt(1));
+				Sample.iSG[4] = (short)((Reply[i].getAt(2) << 8) | Reply[i].getAt(3));
+				Sample.iSG[5] = (short)((Reply[i].getAt(4) << 8) | Reply[i].getAt(5));
+				Sample.dStamp = Reply[i].getStamp();
+				Sample.uiSeq = uiSeq++;
+				StrainGaugeToForce(Sample.iSG, Sample.dWrench, 1);
+
+				if(!m_pSampleRing->push(Sample))
+					m_ulDropped++;
+			}
+		}
+	}
 }
 
 void ForceTorqueCtrl::StrainGaugeToForce(int& sg0, int& sg1, int& sg2, int& sg3, int& sg4, int& sg5)
 {
-	Eigen::VectorXf v6SG(6);
-	Eigen::VectorXf v6tmp(6);
-	Eigen::VectorXf test(6);
-	
+	Vector6f v6SG;
 	v6SG[0] = sg0; v6SG[1] = sg1; v6SG[2] = sg2; v6SG[3] = sg3; v6SG[4] = sg4; v6SG[5] = sg5;
-	//v6SG[0] = 263; v6SG[1] = -272; v6SG[2] = -137; v6SG[3] = 9; v6SG[4] = 275; v6SG[5] = -258;
-
-/*	
-	v6tmp = v6SG - m_v3StrainGaigeOffset;
-	//std::cout<<"\nv6tmp: \n"<< v6tmp <<std::endl;
-	//std::cout<<"\nCalibration Matrix: \n"<<m_mXCalibMatrix<<"\n\n";
-	//std::cout<<"\nCalibration Matrix Transposed: \n"<<m_mXCalibMatrix.transpose()<<"\n\n";
-
-	test = m_mXCalibMatrix * v6tmp;
-	//std::cout << "Test: \n" << test << std::endl;
-	m_vForceData = test;
-*/
-	//std::cout<<"\nCalibration Matrix: \n"<<m_mXCalibMatrix<<"\n\n";
-	//std::cout<<"Calibration Matrix: rows: "<<m_mXCalibMatrix.rows()<<" columns: "<<m_mXCalibMatrix.cols()<<std::endl;
-	test = m_mXCalibMatrix * v6SG;
-	//std::cout<<"test: rows: "<<test.rows()<<" columns: "<<test.cols()<<std::endl;
-	//std::cout<<"v6SG: rows: "<<v6SG.rows()<<" columns: "<<v6SG.cols()<<std::endl;
-	m_vForceData = test * 0.000001;
-	//std::cout << "test: \n" << m_vForceData << std::endl;
-	//std::cout<<"m_vForceData: rows: "<<m_vForceData.rows()<<" columns: "<<m_vForceData.cols()<<std::endl;
+	m_vForceData = m_mXCalibMatrix * v6SG - m_vForceOffset;
+}
+
+void ForceTorqueCtrl::StrainGaugeToForce(const int* pSG, double* pWrench, int iCount) const
+{
+	Vector6f v6SG, v6Force;
+	for(int i = 0; i < iCount; i++, pSG += 6, pWrench += 6)
+	{
+		for(int j = 0; j < 6; j++)
+			v6SG[j] = pSG[j];
+		v6Force = m_mXCalibMatrix * v6SG - m_vForceOffset;
+		for(int j = 0; j < 6; j++)
+			pWrench[j] = v6Force[j];
+	}
+}
+
+void ForceTorqueCtrl::UpdateCalibration()
+{
+	// the gains are given in micro units
+	m_mXCalibMatrix = m_mXGainMatrix * 0.000001f;
+	m_vForceOffset = m_mXCalibMatrix * m_v3StrainGaigeOffset;
 }
 
 void ForceTorqueCtrl::SetGaugeOffset(float sg0Off, float sg1Off, float sg2Off, float sg3Off, float sg4Off, float sg5Off)
 {
-	Eigen::VectorXf tmp(6);
-	tmp[0] = sg0Off; tmp[1] = sg1Off; tmp[2] = sg2Off; tmp[3] = sg3Off; tmp[4] = sg4Off; tmp[5] = sg5Off; 
-	m_v3StrainGaigeOffset = tmp;
-	//std::cout<<"GaugeOffset: \n"<<m_v3StrainGaigeOffset<<"\n";
-	//std::cout<<"GaugeOffset 0: \n"<<tmp[0]<<"\n\n";
+	m_v3StrainGaigeOffset[0] = sg0Off; m_v3StrainGaigeOffset[1] = sg1Off; m_v3StrainGaigeOffset[2] = sg2Off;
+	m_v3StrainGaigeOffset[3] = sg3Off; m_v3StrainGaigeOffset[4] = sg4Off; m_v3StrainGaigeOffset[5] = sg5Off;
+	UpdateCalibration();
 }
 void ForceTorqueCtrl::SetGaugeGain(float gg0, float gg1, float gg2, float gg3, float gg4, float gg5)
 {
-	Eigen::VectorXf tmp(6);
-	tmp[0] = gg0; tmp[1] = gg1; tmp[2] = gg2; tmp[3] = gg3; tmp[4] = gg4; tmp[5] = gg5; 
-	m_v3GaugeGain = tmp;
-	//std::cout<<"GaugeGain: \n"<<m_v3GaugeGain<<"\n\n";
+	m_v3GaugeGain[0] = gg0; m_v3GaugeGain[1] = gg1; m_v3GaugeGain[2] = gg2;
+	m_v3GaugeGain[3] = gg3; m_v3GaugeGain[4] = gg4; m_v3GaugeGain[5] = gg5;
 }
 
 void ForceTorqueCtrl::SetFXGain(float fxg0, float fxg1, float fxg2, float fxg3, float fxg4, float fxg5)
 {
-	Eigen::VectorXf tmp(6);
-	tmp[0] = fxg0; tmp[1] = fxg1; tmp[2] = fxg2; tmp[3] = fxg3; tmp[4] = fxg4; tmp[5] = fxg5; 
-	m_v3FXGain = tmp;
-	//std::cout<<"FXGain: \n"<<m_v3FXGain<<"\n\n";
+	m_v3FXGain[0] = fxg0; m_v3FXGain[1] = fxg1; m_v3FXGain[2] = fxg2;
+	m_v3FXGain[3] = fxg3; m_v3FXGain[4] = fxg4; m_v3FXGain[5] = fxg5;
 }
 void ForceTorqueCtrl::SetFYGain(float fyg0, float fyg1, float fyg2, float fyg3, float fyg4, float fyg5)
 {
-	Eigen::VectorXf tmp(6);
-	tmp[0] = fyg0; tmp[1] = fyg1; tmp[2] = fyg2; tmp[3] = fyg3; tmp[4] = fyg4; tmp[5] = fyg5; 
-	m_v3FYGain = tmp;
-	//std::cout<<"FYGain: \n"<<m_v3FYGain<<"\n\n";
-
+	m_v3FYGain[0] = fyg0; m_v3FYGain[1] = fyg1; m_v3FYGain[2] = fyg2;
+	m_v3FYGain[3] = fyg3; m_v3FYGain[4] = fyg4; m_v3FYGain[5] = fyg5;
 }
 void ForceTorqueCtrl::SetFZGain(float fzg0, float fzg1, float fzg2, float fzg3, float fzg4, float fzg5)
 {
-	Eigen::VectorXf tmp(6);
-	tmp[0] = fzg0; tmp[1] = fzg1; tmp[2] = fzg2; tmp[3] = fzg3; tmp[4] = fzg4; tmp[5] = fzg5; 
-	m_v3FZGain = tmp;
-	//std::cout<<"FZGain: \n"<<m_v3FZGain<<"\n\n";
-
+	m_v3FZGain[0] = fzg0; m_v3FZGain[1] = fzg1; m_v3FZGain[2] = fzg2;
+	m_v3FZGain[3] = fzg3; m_v3FZGain[4] = fzg4; m_v3FZGain[5] = fzg5;
 }
 void ForceTorqueCtrl::SetTXGain(float txg0, float txg1, float txg2, float txg3, float txg4, float txg5)
 {
-	Eigen::VectorXf tmp(6);
-	tmp[0] = txg0; tmp[1] = txg1; tmp[2] = txg2; tmp[3] = txg3; tmp[4] = txg4; tmp[5] = txg5; 
-	m_v3TXGain = tmp;
-	//std::cout<<"TXGain: \n"<<m_v3TXGain<<"\n\n";
+	m_v3TXGain[0] = txg0; m_v3TXGain[1] = txg1; m_v3TXGain[2] = txg2;
+	m_v3TXGain[3] = txg3; m_v3TXGain[4] = txg4; m_v3TXGain[5] = txg5;
 }
 void ForceTorqueCtrl::SetTYGain(float tyg0, float tyg1, float tyg2, float tyg3, float tyg4, float tyg5)
 {
-	Eigen::VectorXf tmp(6);
-	tmp[0] = tyg0; tmp[1] = tyg1; tmp[2] = tyg2; tmp[3] = tyg3; tmp[4] = tyg4; tmp[5] = tyg5; 
-	m_v3TYGain = tmp;
-	//std::cout<<"TYGain: \n"<<m_v3TYGain<<"\n\n";
+	m_v3TYGain[0] = tyg0; m_v3TYGain[1] = tyg1; m_v3TYGain[2] = tyg2;
+	m_v3TYGain[3] = tyg3; m_v3TYGain[4] = tyg4; m_v3TYGain[5] = tyg5;
 }
 void ForceTorqueCtrl::SetTZGain(float tzg0, float tzg1, float tzg2, float tzg3, float tzg4, float tzg5)
 {
-	Eigen::VectorXf tmp(6);
-	tmp[0] = tzg0; tmp[1] = tzg1; tmp[2] = tzg2; tmp[3] = tzg3; tmp[4] = tzg4; tmp[5] = tzg5; 
-	m_v3TZGain = tmp;
-	//std::cout<<"TZGain: \n"<<m_v3TZGain<<"\n\n";
+	m_v3TZGain[0] = tzg0; m_v3TZGain[1] = tzg1; m_v3TZGain[2] = tzg2;
+	m_v3TZGain[3] = tzg3; m_v3TZGain[4] = tzg4; m_v3TZGain[5] = tzg5;
 }
 
 void ForceTorqueCtrl::CalcCalibMatrix()
 {
-	Eigen::MatrixXf tmp(6, 6);
-	tmp(0) = m_v3FXGain[0]/m_v3GaugeGain[0];
-	tmp(1) = m_v3FXGain[1]/m_v3GaugeGain[1];
-	tmp(2) = m_v3FXGain[2]/m_v3GaugeGain[2];
-	tmp(3) = m_v3FXGain[3]/m_v3GaugeGain[3];
-	tmp(4) = m_v3FXGain[4]/m_v3GaugeGain[4];
-	tmp(5) = m_v3FXGain[5]/m_v3GaugeGain[5];
-
-	tmp(6) = m_v3FYGain[0]/m_v3GaugeGain[0];
-	tmp(7) = m_v3FYGain[1]/m_v3GaugeGain[1];
-	tmp(8) = m_v3FYGain[2]/m_v3GaugeGain[2];
-	tmp(9) = m_v3FYGain[3]/m_v3GaugeGain[3];
-	tmp(10) = m_v3FYGain[4]/m_v3GaugeGain[4];
-	tmp(11) = m_v3FYGain[5]/m_v3GaugeGain[5];
-
-	tmp(12) = m_v3FZGain[0]/m_v3GaugeGain[0];
-	tmp(13) = m_v3FZGain[1]/m_v3GaugeGain[1];
-	tmp(14) = m_v3FZGain[2]/m_v3GaugeGain[2];
-	tmp(15) = m_v3FZGain[3]/m_v3GaugeGain[3];
-	tmp(16) = m_v3FZGain[4]/m_v3GaugeGain[4];
-	tmp(17) = m_v3FZGain[5]/m_v3GaugeGain[5];
-
-	tmp(18) = m_v3TXGain[0]/m_v3GaugeGain[0];
-	tmp(19) = m_v3TXGain[1]/m_v3GaugeGain[1];
-	tmp(20) = m_v3TXGain[2]/m_v3GaugeGain[2];
-	tmp(21) = m_v3TXGain[3]/m_v3GaugeGain[3];
-	tmp(22) = m_v3TXGain[4]/m_v3GaugeGain[4];
-	tmp(23) = m_v3TXGain[5]/m_v3GaugeGain[5];
-
-	tmp(24) = m_v3TYGain[0]/m_v3GaugeGain[0];
-	tmp(25) = m_v3TYGain[1]/m_v3GaugeGain[1];
-	tmp(26) = m_v3TYGain[2]/m_v3GaugeGain[2];
-	tmp(27) = m_v3TYGain[3]/m_v3GaugeGain[3];
-	tmp(28) = m_v3TYGain[4]/m_v3GaugeGain[4];
-	tmp(29) = m_v3TYGain[5]/m_v3GaugeGain[5];
-
-	tmp(30) = m_v3TZGain[0]/m_v3GaugeGain[0];
-	tmp(31) = m_v3TZGain[1]/m_v3GaugeGain[1];
-	tmp(32) = m_v3TZGain[2]/m_v3GaugeGain[2];
-	tmp(33) = m_v3TZGain[3]/m_v3GaugeGain[3];
-	tmp(34) = m_v3TZGain[4]/m_v3GaugeGain[4];
-	tmp(35) = m_v3TZGain[5]/m_v3GaugeGain[5];
-	
-	m_mXCalibMatrix = tmp;
-			
+	const Vector6f* pGains[6] = { &m_v3FXGain, &m_v3FYGain, &m_v3FZGain, &m_v3TXGain, &m_v3TYGain, &m_v3TZGain };
+	// one column per axis, normalized by the gauge gains
+	for(int iAxis = 0; iAxis < 6; iAxis++)
+		for(int i = 0; i < 6; i++)
+			m_mXGainMatrix(i, iAxis) = (*pGains[iAxis])[i] / m_v3GaugeGain[i];
+	UpdateCalibration();
 }
+
 void ForceTorqueCtrl::SetCalibMatrix()
 {
-	Eigen::MatrixXf tmp(6, 6);
-	tmp(0) = m_v3FXGain[0];
-	tmp(1) = m_v3FXGain[1];
-	tmp(2) = m_v3FXGain[2];
-	tmp(3) = m_v3FXGain[3];
-	tmp(4) = m_v3FXGain[4];
-	tmp(5) = m_v3FXGain[5];
-
-	tmp(6) = m_v3FYGain[0];
-	tmp(7) = m_v3FYGain[1];
-	tmp(8) = m_v3FYGain[2];
-	tmp(9) = m_v3FYGain[3];
-	tmp(10) = m_v3FYGain[4];
-	tmp(11) = m_v3FYGain[5];
-
-	tmp(12) = m_v3FZGain[0];
-	tmp(13) = m_v3FZGain[1];
-	tmp(14) = m_v3FZGain[2];
-	tmp(15) = m_v3FZGain[3];
-	tmp(16) = m_v3FZGain[4];
-	tmp(17) = m_v3FZGain[5];
-
-	tmp(18) = m_v3TXGain[0];
-	tmp(19) = m_v3TXGain[1];
-	tmp(20) = m_v3TXGain[2];
-	tmp(21) = m_v3TXGain[3];
-	tmp(22) = m_v3TXGain[4];
-	tmp(23) = m_v3TXGain[5];
-
-	tmp(24) = m_v3TYGain[0];
-	tmp(25) = m_v3TYGain[1];
-	tmp(26) = m_v3TYGain[2];
-	tmp(27) = m_v3TYGain[3];
-	tmp(28) = m_v3TYGain[4];
-	tmp(29) = m_v3TYGain[5];
-
-	tmp(30) = m_v3TZGain[0];
-	tmp(31) = m_v3TZGain[1];
-	tmp(32) = m_v3TZGain[2];
-	tmp(33) = m_v3TZGain[3];
-	tmp(34) = m_v3TZGain[4];
-	tmp(35) = m_v3TZGain[5];
-
-	
-	m_mXCalibMatrix = tmp.transpose();
-			
+	m_mXGainMatrix.row(0) = m_v3FXGain.transpose();
+	m_mXGainMatrix.row(1) = m_v3FYGain.transpose();
+	m_mXGainMatrix.row(2) = m_v3FZGain.transpose();
+	m_mXGainMatrix.row(3) = m_v3TXGain.transpose();
+	m_mXGainMatrix.row(4) = m_v3TYGain.transpose();
+	m_mXGainMatrix.row(5) = m_v3TZGain.transpose();
+	UpdateCalibration();
 }
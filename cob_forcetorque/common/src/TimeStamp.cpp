@@ -25,6 +25,13 @@ void TimeStamp::SetNow()
 	::clock_gettime(CLOCK_REALTIME, &m_TimeStamp);
 }
 
+double TimeStamp::MonotonicNow()
+{
+	::timespec Now;
+	::clock_gettime(CLOCK_MONOTONIC, &Now);
+	return TimespecToDouble(Now);
+}
+
 double TimeStamp::TimespecToDouble(const ::timespec& LargeInt)
 {
 	return double(LargeInt.tv_sec) + double(LargeInt.tv_nsec) / 1e9;
@@ -57,15 +57,21 @@ typedef unsigned char uint8_t;
 #include <iostream>
 #include <ros/ros.h>
 #include <std_msgs/Float32MultiArray.h>
+#include <geometry_msgs/WrenchStamped.h>
 #include <cob_forcetorque/ForceTorqueCtrl.h>
+#include <cob_forcetorque/UDPSocketASIO.h>
+#include <cob_forcetorque/BiasEstimator.h>
 
 #include <cob_srvs/Trigger.h>
 
 #include <tf/transform_listener.h>
+#include <boost/thread.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <visualization_msgs/Marker.h>
 
 #include <math.h>
 #include <iostream>
+#include <sstream>
 #define PI 3.14159265
 
 
@@ -75,6 +81,16 @@ public:
   // create a handle for this node, initialize node
   ros::NodeHandle nh_;
 
+  ForceTorqueNode() : m_bTfRunning(false), m_pStreamer(NULL), m_uiStreamSeq(0), m_pBias(NULL) {}
+  ~ForceTorqueNode()
+  {
+    m_bTfRunning = false;
+    if(m_TfThread.joinable())
+      m_TfThread.join();
+    delete m_pStreamer;
+    delete m_pBias;
+  }
+
   bool init();
   bool srvCallback_Init(cob_srvs::Trigger::Request &req,
 			cob_srvs::Trigger::Response &res );
@@ -82,11 +98,13 @@ public:
 			cob_srvs::Trigger::Response &res );
   void updateFTData();
   void visualizeData(double x, double y, double z);
+  bool isStreaming() { return m_bStreaming; }
 
 private:
   // declaration of topics to publish
   ros::Publisher topicPub_ForceData_;
   ros::Publisher topicPub_ForceDataBase_;
+  ros::Publisher topicPub_Wrench_;
   ros::Publisher topicPub_Marker_;
 
   // service servers
@@ -94,19 +112,156 @@ private:
   ros::ServiceServer srvServer_Calibrate_;
 
   tf::TransformListener tflistener;
-  tf::StampedTransform transform_ee_base;
+
+  // A frame the wrenches are transformed into and published in
+  struct TargetFrame
+  {
+    std::string name;
+    ros::Publisher pub;
+    geometry_msgs::WrenchStamped msg;
+    // from the sensor frame, written by the tf thread
+    tf::StampedTransform transform;
+    bool valid;
+  };
+  std::vector<TargetFrame> m_Targets;
+  // copy of the transforms for the current cycle, see updateTransforms()
+  std::vector<tf::StampedTransform> m_Transforms;
+  std::vector<bool> m_TransformValid;
+  boost::mutex m_TfMutex;
+  boost::thread m_TfThread;
+  volatile bool m_bTfRunning;
+  double m_dTfRate;
+
+  void tfThread();
+  void updateTransforms();
+  static void transformWrench(const tf::Transform& T, const double* pIn, double* pOut);
+
+  // tool load, subtracted if m_dToolMass > 0
+  double m_dToolMass;
+  // center of mass in the sensor frame
+  tf::Vector3 m_vToolCog;
+  // frame whose -z axis is the direction of gravity
+  std::string m_sGravityFrame;
+  // into the sensor frame, written by the tf thread
+  tf::StampedTransform m_GravityTransform;
+  bool m_bGravityValid;
+  // copies for the current cycle
+  tf::Transform m_GravityRotation;
+  bool m_bGravityRotationValid;
+
+  bool toolLoad(double* pLoad);
+
+  // reused for every sample
+  geometry_msgs::WrenchStamped m_WrenchMsg;
+  std_msgs::Float32MultiArray m_ForceMsg;
+  std_msgs::Float32MultiArray m_ForceBaseMsg;
+
+  void publishData(const double* pWrench, double dStamp, bool bVisualize);
+  ros::Time toRosTime(double dStamp);
 
   bool m_isInitialized;
+  // pipelined acquisition on a driver thread instead of one request per cycle
+  bool m_bStreaming;
+  int m_iInFlight;
+  std::string m_sFrameId;
+  // optional UDP stream of the wrenches to an external controller
+  boost::asio::io_service m_IOService;
+  WrenchStreamer* m_pStreamer;
+  uint32_t m_uiStreamSeq;
+  // the CAN interface, shared with other devices on the bus through ports;
+  // declared before ftc, which holds a port of it
+  boost::scoped_ptr<CanDispatcher> m_pCanDispatcher;
+  int m_iCanBaseId;
   ForceTorqueCtrl ftc;
+  // bias subtracted from the samples, updated by m_pBias after Calibrate
   std::vector<double> F_avg;
+  BiasEstimator* m_pBias;
   
 };
 
 bool ForceTorqueNode::init()
 {
   m_isInitialized = false;
+  ros::NodeHandle local_nh("~");
+  local_nh.param("streaming", m_bStreaming, true);
+  local_nh.param("in_flight", m_iInFlight, 2);
+  local_nh.param("can_base_id", m_iCanBaseId, (int)READ_SG);
+  local_nh.param("frame_id", m_sFrameId, std::string("arm_7_link"));
+
+  std::string stream_address;
+  local_nh.param("udp_stream_address", stream_address, std::string(""));
+  if(!stream_address.empty())
+    {
+      int port, sensor_id, batch, ttl;
+      local_nh.param("udp_stream_port", port, 5010);
+      local_nh.param("udp_sensor_id", sensor_id, 0);
+      local_nh.param("udp_batch", batch, 1);
+      local_nh.param("udp_ttl", ttl, 1);
+      try
+	{
+	  m_pStreamer = new WrenchStreamer(m_IOService, boost::asio::ip::address::from_string(stream_address),
+					   port, sensor_id, batch, ttl);
+	  ROS_INFO("Streaming wrenches to %s:%d", stream_address.c_str(), port);
+	}
+      catch(std::exception& e)
+	{
+	  ROS_ERROR("Cannot stream wrenches to %s: %s", stream_address.c_str(), e.what());
+	}
+    }
   topicPub_ForceData_ = nh_.advertise<std_msgs::Float32MultiArray>("force_values", 100);
   topicPub_ForceDataBase_ = nh_.advertise<std_msgs::Float32MultiArray>("force_values_base", 100);
+  topicPub_Wrench_ = nh_.advertise<geometry_msgs::WrenchStamped>("wrench", 100);
+  m_WrenchMsg.header.frame_id = m_sFrameId;
+  m_ForceMsg.data.resize(6);
+  m_ForceBaseMsg.data.resize(6);
+
+  // force_values_base carries the first target frame
+  std::string target_frames;
+  local_nh.param("target_frames", target_frames, std::string("base_link"));
+  local_nh.param("tf_rate", m_dTfRate, 50.0);
+  std::istringstream frames(target_frames);
+  std::string frame;
+  while(frames >> frame)
+    {
+      TargetFrame target;
+      target.name = frame;
+      std::string topic = frame;
+      for(size_t i = 0; i < topic.size(); i++)
+	if(topic[i] == '/')
+	  topic[i] = '_';
+      if(!topic.empty() && topic[0] == '_')
+	topic.erase(0, 1);
+      target.pub = nh_.advertise<geometry_msgs::WrenchStamped>("wrench_" + topic, 100);
+      target.msg.header.frame_id = frame;
+      target.valid = false;
+      m_Targets.push_back(target);
+    }
+  m_Transforms.resize(m_Targets.size());
+  m_TransformValid.resize(m_Targets.size(), false);
+
+  // Calibrate collects this many samples in the publishing loop
+  int bias_window;
+  double outlier_sigma;
+  local_nh.param("bias_window", bias_window, m_bStreaming ? 100 : 20);
+  local_nh.param("bias_outlier_sigma", outlier_sigma, 3.0);
+  m_pBias = new BiasEstimator(bias_window, outlier_sigma);
+  F_avg.assign(6, 0.0);
+
+  double cog_x, cog_y, cog_z;
+  local_nh.param("tool_mass", m_dToolMass, 0.0);
+  local_nh.param("tool_cog_x", cog_x, 0.0);
+  local_nh.param("tool_cog_y", cog_y, 0.0);
+  local_nh.param("tool_cog_z", cog_z, 0.0);
+  local_nh.param("gravity_frame", m_sGravityFrame, std::string("base_link"));
+  m_vToolCog = tf::Vector3(cog_x, cog_y, cog_z);
+  m_bGravityValid = false;
+  m_bGravityRotationValid = false;
+
+  if(!m_Targets.empty() || m_dToolMass > 0.0)
+    {
+      m_bTfRunning = true;
+      m_TfThread = boost::thread(boost::bind(&ForceTorqueNode::tfThread, this));
+    }
   topicPub_Marker_ = nh_.advertise<visualization_msgs::Marker>("/visualization_marker", 1);
   srvServer_Init_ = nh_.advertiseService("Init", &ForceTorqueNode::srvCallback_Init, this);
   srvServer_Calibrate_ = nh_.advertiseService("Calibrate", &ForceTorqueNode::srvCallback_Calibrate, this);
@@ -128,17 +283,18 @@ bool ForceTorqueNode::srvCallback_Init(cob_srvs::Trigger::Request &req,
 	ftc.SetTZGain(60.1009854270179, -400.19573754971, 29.142908672741, -392.119024237625, 70.9306507180567, -478.104759057292);
 
 	ftc.SetCalibMatrix();
-	ftc.Init();
+	m_pCanDispatcher.reset(new CanDispatcher(new CanESD("", false)));
+	m_pCanDispatcher->start(80);
+	ftc.Init(m_pCanDispatcher.get(), m_iCanBaseId);
+	if(m_bStreaming && !ftc.StartStreaming(m_iInFlight))
+	{
+	  ROS_WARN("Streaming failed to start, polling the sensor instead");
+	  m_bStreaming = false;
+	}
 	ROS_INFO("FTC initialized");
 
 	//set Calibdata to zero
-	F_avg.resize(6);
-	F_avg[0] = 0.0;
-	F_avg[1] = 0.0;
-	F_avg[2] = 0.0;
-	F_avg[3] = 0.0;
-	F_avg[4] = 0.0;
-	F_avg[5] = 0.0;
+	F_avg.assign(6, 0.0);
 
 
 	m_isInitialized = true;
@@ -146,80 +302,213 @@ bool ForceTorqueNode::srvCallback_Init(cob_srvs::Trigger::Request &req,
   return true;
 }
 
+// Only requests a new estimate, the samples are collected in publishData()
+// so the force stream keeps running meanwhile.
 bool ForceTorqueNode::srvCallback_Calibrate(cob_srvs::Trigger::Request &req,
 		      cob_srvs::Trigger::Response &res )
 {
-  int measurements = 20;
-  if(m_isInitialized)
+  if(!m_isInitialized)
+    return false;
+  m_pBias->start();
+  return true;
+}
+
+void ForceTorqueNode::updateFTData()
+{
+  if(!m_isInitialized)
+    return;
+
+  if(!m_bStreaming)
     {
-      F_avg[0] = 0.0;
-      F_avg[1] = 0.0;
-      F_avg[2] = 0.0;
-      F_avg[3] = 0.0;
-      F_avg[4] = 0.0;
-      F_avg[5] = 0.0;
-      for(int i = 0; i < measurements; i++)
+      double wrench[6] = {0, 0, 0, 0, 0, 0};
+      // a lost reply must not show up as a zero wrench
+      if(!ftc.ReadSGData(wrench[0], wrench[1], wrench[2], wrench[3], wrench[4], wrench[5]))
 	{
-	  double Fx, Fy, Fz, Tx, Ty, Tz = 0;
-	  ftc.ReadSGData(Fx, Fy, Fz, Tx, Ty, Tz);
-	  F_avg[0] += Fx;
-	  F_avg[1] += Fy;
-	  F_avg[2] += Fz;
-	  F_avg[3] += Tx;
-	  F_avg[4] += Ty;
-	  F_avg[5] += Tz;
-	  usleep(10000);
+	  ROS_WARN_THROTTLE(1.0, "No reply from the sensor, skipping this cycle");
+	  return;
 	}
-      for(int i = 0; i < 6; i++)
-	F_avg[i] /= measurements;
-      return true;
+      updateTransforms();
+      publishData(wrench, ftc.GetLastStamp(), true);
+      return;
     }
-  else
-    return false;
+
+  // Publish every sample, visualize only the latest
+  FTSample sample, latest;
+  bool bReceived = false;
+  while(ftc.GetSample(sample))
+    {
+      if(!bReceived)
+	updateTransforms();
+      if(bReceived)
+	publishData(latest.dWrench, latest.dStamp, false);
+      latest = sample;
+      bReceived = true;
+    }
+  if(bReceived)
+    publishData(latest.dWrench, latest.dStamp, true);
+  // don't hold samples of this cycle back for the batch
+  if(m_pStreamer)
+    m_pStreamer->flush();
 }
 
-void ForceTorqueNode::updateFTData()
+// The driver stamps frames on the monotonic clock; going back from now by
+// the age of the sample keeps the stamp right across system time changes.
+ros::Time ForceTorqueNode::toRosTime(double dStamp)
+{
+  ros::Time now = ros::Time::now();
+  if(dStamp <= 0)
+    return now;
+  double age = Neobotix::TimeStamp::MonotonicNow() - dStamp;
+  return (age > 0) ? now - ros::Duration(age) : now;
+}
+
+// Looks the transforms up off the sampling path, lookupTransform takes
+// milliseconds at times.
+void ForceTorqueNode::tfThread()
 {
-  if(m_isInitialized)
+  ros::Rate rate(m_dTfRate);
+  while(m_bTfRunning && ros::ok())
     {
-      double Fx, Fy, Fz, Tx, Ty, Tz = 0;
-      
-      ftc.ReadSGData(Fx, Fy, Fz, Tx, Ty, Tz);
-      std_msgs::Float32MultiArray msg;
-      msg.data.push_back(Fx-F_avg[0]);
-      msg.data.push_back(Fy-F_avg[1]);
-      msg.data.push_back(Fz-F_avg[2]);
-      msg.data.push_back(Tx-F_avg[3]);
-      msg.data.push_back(Ty-F_avg[4]);
-      msg.data.push_back(Tz-F_avg[5]);
-
-
-      topicPub_ForceData_.publish(msg);
-      
-
-      tf::Transform fdata_base;
-      tf::Transform fdata;
-      fdata.setOrigin(tf::Vector3(Fx-F_avg[0], Fy-F_avg[1], Fz-F_avg[2]));
-
-      try{
-        tflistener.lookupTransform("arm_7_link", "base_link", ros::Time(0), transform_ee_base);
-      }
-      catch (tf::TransformException ex){
-	ROS_ERROR("%s",ex.what());
-      }
-
-      fdata_base = transform_ee_base * fdata;
-
-      std_msgs::Float32MultiArray base_msg;
-      base_msg.data.push_back(fdata_base.getOrigin().x());
-      base_msg.data.push_back(fdata_base.getOrigin().y());
-      base_msg.data.push_back(fdata_base.getOrigin().z());
-      base_msg.data.push_back(0.0);
-      base_msg.data.push_back(0.0);
-      base_msg.data.push_back(0.0);
-      topicPub_ForceDataBase_.publish(base_msg);
-      visualizeData(fdata_base.getOrigin().x(), fdata_base.getOrigin().y(), fdata_base.getOrigin().z());
+      for(size_t i = 0; i < m_Targets.size(); i++)
+	{
+	  tf::StampedTransform transform;
+	  try
+	    {
+	      tflistener.lookupTransform(m_Targets[i].name, m_sFrameId, ros::Time(0), transform);
+	    }
+	  catch(tf::TransformException& ex)
+	    {
+	      if(m_Targets[i].valid)
+		ROS_WARN("Lost transform to %s: %s", m_Targets[i].name.c_str(), ex.what());
+	      boost::mutex::scoped_lock lock(m_TfMutex);
+	      m_Targets[i].valid = false;
+	      continue;
+	    }
+	  boost::mutex::scoped_lock lock(m_TfMutex);
+	  m_Targets[i].transform = transform;
+	  m_Targets[i].valid = true;
+	}
+      if(m_dToolMass > 0.0)
+	{
+	  tf::StampedTransform transform;
+	  bool valid = true;
+	  try
+	    {
+	      tflistener.lookupTransform(m_sFrameId, m_sGravityFrame, ros::Time(0), transform);
+	    }
+	  catch(tf::TransformException& ex)
+	    {
+	      if(m_bGravityValid)
+		ROS_WARN("Lost transform from %s: %s", m_sGravityFrame.c_str(), ex.what());
+	      valid = false;
+	    }
+	  boost::mutex::scoped_lock lock(m_TfMutex);
+	  if(valid)
+	    m_GravityTransform = transform;
+	  m_bGravityValid = valid;
+	}
+      rate.sleep();
+    }
+}
+
+void ForceTorqueNode::updateTransforms()
+{
+  boost::mutex::scoped_lock lock(m_TfMutex);
+  for(size_t i = 0; i < m_Targets.size(); i++)
+    {
+      m_Transforms[i] = m_Targets[i].transform;
+      m_TransformValid[i] = m_Targets[i].valid;
     }
+  m_GravityRotation = m_GravityTransform;
+  m_bGravityRotationValid = m_bGravityValid;
+}
+
+// Wrench of the tool weight in the sensor frame
+bool ForceTorqueNode::toolLoad(double* pLoad)
+{
+  if(m_dToolMass <= 0.0 || !m_bGravityRotationValid)
+    return false;
+  tf::Vector3 force = m_GravityRotation.getBasis() * tf::Vector3(0.0, 0.0, -9.81 * m_dToolMass);
+  tf::Vector3 torque = m_vToolCog.cross(force);
+  pLoad[0] = force.x(); pLoad[1] = force.y(); pLoad[2] = force.z();
+  pLoad[3] = torque.x(); pLoad[4] = torque.y(); pLoad[5] = torque.z();
+  return true;
+}
+
+// Rotates force and torque, the lever arm of the frame origin adds to the torque
+void ForceTorqueNode::transformWrench(const tf::Transform& T, const double* pIn, double* pOut)
+{
+  tf::Vector3 force = T.getBasis() * tf::Vector3(pIn[0], pIn[1], pIn[2]);
+  tf::Vector3 torque = T.getBasis() * tf::Vector3(pIn[3], pIn[4], pIn[5]) + T.getOrigin().cross(force);
+  pOut[0] = force.x(); pOut[1] = force.y(); pOut[2] = force.z();
+  pOut[3] = torque.x(); pOut[4] = torque.y(); pOut[5] = torque.z();
+}
+
+void ForceTorqueNode::publishData(const double* pWrench, double dStamp, bool bVisualize)
+{
+      double load[6] = {0, 0, 0, 0, 0, 0};
+      bool bLoad = toolLoad(load);
+      // without the gravity direction a compensated estimate has to wait
+      if((bLoad || m_dToolMass <= 0.0) && m_pBias->add(pWrench, bLoad ? load : NULL))
+	{
+	  m_pBias->getBias(&F_avg[0]);
+	  ROS_INFO("New bias estimate, %d of the samples rejected", m_pBias->getRejected());
+	}
+
+      double wrench[6];
+      for(int i = 0; i < 6; i++)
+	wrench[i] = pWrench[i] - F_avg[i] - load[i];
+
+      m_WrenchMsg.header.stamp = toRosTime(dStamp);
+      m_WrenchMsg.wrench.force.x = wrench[0];
+      m_WrenchMsg.wrench.force.y = wrench[1];
+      m_WrenchMsg.wrench.force.z = wrench[2];
+      m_WrenchMsg.wrench.torque.x = wrench[3];
+      m_WrenchMsg.wrench.torque.y = wrench[4];
+      m_WrenchMsg.wrench.torque.z = wrench[5];
+      topicPub_Wrench_.publish(m_WrenchMsg);
+
+      if(m_pStreamer)
+	{
+	  WrenchSample sample;
+	  sample.uiSeq = m_uiStreamSeq++;
+	  sample.uiStatus = 0;
+	  sample.iStampNs = m_WrenchMsg.header.stamp.toNSec();
+	  for(int i = 0; i < 6; i++)
+	    sample.dWrench[i] = wrench[i];
+	  m_pStreamer->add(sample);
+	}
+
+      for(int i = 0; i < 6; i++)
+	m_ForceMsg.data[i] = wrench[i];
+      topicPub_ForceData_.publish(m_ForceMsg);
+
+      for(size_t j = 0; j < m_Targets.size(); j++)
+	{
+	  if(!m_TransformValid[j])
+	    continue;
+	  double target[6];
+	  transformWrench(m_Transforms[j], wrench, target);
+
+	  geometry_msgs::WrenchStamped& msg = m_Targets[j].msg;
+	  msg.header.stamp = m_WrenchMsg.header.stamp;
+	  msg.wrench.force.x = target[0];
+	  msg.wrench.force.y = target[1];
+	  msg.wrench.force.z = target[2];
+	  msg.wrench.torque.x = target[3];
+	  msg.wrench.torque.y = target[4];
+	  msg.wrench.torque.z = target[5];
+	  m_Targets[j].pub.publish(msg);
+
+	  if(j == 0)
+	    {
+	      for(int i = 0; i < 6; i++)
+		m_ForceBaseMsg.data[i] = target[i];
+	      topicPub_ForceDataBase_.publish(m_ForceBaseMsg);
+	      if(bVisualize)
+		visualizeData(target[0], target[1], target[2]);
+	    }
+	}
 }
 
 void ForceTorqueNode::visualizeData(double x, double y, double z)
@@ -263,7 +552,10 @@ int main(int argc, char ** argv)
   
   ROS_INFO("ForceTorque Sensor Node running.");
   
-  ros::Rate loop_rate(10);
+  // When streaming, each cycle publishes all samples received meanwhile
+  double rate;
+  ros::NodeHandle("~").param("rate", rate, ftn.isStreaming() ? 500.0 : 10.0);
+  ros::Rate loop_rate(rate);
   while(ros::ok())
     {
       ros::spinOnce();
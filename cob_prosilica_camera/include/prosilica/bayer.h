@@ -0,0 +1,37 @@
+#ifndef PROSILICA_BAYER_H
+#define PROSILICA_BAYER_H
+
+#include <cstddef>
+
+#include "prosilica/prosilica.h"
+
+namespace prosilica {
+
+//! Outputs of demosaic(). Leave a pointer NULL to skip that output.
+struct DemosaicOutput
+{
+  unsigned char* bgr;     //!< width x height bgr8, bilinear interpolation
+  size_t bgr_step;
+  unsigned char* mono;    //!< width x height mono8 luminance
+  size_t mono_step;
+  unsigned char* half;    //!< width/2 x height/2 bgr8, one pixel per 2x2 Bayer cell
+  size_t half_step;
+  unsigned char* quarter; //!< width/4 x height/4 bgr8, one pixel per 4x4 block
+  size_t quarter_step;
+
+  DemosaicOutput()
+    : bgr(NULL), bgr_step(0), mono(NULL), mono_step(0),
+      half(NULL), half_step(0), quarter(NULL), quarter_step(0)
+  {}
+};
+
+//! Converts an 8 bit Bayer image into all requested outputs in one pass over
+//! the input rows. Borders are mirrored, which keeps the Bayer phase intact.
+//! width and height must be at least 2. The full resolution outputs use SSE2
+//! where the compiler targets it, with bit-identical results to the scalar code.
+void demosaic(const unsigned char* bayer, size_t width, size_t height, size_t step,
+              tPvBayerPattern pattern, const DemosaicOutput& out);
+
+} // namespace prosilica
+
+#endif
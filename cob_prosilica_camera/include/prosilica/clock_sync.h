@@ -0,0 +1,79 @@
+#ifndef PROSILICA_CLOCK_SYNC_H
+#define PROSILICA_CLOCK_SYNC_H
+
+#include <deque>
+#include <boost/thread.hpp>
+
+#include "prosilica/prosilica.h"
+
+namespace prosilica {
+
+/// Maps the camera's free running tick counter to host (wall clock) time.
+/// A background thread periodically latches the counter and fits
+/// host = offset + drift * ticks over a sliding window of the samples with
+/// the shortest round trips, so frame time stamps carry no callback latency.
+/// A latch is accepted if its round trip is close to the best one of the
+/// recent latches; if none was for a while, the best recent one is taken
+/// anyway so the fit keeps following the drift.
+class ClockSync
+{
+public:
+  ClockSync(Camera& cam, double period = 1.0, size_t window = 30);
+  ~ClockSync();
+
+  //! Start/stop the sampling thread.
+  void start();
+  void stop();
+
+  //! Latches the counter once and updates the fit. Returns false if the
+  //! sample was rejected (attribute error or a slow round trip).
+  bool sample();
+
+  //! Host time in seconds since the epoch of a device tick count. Returns
+  //! false until the first sample has been taken.
+  bool toHostTime(uint64_t ticks, double& host_time);
+
+  //! Ticks at which the frame was time stamped (start of exposure).
+  static uint64_t frameTicks(const tPvFrame* frame);
+
+  //! Fit quality for diagnostics.
+  size_t numSamples();
+  unsigned long numAccepted(); //!< total, unlike numSamples() not bounded by the window
+  bool isStale();     //!< no sample accepted for much longer than expected
+  double residual();  //!< rms deviation of the samples from the fit, seconds
+  double driftPpm();  //!< deviation of the device clock from its nominal rate
+
+private:
+  struct Sample
+  {
+    uint64_t ticks;
+    double host;       // midpoint of the latch round trip
+    double round_trip;
+  };
+
+  Camera& cam_;
+  double period_;
+  size_t window_;
+  double nominal_period_; // seconds per tick
+
+  boost::mutex mutex_;
+  std::deque<Sample> samples_;
+  // the last latches, accepted or not, judged against each other
+  std::deque<Sample> recent_;
+  size_t rejected_in_row_;
+  unsigned long accepted_;
+  // host = host0_ + slope_ * (ticks - ticks0_)
+  uint64_t ticks0_;
+  double host0_, slope_, residual_;
+  bool valid_;
+
+  boost::thread thread_;
+  volatile bool running_;
+
+  void run();
+  void fit();
+};
+
+} // namespace prosilica
+
+#endif
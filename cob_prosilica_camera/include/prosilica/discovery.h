@@ -0,0 +1,47 @@
+#ifndef PROSILICA_DISCOVERY_H
+#define PROSILICA_DISCOVERY_H
+
+#include <string>
+#include <vector>
+
+#include "prosilica/prosilica.h"
+
+namespace prosilica {
+
+//! What is known about a camera without (or before) opening it.
+struct CameraInfo
+{
+  unsigned long guid;
+  std::string ip_address; //!< dotted quad, empty for non-GigE cameras
+  std::string model;      //!< tPvCameraInfo::DisplayName
+  std::string serial;
+  std::string firmware;   //!< only known once the camera has been opened, see describeCamera()
+};
+
+/// Lists all reachable cameras. PvApi finds cameras asynchronously after
+/// init(), so this polls until expected cameras showed up, or (expected = 0)
+/// the list was stable for a moment, or timeout seconds have passed.
+std::vector<CameraInfo> discoverCameras(double timeout = 1.0, size_t expected = 0);
+
+/// Unicast query of the camera at ip_address; fast and works across subnets.
+/// Does not open the camera, so the guid can be checked beforehand.
+bool queryCamera(const std::string& ip_address, CameraInfo& info);
+
+/// Full information of an open camera, including firmware version.
+CameraInfo describeCamera(Camera& cam);
+
+/// Discovery results are shared between processes through a small text file,
+/// so each node of a multi-camera rig opens its camera by address right away
+/// instead of waiting for broadcast discovery. Default location is
+/// $ROS_HOME/prosilica_cameras (~/.ros/prosilica_cameras).
+std::string defaultDiscoveryCachePath();
+bool loadDiscoveryCache(const std::string& path, std::vector<CameraInfo>& cameras);
+//! Replaces the cache contents, atomically.
+bool saveDiscoveryCache(const std::string& path, const std::vector<CameraInfo>& cameras);
+//! Adds or replaces the entry of one camera; safe against concurrent updates.
+bool updateDiscoveryCache(const std::string& path, const CameraInfo& camera);
+bool findCachedCamera(const std::vector<CameraInfo>& cameras, unsigned long guid, CameraInfo& info);
+
+} // namespace prosilica
+
+#endif
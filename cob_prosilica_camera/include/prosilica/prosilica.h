@@ -37,8 +37,13 @@
 
 #include <stdexcept>
 #include <string>
+#include <map>
 #include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/thread.hpp>
+#include <boost/interprocess/sync/interprocess_semaphore.hpp>
+
+#include "prosilica/spsc_queue.h"
 
 // PvApi.h isn't aware of the usual detection macros
 // TODO: support systems other than x86 linux
@@ -59,7 +64,7 @@ struct ProsilicaException : public std::runtime_error
   {}
 };
 
-void init();                // initializes API
+void init(double discovery_timeout = 1.0); // initializes API, waits for the first camera
 void fini();                // releases internal resources
 size_t numCameras();        // number of cameras found
 uint64_t getGuid(size_t i); // camera ids
@@ -91,24 +96,67 @@ enum AutoSetting
   AutoOnce
 };
 
+//! Frame handed out to shared frame callbacks. The frame is requeued for
+//! capture only once the last copy of the pointer has been released.
+typedef boost::shared_ptr<tPvFrame> FramePtr;
+
+//! Allocates the storage of one frame buffer. Returns a pointer to at least
+//! size bytes and sets owner to the object keeping that storage alive. The
+//! default allocator returns page aligned buffers.
+typedef boost::function<void* (size_t size, boost::shared_ptr<void>& owner)> BufferAllocator;
+
+class FramePool;
+
+//! Snapshot of the Stat* attributes of a camera.
+struct CameraStatistics
+{
+  tPvFloat32 frame_rate;
+  tPvUint32 frames_completed, frames_dropped;
+  tPvUint32 packets_received, packets_missed, packets_requested,
+            packets_resent, packets_erroneous;
+};
+
+//! Counters of the queue between the PvApi callback and the frame callbacks.
+struct HandoffStatistics
+{
+  size_t depth;              //!< frames waiting right now
+  size_t max_depth;          //!< high-water mark since start()
+  size_t capacity;
+  unsigned long frames;      //!< frames handed to the worker
+  unsigned long overruns;    //!< frames dropped because the queue was full
+};
+
 class Camera
 {
 public:
   static const size_t DEFAULT_BUFFER_SIZE = 4;
+  //! Upper bound on frame buffers while shared frames are held downstream.
+  static const size_t MAX_BUFFER_SIZE = 32;
+  //! Frames that may wait for the frame callback before new ones are dropped.
+  static const size_t HANDOFF_QUEUE_SIZE = 8;
   
-  Camera(unsigned long guid, size_t bufferSize = DEFAULT_BUFFER_SIZE);
-  Camera(const char* ip_address, size_t bufferSize = DEFAULT_BUFFER_SIZE);
+  Camera(unsigned long guid, size_t bufferSize = DEFAULT_BUFFER_SIZE,
+         BufferAllocator allocator = BufferAllocator());
+  Camera(const char* ip_address, size_t bufferSize = DEFAULT_BUFFER_SIZE,
+         BufferAllocator allocator = BufferAllocator());
 
   ~Camera();
 
-  //! Must be used before calling start() in a non-triggered mode.
+  //! Must be used before calling start() in a non-triggered mode. Frame
+  //! callbacks run on a worker thread fed by the PvApi callback, which puts a
+  //! spare buffer into the capture queue as soon as a frame completes. The
+  //! frame itself is requeued as soon as the callback returns.
   void setFrameCallback(boost::function<void (tPvFrame*)> callback);
+  //! Alternative to setFrameCallback(): the frame stays out of the capture
+  //! queue until every copy of the FramePtr is gone. Spare buffers are
+  //! allocated (up to MAX_BUFFER_SIZE) to keep the queue full meanwhile.
+  void setSharedFrameCallback(boost::function<void (const FramePtr&)> callback);
   //! Start capture.
   void start(FrameStartTriggerMode = Freerun, AcquisitionMode = Continuous);
   //! Stop capture.
   void stop();
   //! Capture a single frame from the camera. Must be called after
-  //! start(Software Triggered).
+  //! start(Software Triggered). The frame stays valid until the next grab().
   tPvFrame* grab(unsigned long timeout_ms = PVINFINITE);
 
   void setExposure(unsigned int val, AutoSetting isauto = Manual);
@@ -121,11 +169,25 @@ public:
   void setRoiToWholeFrame();
   void setBinning(unsigned int binning_x = 1, unsigned int binning_y = 1);
 
-  //! General get/set attribute functions.
+  //! General get/set attribute functions. Numeric getAttribute() always
+  //! queries the camera, setAttribute() and setBinning()/setRoi() keep the
+  //! attribute cache up to date.
   void getAttributeEnum(const std::string &name, std::string &value);
   void getAttribute(const std::string &name, tPvUint32 &value);
   void getAttribute(const std::string &name, tPvFloat32 &value);
   void getAttribute(const std::string &name, std::string &value);
+
+  //! Last value set or read, the camera is only queried on the first call.
+  //! Only use for attributes the camera does not change on its own.
+  void getCachedAttribute(const std::string &name, tPvUint32 &value);
+  void getCachedAttribute(const std::string &name, tPvFloat32 &value);
+
+  //! Stat* attributes, queried again only if the last query is older than max_age seconds.
+  CameraStatistics getStatistics(double max_age = 1.0);
+
+  //! Binning in effect when the frame was captured, stamped into the frame
+  //! by the library so per-frame processing does not query the camera.
+  static void getFrameBinning(const tPvFrame* frame, tPvUint32 &binning_x, tPvUint32 &binning_y);
   
   void setAttributeEnum(const std::string &name, const std::string &value);
   void setAttribute(const std::string &name, tPvUint32 value);
@@ -146,18 +208,60 @@ public:
 
   //! Get raw PvApi camera handle.
   tPvHandle handle();
+
+  //! Snapshot of the handoff queue counters, safe to call from any thread.
+  HandoffStatistics getHandoffStatistics();
+
+  //! Number of frames kept in the capture queue (at most MAX_BUFFER_SIZE).
+  //! More buffers absorb longer stalls of the frame callback at high frame
+  //! rates. Takes effect immediately, also while streaming.
+  void setBufferCount(size_t count);
+  //! mlock() the frame buffers so the PvApi receive path never page faults.
+  //! Needs a sufficient locked memory limit (ulimit -l), logs a warning and
+  //! carries on unpinned otherwise. Locking works on whole pages, so custom
+  //! BufferAllocators should not share pages of a buffer with other data.
+  void setBufferPinning(bool pinned);
+
+  //! Owner returned by the BufferAllocator for the buffer of frame.
+  static boost::shared_ptr<void> getBufferOwner(const tPvFrame* frame);
   
 private:
   tPvHandle handle_; // handle to open camera
-  tPvFrame* frames_; // array of frame buffers
+  boost::shared_ptr<FramePool> frames_; // frame buffers, outlive the camera while shared
   tPvUint32 frameSize_; // bytes per frame
-  size_t bufferSize_; // number of frame buffers
+  size_t bufferSize_; // number of frames kept in the capture queue
   FrameStartTriggerMode FSTmode_;
   AcquisitionMode Amode_;
   boost::function<void (tPvFrame*)> userCallback_;
+  boost::function<void (const FramePtr&)> sharedCallback_;
   boost::mutex frameMutex_;
+  FramePtr grabbed_; // buffer of the last grab()
+
+  // Handoff from the PvApi callback thread (producer) to worker_ (consumer)
+  SpscQueue<FramePtr> handoff_;
+  boost::interprocess::interprocess_semaphore handoffReady_;
+  boost::thread worker_;
+  volatile bool workerRunning_;
+  // written by the callback thread, read by diagnostics: __sync builtins only
+  size_t handoffMaxDepth_;
+  unsigned long handoffFrames_, handoffOverruns_;
+
+  // Attribute cache
+  std::map<std::string, tPvUint32> uint32Cache_;
+  std::map<std::string, tPvFloat32> float32Cache_;
+  boost::mutex cacheMutex_;
+  volatile size_t frameBinning_; // BinningX | BinningY << 16, stamped into Context[2]
+  CameraStatistics statistics_;
+  double statisticsTime_;
 
-  void setup();
+  void setup(BufferAllocator allocator);
+  void updateFrameSize();
+  void cacheAttribute(const std::string &name, tPvUint32 value);
+  void stampFrame(tPvFrame* frame);
+  void startWorker();
+  void stopWorker();
+  void workerThread();
+  void handoff(tPvFrame* frame);
   
   static void frameDone(tPvFrame* frame);
 };
@@ -0,0 +1,81 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <cstddef>
+#include <vector>
+
+// Bounded lock-free ring for exactly one producer and one consumer thread.
+// push() and pop() never block; push() fails instead when the ring is full.
+// Boost.Lockfree only arrives in 1.53, hence the GCC builtin barriers.
+template <typename T>
+class SpscQueue
+{
+public:
+  SpscQueue(size_t capacity)
+    : buffer_(capacity + 1), head_(0), tail_(0)
+  {}
+
+  //! Producer side.
+  bool push(const T& value)
+  {
+    size_t tail = tail_;
+    size_t next = increment(tail);
+    if (next == load(head_))
+      return false; // full
+    buffer_[tail] = value;
+    store(tail_, next);
+    return true;
+  }
+
+  //! Consumer side.
+  bool pop(T& value)
+  {
+    size_t head = head_;
+    if (head == load(tail_))
+      return false; // empty
+    value = buffer_[head];
+    buffer_[head] = T(); // don't keep the element alive in the slot
+    store(head_, increment(head));
+    return true;
+  }
+
+  //! Number of queued elements, exact only on the producer or consumer thread.
+  size_t size() const
+  {
+    size_t head = load(head_), tail = load(tail_);
+    return tail >= head ? tail - head : tail + buffer_.size() - head;
+  }
+
+  size_t capacity() const
+  {
+    return buffer_.size() - 1;
+  }
+
+private:
+  size_t increment(size_t i) const
+  {
+    return ++i == buffer_.size() ? 0 : i;
+  }
+
+  static size_t load(const volatile size_t& index)
+  {
+    size_t value = index;
+    __sync_synchronize();
+    return value;
+  }
+
+  static void store(volatile size_t& index, size_t value)
+  {
+    __sync_synchronize();
+    index = value;
+  }
+
+  std::vector<T> buffer_;
+  // head_ is written by the consumer only, tail_ by the producer only; keep
+  // them on separate cache lines
+  volatile size_t head_;
+  char pad_[64 - sizeof(size_t)];
+  volatile size_t tail_;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef PROSILICA_TRIGGER_MATCHER_H
+#define PROSILICA_TRIGGER_MATCHER_H
+
+#include <deque>
+#include <boost/thread.hpp>
+
+namespace prosilica {
+
+//! Counters of TriggerMatcher for diagnostics.
+struct TriggerMatchStatistics
+{
+  unsigned long matched;
+  unsigned long unmatched_frames;   //!< frames without a trigger, e.g. trigger message lost
+  unsigned long unmatched_triggers; //!< triggers without a frame, e.g. frame dropped
+  unsigned long resyncs;            //!< times the sequence offset had to be re-established
+  double latency;                   //!< estimated trigger to time stamp delay, seconds
+};
+
+/// Pairs hardware trigger time stamps (from a trigger message topic) with
+/// the frames they caused. Once a pair is found by time, the offset between
+/// trigger sequence numbers and camera frame counts is locked in, so a lost
+/// trigger message or dropped frame skips exactly one pair instead of
+/// shifting every following stamp. All times are in seconds.
+class TriggerMatcher
+{
+public:
+  TriggerMatcher(size_t history = 32);
+
+  //! Expected trigger period, matching tolerates half of it.
+  void setPeriod(double period);
+  //! Forget all history, e.g. when streaming restarts.
+  void reset();
+
+  void addTrigger(unsigned long seq, double time);
+
+  //! Finds the trigger of a frame, waiting up to max_wait seconds for the
+  //! trigger message to arrive. frame_count is tPvFrame::FrameCount,
+  //! frame_time the frame's (host) time stamp.
+  bool matchFrame(unsigned long frame_count, double frame_time, double& trigger_time,
+                  double max_wait = 0.0);
+
+  TriggerMatchStatistics getStatistics();
+
+private:
+  struct Trigger
+  {
+    unsigned long seq;
+    double time;
+  };
+
+  size_t history_;
+  double period_;
+  std::deque<Trigger> triggers_;
+  bool locked_;
+  long seq_offset_; // trigger seq - frame count
+  TriggerMatchStatistics stats_;
+
+  boost::mutex mutex_;
+  boost::condition_variable trigger_added_;
+
+  // require mutex_
+  int findBySequence(unsigned long frame_count, double frame_time);
+  int findByTime(double frame_time);
+  void consume(size_t index);
+};
+
+} // namespace prosilica
+
+#endif
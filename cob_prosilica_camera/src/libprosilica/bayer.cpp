@@ -0,0 +1,203 @@
+#include "prosilica/bayer.h"
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace prosilica {
+
+// bgr channel of each cell of a 2x2 Bayer tile, in tPvBayerPattern order
+static const int B = 0, G = 1, R = 2;
+static const int CELLS[4][4] = { { R, G, G, B },   // ePvBayerRGGB
+                                 { G, B, R, G },   // ePvBayerGBRG
+                                 { G, R, B, G },   // ePvBayerGRBG
+                                 { B, G, G, R } }; // ePvBayerBGGR
+
+// Bilinear interpolation of one pixel. color is the channel sampled at x,
+// other the non-green channel of the current row.
+static inline void interpolate(const unsigned char* up, const unsigned char* cur,
+                               const unsigned char* down, size_t xl, size_t x, size_t xr,
+                               int color, int other, unsigned char* bgr)
+{
+  if (color == G) {
+    bgr[G] = cur[x];
+    bgr[other] = (cur[xl] + cur[xr] + 1) >> 1;
+    bgr[2 - other] = (up[x] + down[x] + 1) >> 1;
+  }
+  else {
+    bgr[color] = cur[x];
+    bgr[G] = (up[x] + down[x] + cur[xl] + cur[xr] + 2) >> 2;
+    bgr[2 - color] = (up[xl] + up[xr] + down[xl] + down[xr] + 2) >> 2;
+  }
+}
+
+// ITU-R BT.601 luma in 8 bit fixed point
+static inline unsigned char luma(const unsigned char* bgr)
+{
+  return (29 * bgr[B] + 150 * bgr[G] + 77 * bgr[R] + 128) >> 8;
+}
+
+#ifdef __SSE2__
+// (a + b + c + d + 2) >> 2 of 16 pixels, exact like the scalar code
+static inline __m128i average4(__m128i a, __m128i b, __m128i c, __m128i d)
+{
+  const __m128i zero = _mm_setzero_si128(), two = _mm_set1_epi16(2);
+  __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)),
+                             _mm_add_epi16(_mm_unpacklo_epi8(c, zero), _mm_unpacklo_epi8(d, zero)));
+  __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)),
+                             _mm_add_epi16(_mm_unpackhi_epi8(c, zero), _mm_unpackhi_epi8(d, zero)));
+  lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+  hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+  return _mm_packus_epi16(lo, hi);
+}
+
+static inline __m128i select(__m128i mask, __m128i a, __m128i b)
+{
+  return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// Interpolates the interior pixels of a row 16 at a time, starting at x = 1.
+// Returns the first x left to the scalar code, always odd.
+static size_t interpolateRowSse2(const unsigned char* up, const unsigned char* cur,
+                                 const unsigned char* down, size_t width,
+                                 const int* row, int other, unsigned char* dst,
+                                 unsigned char* mono)
+{
+  // green at odd x (first lane) or at even x
+  const __m128i green = row[1] == G ? _mm_set1_epi16(0x00ff) : _mm_set1_epi16((short)0xff00);
+  const __m128i wb = _mm_set1_epi16(29), wg = _mm_set1_epi16(150), wr = _mm_set1_epi16(77);
+  const __m128i rounding = _mm_set1_epi16(128), zero = _mm_setzero_si128();
+  const int third = 2 - other;
+
+  size_t x = 1;
+  for (; x + 17 <= width; x += 16) {
+    __m128i c  = _mm_loadu_si128((const __m128i*)(cur + x));
+    __m128i l  = _mm_loadu_si128((const __m128i*)(cur + x - 1));
+    __m128i r  = _mm_loadu_si128((const __m128i*)(cur + x + 1));
+    __m128i u  = _mm_loadu_si128((const __m128i*)(up + x));
+    __m128i ul = _mm_loadu_si128((const __m128i*)(up + x - 1));
+    __m128i ur = _mm_loadu_si128((const __m128i*)(up + x + 1));
+    __m128i d  = _mm_loadu_si128((const __m128i*)(down + x));
+    __m128i dl = _mm_loadu_si128((const __m128i*)(down + x - 1));
+    __m128i dr = _mm_loadu_si128((const __m128i*)(down + x + 1));
+
+    // _mm_avg_epu8 rounds up, same as (a + b + 1) >> 1
+    __m128i plane[3];
+    plane[G] = select(green, c, average4(u, d, l, r));
+    plane[other] = select(green, _mm_avg_epu8(l, r), c);
+    plane[third] = select(green, _mm_avg_epu8(u, d), average4(ul, ur, dl, dr));
+
+    unsigned char b[16], g[16], rr[16];
+    _mm_storeu_si128((__m128i*)b, plane[B]);
+    _mm_storeu_si128((__m128i*)g, plane[G]);
+    _mm_storeu_si128((__m128i*)rr, plane[R]);
+    unsigned char* out = dst + 3 * x;
+    for (int i = 0; i < 16; ++i, out += 3) {
+      out[B] = b[i];
+      out[G] = g[i];
+      out[R] = rr[i];
+    }
+
+    if (mono) {
+      // the weights sum up to 256, so the 16 bit sums cannot overflow
+      __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(plane[B], zero), wb),
+                                               _mm_mullo_epi16(_mm_unpacklo_epi8(plane[G], zero), wg)),
+                                 _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(plane[R], zero), wr), rounding));
+      __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(plane[B], zero), wb),
+                                               _mm_mullo_epi16(_mm_unpackhi_epi8(plane[G], zero), wg)),
+                                 _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(plane[R], zero), wr), rounding));
+      _mm_storeu_si128((__m128i*)(mono + x),
+                       _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+    }
+  }
+  return x;
+}
+#endif
+
+void demosaic(const unsigned char* bayer, size_t width, size_t height, size_t step,
+              tPvBayerPattern pattern, const DemosaicOutput& out)
+{
+  if (width < 2 || height < 2 || (unsigned)pattern > ePvBayerBGGR)
+    return;
+  const int* cells = CELLS[pattern];
+
+  // mono without bgr still needs the interpolated row
+  std::vector<unsigned char> scratch;
+  if (out.mono && !out.bgr)
+    scratch.resize(width * 3);
+
+  for (size_t y = 0; y < height; ++y) {
+    const unsigned char* cur  = bayer + y * step;
+    const unsigned char* up   = bayer + (y > 0 ? y - 1 : 1) * step;
+    const unsigned char* down = bayer + (y + 1 < height ? y + 1 : height - 2) * step;
+    const int* row = cells + (y & 1) * 2; // channels at even and odd x
+    int other = row[0] == G ? row[1] : row[0];
+
+    if (out.bgr || out.mono) {
+      unsigned char* dst = out.bgr ? out.bgr + y * out.bgr_step : &scratch[0];
+
+      unsigned char* mono = out.mono ? out.mono + y * out.mono_step : NULL;
+
+      interpolate(up, cur, down, 1, 0, 1, row[0], other, dst);
+      size_t x = 1;
+#ifdef __SSE2__
+      x = interpolateRowSse2(up, cur, down, width, row, other, dst, mono);
+#endif
+      size_t scalar_begin = x;
+      // pairs of odd/even pixels, so the channel layout is loop invariant
+      for (; x + 2 < width; x += 2) {
+        interpolate(up, cur, down, x - 1, x, x + 1, row[1], other, dst + 3 * x);
+        interpolate(up, cur, down, x, x + 1, x + 2, row[0], other, dst + 3 * x + 3);
+      }
+      for (; x + 1 < width; ++x)
+        interpolate(up, cur, down, x - 1, x, x + 1, row[x & 1], other, dst + 3 * x);
+      interpolate(up, cur, down, width - 2, width - 1, width - 2, row[(width - 1) & 1],
+                  other, dst + 3 * (width - 1));
+
+      if (mono) {
+        // the SIMD path has filled in the pixels in between already
+        mono[0] = luma(dst);
+        for (size_t i = scalar_begin; i < width; ++i)
+          mono[i] = luma(dst + 3 * i);
+      }
+    }
+
+    // Downscaled outputs are averaged straight from the raw samples once all
+    // rows of a cell (2x2) or block (4x4) have been seen
+    if (out.half && (y & 1)) {
+      const unsigned char* a = cur - step;
+      unsigned char* dst = out.half + (y / 2) * out.half_step;
+      for (size_t x = 0; x + 1 < width; x += 2) {
+        int sum[3] = { 0, 0, 0 };
+        sum[cells[0]] += a[x];
+        sum[cells[1]] += a[x + 1];
+        sum[cells[2]] += cur[x];
+        sum[cells[3]] += cur[x + 1];
+        dst[B] = sum[B];
+        dst[G] = (sum[G] + 1) >> 1;
+        dst[R] = sum[R];
+        dst += 3;
+      }
+    }
+
+    if (out.quarter && (y & 3) == 3) {
+      unsigned char* dst = out.quarter + (y / 4) * out.quarter_step;
+      for (size_t x = 0; x + 3 < width; x += 4) {
+        int sum[3] = { 0, 0, 0 };
+        for (size_t r = 0; r < 4; ++r) {
+          const unsigned char* src = cur - (3 - r) * step + x;
+          const int* c = cells + (r & 1) * 2;
+          sum[c[0]] += src[0] + src[2];
+          sum[c[1]] += src[1] + src[3];
+        }
+        dst[B] = (sum[B] + 2) >> 2;
+        dst[G] = (sum[G] + 4) >> 3;
+        dst[R] = (sum[R] + 2) >> 2;
+        dst += 3;
+      }
+    }
+  }
+}
+
+} // namespace prosilica
@@ -0,0 +1,228 @@
+#include "prosilica/clock_sync.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <boost/bind.hpp>
+#include <ros/console.h>
+
+namespace prosilica {
+
+// Samples slower than this multiple of the best recent round trip are
+// dominated by scheduling or network delay and would only add noise.
+static const double MAX_ROUND_TRIP_FACTOR = 2.0;
+static const double MIN_ROUND_TRIP_LIMIT = 0.0005;
+// Latches the best round trip is taken from; after this many rejections in a
+// row the best of them is accepted regardless.
+static const size_t RECENT_LATCHES = 10;
+
+static double wallTime()
+{
+  timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+ClockSync::ClockSync(Camera& cam, double period, size_t window)
+  : cam_(cam), period_(period), window_(window < 2 ? 2 : window),
+    rejected_in_row_(0), accepted_(0),
+    ticks0_(0), host0_(0.0), slope_(0.0), residual_(0.0), valid_(false),
+    running_(false)
+{
+  tPvUint32 frequency = 0;
+  if (PvAttrUint32Get(cam_.handle(), "TimeStampFrequency", &frequency) != ePvErrSuccess || frequency == 0) {
+    ROS_WARN("Couldn't read TimeStampFrequency, assuming 1 us ticks");
+    frequency = 1000000;
+  }
+  nominal_period_ = 1.0 / frequency;
+  slope_ = nominal_period_;
+}
+
+ClockSync::~ClockSync()
+{
+  stop();
+}
+
+void ClockSync::start()
+{
+  if (running_)
+    return;
+  running_ = true;
+  thread_ = boost::thread(boost::bind(&ClockSync::run, this));
+}
+
+void ClockSync::stop()
+{
+  if (!running_)
+    return;
+  running_ = false;
+  thread_.interrupt();
+  thread_.join();
+}
+
+void ClockSync::run()
+{
+  try {
+    bool warned = false;
+    while (running_) {
+      sample();
+      bool stale = isStale();
+      if (stale && !warned)
+        ROS_WARN("No camera clock sample accepted for a while, frame time stamps will drift");
+      warned = stale;
+      boost::this_thread::sleep(boost::posix_time::microseconds((long)(period_ * 1e6)));
+    }
+  }
+  catch (boost::thread_interrupted&) {
+  }
+}
+
+bool ClockSync::sample()
+{
+  tPvHandle handle = cam_.handle();
+  tPvUint32 hi, lo;
+
+  double before = wallTime();
+  if (PvCommandRun(handle, "TimeStampValueLatch") != ePvErrSuccess)
+    return false;
+  double after = wallTime();
+  // The latch happens somewhere within the command round trip
+  if (PvAttrUint32Get(handle, "TimeStampValueHi", &hi) != ePvErrSuccess ||
+      PvAttrUint32Get(handle, "TimeStampValueLo", &lo) != ePvErrSuccess)
+    return false;
+
+  Sample s;
+  s.ticks = ((uint64_t)hi << 32) | (lo & 0xffffffffUL);
+  s.host = 0.5 * (before + after);
+  s.round_trip = after - before;
+
+  boost::lock_guard<boost::mutex> guard(mutex_);
+  // Counter reset (camera rebooted or TimeStampReset): start over
+  if ((!samples_.empty() && s.ticks <= samples_.back().ticks) ||
+      (!recent_.empty() && s.ticks <= recent_.back().ticks)) {
+    samples_.clear();
+    recent_.clear();
+    rejected_in_row_ = 0;
+  }
+
+  // The best round trip ages out with the recent latches, so one lucky fast
+  // latch can't block all later ones
+  recent_.push_back(s);
+  while (recent_.size() > RECENT_LATCHES)
+    recent_.pop_front();
+  size_t best = 0;
+  for (size_t i = 1; i < recent_.size(); ++i)
+    if (recent_[i].round_trip < recent_[best].round_trip)
+      best = i;
+
+  if (s.round_trip > std::max(MAX_ROUND_TRIP_FACTOR * recent_[best].round_trip, MIN_ROUND_TRIP_LIMIT)) {
+    if (++rejected_in_row_ < RECENT_LATCHES)
+      return false;
+    // All recent latches were rejected, so they are newer than the last
+    // accepted one and the fit can take the best of them
+    ROS_DEBUG("No fast clock latch in %u tries, taking the best (%.3f ms)",
+              (unsigned)rejected_in_row_, recent_[best].round_trip * 1000.0);
+    s = recent_[best];
+  }
+  rejected_in_row_ = 0;
+
+  samples_.push_back(s);
+  while (samples_.size() > window_)
+    samples_.pop_front();
+  ++accepted_;
+
+  fit();
+  return true;
+}
+
+// Least squares line through the window, in coordinates relative to the
+// newest sample so doubles keep sub-microsecond resolution.
+void ClockSync::fit()
+{
+  const Sample& ref = samples_.back();
+  size_t n = samples_.size();
+
+  double slope = nominal_period_;
+  double mean_x = 0.0, mean_y = 0.0;
+  for (size_t i = 0; i < n; ++i) {
+    mean_x += (double)(int64_t)(samples_[i].ticks - ref.ticks);
+    mean_y += samples_[i].host - ref.host;
+  }
+  mean_x /= n;
+  mean_y /= n;
+
+  if (n >= 2) {
+    double sxx = 0.0, sxy = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+      double dx = (double)(int64_t)(samples_[i].ticks - ref.ticks) - mean_x;
+      double dy = samples_[i].host - ref.host - mean_y;
+      sxx += dx * dx;
+      sxy += dx * dy;
+    }
+    // A drift beyond 1000 ppm means the samples are garbage, keep the nominal rate
+    if (sxx > 0.0 && fabs(sxy / sxx / nominal_period_ - 1.0) < 1e-3)
+      slope = sxy / sxx;
+  }
+
+  ticks0_ = ref.ticks;
+  host0_ = ref.host + mean_y - slope * mean_x;
+  slope_ = slope;
+
+  double sum_sq = 0.0;
+  for (size_t i = 0; i < n; ++i) {
+    double predicted = host0_ + slope_ * (double)(int64_t)(samples_[i].ticks - ticks0_);
+    double error = samples_[i].host - predicted;
+    sum_sq += error * error;
+  }
+  residual_ = sqrt(sum_sq / n);
+  valid_ = true;
+}
+
+bool ClockSync::toHostTime(uint64_t ticks, double& host_time)
+{
+  boost::lock_guard<boost::mutex> guard(mutex_);
+  if (!valid_)
+    return false;
+  host_time = host0_ + slope_ * (double)(int64_t)(ticks - ticks0_);
+  return true;
+}
+
+uint64_t ClockSync::frameTicks(const tPvFrame* frame)
+{
+  return ((uint64_t)frame->TimestampHi << 32) | (frame->TimestampLo & 0xffffffffUL);
+}
+
+size_t ClockSync::numSamples()
+{
+  boost::lock_guard<boost::mutex> guard(mutex_);
+  return samples_.size();
+}
+
+unsigned long ClockSync::numAccepted()
+{
+  boost::lock_guard<boost::mutex> guard(mutex_);
+  return accepted_;
+}
+
+bool ClockSync::isStale()
+{
+  boost::lock_guard<boost::mutex> guard(mutex_);
+  // at most RECENT_LATCHES periods pass between accepted samples
+  if (samples_.empty())
+    return false;
+  return wallTime() - samples_.back().host > 2.0 * RECENT_LATCHES * period_;
+}
+
+double ClockSync::residual()
+{
+  boost::lock_guard<boost::mutex> guard(mutex_);
+  return residual_;
+}
+
+double ClockSync::driftPpm()
+{
+  boost::lock_guard<boost::mutex> guard(mutex_);
+  return (slope_ / nominal_period_ - 1.0) * 1e6;
+}
+
+} // namespace prosilica
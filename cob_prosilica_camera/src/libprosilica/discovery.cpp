@@ -0,0 +1,269 @@
+#include "prosilica/discovery.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#include <ros/console.h>
+
+namespace prosilica {
+
+static const size_t MAX_DISCOVERED_CAMERAS = 64;
+// Replies to the discovery broadcast trickle in; the list counts as complete
+// once it hasn't changed for this long.
+static const double STABLE_TIME = 0.25;
+static const useconds_t POLL_INTERVAL_US = 20000;
+
+static double monotonicSeconds()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static std::string addressString(unsigned long addr)
+{
+  struct in_addr in;
+  in.s_addr = addr;
+  return inet_ntoa(in);
+}
+
+static void fillInfo(const tPvCameraInfo& pv_info, CameraInfo& info)
+{
+  info.guid = pv_info.UniqueId;
+  info.model = pv_info.DisplayName;
+  info.serial = pv_info.SerialString;
+  info.firmware.clear();
+  info.ip_address.clear();
+}
+
+std::vector<CameraInfo> discoverCameras(double timeout, size_t expected)
+{
+  tPvCameraInfo list[MAX_DISCOVERED_CAMERAS];
+  unsigned long count = 0, last_count = 0;
+  double start = monotonicSeconds(), changed = start;
+
+  for (;;) {
+    count = PvCameraList(list, MAX_DISCOVERED_CAMERAS, NULL);
+    double now = monotonicSeconds();
+    if (count != last_count) {
+      last_count = count;
+      changed = now;
+    }
+    if (expected ? count >= expected : (count > 0 && now - changed >= STABLE_TIME))
+      break;
+    if (now - start >= timeout)
+      break;
+    usleep(POLL_INTERVAL_US);
+  }
+
+  std::vector<CameraInfo> cameras(count);
+  for (unsigned long i = 0; i < count; ++i) {
+    fillInfo(list[i], cameras[i]);
+    tPvIpSettings settings;
+    if (list[i].InterfaceType == ePvInterfaceEthernet &&
+        PvCameraIpSettingsGet(list[i].UniqueId, &settings) == ePvErrSuccess)
+      cameras[i].ip_address = addressString(settings.CurrentIpAddress);
+  }
+  return cameras;
+}
+
+bool queryCamera(const std::string& ip_address, CameraInfo& info)
+{
+  unsigned long addr = inet_addr(ip_address.c_str());
+  tPvCameraInfo pv_info;
+  tPvIpSettings settings;
+  if (PvCameraInfoByAddr(addr, &pv_info, &settings) != ePvErrSuccess)
+    return false;
+  fillInfo(pv_info, info);
+  info.ip_address = addressString(settings.CurrentIpAddress);
+  return true;
+}
+
+CameraInfo describeCamera(Camera& cam)
+{
+  CameraInfo info;
+  info.guid = cam.guid();
+
+  tPvCameraInfo pv_info;
+  if (PvCameraInfo(info.guid, &pv_info) == ePvErrSuccess)
+    fillInfo(pv_info, info);
+
+  tPvIpSettings settings;
+  if (PvCameraIpSettingsGet(info.guid, &settings) == ePvErrSuccess)
+    info.ip_address = addressString(settings.CurrentIpAddress);
+
+  tPvUint32 major, minor, build;
+  if (PvAttrUint32Get(cam.handle(), "FirmwareVerMajor", &major) == ePvErrSuccess &&
+      PvAttrUint32Get(cam.handle(), "FirmwareVerMinor", &minor) == ePvErrSuccess) {
+    std::ostringstream version;
+    version << major << "." << minor;
+    if (PvAttrUint32Get(cam.handle(), "FirmwareVerBuild", &build) == ePvErrSuccess)
+      version << "." << build;
+    info.firmware = version.str();
+  }
+  return info;
+}
+
+std::string defaultDiscoveryCachePath()
+{
+  const char* ros_home = getenv("ROS_HOME");
+  if (ros_home && *ros_home)
+    return std::string(ros_home) + "/prosilica_cameras";
+  const char* home = getenv("HOME");
+  if (home && *home)
+    return std::string(home) + "/.ros/prosilica_cameras";
+  return "";
+}
+
+// Fields are tab separated, "-" stands for an unknown value
+static std::string field(const std::string& value)
+{
+  return value.empty() ? "-" : value;
+}
+
+static std::string unfield(const std::string& value)
+{
+  return value == "-" ? "" : value;
+}
+
+static bool readCache(const std::string& path, std::vector<CameraInfo>& cameras)
+{
+  std::ifstream file(path.c_str());
+  if (!file)
+    return false;
+
+  cameras.clear();
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#')
+      continue;
+    std::vector<std::string> fields;
+    std::istringstream fields_stream(line);
+    std::string value;
+    while (std::getline(fields_stream, value, '\t'))
+      fields.push_back(value);
+    if (fields.size() < 5)
+      continue;
+
+    CameraInfo info;
+    info.guid = strtoul(fields[0].c_str(), NULL, 0);
+    info.ip_address = unfield(fields[1]);
+    info.model = unfield(fields[2]);
+    info.serial = unfield(fields[3]);
+    info.firmware = unfield(fields[4]);
+    if (info.guid != 0)
+      cameras.push_back(info);
+  }
+  return true;
+}
+
+// Written next to the cache and renamed over it, readers never see half a file
+static bool writeCache(const std::string& path, const std::vector<CameraInfo>& cameras)
+{
+  std::ostringstream tmp_path;
+  tmp_path << path << ".tmp" << getpid();
+  {
+    std::ofstream file(tmp_path.str().c_str());
+    if (!file)
+      return false;
+    file << "# guid\tip_address\tmodel\tserial\tfirmware\n";
+    for (size_t i = 0; i < cameras.size(); ++i) {
+      const CameraInfo& info = cameras[i];
+      file << info.guid << "\t" << field(info.ip_address) << "\t" << field(info.model) << "\t"
+           << field(info.serial) << "\t" << field(info.firmware) << "\n";
+    }
+    if (!file)
+      return false;
+  }
+  if (rename(tmp_path.str().c_str(), path.c_str()) != 0) {
+    unlink(tmp_path.str().c_str());
+    return false;
+  }
+  return true;
+}
+
+/// Serializes read-modify-write cycles of several nodes starting at once.
+class CacheLock
+{
+public:
+  CacheLock(const std::string& path)
+  {
+    fd_ = open((path + ".lock").c_str(), O_RDWR | O_CREAT, 0666);
+    if (fd_ >= 0)
+      flock(fd_, LOCK_EX);
+  }
+
+  ~CacheLock()
+  {
+    if (fd_ >= 0)
+      close(fd_); // releases the lock
+  }
+
+private:
+  int fd_;
+};
+
+bool loadDiscoveryCache(const std::string& path, std::vector<CameraInfo>& cameras)
+{
+  return readCache(path, cameras);
+}
+
+bool saveDiscoveryCache(const std::string& path, const std::vector<CameraInfo>& cameras)
+{
+  CacheLock lock(path);
+  if (!writeCache(path, cameras)) {
+    ROS_WARN("Couldn't write camera discovery cache %s: %s", path.c_str(), strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+bool updateDiscoveryCache(const std::string& path, const CameraInfo& camera)
+{
+  CacheLock lock(path);
+  std::vector<CameraInfo> cameras;
+  readCache(path, cameras); // a missing cache is simply empty
+
+  bool found = false;
+  for (size_t i = 0; i < cameras.size(); ++i) {
+    if (cameras[i].guid == camera.guid) {
+      std::string firmware = cameras[i].firmware;
+      cameras[i] = camera;
+      if (cameras[i].firmware.empty())
+        cameras[i].firmware = firmware; // discovery alone doesn't know it
+      found = true;
+    }
+    // Another camera that used to have this address has moved
+    else if (!camera.ip_address.empty() && cameras[i].ip_address == camera.ip_address)
+      cameras[i].ip_address.clear();
+  }
+  if (!found)
+    cameras.push_back(camera);
+
+  if (!writeCache(path, cameras)) {
+    ROS_WARN("Couldn't write camera discovery cache %s: %s", path.c_str(), strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+bool findCachedCamera(const std::vector<CameraInfo>& cameras, unsigned long guid, CameraInfo& info)
+{
+  for (size_t i = 0; i < cameras.size(); ++i) {
+    if (cameras[i].guid == guid) {
+      info = cameras[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace prosilica
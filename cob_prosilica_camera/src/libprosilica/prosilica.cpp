@@ -34,11 +34,19 @@
 
 #include "prosilica/prosilica.h"
 #include <PvRegIo.h>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
 #include <cstdio>
+#include <cstdlib>
 #include <ctime>
 #include <cstring>
+#include <new>
 #include <arpa/inet.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+#include <boost/enable_shared_from_this.hpp>
 
 #include <ros/console.h>
 
@@ -85,16 +93,16 @@ static const char* errorStrings[] = {"No error",
 static tPvCameraInfo cameraList[MAX_CAMERA_LIST];
 static unsigned long cameraNum = 0;
 
-void init()
+void init(double discovery_timeout)
 {
   CHECK_ERR( PvInitialize(), "Failed to initialize Prosilica API" );
 
-  // Spend up to 1s trying to find a camera. Finding no camera is not
-  // an error; the user may still be able open one by IP address.
-  for (int tries = 0; tries < 5; ++tries)
+  // Spend up to discovery_timeout trying to find a camera. Finding no camera
+  // is not an error; the user may still be able open one by IP address.
+  for (double waited = 0.0; ; waited += 0.2)
   {
     cameraNum = PvCameraList(cameraList, MAX_CAMERA_LIST, NULL);
-    if (cameraNum)
+    if (cameraNum || waited >= discovery_timeout)
       return;
     usleep(200000);
   }
@@ -135,27 +143,311 @@ static void openCamera(boost::function<tPvErr (tPvCameraInfo*)> info_fn,
   CHECK_ERR( open_fn(ePvAccessMaster), "Unable to open requested camera" );
 }
 
-Camera::Camera(unsigned long guid, size_t bufferSize)
-  : bufferSize_(bufferSize), FSTmode_(None)
+// Page aligned and padded to whole pages, so pinning one buffer never locks
+// or unlocks pages of another.
+static void* allocateBuffer(size_t size, boost::shared_ptr<void>& owner)
 {
+  size_t page = sysconf(_SC_PAGESIZE);
+  void* buffer = NULL;
+  if (posix_memalign(&buffer, page, (size + page - 1) / page * page) != 0)
+    throw std::bad_alloc();
+  owner.reset(buffer, free);
+  return buffer;
+}
+
+/// Frame buffers of one camera. Frames claimed for shared callbacks hold a
+/// reference to the pool and are requeued (or parked on the free list) when
+/// released, so buffers stay valid even if the Camera goes away first.
+/// Buffers of the wrong size for the current frame size are reallocated the
+/// next time they would be queued.
+class FramePool : public boost::enable_shared_from_this<FramePool>
+{
+public:
+  FramePool(tPvHandle handle, void* context, tPvUint32 frameSize, size_t queueSize,
+            const BufferAllocator& allocator)
+    : handle_(handle), context_(context), frameSize_(frameSize), queueSize_(queueSize),
+      allocator_(allocator.empty() ? BufferAllocator(allocateBuffer) : allocator),
+      callback_(NULL), capturing_(false), queued_(0), pinned_(false), pinFailed_(false)
+  {
+    boost::lock_guard<boost::mutex> guard(mutex_);
+    for (size_t i = 0; i < queueSize_; ++i)
+      free_.push_back(allocate());
+  }
+
+  ~FramePool()
+  {
+    // Zero-copy buffers may outlive the pool, don't leave them locked
+    for (size_t i = 0; i < buffers_.size(); ++i) {
+      unpin(buffers_[i]);
+      delete buffers_[i];
+    }
+  }
+
+  size_t size()
+  {
+    boost::lock_guard<boost::mutex> guard(mutex_);
+    return buffers_.size();
+  }
+
+  void startCapture(tPvFrameCallback callback)
+  {
+    boost::lock_guard<boost::mutex> guard(mutex_);
+    callback_ = callback;
+    capturing_ = true;
+    queued_ = 0;
+    fill();
+  }
+
+  //! Called before the capture queue is cleared, released frames are no longer requeued.
+  void stopCapture()
+  {
+    boost::lock_guard<boost::mutex> guard(mutex_);
+    capturing_ = false;
+  }
+
+  //! Called after the capture queue was cleared, everything not held downstream is free.
+  void reclaim()
+  {
+    boost::lock_guard<boost::mutex> guard(mutex_);
+    queued_ = 0;
+    free_.clear();
+    for (size_t i = 0; i < buffers_.size(); ++i)
+      if (!buffers_[i]->held)
+        free_.push_back(buffers_[i]);
+  }
+
+  //! Number of frames kept in the capture queue. Extra frames drain as they complete.
+  void setQueueSize(size_t queueSize)
+  {
+    boost::lock_guard<boost::mutex> guard(mutex_);
+    queueSize_ = queueSize;
+    while (buffers_.size() < queueSize_)
+      free_.push_back(allocate());
+    if (capturing_)
+      fill();
+  }
+
+  //! Free buffers are reallocated right away, queued and held ones when they come back.
+  void setFrameSize(tPvUint32 frameSize)
+  {
+    boost::lock_guard<boost::mutex> guard(mutex_);
+    frameSize_ = frameSize;
+    for (size_t i = 0; i < free_.size(); ++i)
+      refresh(free_[i]);
+  }
+
+  //! Locks all buffers into RAM, so the PvApi receive path never page faults.
+  void setPinned(bool pinned)
+  {
+    boost::lock_guard<boost::mutex> guard(mutex_);
+    pinned_ = pinned;
+    for (size_t i = 0; i < buffers_.size(); ++i) {
+      if (pinned_)
+        pin(buffers_[i]);
+      else
+        unpin(buffers_[i]);
+    }
+  }
+
+  //! Takes a completed frame out of circulation and tops up the capture queue.
+  FramePtr claim(tPvFrame* frame)
+  {
+    {
+      boost::lock_guard<boost::mutex> guard(mutex_);
+      buffer(frame)->held = true;
+      --queued_;
+      if (capturing_)
+        fill();
+    }
+    return FramePtr(frame, Releaser(shared_from_this()));
+  }
+
+  //! Takes a free buffer out of circulation for a single software triggered
+  //! capture, released like a claimed frame. Empty if all buffers are held.
+  FramePtr claimFree()
+  {
+    FrameBuffer* b = NULL;
+    {
+      boost::lock_guard<boost::mutex> guard(mutex_);
+      if (!free_.empty()) {
+        b = free_.back();
+        free_.pop_back();
+      }
+      else if (buffers_.size() < Camera::MAX_BUFFER_SIZE)
+        b = allocate();
+      else
+        return FramePtr();
+      refresh(b);
+      b->held = true;
+    }
+    return FramePtr(&b->frame, Releaser(shared_from_this()));
+  }
+
+  static boost::shared_ptr<void> owner(const tPvFrame* frame)
+  {
+    return buffer(frame)->owner;
+  }
+
+private:
+  struct FrameBuffer
+  {
+    tPvFrame frame;
+    boost::shared_ptr<void> owner; // keeps frame.ImageBuffer alive
+    bool held; // claimed by a shared frame callback
+    bool locked; // frame.ImageBuffer is mlock()ed
+  };
+
+  struct Releaser
+  {
+    boost::shared_ptr<FramePool> pool;
+    Releaser(const boost::shared_ptr<FramePool>& p) : pool(p) {}
+    void operator()(tPvFrame* frame) { pool->release(frame); }
+  };
+
+  static FrameBuffer* buffer(const tPvFrame* frame)
+  {
+    return (FrameBuffer*) frame->Context[1];
+  }
+
+  // The following require mutex_ to be held.
+  FrameBuffer* allocate()
+  {
+    FrameBuffer* b = new FrameBuffer;
+    memset(&b->frame, 0, sizeof(tPvFrame));
+    b->frame.ImageBuffer = allocator_(frameSize_, b->owner);
+    b->frame.ImageBufferSize = frameSize_;
+    b->frame.Context[0] = context_; // for frameDone callback
+    b->frame.Context[1] = (void*)b;
+    b->held = false;
+    b->locked = false;
+    if (pinned_)
+      pin(b);
+    buffers_.push_back(b);
+    return b;
+  }
+
+  // Reallocates the storage of b if it is too small for a frame, or more than
+  // twice as large as needed (memory held by a large ROI no longer in use).
+  void refresh(FrameBuffer* b)
+  {
+    unsigned long size = b->frame.ImageBufferSize;
+    if (size >= frameSize_ && size / 2 <= frameSize_)
+      return;
+    unpin(b);
+    b->owner.reset();
+    b->frame.ImageBuffer = allocator_(frameSize_, b->owner);
+    b->frame.ImageBufferSize = frameSize_;
+    if (pinned_)
+      pin(b);
+  }
+
+  void pin(FrameBuffer* b)
+  {
+    if (b->locked)
+      return;
+    if (mlock(b->frame.ImageBuffer, b->frame.ImageBufferSize) == 0)
+      b->locked = true;
+    else if (!pinFailed_) {
+      ROS_WARN("Unable to lock frame buffers into memory (%s), raise the locked memory "
+               "limit (ulimit -l) to avoid page faults while receiving", strerror(errno));
+      pinFailed_ = true;
+    }
+  }
+
+  void unpin(FrameBuffer* b)
+  {
+    if (!b->locked)
+      return;
+    munlock(b->frame.ImageBuffer, b->frame.ImageBufferSize);
+    b->locked = false;
+  }
+
+  void queue(FrameBuffer* b)
+  {
+    refresh(b);
+    if (PvCaptureQueueFrame(handle_, &b->frame, callback_) == ePvErrSuccess)
+      ++queued_;
+    else
+      free_.push_back(b);
+  }
+
+  void fill()
+  {
+    while (queued_ < queueSize_) {
+      FrameBuffer* b = NULL;
+      if (!free_.empty()) {
+        b = free_.back();
+        free_.pop_back();
+      }
+      else if (buffers_.size() < Camera::MAX_BUFFER_SIZE)
+        b = allocate();
+      else {
+        ROS_DEBUG("All %u frame buffers are held downstream, capture queue runs short",
+                  (unsigned)buffers_.size());
+        return;
+      }
+      size_t before = queued_;
+      queue(b);
+      if (queued_ == before)
+        return; // camera refuses frames, e.g. while stopping
+    }
+  }
+
+  void release(tPvFrame* frame)
+  {
+    boost::lock_guard<boost::mutex> guard(mutex_);
+    FrameBuffer* b = buffer(frame);
+    b->held = false;
+    if (capturing_ && queued_ < queueSize_)
+      queue(b);
+    else
+      free_.push_back(b);
+  }
+
+  tPvHandle handle_;
+  void* context_;
+  tPvUint32 frameSize_;
+  size_t queueSize_;
+  BufferAllocator allocator_;
+  tPvFrameCallback callback_;
+  bool capturing_;
+  size_t queued_; // frames currently in the PvApi capture queue
+  bool pinned_;
+  bool pinFailed_; // warned about RLIMIT_MEMLOCK already
+  std::vector<FrameBuffer*> buffers_; // all buffers, never shrinks
+  std::vector<FrameBuffer*> free_; // neither queued nor held
+  boost::mutex mutex_;
+};
+
+Camera::Camera(unsigned long guid, size_t bufferSize, BufferAllocator allocator)
+  : bufferSize_(bufferSize), FSTmode_(None),
+    handoff_(HANDOFF_QUEUE_SIZE), handoffReady_(0), workerRunning_(false),
+    handoffMaxDepth_(0), handoffFrames_(0), handoffOverruns_(0),
+    frameBinning_(1 | 1 << 16), statisticsTime_(-1.0)
+{
+  bufferSize_ = std::max<size_t>(1, std::min(bufferSize_, MAX_BUFFER_SIZE));
   openCamera(boost::bind(PvCameraInfo, guid, _1),
              boost::bind(PvCameraOpen, guid, _1, &handle_));
   
-  setup();
+  setup(allocator);
 }
 
-Camera::Camera(const char* ip_address, size_t bufferSize)
-  : bufferSize_(bufferSize), FSTmode_(None)
+Camera::Camera(const char* ip_address, size_t bufferSize, BufferAllocator allocator)
+  : bufferSize_(bufferSize), FSTmode_(None),
+    handoff_(HANDOFF_QUEUE_SIZE), handoffReady_(0), workerRunning_(false),
+    handoffMaxDepth_(0), handoffFrames_(0), handoffOverruns_(0),
+    frameBinning_(1 | 1 << 16), statisticsTime_(-1.0)
 {
+  bufferSize_ = std::max<size_t>(1, std::min(bufferSize_, MAX_BUFFER_SIZE));
   unsigned long addr = inet_addr(ip_address);
   tPvIpSettings settings;
   openCamera(boost::bind(PvCameraInfoByAddr, addr, _1, &settings),
              boost::bind(PvCameraOpenByAddr, addr, _1, &handle_));
   
-  setup();
+  setup(allocator);
 }
 
-void Camera::setup()
+void Camera::setup(BufferAllocator allocator)
 {
   // adjust packet size according to the current network capacity
   tPvUint32 maxPacketSize = 9000;
@@ -175,18 +467,10 @@ void Camera::setup()
   setRoiToWholeFrame();
   
   // query for attributes (TODO: more)
-  CHECK_ERR( PvAttrUint32Get(handle_, "TotalBytesPerFrame", &frameSize_),
-             "Unable to retrieve frame size" );
+  getAttribute("TotalBytesPerFrame", frameSize_);
   
   // allocate frame buffers
-  frames_ = new tPvFrame[bufferSize_];
-  memset(frames_, 0, sizeof(tPvFrame) * bufferSize_);
-  for (unsigned int i = 0; i < bufferSize_; ++i)
-  {
-    frames_[i].ImageBuffer = new char[frameSize_];
-    frames_[i].ImageBufferSize = frameSize_;
-    frames_[i].Context[0] = (void*)this; // for frameDone callback
-  }
+  frames_.reset( new FramePool(handle_, (void*)this, frameSize_, bufferSize_, allocator) );
 }
 
 Camera::~Camera()
@@ -195,31 +479,36 @@ Camera::~Camera()
   
   PvCameraClose(handle_);
 
-  if (frames_)
-  {
-    for (unsigned int i = 0; i < bufferSize_; ++i)
-      delete[] (char*)frames_[i].ImageBuffer;
-    delete[] frames_;
-  }
+  // buffers still held through FramePtrs are freed with the last of them
+  frames_.reset();
 }
 
 void Camera::setFrameCallback(boost::function<void (tPvFrame*)> callback)
 {
   userCallback_ = callback;
+  sharedCallback_.clear();
+}
+
+void Camera::setSharedFrameCallback(boost::function<void (const FramePtr&)> callback)
+{
+  sharedCallback_ = callback;
+  userCallback_.clear();
 }
 
 void Camera::start(FrameStartTriggerMode fmode, AcquisitionMode amode)
 {
   assert( FSTmode_ == None && fmode != None );
   ///@todo verify this assert again
-  assert( fmode == SyncIn1 || fmode == SyncIn2 || fmode == Software || !userCallback_.empty() );
+  assert( fmode == SyncIn1 || fmode == SyncIn2 || fmode == Software ||
+          !userCallback_.empty() || !sharedCallback_.empty() );
   
   // set camera in acquisition mode
   CHECK_ERR( PvCaptureStart(handle_), "Could not start capture");
 
-  if (fmode == Freerun || fmode == SyncIn1 || fmode == SyncIn2)
-    for (unsigned int i = 0; i < bufferSize_; ++i)
-      PvCaptureQueueFrame(handle_, frames_ + i, Camera::frameDone);
+  if (fmode == Freerun || fmode == SyncIn1 || fmode == SyncIn2) {
+    startWorker();
+    frames_->startCapture(Camera::frameDone);
+  }
 
   // start capture after setting acquisition and trigger modes
   try {
@@ -232,7 +521,11 @@ void Camera::start(FrameStartTriggerMode fmode, AcquisitionMode amode)
                "Could not start acquisition" );
   } 
   catch (ProsilicaException& e) {
+    frames_->stopCapture();
     PvCaptureEnd(handle_); // reset to non capture mode
+    PvCaptureQueueClear(handle_);
+    stopWorker();
+    frames_->reclaim();
     throw; // rethrow
   }
   FSTmode_ = fmode;
@@ -244,16 +537,145 @@ void Camera::stop()
   if (FSTmode_ == None)
     return;
   
+  frames_->stopCapture();
   PvCommandRun(handle_, "AcquisitionStop");
   PvCaptureEnd(handle_);
   PvCaptureQueueClear(handle_);
+  stopWorker();
+  frames_->reclaim();
   FSTmode_ = None;
 }
 
+void Camera::setBufferCount(size_t count)
+{
+  bufferSize_ = std::max<size_t>(1, std::min(count, MAX_BUFFER_SIZE));
+  frames_->setQueueSize(bufferSize_);
+}
+
+void Camera::setBufferPinning(bool pinned)
+{
+  frames_->setPinned(pinned);
+}
+
+void Camera::updateFrameSize()
+{
+  tPvUint32 frameSize;
+  getAttribute("TotalBytesPerFrame", frameSize); // keeps the cached value current
+  if (!frames_ || frameSize == frameSize_)
+    return; // still in setup(), or nothing to do
+  frameSize_ = frameSize;
+
+  bool streaming = (FSTmode_ == Freerun || FSTmode_ == SyncIn1 || FSTmode_ == SyncIn2);
+  if (streaming) {
+    // Flush the capture queue so no frame lands in a buffer of the old size.
+    // Acquisition and the worker keep running.
+    frames_->stopCapture();
+    PvCaptureQueueClear(handle_);
+    frames_->reclaim();
+  }
+  frames_->setFrameSize(frameSize_);
+  if (streaming)
+    frames_->startCapture(Camera::frameDone);
+}
+
+void Camera::startWorker()
+{
+  if (userCallback_.empty() && sharedCallback_.empty())
+    return; // frames are simply requeued
+
+  __sync_lock_test_and_set(&handoffMaxDepth_, 0);
+  __sync_lock_test_and_set(&handoffFrames_, 0);
+  __sync_lock_test_and_set(&handoffOverruns_, 0);
+  workerRunning_ = true;
+  worker_ = boost::thread(boost::bind(&Camera::workerThread, this));
+}
+
+void Camera::stopWorker()
+{
+  if (!workerRunning_)
+    return;
+
+  workerRunning_ = false;
+  handoffReady_.post();
+  worker_.join();
+
+  // The capture queue is cleared, so nothing pushes anymore; drop leftovers.
+  FramePtr frame;
+  while (handoff_.pop(frame))
+    frame.reset();
+}
+
+void Camera::workerThread()
+{
+  for (;;) {
+    handoffReady_.wait();
+
+    FramePtr frame;
+    if (!handoff_.pop(frame)) {
+      if (!workerRunning_)
+        return;
+      continue; // leftover wakeup from a previous run
+    }
+    if (!workerRunning_)
+      continue; // stopping, drop the frame
+
+    boost::lock_guard<boost::mutex> guard(frameMutex_);
+    if (!sharedCallback_.empty())
+      sharedCallback_(frame);
+    else if (!userCallback_.empty())
+      userCallback_(frame.get());
+    // the frame goes back to the pool when the last FramePtr is released
+  }
+}
+
+void Camera::handoff(tPvFrame* frame)
+{
+  // Claiming refills the capture queue from the pool right away, so the
+  // camera keeps streaming however long the worker takes.
+  FramePtr shared = frames_->claim(frame);
+  if (!handoff_.push(shared)) {
+    __sync_fetch_and_add(&handoffOverruns_, 1); // worker is behind, drop this frame
+    return;
+  }
+  __sync_fetch_and_add(&handoffFrames_, 1);
+  // the statistics can be reset from another thread, so raise the maximum with CAS
+  size_t depth = handoff_.size();
+  size_t max_depth = handoffMaxDepth_;
+  while (depth > max_depth) {
+    size_t seen = __sync_val_compare_and_swap(&handoffMaxDepth_, max_depth, depth);
+    if (seen == max_depth)
+      break;
+    max_depth = seen;
+  }
+  handoffReady_.post();
+}
+
+HandoffStatistics Camera::getHandoffStatistics()
+{
+  HandoffStatistics stats;
+  stats.depth = handoff_.size();
+  stats.max_depth = __sync_fetch_and_add(&handoffMaxDepth_, 0);
+  stats.capacity = handoff_.capacity();
+  stats.frames = __sync_fetch_and_add(&handoffFrames_, 0);
+  stats.overruns = __sync_fetch_and_add(&handoffOverruns_, 0);
+  return stats;
+}
+
 tPvFrame* Camera::grab(unsigned long timeout_ms)
 {
   assert( FSTmode_ == Software );
   
+  // The previous frame goes back to the pool, buffers still held through a
+  // FramePtr from an earlier streaming session are left alone
+  grabbed_.reset();
+  grabbed_ = frames_->claimFree();
+  if (!grabbed_) {
+    ROS_ERROR("All %u frame buffers are held downstream, cannot grab",
+              (unsigned)frames_->size());
+    return NULL;
+  }
+  tPvFrame* frame = grabbed_.get();
+
   unsigned long time_so_far = 0;
   while (time_so_far < timeout_ms)
   {
@@ -263,7 +685,6 @@ tPvFrame* Camera::grab(unsigned long timeout_ms)
     boost::this_thread::sleep(boost::posix_time::millisec(400));
 
     // Queue up a single frame
-    tPvFrame* frame = &frames_[0];
     CHECK_ERR( PvCaptureQueueFrame(handle_, frame, NULL), "Couldn't queue frame" );
     
     // Trigger the camera
@@ -289,11 +710,15 @@ tPvFrame* Camera::grab(unsigned long timeout_ms)
       }
     } while (e == ePvErrTimeout && time_so_far < timeout_ms);
 
-    if (e != ePvErrSuccess)
+    if (e != ePvErrSuccess) {
+      PvCaptureQueueClear(handle_); // don't leave the buffer in the queue
       return NULL; // Something bad happened (camera unplugged?)
+    }
     
-    if (frame->Status == ePvErrSuccess)
+    if (frame->Status == ePvErrSuccess) {
+      stampFrame(frame);
       return frame; // Yay!
+    }
 
     ROS_DEBUG("Error in frame: %s", errorStrings[frame->Status]);
 
@@ -358,6 +783,11 @@ void Camera::setRoi(unsigned int x, unsigned int y,
              "Couldn't set region width" );
   CHECK_ERR( PvAttrUint32Set(handle_, "Height", height),
              "Couldn't set region height" );
+  cacheAttribute("RegionX", x);
+  cacheAttribute("RegionY", y);
+  cacheAttribute("Width", width);
+  cacheAttribute("Height", height);
+  updateFrameSize();
 }
 
 void Camera::setRoiToWholeFrame()
@@ -371,10 +801,15 @@ void Camera::setRoiToWholeFrame()
              "Couldn't get range of Width attribute" );
   CHECK_ERR( PvAttrUint32Set(handle_, "Width", max_val),
              "Couldn't set region width" );
+  cacheAttribute("RegionX", 0);
+  cacheAttribute("RegionY", 0);
+  cacheAttribute("Width", max_val);
   CHECK_ERR( PvAttrRangeUint32(handle_, "Height", &min_val, &max_val),
              "Couldn't get range of Height attribute" );
   CHECK_ERR( PvAttrUint32Set(handle_, "Height", max_val),
              "Couldn't set region height" );
+  cacheAttribute("Height", max_val);
+  updateFrameSize();
 }
 
 void Camera::setBinning(unsigned int binning_x, unsigned int binning_y)
@@ -383,6 +818,34 @@ void Camera::setBinning(unsigned int binning_x, unsigned int binning_y)
              "Couldn't set horizontal binning" );
   CHECK_ERR( PvAttrUint32Set(handle_, "BinningY", binning_y),
              "Couldn't set vertical binning" );
+  cacheAttribute("BinningX", binning_x);
+  cacheAttribute("BinningY", binning_y);
+  updateFrameSize();
+}
+
+void Camera::cacheAttribute(const std::string &name, tPvUint32 value)
+{
+  boost::lock_guard<boost::mutex> guard(cacheMutex_);
+  uint32Cache_[name] = value;
+  if (name == "BinningX" || name == "BinningY") {
+    tPvUint32 binning_x = uint32Cache_.count("BinningX") ? uint32Cache_["BinningX"] : 1;
+    tPvUint32 binning_y = uint32Cache_.count("BinningY") ? uint32Cache_["BinningY"] : 1;
+    frameBinning_ = (size_t)binning_x | ((size_t)binning_y << 16);
+  }
+}
+
+void Camera::stampFrame(tPvFrame* frame)
+{
+  frame->Context[2] = (void*)frameBinning_;
+}
+
+void Camera::getFrameBinning(const tPvFrame* frame, tPvUint32 &binning_x, tPvUint32 &binning_y)
+{
+  size_t packed = (size_t)frame->Context[2];
+  binning_x = packed & 0xffff;
+  binning_y = packed >> 16;
+  if (binning_x == 0) binning_x = 1;
+  if (binning_y == 0) binning_y = 1;
 }
 
 static void getStringValuedAttribute(std::string &value,
@@ -413,7 +876,7 @@ void Camera::getAttribute(const std::string &name, tPvUint32 &value)
   std::string err_msg = "Couldn't get attribute " + name;
   CHECK_ERR( PvAttrUint32Get(handle_, name.c_str(), &value),
 	     err_msg.c_str());
-             
+  cacheAttribute(name, value);
 }
 
 void Camera::getAttribute(const std::string &name, tPvFloat32 &value)
@@ -421,6 +884,68 @@ void Camera::getAttribute(const std::string &name, tPvFloat32 &value)
 std::string err_msg = "Couldn't get attribute " + name;
   CHECK_ERR( PvAttrFloat32Get(handle_, name.c_str(), &value),
              err_msg.c_str());
+  boost::lock_guard<boost::mutex> guard(cacheMutex_);
+  float32Cache_[name] = value;
+}
+
+void Camera::getCachedAttribute(const std::string &name, tPvUint32 &value)
+{
+  {
+    boost::lock_guard<boost::mutex> guard(cacheMutex_);
+    std::map<std::string, tPvUint32>::const_iterator it = uint32Cache_.find(name);
+    if (it != uint32Cache_.end()) {
+      value = it->second;
+      return;
+    }
+  }
+  getAttribute(name, value);
+}
+
+void Camera::getCachedAttribute(const std::string &name, tPvFloat32 &value)
+{
+  {
+    boost::lock_guard<boost::mutex> guard(cacheMutex_);
+    std::map<std::string, tPvFloat32>::const_iterator it = float32Cache_.find(name);
+    if (it != float32Cache_.end()) {
+      value = it->second;
+      return;
+    }
+  }
+  getAttribute(name, value);
+}
+
+static double monotonicSeconds()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+CameraStatistics Camera::getStatistics(double max_age)
+{
+  double now = monotonicSeconds();
+  if (statisticsTime_ < 0.0 || now - statisticsTime_ >= max_age) {
+    CameraStatistics stats;
+    CHECK_ERR( PvAttrFloat32Get(handle_, "StatFrameRate", &stats.frame_rate),
+               "Couldn't get attribute StatFrameRate" );
+    CHECK_ERR( PvAttrUint32Get(handle_, "StatFramesCompleted", &stats.frames_completed),
+               "Couldn't get attribute StatFramesCompleted" );
+    CHECK_ERR( PvAttrUint32Get(handle_, "StatFramesDropped", &stats.frames_dropped),
+               "Couldn't get attribute StatFramesDropped" );
+    CHECK_ERR( PvAttrUint32Get(handle_, "StatPacketsReceived", &stats.packets_received),
+               "Couldn't get attribute StatPacketsReceived" );
+    CHECK_ERR( PvAttrUint32Get(handle_, "StatPacketsMissed", &stats.packets_missed),
+               "Couldn't get attribute StatPacketsMissed" );
+    CHECK_ERR( PvAttrUint32Get(handle_, "StatPacketsRequested", &stats.packets_requested),
+               "Couldn't get attribute StatPacketsRequested" );
+    CHECK_ERR( PvAttrUint32Get(handle_, "StatPacketsResent", &stats.packets_resent),
+               "Couldn't get attribute StatPacketsResent" );
+    CHECK_ERR( PvAttrUint32Get(handle_, "StatPacketsErroneous", &stats.packets_erroneous),
+               "Couldn't get attribute StatPacketsErroneous" );
+    statistics_ = stats;
+    statisticsTime_ = now;
+  }
+  return statistics_;
 }
 
 void Camera::getAttribute(const std::string &name, std::string &value)
@@ -434,6 +959,8 @@ void Camera::setAttributeEnum(const std::string &name, const std::string &value)
   std::string err_msg = "Couldn't get attribute " + name;
   CHECK_ERR( PvAttrEnumSet(handle_, name.c_str(), value.c_str()),
              err_msg.c_str());
+  if (name == "PixelFormat")
+    updateFrameSize();
 }
 
 void Camera::setAttribute(const std::string &name, tPvUint32 value)
@@ -441,6 +968,7 @@ void Camera::setAttribute(const std::string &name, tPvUint32 value)
   std::string err_msg = "Couldn't set attribute " + name;
   CHECK_ERR( PvAttrUint32Set(handle_, name.c_str(), value),
              err_msg.c_str());
+  cacheAttribute(name, value);
 }
 
 void Camera::setAttribute(const std::string &name, tPvFloat32 value)
@@ -448,6 +976,8 @@ void Camera::setAttribute(const std::string &name, tPvFloat32 value)
   std::string err_msg = "Couldn't set attribute " + name;
   CHECK_ERR( PvAttrFloat32Set(handle_, name.c_str(), value),
              err_msg.c_str());
+  boost::lock_guard<boost::mutex> guard(cacheMutex_);
+  float32Cache_[name] = value;
 }
 
 void Camera::setAttribute(const std::string &name, const std::string &value)
@@ -512,10 +1042,17 @@ void Camera::frameDone(tPvFrame* frame)
     return;
 
   Camera* camPtr = (Camera*) frame->Context[0];
-  if (frame->Status == ePvErrSuccess && camPtr && !camPtr->userCallback_.empty()) {
-    // TODO: thread safety OK here?
-    boost::lock_guard<boost::mutex> guard(camPtr->frameMutex_);
-    camPtr->userCallback_(frame);
+  if (!camPtr)
+    return;
+
+  if (frame->Status == ePvErrSuccess) {
+    if (camPtr->workerRunning_) {
+      // requeued by the pool once the worker is done with it
+      camPtr->stampFrame(frame);
+      camPtr->handoff(frame);
+      return;
+    }
+    // good frame but nobody to hand it to (capture is stopping), just requeue
   }
   else if (frame->Status == ePvErrDataMissing) {
     // Avoid warning spew; lots of dropped packets will show up in the diagnostics.
@@ -533,4 +1070,9 @@ tPvHandle Camera::handle()
   return handle_;
 }
 
+boost::shared_ptr<void> Camera::getBufferOwner(const tPvFrame* frame)
+{
+  return FramePool::owner(frame);
+}
+
 } // namespace prosilica
@@ -0,0 +1,135 @@
+#include "prosilica/trigger_matcher.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace prosilica {
+
+// tPvFrame::FrameCount is a 16 bit rolling counter on GigE cameras
+static const unsigned long FRAME_COUNT_MASK = 0xffff;
+// Weight of a new pair in the running latency estimate
+static const double LATENCY_GAIN = 0.1;
+
+TriggerMatcher::TriggerMatcher(size_t history)
+  : history_(history), period_(1.0), locked_(false), seq_offset_(0)
+{
+  memset(&stats_, 0, sizeof(stats_));
+}
+
+void TriggerMatcher::setPeriod(double period)
+{
+  boost::lock_guard<boost::mutex> guard(mutex_);
+  period_ = period > 0.0 ? period : 1.0;
+}
+
+void TriggerMatcher::reset()
+{
+  boost::lock_guard<boost::mutex> guard(mutex_);
+  triggers_.clear();
+  locked_ = false;
+  seq_offset_ = 0;
+}
+
+void TriggerMatcher::addTrigger(unsigned long seq, double time)
+{
+  {
+    boost::lock_guard<boost::mutex> guard(mutex_);
+    Trigger trigger;
+    trigger.seq = seq;
+    trigger.time = time;
+    triggers_.push_back(trigger);
+    while (triggers_.size() > history_) {
+      triggers_.pop_front();
+      ++stats_.unmatched_triggers;
+    }
+  }
+  trigger_added_.notify_all();
+}
+
+int TriggerMatcher::findBySequence(unsigned long frame_count, double frame_time)
+{
+  for (size_t i = 0; i < triggers_.size(); ++i) {
+    if (((triggers_[i].seq - frame_count - seq_offset_) & FRAME_COUNT_MASK) != 0)
+      continue;
+    // Right sequence number, but it must also fit in time; otherwise the
+    // counters jumped (camera restarted, trigger source reset)
+    if (fabs(frame_time - triggers_[i].time - stats_.latency) < 0.5 * period_)
+      return i;
+    return -1;
+  }
+  return -1;
+}
+
+int TriggerMatcher::findByTime(double frame_time)
+{
+  // Before the first pair the latency is unknown, allow up to a full period
+  double tolerance = stats_.matched ? 0.5 * period_ : period_;
+  int best = -1;
+  double best_error = tolerance;
+  for (size_t i = 0; i < triggers_.size(); ++i) {
+    double error = fabs(frame_time - triggers_[i].time - stats_.latency);
+    if (error < best_error) {
+      best = i;
+      best_error = error;
+    }
+  }
+  return best;
+}
+
+void TriggerMatcher::consume(size_t index)
+{
+  // Older triggers will never see their frame
+  stats_.unmatched_triggers += index;
+  triggers_.erase(triggers_.begin(), triggers_.begin() + index + 1);
+}
+
+bool TriggerMatcher::matchFrame(unsigned long frame_count, double frame_time,
+                                double& trigger_time, double max_wait)
+{
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  boost::system_time deadline = boost::get_system_time() +
+    boost::posix_time::microseconds((long)(max_wait * 1e6));
+
+  for (;;) {
+    int index = locked_ ? findBySequence(frame_count, frame_time) : -1;
+    if (index < 0) {
+      index = findByTime(frame_time);
+      if (index >= 0) {
+        long offset = (triggers_[index].seq - frame_count) & FRAME_COUNT_MASK;
+        if (locked_ && offset != seq_offset_)
+          ++stats_.resyncs;
+        seq_offset_ = offset;
+        locked_ = true;
+      }
+    }
+
+    if (index >= 0) {
+      trigger_time = triggers_[index].time;
+      double latency = frame_time - trigger_time;
+      if (stats_.matched == 0)
+        stats_.latency = latency;
+      else
+        stats_.latency += LATENCY_GAIN * (latency - stats_.latency);
+      consume(index);
+      ++stats_.matched;
+      return true;
+    }
+
+    // Wait only while this frame's trigger message may still be on its way
+    if (!triggers_.empty() && triggers_.back().time + stats_.latency > frame_time + 0.5 * period_)
+      break;
+    if (max_wait <= 0.0 || !trigger_added_.timed_wait(lock, deadline))
+      break;
+  }
+
+  ++stats_.unmatched_frames;
+  return false;
+}
+
+TriggerMatchStatistics TriggerMatcher::getStatistics()
+{
+  boost::lock_guard<boost::mutex> guard(mutex_);
+  return stats_;
+}
+
+} // namespace prosilica
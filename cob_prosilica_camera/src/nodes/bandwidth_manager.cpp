@@ -0,0 +1,211 @@
+#include "bandwidth_manager.h"
+
+#include <algorithm>
+#include <fstream>
+#include <cctype>
+#include <cmath>
+#include <arpa/inet.h>
+#include <ifaddrs.h>
+#include <netinet/in.h>
+
+const double BandwidthManager::STALE_TIMEOUT = 5.0;
+const double BandwidthManager::HEADROOM = 0.1;
+const double BandwidthManager::FREERUN_GROWTH = 1.25;
+const double BandwidthManager::REFRESH_PERIOD = 2.0;
+const double BandwidthManager::DEMAND_CHANGE = 0.05;
+
+// GVSP/UDP/IP headers on top of the image payload
+static const double PROTOCOL_OVERHEAD = 1.05;
+
+// Parameter names only allow alphanumerics and underscores
+static std::string paramName(const std::string& name)
+{
+  std::string result = name;
+  for (size_t i = 0; i < result.size(); ++i)
+    if (!isalnum(result[i]))
+      result[i] = '_';
+  if (result.empty() || !isalpha(result[0]))
+    result = "_" + result;
+  return result;
+}
+
+BandwidthManager::BandwidthManager(prosilica::Camera& cam, const std::string& camera_id)
+  : cam_(cam), camera_id_(camera_id), interface_("unknown"),
+    link_capacity_(prosilica::Camera::GIGE_MAX_DATA_RATE),
+    share_(0), rate_(0), cameras_on_link_(1), expected_rate_(0.0), measured_rate_(0.0),
+    last_missed_(0), last_resent_(0),
+    announced_demand_(0.0), last_announce_(0.0), last_read_(0.0)
+{
+  camera_max_rate_ = cam_.getMaxDataRate();
+  findInterface();
+
+  link_key_ = "/prosilica_bandwidth/" + paramName(interface_);
+  param_key_ = link_key_ + "/" + paramName(camera_id_);
+  ROS_INFO("Camera %s streams over %s, link capacity %lu bytes/s",
+           camera_id_.c_str(), interface_.c_str(), link_capacity_);
+}
+
+BandwidthManager::~BandwidthManager()
+{
+  ros::param::del(param_key_);
+}
+
+void BandwidthManager::findInterface()
+{
+  tPvIpSettings settings;
+  if (PvCameraIpSettingsGet(cam_.guid(), &settings) != ePvErrSuccess) {
+    ROS_WARN("Couldn't read the camera IP settings, assuming a dedicated GigE link");
+    return;
+  }
+
+  // The host interface on the camera's subnet carries its stream
+  struct ifaddrs* interfaces;
+  if (getifaddrs(&interfaces) != 0)
+    return;
+  for (struct ifaddrs* it = interfaces; it; it = it->ifa_next) {
+    if (!it->ifa_addr || !it->ifa_netmask || it->ifa_addr->sa_family != AF_INET)
+      continue;
+    in_addr_t addr = ((struct sockaddr_in*)it->ifa_addr)->sin_addr.s_addr;
+    in_addr_t mask = ((struct sockaddr_in*)it->ifa_netmask)->sin_addr.s_addr;
+    if ((addr & mask) == (settings.CurrentIpAddress & mask)) {
+      interface_ = it->ifa_name;
+      break;
+    }
+  }
+  freeifaddrs(interfaces);
+
+  // Negotiated link speed in Mbit/s, -1 if the link is down
+  std::ifstream speed_file(("/sys/class/net/" + interface_ + "/speed").c_str());
+  long mbits = 0;
+  if (speed_file >> mbits && mbits > 0)
+    link_capacity_ = (unsigned long)mbits * 125000UL;
+}
+
+tPvUint32 BandwidthManager::negotiatePacketSize(tPvUint32 max_packet_size)
+{
+  // PvApi sends test packets of decreasing size until one gets through
+  tPvErr err = PvCaptureAdjustPacketSize(cam_.handle(), max_packet_size);
+  tPvUint32 packet_size = 0;
+  cam_.getAttribute("PacketSize", packet_size);
+  if (err != ePvErrSuccess)
+    ROS_WARN("Packet size negotiation failed, keeping %u bytes", (unsigned)packet_size);
+  else if (packet_size <= 1500 && max_packet_size > 1500)
+    ROS_WARN("Jumbo frames are not supported on %s, using %u byte packets. Enable them on "
+             "the NIC (MTU 9000) for less CPU load and more headroom.",
+             interface_.c_str(), (unsigned)packet_size);
+  else
+    ROS_INFO("Using %u byte packets", (unsigned)packet_size);
+  return packet_size;
+}
+
+void BandwidthManager::setExpectedFrameRate(double rate)
+{
+  expected_rate_ = rate;
+}
+
+double BandwidthManager::frameBytes()
+{
+  // Cached by the driver whenever the frame size changes
+  tPvUint32 frame_bytes;
+  cam_.getCachedAttribute("TotalBytesPerFrame", frame_bytes);
+  return frame_bytes * PROTOCOL_OVERHEAD;
+}
+
+double BandwidthManager::demand()
+{
+  double rate = camera_max_rate_;
+  if (expected_rate_ > 0.0) {
+    // Triggered cameras need their frames at the trigger rate, or what they
+    // actually deliver if triggered faster than configured
+    rate = std::max(frameBytes() * expected_rate_, measured_rate_);
+  }
+  else if (measured_rate_ > 0.0) {
+    // Free running cameras are limited by exposure as often as by the link,
+    // so ask for what they deliver plus room to grow into
+    rate = measured_rate_ * FREERUN_GROWTH;
+  }
+  return std::min(rate, (double)camera_max_rate_);
+}
+
+void BandwidthManager::announce(double demand, double now)
+{
+  XmlRpc::XmlRpcValue entry;
+  entry["demand"] = demand;
+  entry["stamp"] = now;
+  ros::param::set(param_key_, entry);
+  announced_demand_ = demand;
+  last_announce_ = now;
+}
+
+void BandwidthManager::readLink()
+{
+  // Keeps the previous entries if the parameter server is unreachable
+  XmlRpc::XmlRpcValue link;
+  if (!ros::param::get(link_key_, link) || link.getType() != XmlRpc::XmlRpcValue::TypeStruct)
+    return;
+
+  std::string own_name = paramName(camera_id_);
+  others_.clear();
+  for (XmlRpc::XmlRpcValue::iterator it = link.begin(); it != link.end(); ++it) {
+    XmlRpc::XmlRpcValue& other = it->second;
+    if (it->first == own_name ||
+        other.getType() != XmlRpc::XmlRpcValue::TypeStruct ||
+        !other.hasMember("demand") || !other.hasMember("stamp") ||
+        other["demand"].getType() != XmlRpc::XmlRpcValue::TypeDouble ||
+        other["stamp"].getType() != XmlRpc::XmlRpcValue::TypeDouble)
+      continue;
+    LinkEntry entry;
+    entry.demand = other["demand"];
+    entry.stamp = other["stamp"];
+    others_[it->first] = entry;
+  }
+}
+
+unsigned long BandwidthManager::update(const prosilica::CameraStatistics& stats)
+{
+  double now = ros::WallTime::now().toSec();
+  measured_rate_ = stats.frame_rate * frameBytes();
+  double my_demand = demand();
+
+  // Announce our demand when it changes noticeably, and often enough for the
+  // others not to consider it stale
+  if (now - last_announce_ >= REFRESH_PERIOD ||
+      std::fabs(my_demand - announced_demand_) > DEMAND_CHANGE * announced_demand_)
+    announce(my_demand, now);
+  if (now - last_read_ >= REFRESH_PERIOD) {
+    readLink();
+    last_read_ = now;
+  }
+
+  // Split the link by everybody's demand
+  double total_demand = my_demand;
+  int cameras = 1;
+  for (std::map<std::string, LinkEntry>::const_iterator it = others_.begin(); it != others_.end(); ++it) {
+    if (now - it->second.stamp > STALE_TIMEOUT)
+      continue;
+    total_demand += it->second.demand;
+    ++cameras;
+  }
+  cameras_on_link_ = cameras;
+
+  double budget = (1.0 - HEADROOM) * link_capacity_;
+  share_ = (unsigned long)std::min(budget * my_demand / total_demand, (double)camera_max_rate_);
+
+  // Within the share: multiplicative decrease on resends, slow increase otherwise.
+  // Counters going backwards mean the camera was restarted.
+  unsigned long missed_total = stats.packets_missed, resent_total = stats.packets_resent;
+  bool congested = (missed_total > last_missed_ || resent_total > last_resent_) &&
+                   missed_total >= last_missed_ && resent_total >= last_resent_;
+  last_missed_ = missed_total;
+  last_resent_ = resent_total;
+
+  if (rate_ == 0)
+    rate_ = share_;
+  else if (congested)
+    rate_ = (unsigned long)(rate_ * 0.9);
+  else
+    rate_ = (unsigned long)(rate_ * 1.05);
+  rate_ = std::max(std::min(rate_, share_), share_ / 10);
+
+  return rate_;
+}
@@ -0,0 +1,84 @@
+#ifndef PROSILICA_BANDWIDTH_MANAGER_H
+#define PROSILICA_BANDWIDTH_MANAGER_H
+
+#include <map>
+#include <string>
+#include <ros/ros.h>
+
+#include "prosilica/prosilica.h"
+
+/// Shares the GigE link between all Prosilica cameras behind the same host
+/// interface. Every node publishes the data rate its camera needs under
+/// /prosilica_bandwidth/<interface>/<camera> on the parameter server and
+/// takes a share of the link proportional to it. The need follows the rate
+/// the camera actually delivers (StatFrameRate times the frame size), so a
+/// camera held back by its exposure leaves the rest of the link to the
+/// others. Within its share a node backs off when packets get resent and
+/// creeps back up when they don't. The parameter server is only read every
+/// REFRESH_PERIOD, our own entry is rewritten then or when our demand changes.
+class BandwidthManager
+{
+public:
+  BandwidthManager(prosilica::Camera& cam, const std::string& camera_id);
+  ~BandwidthManager();
+
+  //! Largest packet size up to max_packet_size the path supports, i.e. jumbo
+  //! frames if the NIC and switch allow them. Sets PacketSize on the camera.
+  tPvUint32 negotiatePacketSize(tPvUint32 max_packet_size = 9000);
+
+  //! Frame rate the camera is expected to deliver, 0 for free running.
+  void setExpectedFrameRate(double rate);
+
+  //! Call once per diagnostics period with the camera statistics.
+  //! Returns the StreamBytesPerSecond the camera should use.
+  unsigned long update(const prosilica::CameraStatistics& stats);
+
+  const std::string& interfaceName() const { return interface_; }
+  unsigned long linkCapacity() const { return link_capacity_; }
+  unsigned long share() const { return share_; }
+  unsigned long rate() const { return rate_; }
+  int camerasOnLink() const { return cameras_on_link_; }
+  //! Data rate the camera delivered at the last update, bytes/s.
+  double measuredRate() const { return measured_rate_; }
+
+  //! Entries older than this (seconds) are from dead nodes and ignored.
+  static const double STALE_TIMEOUT;
+  //! Fraction of the link left for packet resends and other traffic.
+  static const double HEADROOM;
+  //! Demand of a free running camera relative to the rate it delivers.
+  static const double FREERUN_GROWTH;
+  //! Seconds between parameter server reads and refreshes of our own entry.
+  static const double REFRESH_PERIOD;
+  //! Relative change of our demand that is announced right away.
+  static const double DEMAND_CHANGE;
+
+private:
+  prosilica::Camera& cam_;
+  std::string camera_id_;
+  std::string interface_;
+  std::string link_key_, param_key_;
+  unsigned long link_capacity_; // bytes/s
+  unsigned long camera_max_rate_;
+  unsigned long share_, rate_;
+  int cameras_on_link_;
+  double expected_rate_;
+  double measured_rate_; // bytes/s
+  unsigned long last_missed_, last_resent_;
+
+  // Parameter server cache
+  struct LinkEntry
+  {
+    double demand, stamp;
+  };
+  std::map<std::string, LinkEntry> others_; // the other cameras on the link
+  double announced_demand_;
+  double last_announce_, last_read_;
+
+  void findInterface();
+  void announce(double demand, double now);
+  void readLink();
+  double frameBytes();
+  double demand();
+};
+
+#endif
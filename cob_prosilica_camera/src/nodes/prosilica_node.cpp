@@ -59,9 +59,18 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/format.hpp>
 #include <sstream>
+#include <cmath>
 
 #include "prosilica/prosilica.h"
+#include "prosilica/bayer.h"
+#include "prosilica/clock_sync.h"
+#include "prosilica/discovery.h"
 #include "prosilica/rolling_sum.h"
+#include "prosilica/trigger_matcher.h"
+#include "bandwidth_manager.h"
+
+// Indexed by tPvBayerPattern
+static const char* BAYER_ENCODINGS[] = { "bayer_rggb8", "bayer_gbrg8", "bayer_grbg8", "bayer_bggr8" };
 
 /// @todo Only stream when subscribed to
 class ProsilicaNode
@@ -82,10 +91,26 @@ private:
   tPvUint32 sensor_width_, sensor_height_; // full resolution dimensions (maybe should be in lib)
   tPvUint32 max_binning_x_, max_binning_y_;
   bool auto_adjust_stream_bytes_per_second_;
+  boost::scoped_ptr<BandwidthManager> bandwidth_;
+  bool zero_copy_; // publish the frame buffers themselves instead of copies
+
+  // On-node demosaicing, runs on its own thread on the latest frame only
+  bool demosaic_;
+  image_transport::CameraPublisher color_pub_, mono_pub_, color_half_pub_, color_quarter_pub_;
+  boost::thread processing_thread_;
+  boost::mutex processing_mutex_;
+  boost::condition_variable processing_cond_;
+  bool processing_running_;
+  sensor_msgs::ImageConstPtr pending_image_; // replaced if the thread falls behind
+  sensor_msgs::CameraInfo pending_info_;
 
   // Hardware triggering
   std::string trig_timestamp_topic_;
-  ros::Time trig_time_;
+  prosilica::TriggerMatcher trigger_matcher_;
+  unsigned long last_unmatched_frames_;
+
+  // Maps frame time stamps from camera ticks to host time
+  boost::scoped_ptr<prosilica::ClockSync> clock_sync_;
 
   // ROS messages
   sensor_msgs::Image img_;
@@ -108,46 +133,120 @@ private:
   RollingSum<unsigned long> frames_dropped_acc_, frames_completed_acc_;
   unsigned long packets_missed_total_, packets_received_total_;
   RollingSum<unsigned long> packets_missed_acc_, packets_received_acc_;
+  unsigned long handoff_overruns_total_;
+  RollingSum<unsigned long> handoff_overruns_acc_;
 
   // So we don't get burned by auto-exposure
+  bool auto_exposure_;
+  boost::mutex exposure_mutex_;
+  boost::condition_variable exposure_cond_; // signalled once the exposure has settled
   unsigned long last_exposure_value_;
   int consecutive_stable_exposures_;
+  int exposure_stable_samples_;   // samples in a row within tolerance to call it settled
+  double exposure_sample_period_; // seconds between ExposureValue reads
+  double last_exposure_sample_;   // wall time of the last read
+  double exposure_tolerance_;     // relative change still counted as stable
+  double exposure_timeout_;       // seconds before giving up
+  unsigned long converged_exposure_; // last settled value, 0 if none yet
 
 public:
   ProsilicaNode(const ros::NodeHandle& node_handle)
     : nh_(node_handle),
       it_(nh_),
-      cam_(NULL), running_(false), auto_adjust_stream_bytes_per_second_(false),
+      cam_(NULL), running_(false), auto_adjust_stream_bytes_per_second_(false), zero_copy_(false),
+      demosaic_(false), processing_running_(false), last_unmatched_frames_(0),
       count_(0),
       frames_dropped_total_(0), frames_completed_total_(0),
       frames_dropped_acc_(WINDOW_SIZE),
       frames_completed_acc_(WINDOW_SIZE),
       packets_missed_total_(0), packets_received_total_(0),
       packets_missed_acc_(WINDOW_SIZE),
-      packets_received_acc_(WINDOW_SIZE)
+      packets_received_acc_(WINDOW_SIZE),
+      handoff_overruns_total_(0),
+      handoff_overruns_acc_(WINDOW_SIZE),
+      auto_exposure_(false), last_exposure_value_(0), consecutive_stable_exposures_(0),
+      exposure_sample_period_(0.1), last_exposure_sample_(0.0), converged_exposure_(0)
   {
     // Two-stage initialization: in the constructor we open the requested camera. Most
     // parameters controlling capture are set and streaming started in configure(), the
     // callback to dynamic_reconfig.
-    prosilica::init();
-
-    if (prosilica::numCameras() == 0)
-      ROS_WARN("Found no cameras on local subnet");
+    ros::NodeHandle local_nh("~");
+    local_nh.param("zero_copy", zero_copy_, false);
+    local_nh.param("demosaic", demosaic_, false);
+
+    // Exposure normalization before polled captures
+    local_nh.param("exposure_stable_samples", exposure_stable_samples_, 3);
+    double exposure_sample_rate;
+    local_nh.param("exposure_sample_rate", exposure_sample_rate, 10.0);
+    exposure_sample_period_ = exposure_sample_rate > 0.0 ? 1.0 / exposure_sample_rate : 0.0;
+    local_nh.param("exposure_tolerance", exposure_tolerance_, 0.02);
+    local_nh.param("exposure_timeout", exposure_timeout_, 3.0);
+    // One value per camera rather than per scene: it only seeds auto exposure,
+    // after a change of scene settling merely takes a little longer.
+    int converged_exposure;
+    if (local_nh.getParam("last_converged_exposure", converged_exposure) && converged_exposure > 0)
+      converged_exposure_ = converged_exposure;
+    prosilica::BufferAllocator allocator;
+    if (zero_copy_)
+      allocator = &ProsilicaNode::allocateImageBuffer;
+
+    // Frame buffers: more absorb longer publishing stalls at high frame rates,
+    // pinning keeps the receive path free of page faults
+    int buffer_count;
+    local_nh.param("buffer_count", buffer_count, (int)prosilica::Camera::DEFAULT_BUFFER_SIZE);
+    bool pin_buffers;
+    local_nh.param("pin_buffers", pin_buffers, false);
 
     // Determine which camera to use. Opening by IP address is preferred, then guid. If both
     // parameters are set we open by IP and verify the guid. If neither are set we default
     // to opening the first available camera.
-    ros::NodeHandle local_nh("~");
     unsigned long guid = 0;
     std::string guid_str;
     if (local_nh.getParam("guid", guid_str) && !guid_str.empty())
       guid = strtol(guid_str.c_str(), NULL, 0);
-
     std::string ip_str;
-    if (local_nh.getParam("ip_address", ip_str) && !ip_str.empty()) {
-      cam_.reset( new prosilica::Camera(ip_str.c_str()) );
-      
-      // Verify guid is the one expected
+    local_nh.getParam("ip_address", ip_str);
+
+    // Broadcast discovery takes a while; a guid found before (by find_camera or
+    // another node) is opened at its cached address right away.
+    double discovery_timeout;
+    local_nh.param("discovery_timeout", discovery_timeout, 1.0);
+    std::string discovery_cache;
+    local_nh.param("discovery_cache", discovery_cache, prosilica::defaultDiscoveryCachePath());
+    prosilica::CameraInfo cached;
+    bool use_cache = false;
+    if (ip_str.empty() && guid != 0 && !discovery_cache.empty()) {
+      std::vector<prosilica::CameraInfo> cameras;
+      use_cache = prosilica::loadDiscoveryCache(discovery_cache, cameras) &&
+                  prosilica::findCachedCamera(cameras, guid, cached) &&
+                  !cached.ip_address.empty();
+    }
+
+    prosilica::init(ip_str.empty() && !use_cache ? discovery_timeout : 0.0);
+
+    if (use_cache) {
+      prosilica::CameraInfo info;
+      if (prosilica::queryCamera(cached.ip_address, info) && info.guid == guid)
+        ip_str = cached.ip_address;
+      else {
+        ROS_WARN("Camera %lu is no longer at cached address %s, discovering",
+                 guid, cached.ip_address.c_str());
+        std::vector<prosilica::CameraInfo> cameras = prosilica::discoverCameras(discovery_timeout);
+        if (prosilica::findCachedCamera(cameras, guid, info))
+          ip_str = info.ip_address;
+      }
+    }
+    else if (ip_str.empty() && prosilica::numCameras() == 0)
+      ROS_WARN("Found no cameras on local subnet");
+
+    if (!ip_str.empty()) {
+      // Verify guid is the one expected, before taking the camera over
+      prosilica::CameraInfo info;
+      if (guid != 0 && prosilica::queryCamera(ip_str, info) && info.guid != guid)
+        throw prosilica::ProsilicaException(ePvErrBadParameter,
+                                            "guid does not match expected");
+
+      cam_.reset( new prosilica::Camera(ip_str.c_str(), std::max(buffer_count, 1), allocator) );
       unsigned long cam_guid = cam_->guid();
       if (guid != 0 && guid != cam_guid)
         throw prosilica::ProsilicaException(ePvErrBadParameter,
@@ -156,8 +255,12 @@ public:
     }
     else {
       if (guid == 0) guid = prosilica::getGuid(0);
-      cam_.reset( new prosilica::Camera(guid) );
+      cam_.reset( new prosilica::Camera(guid, std::max(buffer_count, 1), allocator) );
     }
+    if (!discovery_cache.empty())
+      prosilica::updateDiscoveryCache(discovery_cache, prosilica::describeCamera(*cam_));
+    if (pin_buffers)
+      cam_->setBufferPinning(true);
     hw_id_ = boost::lexical_cast<std::string>(guid);
     ROS_INFO("Found camera, guid = %s", hw_id_.c_str());
     diagnostic_.setHardwareID(hw_id_);
@@ -172,6 +275,16 @@ public:
     // Try to load intrinsics from on-camera memory.
     loadIntrinsics();
 
+    // Stamp frames with their exposure start instead of the publish time
+    bool sync_clock;
+    local_nh.param("sync_clock", sync_clock, true);
+    if (sync_clock) {
+      double period;
+      local_nh.param("clock_sync_period", period, 1.0);
+      clock_sync_.reset(new prosilica::ClockSync(*cam_, period));
+      clock_sync_->start();
+    }
+
     // Set up self tests and diagnostics.
     // NB: Need to wait until here to construct self_test_, otherwise an exception
     // above from failing to find the camera gives bizarre backtraces
@@ -185,17 +298,24 @@ public:
     diagnostic_.add( "Frame Statistics", this, &ProsilicaNode::frameStatistics );
     diagnostic_.add( "Packet Statistics", this, &ProsilicaNode::packetStatistics );
     diagnostic_.add( "Packet Error Status", this, &ProsilicaNode::packetErrorStatus );
+    diagnostic_.add( "Handoff Queue", this, &ProsilicaNode::handoffStatus );
+    if (clock_sync_)
+      diagnostic_.add( "Clock Sync", this, &ProsilicaNode::clockSyncStatus );
+    diagnostic_.add( "Trigger Matching", this, &ProsilicaNode::triggerStatus );
 
     diagnostic_timer_ = nh_.createTimer(ros::Duration(0.1), boost::bind(&ProsilicaNode::runDiagnostics, this));
 
     // Service call for setting calibration.
     set_camera_info_srv_ = nh_.advertiseService("set_camera_info", &ProsilicaNode::setCameraInfo, this);
 
-    // packet_size
+    // packet_size, 0 negotiates the largest the network supports
+    bandwidth_.reset(new BandwidthManager(*cam_, "prosilica" + hw_id_));
     int packet_size;
-    local_nh.param("packet_size", packet_size, 1500);
-	std::cout << "config.packet_size: " << packet_size << "\n";
-	cam_->setAttribute("PacketSize", (tPvUint32)packet_size);
+    local_nh.param("packet_size", packet_size, 0);
+    if (packet_size > 0)
+      cam_->setAttribute("PacketSize", (tPvUint32)packet_size);
+    else
+      bandwidth_->negotiatePacketSize();
 
     // Start dynamic_reconfigure
     reconfigure_server_.setCallback(boost::bind(&ProsilicaNode::configure, this, _1, _2));
@@ -217,10 +337,12 @@ public:
     else if (config.trigger_mode == "syncin1") {
       trigger_mode_ = prosilica::SyncIn1;
       desired_freq_ = config.trig_rate;
+      trigger_matcher_.setPeriod(1.0 / config.trig_rate);
     }
     else if (config.trigger_mode == "syncin2") {
       trigger_mode_ = prosilica::SyncIn2;
       desired_freq_ = config.trig_rate;
+      trigger_matcher_.setPeriod(1.0 / config.trig_rate);
     }
 #if 0
     else if (config.trigger_mode == "fixedrate") {
@@ -238,8 +360,11 @@ public:
       ROS_ERROR("Invalid trigger mode '%s' in reconfigure request", config.trigger_mode.c_str());
     }
     trig_timestamp_topic_ = config.trig_timestamp_topic;
+    // Free running cameras get the largest share of the link
+    bandwidth_->setExpectedFrameRate(trigger_mode_ == prosilica::Freerun ? 0.0 : std::max(desired_freq_, 1.0));
 
     // Exposure
+    auto_exposure_ = config.auto_exposure;
     if (config.auto_exposure)
     {
       cam_->setExposure(0, prosilica::Auto);
@@ -332,14 +457,15 @@ public:
   ~ProsilicaNode()
   {
     stop();
+    bandwidth_.reset(); // withdraws our share of the link
+    clock_sync_.reset();
     cam_.reset(); // must destroy Camera before calling prosilica::fini
     prosilica::fini();
   }
 
   void syncInCallback (const std_msgs::HeaderConstPtr& msg)
   {
-    /// @todo Replace this with robust trigger matching
-    trig_time_ = msg->stamp;
+    trigger_matcher_.addTrigger(msg->seq, msg->stamp.toSec());
   }
   
   ///@todo add the setting of output sync1 and sync2?
@@ -351,19 +477,27 @@ public:
     if (trigger_mode_ == prosilica::Software) {
       poll_srv_ = polled_camera::advertise(nh_, "request_image", &ProsilicaNode::pollCallback, this);
       // Auto-exposure tends to go wild the first few frames after startup
-      // if (auto_expose) normalizeExposure();
+      if (auto_exposure_) normalizeExposure();
     }
     else {
       if ((trigger_mode_ == prosilica::SyncIn1) || (trigger_mode_ == prosilica::SyncIn2)) {
-        if (!trig_timestamp_topic_.empty())
-          trigger_sub_ = nh_.subscribe(trig_timestamp_topic_, 1, &ProsilicaNode::syncInCallback, this);
+        if (!trig_timestamp_topic_.empty()) {
+          // Frame counts restart with acquisition, so does the pairing
+          trigger_matcher_.reset();
+          trigger_sub_ = nh_.subscribe(trig_timestamp_topic_, 32, &ProsilicaNode::syncInCallback, this);
+        }
       }
       else {
         assert(trigger_mode_ == prosilica::Freerun);
         //cam_->setFrameCallback(boost::bind(&ProsilicaNode::publishImage, this, _1));
       }
-      cam_->setFrameCallback(boost::bind(&ProsilicaNode::publishImage, this, _1));
+      if (zero_copy_)
+        cam_->setSharedFrameCallback(boost::bind(&ProsilicaNode::publishSharedImage, this, _1));
+      else
+        cam_->setFrameCallback(boost::bind(&ProsilicaNode::publishImage, this, _1));
       streaming_pub_ = it_.advertiseCamera("image_raw", 1);
+      if (demosaic_)
+        startProcessing();
     }
     cam_->start(trigger_mode_, prosilica::Continuous);
     running_ = true;
@@ -374,6 +508,7 @@ public:
     if (!running_) return;
 
     cam_->stop(); // Must stop camera before streaming_pub_.
+    stopProcessing();
     poll_srv_.shutdown();
     trigger_sub_.shutdown();
     streaming_pub_.shutdown();
@@ -445,8 +580,6 @@ public:
   static bool frameToImage(tPvFrame* frame, sensor_msgs::Image &image)
   {
     // NOTE: 16-bit and Yuv formats not supported
-    static const char* BAYER_ENCODINGS[] = { "bayer_rggb8", "bayer_gbrg8", "bayer_grbg8", "bayer_bggr8" };
-
     std::string encoding;
     if (frame->Format == ePvFmtMono8)       encoding = sensor_msgs::image_encodings::MONO8;
     else if (frame->Format == ePvFmtBayer8) 
@@ -473,27 +606,44 @@ public:
     }
 
     uint32_t step = frame->ImageSize / frame->Height;
+
+    // Zero-copy frames were captured straight into image.data, only fill in the rest
+    if (!image.data.empty() && (void*)&image.data[0] == frame->ImageBuffer) {
+      image.encoding = encoding;
+      image.height = frame->Height;
+      image.width = frame->Width;
+      image.step = step;
+      image.is_bigendian = 0;
+      image.data.resize(step * frame->Height); // never reallocates, buffer is larger
+      return true;
+    }
     return sensor_msgs::fillImage(image, encoding, frame->Height, frame->Width, step, frame->ImageBuffer);
   }
   
   bool processFrame(tPvFrame* frame, sensor_msgs::Image &img, sensor_msgs::CameraInfo &cam_info)
   {
-    /// @todo Better trigger timestamp matching
-    if ((trigger_mode_ == prosilica::SyncIn1 || trigger_mode_ == prosilica::SyncIn2) && !trig_time_.isZero()) {
-      img.header.stamp = cam_info.header.stamp = trig_time_;
-      trig_time_ = ros::Time(); // Zero
-    }
-    else {
-      /// @todo Match time stamp from frame to ROS time?
-      img.header.stamp = cam_info.header.stamp = ros::Time::now();
+    double exposure_start;
+    if (!clock_sync_ ||
+        !clock_sync_->toHostTime(prosilica::ClockSync::frameTicks(frame), exposure_start))
+      exposure_start = ros::Time::now().toSec();
+
+    // Prefer the trigger's own time stamp, paired by frame count and time so a
+    // lost trigger message or dropped frame doesn't shift all following stamps
+    double stamp = exposure_start;
+    if ((trigger_mode_ == prosilica::SyncIn1 || trigger_mode_ == prosilica::SyncIn2) &&
+        !trig_timestamp_topic_.empty()) {
+      double trigger_time;
+      if (trigger_matcher_.matchFrame(frame->FrameCount, exposure_start, trigger_time,
+                                      0.5 / std::max(desired_freq_, 1.0)))
+        stamp = trigger_time;
+      else
+        ROS_DEBUG("No trigger for frame %lu, using the frame time stamp", frame->FrameCount);
     }
+    img.header.stamp = cam_info.header.stamp = ros::Time(stamp);
     
-    /// @todo Binning values retrieved here may differ from the ones used to actually
-    /// capture the frame! Maybe need to clear queue when changing binning and/or
-    /// stuff binning values into context?
+    // Binning is stamped into the frame when it completes, no need to ask the camera
     tPvUint32 binning_x, binning_y;
-    cam_->getAttribute("BinningX", binning_x);
-    cam_->getAttribute("BinningY", binning_y);
+    prosilica::Camera::getFrameBinning(frame, binning_x, binning_y);
     // Binning averages bayer samples, so just call it mono8 in that case
     if (frame->Format == ePvFmtBayer8 && (binning_x > 1 || binning_y > 1))
       frame->Format = ePvFmtMono8;
@@ -518,8 +668,202 @@ public:
   
   void publishImage(tPvFrame* frame)
   {
-    if (processFrame(frame, img_, cam_info_))
-      streaming_pub_.publish(img_, cam_info_);
+    if (!wantsProcessing()) {
+      if (processFrame(frame, img_, cam_info_))
+        streaming_pub_.publish(img_, cam_info_);
+      return;
+    }
+
+    // The processing thread keeps the message, so copy into a fresh one
+    sensor_msgs::ImagePtr image(new sensor_msgs::Image);
+    image->header.frame_id = img_.header.frame_id;
+    if (!processFrame(frame, *image, cam_info_))
+      return;
+    sensor_msgs::CameraInfoConstPtr info(new sensor_msgs::CameraInfo(cam_info_));
+    streaming_pub_.publish(image, info);
+    postForProcessing(image, cam_info_);
+  }
+
+  // In zero-copy mode every frame buffer is the data array of its own image message.
+  static void* allocateImageBuffer(size_t size, boost::shared_ptr<void>& owner)
+  {
+    sensor_msgs::ImagePtr image(new sensor_msgs::Image);
+    image->data.resize(size);
+    owner = image;
+    return &image->data[0];
+  }
+
+  // Deleter of the published message: restores the buffer size and hands the
+  // frame back to the camera once the last subscriber is done with it.
+  struct FrameReleaser
+  {
+    prosilica::FramePtr frame;
+    FrameReleaser(const prosilica::FramePtr& f) : frame(f) {}
+    void operator()(sensor_msgs::Image* image)
+    {
+      image->data.resize(frame->ImageBufferSize);
+      frame.reset();
+    }
+  };
+
+  void publishSharedImage(const prosilica::FramePtr& frame)
+  {
+    sensor_msgs::ImagePtr image =
+      boost::static_pointer_cast<sensor_msgs::Image>(prosilica::Camera::getBufferOwner(frame.get()));
+    image->header.frame_id = img_.header.frame_id;
+    if (!processFrame(frame.get(), *image, cam_info_))
+      return;
+
+    // Intra-process subscribers receive this very pointer, remote ones are
+    // serialized from it. Either way the buffer is not touched again by the
+    // camera until the message is released.
+    sensor_msgs::ImageConstPtr msg(image.get(), FrameReleaser(frame));
+    sensor_msgs::CameraInfoConstPtr info(new sensor_msgs::CameraInfo(cam_info_));
+    streaming_pub_.publish(msg, info);
+    if (wantsProcessing())
+      postForProcessing(msg, cam_info_);
+  }
+
+  ////////////////////////////
+  // On-node demosaicing    //
+  ////////////////////////////
+
+  void startProcessing()
+  {
+    color_pub_ = it_.advertiseCamera("image_color", 1);
+    mono_pub_ = it_.advertiseCamera("image_mono", 1);
+    color_half_pub_ = it_.advertiseCamera("image_color_half", 1);
+    color_quarter_pub_ = it_.advertiseCamera("image_color_quarter", 1);
+
+    processing_running_ = true;
+    processing_thread_ = boost::thread(boost::bind(&ProsilicaNode::processingThread, this));
+  }
+
+  void stopProcessing()
+  {
+    if (!processing_running_)
+      return;
+
+    {
+      boost::lock_guard<boost::mutex> lock(processing_mutex_);
+      processing_running_ = false;
+      pending_image_.reset();
+    }
+    processing_cond_.notify_one();
+    processing_thread_.join();
+
+    color_pub_.shutdown();
+    mono_pub_.shutdown();
+    color_half_pub_.shutdown();
+    color_quarter_pub_.shutdown();
+  }
+
+  bool wantsProcessing()
+  {
+    return processing_running_ &&
+      (color_pub_.getNumSubscribers() || mono_pub_.getNumSubscribers() ||
+       color_half_pub_.getNumSubscribers() || color_quarter_pub_.getNumSubscribers());
+  }
+
+  void postForProcessing(const sensor_msgs::ImageConstPtr& image, const sensor_msgs::CameraInfo& info)
+  {
+    {
+      boost::lock_guard<boost::mutex> lock(processing_mutex_);
+      pending_image_ = image; // drops an unprocessed older frame
+      pending_info_ = info;
+    }
+    processing_cond_.notify_one();
+  }
+
+  void processingThread()
+  {
+    for (;;) {
+      sensor_msgs::ImageConstPtr raw;
+      sensor_msgs::CameraInfo info;
+      {
+        boost::unique_lock<boost::mutex> lock(processing_mutex_);
+        while (processing_running_ && !pending_image_)
+          processing_cond_.wait(lock);
+        if (!processing_running_)
+          return;
+        raw.swap(pending_image_);
+        info = pending_info_;
+      }
+      publishProcessed(*raw, info);
+    }
+  }
+
+  static sensor_msgs::ImagePtr makeImage(const sensor_msgs::Image& raw, uint32_t width, uint32_t height,
+                                         const std::string& encoding, uint32_t channels)
+  {
+    sensor_msgs::ImagePtr image(new sensor_msgs::Image);
+    image->header = raw.header;
+    image->encoding = encoding;
+    image->width = width;
+    image->height = height;
+    image->step = width * channels;
+    image->is_bigendian = 0;
+    image->data.resize(image->step * height);
+    return image;
+  }
+
+  // All outputs come out of a single pass over the raw frame, and only the
+  // ones somebody listens to are computed.
+  void publishProcessed(const sensor_msgs::Image& raw, const sensor_msgs::CameraInfo& info)
+  {
+    int pattern = 0;
+    while (pattern < 4 && raw.encoding != BAYER_ENCODINGS[pattern])
+      ++pattern;
+    if (pattern == 4)
+      return; // mono or binned frame, nothing to demosaic
+
+    using namespace sensor_msgs::image_encodings;
+    prosilica::DemosaicOutput out;
+    sensor_msgs::ImagePtr color, mono, half, quarter;
+    if (color_pub_.getNumSubscribers()) {
+      color = makeImage(raw, raw.width, raw.height, BGR8, 3);
+      out.bgr = &color->data[0];
+      out.bgr_step = color->step;
+    }
+    if (mono_pub_.getNumSubscribers()) {
+      mono = makeImage(raw, raw.width, raw.height, MONO8, 1);
+      out.mono = &mono->data[0];
+      out.mono_step = mono->step;
+    }
+    if (color_half_pub_.getNumSubscribers() && raw.width >= 2 && raw.height >= 2) {
+      half = makeImage(raw, raw.width / 2, raw.height / 2, BGR8, 3);
+      out.half = &half->data[0];
+      out.half_step = half->step;
+    }
+    if (color_quarter_pub_.getNumSubscribers() && raw.width >= 4 && raw.height >= 4) {
+      quarter = makeImage(raw, raw.width / 4, raw.height / 4, BGR8, 3);
+      out.quarter = &quarter->data[0];
+      out.quarter_step = quarter->step;
+    }
+    if (!color && !mono && !half && !quarter)
+      return;
+
+    prosilica::demosaic(&raw.data[0], raw.width, raw.height, raw.step,
+                        (tPvBayerPattern)pattern, out);
+
+    sensor_msgs::CameraInfoPtr full_info(new sensor_msgs::CameraInfo(info));
+    if (color)
+      color_pub_.publish(color, full_info);
+    if (mono)
+      mono_pub_.publish(mono, full_info);
+    // Downscaled images look like binned ones to consumers of the calibration
+    if (half) {
+      sensor_msgs::CameraInfoPtr half_info(new sensor_msgs::CameraInfo(info));
+      half_info->binning_x = std::max(info.binning_x, 1u) * 2;
+      half_info->binning_y = std::max(info.binning_y, 1u) * 2;
+      color_half_pub_.publish(half, half_info);
+    }
+    if (quarter) {
+      sensor_msgs::CameraInfoPtr quarter_info(new sensor_msgs::CameraInfo(info));
+      quarter_info->binning_x = std::max(info.binning_x, 1u) * 4;
+      quarter_info->binning_y = std::max(info.binning_y, 1u) * 4;
+      color_quarter_pub_.publish(quarter, quarter_info);
+    }
   }
 
   void loadIntrinsics()
@@ -592,33 +936,74 @@ public:
 
   void normalizeCallback(tPvFrame* frame)
   {
+    // Reading ExposureValue is a round trip to the camera, don't do it for
+    // every frame of a fast stream
+    double now = ros::WallTime::now().toSec();
+    if (now - last_exposure_sample_ < exposure_sample_period_)
+      return;
+    last_exposure_sample_ = now;
+
     unsigned long exposure;
     cam_->getAttribute("ExposureValue", exposure);
-    //ROS_WARN("Exposure value = %u", exposure);
 
-    if (exposure == last_exposure_value_)
+    boost::lock_guard<boost::mutex> lock(exposure_mutex_);
+    double change = last_exposure_value_ ?
+      fabs((double)exposure - (double)last_exposure_value_) / last_exposure_value_ : 1.0;
+    if (change <= exposure_tolerance_)
       consecutive_stable_exposures_++;
-    else {
-      last_exposure_value_ = exposure;
+    else
       consecutive_stable_exposures_ = 0;
-    }
+    last_exposure_value_ = exposure;
+
+    if (consecutive_stable_exposures_ >= exposure_stable_samples_)
+      exposure_cond_.notify_all();
   }
   
-  void normalizeExposure()
+  // Streams until auto exposure settles, returns false on timeout. Must be
+  // called with the camera stopped.
+  bool normalizeExposure()
   {
     ROS_INFO("Normalizing exposure");
-    /// @todo assert(stopped)
 
-    last_exposure_value_ = 0;
-    consecutive_stable_exposures_ = 0;
+    // Auto exposure continues from the current value, so start from where
+    // it settled last time; the scene rarely changes much between captures.
+    if (converged_exposure_) {
+      cam_->setExposure(converged_exposure_, prosilica::Manual);
+      cam_->setExposure(0, prosilica::Auto);
+    }
+
+    {
+      boost::lock_guard<boost::mutex> lock(exposure_mutex_);
+      last_exposure_value_ = 0;
+      consecutive_stable_exposures_ = 0;
+    }
+    last_exposure_sample_ = 0.0; // camera is stopped, the callback is not running
     cam_->setFrameCallback(boost::bind(&ProsilicaNode::normalizeCallback, this, _1));
     cam_->start(prosilica::Freerun);
 
-    /// @todo thread safety
-    while (consecutive_stable_exposures_ < 3)
-      boost::this_thread::sleep(boost::posix_time::millisec(250));
+    bool converged;
+    unsigned long exposure;
+    {
+      boost::unique_lock<boost::mutex> lock(exposure_mutex_);
+      boost::system_time deadline = boost::get_system_time() +
+        boost::posix_time::microseconds((long)(exposure_timeout_ * 1e6));
+      while (consecutive_stable_exposures_ < exposure_stable_samples_)
+        if (!exposure_cond_.timed_wait(lock, deadline))
+          break;
+      converged = consecutive_stable_exposures_ >= exposure_stable_samples_;
+      exposure = last_exposure_value_;
+    }
 
     cam_->stop();
+
+    if (!converged) {
+      ROS_WARN("Exposure did not settle within %.1f s, continuing anyway", exposure_timeout_);
+      return false;
+    }
+    ROS_INFO("Exposure settled at %lu us", exposure);
+    converged_exposure_ = exposure;
+    ros::NodeHandle("~").setParam("last_converged_exposure", (int)exposure);
+    return true;
   }
 
   /////////////////
@@ -653,12 +1038,10 @@ public:
 
   void frameStatistics(diagnostic_updater::DiagnosticStatusWrapper& status)
   {
-    // Get stats from camera driver
-    float frame_rate;
-    unsigned long completed, dropped;
-    cam_->getAttribute("StatFrameRate", frame_rate);
-    cam_->getAttribute("StatFramesCompleted", completed);
-    cam_->getAttribute("StatFramesDropped", dropped);
+    // Get stats from camera driver, one snapshot serves all tasks of an update
+    prosilica::CameraStatistics stats = cam_->getStatistics(0.5 * diagnostic_.getPeriod());
+    float frame_rate = stats.frame_rate;
+    unsigned long completed = stats.frames_completed, dropped = stats.frames_dropped;
 
     // Compute rolling totals, percentages
     frames_completed_acc_.add(completed - frames_completed_total_);
@@ -693,11 +1076,9 @@ public:
   void packetStatistics(diagnostic_updater::DiagnosticStatusWrapper& status)
   {
     // Get stats from camera driver
-    unsigned long received, missed, requested, resent;
-    cam_->getAttribute("StatPacketsReceived", received);
-    cam_->getAttribute("StatPacketsMissed", missed);
-    cam_->getAttribute("StatPacketsRequested", requested);
-    cam_->getAttribute("StatPacketsResent", resent);
+    prosilica::CameraStatistics stats = cam_->getStatistics(0.5 * diagnostic_.getPeriod());
+    unsigned long received = stats.packets_received, missed = stats.packets_missed;
+    unsigned long requested = stats.packets_requested, resent = stats.packets_resent;
 
     // Compute rolling totals, percentages
     packets_received_acc_.add(received - packets_received_total_);
@@ -730,28 +1111,15 @@ public:
       if (max_data_rate < prosilica::Camera::GIGE_MAX_DATA_RATE)
         status.mergeSummary(1, "Max data rate is lower than expected for a GigE port");
       try {
-        cam_->getAttribute("StreamBytesPerSecond", data_rate);
+        cam_->getCachedAttribute("StreamBytesPerSecond", data_rate);
 
-        /// @todo Something that doesn't oscillate
-        float multiplier = 1.0f;
-        if (recent_ratio == 1.0f)
-        {
-          multiplier = 1.1f;
-	    }
-        else if (recent_ratio < 0.99f)
-        {
-          multiplier = 0.9f;
-        }
-        if (multiplier != 1.0f)
+        // Share of the link negotiated with the other cameras on it
+        unsigned long new_data_rate = bandwidth_->update(stats);
+        if (data_rate != new_data_rate)
         {
-          unsigned long new_data_rate = std::min((unsigned long)(multiplier * data_rate + 0.5), max_data_rate);
-          new_data_rate = std::max(new_data_rate, max_data_rate/1000);
-          if (data_rate != new_data_rate)
-          {
-            data_rate = new_data_rate;
-            cam_->setAttribute("StreamBytesPerSecond", data_rate);
-            ROS_DEBUG("Changed data rate to %lu bytes per second", data_rate);
-          }
+          data_rate = new_data_rate;
+          cam_->setAttribute("StreamBytesPerSecond", data_rate);
+          ROS_DEBUG("Changed data rate to %lu bytes per second", data_rate);
         }
       }
       catch (prosilica::ProsilicaException &e)
@@ -774,12 +1142,16 @@ public:
     status.add("Resent Packets", resent);
     status.add("Data Rate (bytes/s)", data_rate);
     status.add("Max Data Rate (bytes/s)", max_data_rate);
+    status.add("Interface", bandwidth_->interfaceName());
+    status.add("Link Capacity (bytes/s)", bandwidth_->linkCapacity());
+    status.add("Cameras on Link", bandwidth_->camerasOnLink());
+    status.add("Bandwidth Share (bytes/s)", bandwidth_->share());
+    status.add("Measured Rate (bytes/s)", bandwidth_->measuredRate());
   }
 
   void packetErrorStatus(diagnostic_updater::DiagnosticStatusWrapper& status)
   {
-    unsigned long erroneous;
-    cam_->getAttribute("StatPacketsErroneous", erroneous);
+    unsigned long erroneous = cam_->getStatistics(0.5 * diagnostic_.getPeriod()).packets_erroneous;
 
     if (erroneous == 0) {
       status.summary(0, "No erroneous packets");
@@ -790,6 +1162,75 @@ public:
     status.add("Erroneous Packets", erroneous);
   }
 
+  void handoffStatus(diagnostic_updater::DiagnosticStatusWrapper& status)
+  {
+    prosilica::HandoffStatistics stats = cam_->getHandoffStatistics();
+
+    // Counters restart with every start()
+    if (stats.overruns < handoff_overruns_total_)
+      handoff_overruns_total_ = 0;
+    handoff_overruns_acc_.add(stats.overruns - handoff_overruns_total_);
+    handoff_overruns_total_ = stats.overruns;
+    unsigned long overruns_recent = handoff_overruns_acc_.sum();
+
+    if (overruns_recent == 0) {
+      status.summary(0, "Frame processing keeps up");
+    }
+    else {
+      status.summary(1, "Frames dropped because processing falls behind");
+    }
+
+    status.add("Queue Depth", stats.depth);
+    status.add("Max Queue Depth", stats.max_depth);
+    status.add("Queue Capacity", stats.capacity);
+    status.add("Frames Handed Off", stats.frames);
+    status.add("Recent Overruns", overruns_recent);
+    status.add("Overruns", stats.overruns);
+  }
+
+  void clockSyncStatus(diagnostic_updater::DiagnosticStatusWrapper& status)
+  {
+    size_t samples = clock_sync_->numSamples();
+    double residual = clock_sync_->residual();
+
+    if (samples == 0)
+      status.summary(2, "No clock samples, stamping with publish time");
+    else if (clock_sync_->isStale())
+      status.summary(1, "No new clock samples, the drift is not followed");
+    else if (residual > 0.001)
+      status.summary(1, "Camera clock mapping is noisy");
+    else
+      status.summary(0, "Camera clock synchronized");
+
+    status.add("Samples", samples);
+    status.add("Samples Accepted", clock_sync_->numAccepted());
+    status.add("Residual (ms)", residual * 1000.0);
+    status.add("Drift (ppm)", clock_sync_->driftPpm());
+  }
+
+  void triggerStatus(diagnostic_updater::DiagnosticStatusWrapper& status)
+  {
+    prosilica::TriggerMatchStatistics stats = trigger_matcher_.getStatistics();
+    unsigned long unmatched_recent = stats.unmatched_frames - last_unmatched_frames_;
+    last_unmatched_frames_ = stats.unmatched_frames;
+
+    if ((trigger_mode_ != prosilica::SyncIn1 && trigger_mode_ != prosilica::SyncIn2) ||
+        trig_timestamp_topic_.empty())
+      status.summary(0, "No trigger time stamps to match");
+    else if (stats.matched == 0)
+      status.summary(1, "No frame matched to a trigger yet");
+    else if (unmatched_recent > 0)
+      status.summary(1, "Frames stamped without a trigger");
+    else
+      status.summary(0, "Frames matched to triggers");
+
+    status.add("Matched", stats.matched);
+    status.add("Unmatched Frames", stats.unmatched_frames);
+    status.add("Unmatched Triggers", stats.unmatched_triggers);
+    status.add("Resyncs", stats.resyncs);
+    status.add("Latency (ms)", stats.latency * 1000.0);
+  }
+
   ////////////////
   // Self tests //
   ////////////////
@@ -32,175 +32,48 @@
  *  POSSIBILITY OF SUCH DAMAGE.
  *********************************************************************/
 
-#include <ros/console.h>
-#include <sys/types.h>
-#include <sys/socket.h>
-#include <ifaddrs.h>
-#include <netinet/ip.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
-#include <errno.h>
-#include <string.h>
-                          
-int receive_socket()
-{
-  int insock;
-  struct sockaddr_in recvaddr;
-  
-  if ((insock = socket(PF_INET,SOCK_DGRAM,0)) == -1)
-  {
-    ROS_ERROR("Error opening input socket.");
-    return -1;
-  }
-  
-  // Address to receive at.
-  memset(&recvaddr, 0, sizeof(recvaddr));
-  recvaddr.sin_family = AF_INET;
-  recvaddr.sin_addr.s_addr = INADDR_BROADCAST;
-  recvaddr.sin_port = htons(1234);
-  
-  if (bind(insock, (struct sockaddr*) &recvaddr, sizeof recvaddr) == -1)
-  {
-    ROS_ERROR("Can't bind to socket to receive.");
-    close(insock);
-    return -1;
-  }
-
-  return insock;
-}
-
-int send_query(struct ifaddrs *iface, int srcport)
-{
-  int outsock;
-  int port = 3956;
-  int broadcast=1;
-  struct sockaddr_in sendaddr;
-  struct sockaddr_in recvaddr;
-
-  if ((outsock = socket(PF_INET,SOCK_DGRAM,0)) == -1)
-  {
-    ROS_ERROR("Error opening output socket.");
-    return -1;
-  }
-
-  // Address to receive at.
-  memset(&sendaddr, 0, sizeof(sendaddr));
-  sendaddr.sin_family = AF_INET;
-  sendaddr.sin_addr.s_addr = ((sockaddr_in *) iface->ifa_addr)->sin_addr.s_addr;
-  sendaddr.sin_port = htons(srcport);
-
-  if (bind(outsock, (struct sockaddr*) &sendaddr, sizeof sendaddr) == -1)
-  {
-    ROS_ERROR("Can't bind to socket on interface %s.", iface->ifa_name);
-    close(outsock);
-    return -1;
-  }
-
-  // Send a broadcast.
-  if ((setsockopt(outsock,SOL_SOCKET,SO_BROADCAST, &broadcast,sizeof broadcast)) == -1)
-  {
-    ROS_ERROR("Can't set broadcast flag on interface %s.", iface->ifa_name);
-    close(outsock);
-    return -1;
-  }
-
-  memset(&recvaddr, 0, sizeof(recvaddr));
-  recvaddr.sin_family = AF_INET;
-  recvaddr.sin_port = htons(port);
-  recvaddr.sin_addr.s_addr = INADDR_BROADCAST;
-
-  char outpkt[] = { 0x42, 0x11, 0x00, 0x02, 0x00, 0x00, 0x06, 0x26 };
-
-  if (sendto(outsock, outpkt, sizeof(outpkt) , 0, (struct sockaddr *)&recvaddr, sizeof(recvaddr)) != sizeof(outpkt))
-  {
-    ROS_ERROR("Failed sending packet on interface %s.", iface->ifa_name);
-    close(outsock);
-    return -1;
-  }
+// Lists all reachable cameras once and records them in the discovery cache,
+// so prosilica_node instances configured by guid open their camera by
+// address without waiting for broadcast discovery.
 
-  close(outsock);
-  return 0;
-}
-
-void get_response(int fd)
-{
-  ROS_INFO("Got a response on socket %i.", fd);
-}
-
-int collect_replies(fd_set *master_set, int maxfd)
-{
-  struct timeval tv;
-  int retval;
-  fd_set tmpset;
-
-  tv.tv_sec = 1;
-  tv.tv_usec = 0;
-
-  while (1)
-  {
-    memcpy(&tmpset, master_set, sizeof(tmpset));
-    retval = select(maxfd + 1, &tmpset, NULL, NULL, &tv);
-
-    if (retval < 0 && errno != EINTR)
-    {
-      ROS_ERROR("Select exited with an error code.");
-      return -1;
-    }
+#include <cstdio>
+#include <cstdlib>
+#include "prosilica/prosilica.h"
+#include "prosilica/discovery.h"
 
-    if (!retval)
-      return 0;
-
-    ROS_INFO("Got packet %i.", retval);
-    for (int i = 0; i <= maxfd && retval > 0; i++)
-      if (FD_ISSET(i, &tmpset))
-      {
-        get_response(i);
-        retval--;
-      }
-  }
-}
-     
-int get_local_port(int fd)
+int main(int argc, char** argv)
 {
-  struct sockaddr localPort;
-  socklen_t localPortLen;
-
-  if (getsockname(fd, &localPort, &localPortLen) == -1)
-  {
-    ROS_ERROR("Unable to get local port for socket.");
-    return -1;
+  if (argc > 1 && argv[1][0] == '-') {
+    printf("Usage: %s [timeout_s [expected_cameras [cache_file]]]\n", argv[0]);
+    return 0;
   }
+  double timeout = argc > 1 ? atof(argv[1]) : 2.0;
+  size_t expected = argc > 2 ? strtoul(argv[2], NULL, 0) : 0;
+  std::string cache = argc > 3 ? argv[3] : prosilica::defaultDiscoveryCachePath();
 
-  return ntohs(((struct sockaddr_in *)&localPort)->sin_port);
-}
+  prosilica::init(0.0);
+  // Make sure we call prosilica::fini() on exit.
+  boost::shared_ptr<void> guard(static_cast<void*>(0), boost::bind(prosilica::fini));
 
-int main()
-{
-  struct ifaddrs *ifaces = NULL;
-  fd_set fdset;
-  int maxfd = 0;
-
-  if (getifaddrs(&ifaces))
-  {
-    ROS_ERROR("Couldn't get interface list.");
+  std::vector<prosilica::CameraInfo> cameras = prosilica::discoverCameras(timeout, expected);
+  if (cameras.empty()) {
+    printf("ERROR: No camera detected. Is it plugged in?\n");
     return 1;
   }
 
-  FD_ZERO(&fdset);
-  maxfd = receive_socket();
-  if (maxfd < 0)
-    return 1;
-  FD_SET(maxfd, &fdset);
-  
-  int port = get_local_port(maxfd);
-
-  for (struct ifaddrs *curif = ifaces; curif; curif = curif->ifa_next)
-  {
-    if (curif->ifa_addr && curif->ifa_addr->sa_family == AF_INET)
-      send_query(curif, port);
+  printf("%-12s %-16s %-16s %s\n", "guid", "ip_address", "model", "serial");
+  for (size_t i = 0; i < cameras.size(); ++i) {
+    const prosilica::CameraInfo& info = cameras[i];
+    printf("%-12lu %-16s %-16s %s\n", info.guid, info.ip_address.c_str(),
+           info.model.c_str(), info.serial.c_str());
+    if (!cache.empty())
+      prosilica::updateDiscoveryCache(cache, info);
   }
-                                       
-  freeifaddrs(ifaces); 
+  if (expected && cameras.size() < expected)
+    printf("WARNING: Found %u of %u expected cameras\n",
+           (unsigned)cameras.size(), (unsigned)expected);
+  if (!cache.empty())
+    printf("Recorded in %s\n", cache.c_str());
 
-  return collect_replies(&fdset, maxfd) != 0;
+  return expected && cameras.size() < expected;
 }